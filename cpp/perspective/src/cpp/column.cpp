@@ -200,6 +200,12 @@ t_column::get_interned(const char* s) {
     return m_vocab->get_interned(s);
 }
 
+bool
+t_column::string_exists(const char* s, t_uindex& interned) const {
+    COLUMN_CHECK_STRCOL();
+    return m_vocab->string_exists(s, interned);
+}
+
 template <>
 void
 t_column::push_back<const char*>(const char* elem) {
@@ -319,6 +325,21 @@ t_column::data_lstore() const {
     return *m_data;
 }
 
+const t_lstore&
+t_column::status_lstore() const {
+    return *m_status;
+}
+
+const t_lstore&
+t_column::vlendata_lstore() const {
+    return *(m_vocab->get_vlendata());
+}
+
+const t_lstore&
+t_column::extents_lstore() const {
+    return *(m_vocab->get_extents());
+}
+
 t_uindex
 t_column::size() const {
     return m_size;
@@ -507,6 +528,13 @@ t_column::get_nth_status(t_uindex idx) const {
     return status;
 }
 
+t_status*
+t_column::get_nth_status(t_uindex idx) {
+    PSP_VERBOSE_ASSERT(is_status_enabled(), "Status not available for column");
+    COLUMN_CHECK_ACCESS(idx);
+    return m_status->get_nth<t_status>(idx);
+}
+
 bool
 t_column::is_valid(t_uindex idx) const {
     PSP_VERBOSE_ASSERT(is_status_enabled(), "Status not available for column");
@@ -661,10 +689,13 @@ t_column::append(const t_column& other) {
             set_size(other.size());
             m_vocab->rebuild_map();
         } else {
-            for (t_uindex idx = 0, loop_end = other.size(); idx < loop_end; ++idx) {
-                const char* s = other.get_nth<const char>(idx);
-                push_back(s);
-            }
+            t_uindex offset = m_data->size() / sizeof(t_uindex);
+            t_vocab_remap remap = remap_vocabulary(other);
+            const t_status* status
+                = other.is_status_enabled() ? other.m_status->get_nth<t_status>(0) : nullptr;
+            m_data->append(*other.m_data);
+            remap.translate(m_data->get_nth<t_uindex>(offset), status, other.size());
+            m_size += other.size();
 
             if (is_status_enabled()) {
                 m_status->append(*other.m_status);
@@ -775,8 +806,12 @@ t_column::clone(const t_mask& mask) const {
         rval->m_status->fill(*m_status, mask, sizeof(t_status));
     }
 
+    // Only the strings of the selected rows are carried over
     if (is_vlen_dtype(get_dtype())) {
-        rval->m_vocab->clone(*m_vocab);
+        t_vocab_remap remap = rval->remap_vocabulary(*this);
+        const t_status* status
+            = rval->is_status_enabled() ? rval->m_status->get_nth<t_status>(0) : nullptr;
+        remap.translate(rval->m_data->get_nth<t_uindex>(0), status, mask.count());
     }
 #ifdef PSP_COLUMN_VERIFY
     rval->verify();
@@ -850,8 +885,14 @@ t_column::copy_helper<const char>(
     t_uindex eidx = std::min(other->size(), static_cast<t_uindex>(indices.size()));
     reserve(eidx + offset);
 
+    t_vocab_remap remap = remap_vocabulary(*other);
     for (t_uindex idx = 0; idx < eidx; ++idx) {
-        set_scalar(offset + idx, other->get_scalar(indices[idx]));
+        t_uindex oidx = indices[idx];
+        t_status status
+            = other->is_status_enabled() ? *(other->get_nth_status(oidx)) : STATUS_VALID;
+        t_uindex interned
+            = status == STATUS_VALID ? remap.translate(*(other->get_nth<t_uindex>(oidx))) : 0;
+        set_nth<t_uindex>(offset + idx, interned, status);
     }
     COLUMN_CHECK_VALUES();
 }
@@ -921,6 +962,12 @@ t_column::borrow_vocabulary(const t_column& o) {
     m_vocab = const_cast<t_column&>(o).m_vocab;
 }
 
+t_vocab_remap
+t_column::remap_vocabulary(const t_column& other) {
+    COLUMN_CHECK_STRCOL();
+    return t_vocab_remap(*other.m_vocab, *m_vocab);
+}
+
 #ifdef PSP_ENABLE_PYTHON
 np::ndarray
 t_column::_as_numpy() {
@@ -928,6 +975,22 @@ t_column::_as_numpy() {
         return m_data->_as_numpy(DTYPE_UINT64);
     return m_data->_as_numpy(m_dtype);
 }
+
+np::ndarray
+t_column::_status_as_numpy() {
+    PSP_VERBOSE_ASSERT(is_status_enabled(), "Validity not enabled for column");
+    return m_status->_as_numpy(DTYPE_UINT8);
+}
+
+py::list
+t_column::_vocab_as_list() const {
+    COLUMN_CHECK_STRCOL();
+    py::list rval;
+    for (t_uindex idx = 0, loop_end = m_vocab->get_vlenidx(); idx < loop_end; ++idx) {
+        rval.append(std::string(m_vocab->unintern_c(idx)));
+    }
+    return rval;
+}
 #endif
 
 } // end namespace perspective
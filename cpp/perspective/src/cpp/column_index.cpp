@@ -0,0 +1,440 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/column_index.h>
+#include <boost/dynamic_bitset.hpp>
+#include <tsl/hopscotch_map.h>
+#include <algorithm>
+#include <iterator>
+
+namespace perspective {
+
+// Once more than one row in this many is marked, rebuilding is cheaper
+static const t_uindex INDEX_DIRTY_RATIO = 8;
+
+static bool
+is_valid_cell(const t_column& column, t_uindex ridx) {
+    return !column.is_status_enabled() || column.is_valid(ridx);
+}
+
+/**
+ * Sorted rows of a string column by vocabulary id, so that the index holds
+ * each row once however many distinct values the column has.
+ */
+class t_vocab_index : public t_column_index {
+    // Rows leaving and joining the list of one id, both sorted
+    struct t_changes {
+        std::vector<t_uindex> m_removed;
+        std::vector<t_uindex> m_added;
+    };
+
+public:
+    void
+    rebuild(const t_column& column) override {
+        m_rows.clear();
+        m_ids.assign(column.size(), 0);
+        for (t_uindex ridx = 0, loop_end = column.size(); ridx < loop_end; ++ridx) {
+            if (!is_valid_cell(column, ridx)) {
+                continue;
+            }
+
+            t_uindex id = *(column.get_nth<t_uindex>(ridx));
+            if (id >= m_rows.size()) {
+                m_rows.resize(id + 1);
+            }
+            m_rows[id].push_back(ridx);
+            m_ids[ridx] = id + 1;
+        }
+    }
+
+    void
+    update(const t_column& column, const std::vector<t_uindex>& rows) override {
+        t_uindex nrows = column.size();
+        if (m_ids.size() < nrows) {
+            m_ids.resize(nrows, 0);
+        }
+
+        tsl::hopscotch_map<t_uindex, t_changes> changes;
+        for (auto ridx : rows) {
+            if (ridx >= nrows) {
+                break;
+            }
+
+            // Ids are stored plus one, so zero marks a row that is not indexed
+            if (m_ids[ridx] != 0) {
+                changes[m_ids[ridx] - 1].m_removed.push_back(ridx);
+                m_ids[ridx] = 0;
+            }
+
+            if (!is_valid_cell(column, ridx)) {
+                continue;
+            }
+
+            t_uindex id = *(column.get_nth<t_uindex>(ridx));
+            changes[id].m_added.push_back(ridx);
+            m_ids[ridx] = id + 1;
+        }
+
+        // Each touched list is merged with its changes once
+        for (const auto& change : changes) {
+            if (change.first >= m_rows.size()) {
+                m_rows.resize(change.first + 1);
+            }
+
+            std::vector<t_uindex>& list = m_rows[change.first];
+            std::vector<t_uindex> kept;
+            std::set_difference(list.begin(), list.end(), change.second.m_removed.begin(),
+                change.second.m_removed.end(), std::back_inserter(kept));
+            list.clear();
+            std::set_union(kept.begin(), kept.end(), change.second.m_added.begin(),
+                change.second.m_added.end(), std::back_inserter(list));
+        }
+    }
+
+    bool
+    lookup(const t_column& column, const t_fterm& fterm,
+        std::vector<t_uindex>& rows) const override {
+        if (fterm.m_negated) {
+            return false;
+        }
+
+        std::vector<t_tscalar> values;
+        switch (fterm.m_op) {
+            case FILTER_OP_EQ: {
+                values.push_back(fterm.m_threshold);
+            } break;
+            case FILTER_OP_IN: {
+                values = fterm.m_bag;
+            } break;
+            default: { return false; }
+        }
+
+        rows.clear();
+        std::vector<t_uindex> merged;
+        for (const auto& value : values) {
+            t_uindex id;
+            if (!value.is_valid() || value.get_dtype() != DTYPE_STR
+                || !column.string_exists(value.get_char_ptr(), id) || id >= m_rows.size()) {
+                continue;
+            }
+
+            const std::vector<t_uindex>& list = m_rows[id];
+            merged.clear();
+            std::set_union(rows.begin(), rows.end(), list.begin(), list.end(),
+                std::back_inserter(merged));
+            std::swap(rows, merged);
+        }
+        return true;
+    }
+
+private:
+    std::vector<std::vector<t_uindex>> m_rows;
+    std::vector<t_uindex> m_ids;
+};
+
+/**
+ * (value, row) pairs of the valid cells of a column, by value. NaNs are
+ * left out, as they pass no comparison with a number.
+ */
+template <typename DATA_T>
+class t_sorted_index : public t_column_index {
+    typedef std::pair<DATA_T, t_uindex> t_entry;
+
+public:
+    t_sorted_index(t_dtype dtype)
+        : m_dtype(dtype) {}
+
+    void
+    rebuild(const t_column& column) override {
+        m_entries.clear();
+        m_entries.reserve(column.size());
+        for (t_uindex ridx = 0, loop_end = column.size(); ridx < loop_end; ++ridx) {
+            add_entry(column, ridx, m_entries);
+        }
+        std::sort(m_entries.begin(), m_entries.end());
+    }
+
+    void
+    update(const t_column& column, const std::vector<t_uindex>& rows) override {
+        boost::dynamic_bitset<> marked(column.size());
+        std::vector<t_entry> added;
+        added.reserve(rows.size());
+        for (auto ridx : rows) {
+            if (ridx >= column.size()) {
+                break;
+            }
+            marked.set(ridx);
+            add_entry(column, ridx, added);
+        }
+
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                            [&marked](const t_entry& entry) {
+                                return entry.second < marked.size() && marked[entry.second];
+                            }),
+            m_entries.end());
+
+        std::sort(added.begin(), added.end());
+        auto middle = m_entries.insert(m_entries.end(), added.begin(), added.end());
+        std::inplace_merge(m_entries.begin(), middle, m_entries.end());
+    }
+
+    bool
+    lookup(const t_column& column, const t_fterm& fterm,
+        std::vector<t_uindex>& rows) const override {
+        if (fterm.m_negated) {
+            return false;
+        }
+
+        std::vector<t_tscalar> values;
+        switch (fterm.m_op) {
+            case FILTER_OP_EQ:
+            case FILTER_OP_LT:
+            case FILTER_OP_LTEQ:
+            case FILTER_OP_GT:
+            case FILTER_OP_GTEQ: {
+                values.push_back(fterm.m_threshold);
+            } break;
+            case FILTER_OP_IN: {
+                values = fterm.m_bag;
+            } break;
+            default: { return false; }
+        }
+
+        std::vector<DATA_T> keys;
+        for (const auto& value : values) {
+            t_tscalar coerced = value.coerce_numeric_dtype(m_dtype);
+            if (!coerced.is_valid() || coerced.get_dtype() != m_dtype) {
+                if (fterm.m_op == FILTER_OP_IN) {
+                    continue;
+                }
+                return false;
+            }
+
+            // A NaN threshold matches the NaNs with the same bits
+            DATA_T key = coerced.get<DATA_T>();
+            if (!(key == key)) {
+                return false;
+            }
+            keys.push_back(key);
+        }
+
+        auto less = [](const t_entry& entry, DATA_T key) { return entry.first < key; };
+        auto greater = [](DATA_T key, const t_entry& entry) { return key < entry.first; };
+
+        rows.clear();
+        auto add_range = [&rows](typename std::vector<t_entry>::const_iterator begin,
+                             typename std::vector<t_entry>::const_iterator end) {
+            for (auto iter = begin; iter != end; ++iter) {
+                rows.push_back(iter->second);
+            }
+        };
+
+        auto begin = m_entries.begin();
+        auto end = m_entries.end();
+        for (auto key : keys) {
+            switch (fterm.m_op) {
+                case FILTER_OP_LT: {
+                    add_range(begin, std::lower_bound(begin, end, key, less));
+                } break;
+                case FILTER_OP_LTEQ: {
+                    add_range(begin, std::upper_bound(begin, end, key, greater));
+                } break;
+                case FILTER_OP_GT: {
+                    add_range(std::upper_bound(begin, end, key, greater), end);
+                } break;
+                case FILTER_OP_GTEQ: {
+                    add_range(std::lower_bound(begin, end, key, less), end);
+                } break;
+                default: {
+                    add_range(std::lower_bound(begin, end, key, less),
+                        std::upper_bound(begin, end, key, greater));
+                } break;
+            }
+        }
+
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        return true;
+    }
+
+private:
+    void
+    add_entry(const t_column& column, t_uindex ridx, std::vector<t_entry>& entries) const {
+        if (!is_valid_cell(column, ridx)) {
+            return;
+        }
+        DATA_T value = *(column.get_nth<DATA_T>(ridx));
+        if (value == value) {
+            entries.emplace_back(value, ridx);
+        }
+    }
+
+    t_dtype m_dtype;
+    std::vector<t_entry> m_entries;
+};
+
+std::unique_ptr<t_column_index>
+t_column_index::make(t_dtype dtype) {
+    switch (dtype) {
+        case DTYPE_STR: {
+            return std::unique_ptr<t_column_index>(new t_vocab_index());
+        }
+        case DTYPE_INT64: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::int64_t>(dtype));
+        }
+        case DTYPE_INT32: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::int32_t>(dtype));
+        }
+        case DTYPE_INT16: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::int16_t>(dtype));
+        }
+        case DTYPE_INT8: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::int8_t>(dtype));
+        }
+        case DTYPE_UINT64: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::uint64_t>(dtype));
+        }
+        case DTYPE_UINT32:
+        case DTYPE_DATE: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::uint32_t>(dtype));
+        }
+        case DTYPE_UINT16: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::uint16_t>(dtype));
+        }
+        case DTYPE_UINT8: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::uint8_t>(dtype));
+        }
+        case DTYPE_FLOAT64: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<double>(dtype));
+        }
+        case DTYPE_FLOAT32: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<float>(dtype));
+        }
+        case DTYPE_TIME: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<std::int64_t>(dtype));
+        }
+        case DTYPE_BOOL: {
+            return std::unique_ptr<t_column_index>(new t_sorted_index<bool>(dtype));
+        }
+        default: {
+            PSP_COMPLAIN_AND_ABORT("Cannot index column of type " + get_dtype_descr(dtype));
+        }
+    }
+    return nullptr;
+}
+
+t_column_index::~t_column_index() {}
+
+t_column_indexes::t_column_indexes()
+    : m_stale(false) {}
+
+void
+t_column_indexes::create(const std::string& colname, t_dtype dtype) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_indexes.find(colname) == m_indexes.end()) {
+        m_indexes[colname] = t_column_index::make(dtype);
+        m_stale = true;
+    }
+}
+
+bool
+t_column_indexes::has_index(const std::string& colname) const {
+    return m_indexes.find(colname) != m_indexes.end();
+}
+
+bool
+t_column_indexes::empty() const {
+    return m_indexes.empty();
+}
+
+void
+t_column_indexes::mark(t_uindex ridx) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (!m_stale) {
+        m_dirty.push_back(ridx);
+    }
+}
+
+void
+t_column_indexes::mark(const std::vector<t_uindex>& rows) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (!m_stale) {
+        m_dirty.insert(m_dirty.end(), rows.begin(), rows.end());
+    }
+}
+
+void
+t_column_indexes::invalidate() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_stale = true;
+    m_dirty.clear();
+}
+
+void
+t_column_indexes::refresh(const t_data_table& tbl) {
+    if (!m_stale && m_dirty.size() * INDEX_DIRTY_RATIO > tbl.size()) {
+        m_stale = true;
+    }
+
+    if (m_stale) {
+        for (auto& index : m_indexes) {
+            index.second->rebuild(*(tbl.get_const_column(index.first)));
+        }
+    } else if (!m_dirty.empty()) {
+        std::sort(m_dirty.begin(), m_dirty.end());
+        m_dirty.erase(std::unique(m_dirty.begin(), m_dirty.end()), m_dirty.end());
+        for (auto& index : m_indexes) {
+            index.second->update(*(tbl.get_const_column(index.first)), m_dirty);
+        }
+    }
+
+    m_stale = false;
+    m_dirty.clear();
+}
+
+bool
+t_column_indexes::filter(
+    const t_data_table& tbl, const std::vector<t_fterm>& fterms, t_mask& mask) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_indexes.empty()) {
+        return false;
+    }
+    refresh(tbl);
+
+    std::vector<t_uindex> candidates;
+    std::vector<t_uindex> rows;
+    bool narrowed = false;
+    for (const auto& fterm : fterms) {
+        auto iter = m_indexes.find(fterm.m_colname);
+        if (iter == m_indexes.end()
+            || !iter->second->lookup(*(tbl.get_const_column(fterm.m_colname)), fterm, rows)) {
+            continue;
+        }
+
+        if (narrowed) {
+            std::vector<t_uindex> both;
+            std::set_intersection(candidates.begin(), candidates.end(), rows.begin(),
+                rows.end(), std::back_inserter(both));
+            std::swap(candidates, both);
+        } else {
+            std::swap(candidates, rows);
+            narrowed = true;
+        }
+    }
+
+    if (!narrowed) {
+        return false;
+    }
+
+    mask = tbl.filter_cpp(FILTER_OP_AND, fterms, candidates);
+    return true;
+}
+
+} // end namespace perspective
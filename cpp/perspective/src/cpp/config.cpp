@@ -104,6 +104,8 @@ t_config::t_config(
     const std::vector<t_pivot>& row_pivots, const std::vector<t_aggspec>& aggregates)
     : m_row_pivots(row_pivots)
     , m_aggregates(aggregates)
+    , m_totals(TOTALS_BEFORE)
+    , m_combiner(FILTER_OP_AND)
     , m_fmode(FMODE_SIMPLE_CLAUSES) {
     setup(m_detail_columns, std::vector<std::string>{}, std::vector<std::string>{});
 }
@@ -193,9 +195,9 @@ t_config::populate_sortby(const std::vector<t_pivot>& pivots) {
     for (t_index idx = 0, loop_end = pivots.size(); idx < loop_end; ++idx) {
         const t_pivot& pivot = pivots[idx];
 
-        PSP_VERBOSE_ASSERT(
-            pivot.mode() == PIVOT_MODE_NORMAL, "Only normal pivots supported for now");
-        std::string pstr = pivot.colname();
+        PSP_VERBOSE_ASSERT(pivot.mode() == PIVOT_MODE_NORMAL || pivot.is_time_bucket(),
+            "Only normal and time bucket pivots supported for now");
+        std::string pstr = pivot.name();
         if (m_sortby.find(pstr) == m_sortby.end())
             m_sortby[pstr] = pstr;
     }
@@ -340,6 +342,9 @@ t_config::has_filters() const {
         case FMODE_SIMPLE_CLAUSES: {
             return !m_fterms.empty();
         } break;
+        case FMODE_JIT_EXPR: {
+            return true;
+        } break;
         default: { return false; }
     }
     return false;
@@ -411,4 +416,17 @@ t_config::get_fmode() const {
     return m_fmode;
 }
 
+void
+t_config::set_filter_expr(const std::string& expr, const t_schema& schema) {
+    auto filter_expr = std::make_shared<const t_filter_expr>(expr);
+    filter_expr->validate(schema);
+    m_filter_expr = filter_expr;
+    m_fmode = FMODE_JIT_EXPR;
+}
+
+std::shared_ptr<const t_filter_expr>
+t_config::get_filter_expr() const {
+    return m_filter_expr;
+}
+
 } // end namespace perspective
@@ -43,7 +43,6 @@ t_ctx_grouped_pkey::init() {
     m_tree = std::make_shared<t_stree>(pivots, m_config.get_aggregates(), m_schema, m_config);
     m_tree->init();
     m_traversal = std::shared_ptr<t_traversal>(new t_traversal(m_tree));
-    m_minmax = std::vector<t_minmax>(m_config.get_num_aggregates());
     m_init = true;
 }
 
@@ -51,6 +50,7 @@ t_index
 t_ctx_grouped_pkey::get_row_count() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_traversal->size();
 }
 
@@ -58,6 +58,7 @@ t_index
 t_ctx_grouped_pkey::get_column_count() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_config.get_num_columns() + 1;
 }
 
@@ -79,6 +80,7 @@ t_index
 t_ctx_grouped_pkey::open(t_index idx) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     // If we manually open/close a node, stop automatically expanding
     m_depth_set = false;
     m_depth = 0;
@@ -95,6 +97,7 @@ t_index
 t_ctx_grouped_pkey::close(t_index idx) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     // If we manually open/close a node, stop automatically expanding
     m_depth_set = false;
     m_depth = 0;
@@ -112,6 +115,7 @@ t_ctx_grouped_pkey::get_data(
     t_index start_row, t_index end_row, t_index start_col, t_index end_col) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     t_uindex ctx_nrows = get_row_count();
     t_uindex ncols = get_column_count();
     auto ext
@@ -194,7 +198,7 @@ void
 t_ctx_grouped_pkey::step_end() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    m_minmax = m_tree->get_min_max();
+    m_tree->refresh_min_max();
     sort_by(m_sortby);
     if (m_depth_set) {
         set_depth(m_depth);
@@ -212,6 +216,7 @@ std::vector<t_tscalar>
 t_ctx_grouped_pkey::get_row_path(t_index idx) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return ctx_get_path(m_tree, m_traversal, idx);
 }
 
@@ -226,6 +231,7 @@ std::vector<t_path>
 t_ctx_grouped_pkey::get_expansion_state() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return ctx_get_expansion_state(m_tree, m_traversal);
 }
 
@@ -240,6 +246,7 @@ void
 t_ctx_grouped_pkey::expand_path(const std::vector<t_tscalar>& path) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     ctx_expand_path(*this, HEADER_ROW, m_tree, m_traversal, path);
 }
 
@@ -254,6 +261,7 @@ t_tscalar
 t_ctx_grouped_pkey::get_tree_value(t_index nidx) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_tree->get_value(nidx);
 }
 
@@ -261,6 +269,7 @@ std::vector<t_ftreenode>
 t_ctx_grouped_pkey::get_flattened_tree(t_index idx, t_depth stop_depth) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return ctx_get_flattened_tree(idx, stop_depth, *(m_traversal.get()), m_config, m_sortby);
 }
 
@@ -268,6 +277,7 @@ std::shared_ptr<const t_traversal>
 t_ctx_grouped_pkey::get_traversal() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_traversal;
 }
 
@@ -288,6 +298,7 @@ void
 t_ctx_grouped_pkey::set_depth(t_depth depth) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     t_depth final_depth = std::min<t_depth>(m_config.get_num_rpivots() - 1, depth);
     t_index retval = 0;
     retval = m_traversal->set_depth(m_sortby, final_depth);
@@ -300,6 +311,7 @@ std::vector<t_tscalar>
 t_ctx_grouped_pkey::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
 
     if (!m_traversal->validate_cells(cells)) {
         std::vector<t_tscalar> rval;
@@ -345,6 +357,7 @@ t_ctx_grouped_pkey::get_cell_data(
     const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     if (!m_traversal->validate_cells(cells)) {
         std::vector<t_tscalar> rval;
         return rval;
@@ -405,13 +418,15 @@ std::vector<t_minmax>
 t_ctx_grouped_pkey::get_min_max() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    return m_minmax;
+    resume();
+    return m_tree->get_min_max();
 }
 
 t_stepdelta
 t_ctx_grouped_pkey::get_step_delta(t_index bidx, t_index eidx) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     bidx = std::min(bidx, t_index(m_traversal->size()));
     eidx = std::min(eidx, t_index(m_traversal->size()));
 
@@ -424,6 +439,7 @@ std::vector<t_cellupd>
 t_ctx_grouped_pkey::get_cell_delta(t_index bidx, t_index eidx) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     eidx = std::min(eidx, t_index(m_traversal->size()));
     std::vector<t_cellupd> rval;
     const auto& deltas = m_tree->get_deltas();
@@ -440,11 +456,29 @@ t_ctx_grouped_pkey::get_cell_delta(t_index bidx, t_index eidx) const {
 
 void
 t_ctx_grouped_pkey::reset() {
+    m_pending.clear();
     auto pivots = m_config.get_row_pivots();
     m_tree = std::make_shared<t_stree>(pivots, m_config.get_aggregates(), m_schema, m_config);
     m_tree->init();
     m_tree->set_deltas_enabled(get_feature_state(CTX_FEAT_DELTA));
+    m_tree->set_minmax_enabled(get_feature_state(CTX_FEAT_MINMAX));
     m_traversal = std::shared_ptr<t_traversal>(new t_traversal(m_tree));
+    m_sketches.clear();
+}
+
+void
+t_ctx_grouped_pkey::rebuild_from_state() {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    auto expanded = get_expansion_state();
+    auto flattened = m_state->get_pkeyed_table();
+    reset();
+    if (flattened->size() > 0) {
+        step_begin();
+        notify(*flattened);
+        step_end();
+    }
+    set_expansion_state(expanded);
 }
 
 void
@@ -469,6 +503,7 @@ bool
 t_ctx_grouped_pkey::has_deltas() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return true;
 }
 
@@ -476,6 +511,7 @@ t_minmax
 t_ctx_grouped_pkey::get_agg_min_max(t_uindex aggidx, t_depth depth) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_tree->get_agg_min_max(aggidx, depth);
 }
 
@@ -508,6 +544,9 @@ t_ctx_grouped_pkey::rebuild() {
 
     reset();
 
+    // Every notify rebuilds, so the sketches are refilled from the filtered rows
+    m_sketches.add_rows(*tbl, nullptr);
+
     t_uindex nrows = child_col->size();
 
     if (nrows == 0) {
@@ -712,6 +751,7 @@ t_ctx_grouped_pkey::get_column_dtype(t_uindex idx) const {
 
 std::vector<t_tscalar>
 t_ctx_grouped_pkey::unity_get_row_data(t_uindex idx) const {
+    resume();
     auto rval = get_data(idx, idx + 1, 0, get_column_count());
     if (rval.empty())
         return std::vector<t_tscalar>();
@@ -721,27 +761,32 @@ t_ctx_grouped_pkey::unity_get_row_data(t_uindex idx) const {
 
 std::vector<t_tscalar>
 t_ctx_grouped_pkey::unity_get_column_data(t_uindex idx) const {
+    resume();
     PSP_COMPLAIN_AND_ABORT("Not implemented");
     return std::vector<t_tscalar>();
 }
 
 std::vector<t_tscalar>
 t_ctx_grouped_pkey::unity_get_row_path(t_uindex idx) const {
+    resume();
     return get_row_path(idx);
 }
 
 std::vector<t_tscalar>
 t_ctx_grouped_pkey::unity_get_column_path(t_uindex idx) const {
+    resume();
     return std::vector<t_tscalar>();
 }
 
 t_uindex
 t_ctx_grouped_pkey::unity_get_row_depth(t_uindex ridx) const {
+    resume();
     return m_traversal->get_depth(ridx);
 }
 
 t_uindex
 t_ctx_grouped_pkey::unity_get_column_depth(t_uindex cidx) const {
+    resume();
     return 0;
 }
 
@@ -772,16 +817,19 @@ t_ctx_grouped_pkey::unity_get_column_count() const {
 
 t_uindex
 t_ctx_grouped_pkey::unity_get_row_count() const {
+    resume();
     return get_row_count();
 }
 
 bool
 t_ctx_grouped_pkey::unity_get_row_expanded(t_uindex idx) const {
+    resume();
     return m_traversal->get_node_expanded(idx);
 }
 
 bool
 t_ctx_grouped_pkey::unity_get_column_expanded(t_uindex idx) const {
+    resume();
     return false;
 }
 
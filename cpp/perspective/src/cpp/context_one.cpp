@@ -34,7 +34,6 @@ t_ctx1::init() {
     m_tree = std::make_shared<t_stree>(pivots, m_config.get_aggregates(), m_schema, m_config);
     m_tree->init();
     m_traversal = std::shared_ptr<t_traversal>(new t_traversal(m_tree));
-    m_minmax = std::vector<t_minmax>(m_config.get_num_aggregates());
     m_init = true;
 }
 
@@ -42,6 +41,7 @@ t_index
 t_ctx1::get_row_count() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_traversal->size();
 }
 
@@ -49,6 +49,7 @@ t_index
 t_ctx1::get_column_count() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_config.get_num_aggregates() + 1;
 }
 
@@ -70,6 +71,7 @@ t_index
 t_ctx1::open(t_index idx) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     // If we manually open/close a node, stop automatically expanding
     m_depth_set = false;
     m_depth = 0;
@@ -86,6 +88,7 @@ t_index
 t_ctx1::close(t_index idx) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     // If we manually open/close a node, stop automatically expanding
     m_depth_set = false;
     m_depth = 0;
@@ -102,6 +105,7 @@ std::vector<t_tscalar>
 t_ctx1::get_data(t_index start_row, t_index end_row, t_index start_col, t_index end_col) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     t_uindex ctx_nrows = get_row_count();
     t_uindex ncols = get_column_count();
     auto ext
@@ -159,6 +163,7 @@ std::vector<t_tscalar>
 t_ctx1::get_data(const std::vector<t_uindex>& rows) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     t_uindex nrows = rows.size();
     t_uindex ncols = get_column_count();
 
@@ -216,9 +221,17 @@ t_ctx1::notify(const t_data_table& flattened, const t_data_table& delta,
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     psp_log_time(repr() + " notify.enter");
+    bool has_filters = m_config.has_filters();
+    std::pair<t_mask, t_mask> masks;
+    if (has_filters) {
+        masks = m_filter_cache.filter(m_config, *m_state, flattened, prev, current, existed);
+    }
     notify_sparse_tree(m_tree, m_traversal, true, m_config.get_aggregates(),
         m_config.get_sortby_pairs(), m_sortby, flattened, delta, prev, current, transitions,
-        existed, m_config, *m_state);
+        existed, m_config, *m_state, has_filters ? &masks.first : nullptr,
+        has_filters ? &masks.second : nullptr);
+    update_sketches(flattened, prev, current, existed, has_filters ? &masks.first : nullptr,
+        has_filters ? &masks.second : nullptr);
     psp_log_time(repr() + " notify.exit");
 }
 
@@ -233,8 +246,18 @@ void
 t_ctx1::step_end() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    m_minmax = m_tree->get_min_max();
-    sort_by(m_sortby);
+
+    // Only sibling sets touched by this step can be out of order; updates
+    // reaching most of the traversal go through the parallel full sort.
+    auto updated = m_tree->get_updated_nodes();
+    if (!m_sortby.empty() && updated.size() < m_traversal->size() / 2) {
+        m_traversal->resort_nodes(m_sortby, *m_tree, updated);
+    } else {
+        sort_by(m_sortby);
+    }
+
+    m_tree->refresh_min_max();
+
     if (m_depth_set) {
         set_depth(m_depth);
     }
@@ -271,6 +294,7 @@ std::vector<t_tscalar>
 t_ctx1::get_row_path(t_index idx) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     if (idx < 0)
         return std::vector<t_tscalar>();
     return ctx_get_path(m_tree, m_traversal, idx);
@@ -285,19 +309,25 @@ t_ctx1::reset_sortby() {
 
 void
 t_ctx1::sort_by(const std::vector<t_sortspec>& sortby) {
+    sort_by(sortby, INVALID_INDEX);
+}
+
+void
+t_ctx1::sort_by(const std::vector<t_sortspec>& sortby, t_index viewport_end) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_sortby = sortby;
     if (m_sortby.empty()) {
         return;
     }
-    m_traversal->sort_by(m_config, sortby, *(m_tree.get()));
+    m_traversal->sort_by(m_config, sortby, *(m_tree.get()), nullptr, viewport_end);
 }
 
 void
 t_ctx1::set_depth(t_depth depth) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     if (m_config.get_num_rpivots() == 0)
         return;
     depth = std::min<t_depth>(m_config.get_num_rpivots() - 1, depth);
@@ -312,6 +342,7 @@ std::vector<t_tscalar>
 t_ctx1::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
 
     if (!m_traversal->validate_cells(cells)) {
         std::vector<t_tscalar> rval;
@@ -333,6 +364,7 @@ std::vector<t_tscalar>
 t_ctx1::get_cell_data(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     if (!m_traversal->validate_cells(cells)) {
         std::vector<t_tscalar> rval;
         return rval;
@@ -398,7 +430,8 @@ std::vector<t_minmax>
 t_ctx1::get_min_max() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    return m_minmax;
+    resume();
+    return m_tree->get_min_max();
 }
 
 /**
@@ -412,6 +445,7 @@ t_stepdelta
 t_ctx1::get_step_delta(t_index bidx, t_index eidx) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     bidx = std::min(bidx, t_index(m_traversal->size()));
     eidx = std::min(eidx, t_index(m_traversal->size()));
 
@@ -431,6 +465,7 @@ t_rowdelta
 t_ctx1::get_row_delta() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     std::vector<t_uindex> rows = get_rows_changed();
     std::vector<t_tscalar> data = get_data(rows);
     t_rowdelta rval(m_rows_changed, rows.size(), data);
@@ -440,6 +475,7 @@ t_ctx1::get_row_delta() {
 
 std::vector<t_uindex>
 t_ctx1::get_rows_changed() {
+    resume();
     std::vector<t_uindex> rows;
     const auto& deltas = m_tree->get_deltas();
     t_uindex eidx = t_uindex(m_traversal->size());
@@ -461,6 +497,7 @@ std::vector<t_cellupd>
 t_ctx1::get_cell_delta(t_index bidx, t_index eidx) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     eidx = std::min(eidx, t_index(m_traversal->size()));
     std::vector<t_cellupd> rval;
     const auto& deltas = m_tree->get_deltas();
@@ -477,11 +514,29 @@ t_ctx1::get_cell_delta(t_index bidx, t_index eidx) const {
 
 void
 t_ctx1::reset() {
+    m_pending.clear();
     auto pivots = m_config.get_row_pivots();
     m_tree = std::make_shared<t_stree>(pivots, m_config.get_aggregates(), m_schema, m_config);
     m_tree->init();
     m_tree->set_deltas_enabled(get_feature_state(CTX_FEAT_DELTA));
+    m_tree->set_minmax_enabled(get_feature_state(CTX_FEAT_MINMAX));
     m_traversal = std::shared_ptr<t_traversal>(new t_traversal(m_tree));
+    m_sketches.clear();
+}
+
+void
+t_ctx1::rebuild_from_state() {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    auto expanded = ctx_get_expansion_state(m_tree, m_traversal);
+    auto flattened = m_state->get_pkeyed_table();
+    reset();
+    if (flattened->size() > 0) {
+        step_begin();
+        notify(*flattened);
+        step_end();
+    }
+    ctx_set_expansion_state(*this, HEADER_ROW, m_tree, m_traversal, expanded);
 }
 
 void
@@ -511,6 +566,7 @@ bool
 t_ctx1::has_deltas() const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_tree->has_deltas();
 }
 
@@ -518,6 +574,7 @@ t_minmax
 t_ctx1::get_agg_min_max(t_uindex aggidx, t_depth depth) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
     return m_tree->get_agg_min_max(aggidx, depth);
 }
 
@@ -525,8 +582,15 @@ void
 t_ctx1::notify(const t_data_table& flattened) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    bool has_filters = m_config.has_filters();
+    t_mask msk;
+    if (has_filters) {
+        msk = m_filter_cache.filter(m_config, *m_state, flattened);
+    }
     notify_sparse_tree(m_tree, m_traversal, true, m_config.get_aggregates(),
-        m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_state);
+        m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_state,
+        has_filters ? &msk : nullptr);
+    m_sketches.add_rows(flattened, has_filters ? &msk : nullptr);
 }
 
 void
@@ -573,6 +637,7 @@ t_ctx1::pprint() const {
 
 t_index
 t_ctx1::get_row_idx(const std::vector<t_tscalar>& path) const {
+    resume();
     auto nidx = m_tree->resolve_path(0, path);
     if (nidx == INVALID_INDEX) {
         return nidx;
@@ -590,11 +655,13 @@ t_ctx1::get_column_dtype(t_uindex idx) const {
 
 t_depth
 t_ctx1::get_trav_depth(t_index idx) const {
+    resume();
     return m_traversal->get_depth(idx);
 }
 
 std::vector<t_tscalar>
 t_ctx1::unity_get_row_data(t_uindex idx) const {
+    resume();
     auto rval = get_data(idx, idx + 1, 0, get_column_count());
     if (rval.empty())
         return std::vector<t_tscalar>();
@@ -604,27 +671,32 @@ t_ctx1::unity_get_row_data(t_uindex idx) const {
 
 std::vector<t_tscalar>
 t_ctx1::unity_get_column_data(t_uindex idx) const {
+    resume();
     PSP_COMPLAIN_AND_ABORT("Not implemented");
     return std::vector<t_tscalar>();
 }
 
 std::vector<t_tscalar>
 t_ctx1::unity_get_row_path(t_uindex idx) const {
+    resume();
     return get_row_path(idx);
 }
 
 std::vector<t_tscalar>
 t_ctx1::unity_get_column_path(t_uindex idx) const {
+    resume();
     return std::vector<t_tscalar>();
 }
 
 t_uindex
 t_ctx1::unity_get_row_depth(t_uindex ridx) const {
+    resume();
     return m_traversal->get_depth(ridx);
 }
 
 t_uindex
 t_ctx1::unity_get_column_depth(t_uindex cidx) const {
+    resume();
     return 0;
 }
 
@@ -665,16 +737,19 @@ t_ctx1::unity_get_column_count() const {
 
 t_uindex
 t_ctx1::unity_get_row_count() const {
+    resume();
     return get_row_count();
 }
 
 bool
 t_ctx1::unity_get_row_expanded(t_uindex idx) const {
+    resume();
     return m_traversal->get_node_expanded(idx);
 }
 
 bool
 t_ctx1::unity_get_column_expanded(t_uindex idx) const {
+    resume();
     return false;
 }
 
@@ -688,6 +763,7 @@ t_ctx1::unity_init_load_step_end() {}
 
 std::shared_ptr<t_data_table>
 t_ctx1::get_table() const {
+    resume();
     auto schema = m_tree->get_aggtable()->get_schema();
     auto pivots = m_config.get_row_pivots();
     auto tbl = std::make_shared<t_data_table>(schema, m_tree->size());
@@ -700,7 +776,7 @@ t_ctx1::get_table() const {
 
     std::stringstream ss;
     for (const auto& c : pivots) {
-        pivcols.push_back(tbl->add_column(c.colname(), m_schema.get_dtype(c.colname()), true));
+        pivcols.push_back(tbl->add_column(c.name(), m_schema.get_dtype(c.colname()), true));
     }
 
     auto idx = 0;
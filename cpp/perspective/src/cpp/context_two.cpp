@@ -69,7 +69,8 @@ t_ctx2::init() {
     m_rtraversal = std::make_shared<t_traversal>(rtree());
 
     m_ctraversal = std::make_shared<t_traversal>(ctree());
-    m_minmax = std::vector<t_minmax>(m_config.get_num_aggregates());
+    m_cell_keys.resize(m_trees.size());
+    init_aggcols();
     m_init = true;
 }
 
@@ -80,7 +81,9 @@ t_ctx2::step_begin() {
 
 void
 t_ctx2::step_end() {
-    m_minmax = m_trees.back()->get_min_max();
+    for (auto& tree : m_trees) {
+        tree->refresh_min_max();
+    }
     if (m_row_depth_set) {
         set_depth(HEADER_ROW, m_row_depth);
     }
@@ -91,16 +94,19 @@ t_ctx2::step_end() {
 
 t_index
 t_ctx2::get_row_count() const {
+    resume();
     return m_rtraversal->size();
 }
 
 t_index
 t_ctx2::get_column_count() const {
+    resume();
     return get_num_view_columns();
 }
 
 t_index
 t_ctx2::open(t_header header, t_index idx) {
+    resume();
     t_index retval;
 
     if (header == HEADER_ROW) {
@@ -128,6 +134,7 @@ t_ctx2::open(t_header header, t_index idx) {
 
 t_index
 t_ctx2::close(t_header header, t_index idx) {
+    resume();
     t_index retval;
 
     switch (header) {
@@ -157,11 +164,13 @@ t_ctx2::close(t_header header, t_index idx) {
 
 t_totals
 t_ctx2::get_totals() const {
+    resume();
     return m_config.get_totals();
 }
 
 std::vector<t_index>
 t_ctx2::get_ctraversal_indices() const {
+    resume();
     switch (m_config.get_totals()) {
         case TOTALS_BEFORE: {
             t_index nelems = m_ctraversal->size();
@@ -194,6 +203,7 @@ t_ctx2::get_ctraversal_indices() const {
 
 std::vector<t_tscalar>
 t_ctx2::get_data(t_index start_row, t_index end_row, t_index start_col, t_index end_col) const {
+    resume();
     t_uindex ctx_nrows = get_row_count();
     t_uindex ctx_ncols = get_column_count();
     auto ext = sanitize_get_data_extents(
@@ -214,22 +224,7 @@ t_ctx2::get_data(t_index start_row, t_index end_row, t_index start_col, t_index
 
     t_tscalar empty = mknone();
 
-    typedef std::pair<t_uindex, t_uindex> t_aggpair;
-    std::map<t_aggpair, const t_column*> aggmap;
-
-    for (t_uindex treeidx = 0, tree_loop_end = m_trees.size(); treeidx < tree_loop_end;
-         ++treeidx) {
-        auto aggtable = m_trees[treeidx]->get_aggtable();
-        t_schema aggschema = aggtable->get_schema();
-
-        for (t_uindex aggidx = 0, agg_loop_end = m_config.get_num_aggregates();
-             aggidx < agg_loop_end; ++aggidx) {
-            const std::string& aggname = aggschema.m_columns[aggidx];
-
-            aggmap[t_aggpair(treeidx, aggidx)] = aggtable->get_const_column(aggname).get();
-        }
-    }
-
+    t_uindex naggs = m_config.get_num_aggregates();
     const std::vector<t_aggspec>& aggspecs = m_config.get_aggregates();
 
     for (t_index ridx = ext.m_srow; ridx < ext.m_erow; ++ridx) {
@@ -245,7 +240,7 @@ t_ctx2::get_data(t_index start_row, t_index end_row, t_index start_col, t_index
             if (cinfo.m_idx < 0) {
                 retval[insert_idx].set(empty);
             } else {
-                auto aggcol = aggmap[t_aggpair(cinfo.m_treenum, cinfo.m_agg_index)];
+                auto aggcol = m_aggcols[cinfo.m_treenum * naggs + cinfo.m_agg_index];
 
                 t_index p_idx = m_trees[cinfo.m_treenum]->get_parent_idx(cinfo.m_idx);
 
@@ -271,6 +266,7 @@ t_ctx2::get_data(t_index start_row, t_index end_row, t_index start_col, t_index
 
 std::vector<t_tscalar>
 t_ctx2::get_data(const std::vector<t_uindex>& rows) const {
+    resume();
     t_uindex nrows = rows.size();
     t_uindex ncols = get_column_count();
 
@@ -287,22 +283,7 @@ t_ctx2::get_data(const std::vector<t_uindex>& rows) const {
 
     t_tscalar empty = mknone();
 
-    typedef std::pair<t_uindex, t_uindex> t_aggpair;
-    std::map<t_aggpair, const t_column*> aggmap;
-
-    for (t_uindex treeidx = 0, tree_loop_end = m_trees.size(); treeidx < tree_loop_end;
-         ++treeidx) {
-        auto aggtable = m_trees[treeidx]->get_aggtable();
-        t_schema aggschema = aggtable->get_schema();
-
-        for (t_uindex aggidx = 0, agg_loop_end = m_config.get_num_aggregates();
-             aggidx < agg_loop_end; ++aggidx) {
-            const std::string& aggname = aggschema.m_columns[aggidx];
-
-            aggmap[t_aggpair(treeidx, aggidx)] = aggtable->get_const_column(aggname).get();
-        }
-    }
-
+    t_uindex naggs = m_config.get_num_aggregates();
     const std::vector<t_aggspec>& aggspecs = m_config.get_aggregates();
 
     for (t_uindex idx = 0; idx < nrows; ++idx) {
@@ -313,7 +294,7 @@ t_ctx2::get_data(const std::vector<t_uindex>& rows) const {
             if (cinfo.m_idx < 0) {
                 retval[insert_idx].set(empty);
             } else {
-                auto aggcol = aggmap[t_aggpair(cinfo.m_treenum, cinfo.m_agg_index)];
+                auto aggcol = m_aggcols[cinfo.m_treenum * naggs + cinfo.m_agg_index];
 
                 t_index p_idx = m_trees[cinfo.m_treenum]->get_parent_idx(cinfo.m_idx);
 
@@ -346,13 +327,18 @@ t_ctx2::column_sort_by(const std::vector<t_sortspec>& sortby) {
 
 void
 t_ctx2::sort_by(const std::vector<t_sortspec>& sortby) {
+    sort_by(sortby, INVALID_INDEX);
+}
+
+void
+t_ctx2::sort_by(const std::vector<t_sortspec>& sortby, t_index viewport_end) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_sortby = sortby;
     if (m_sortby.empty()) {
         return;
     }
-    m_rtraversal->sort_by(m_config, sortby, *(rtree().get()), this);
+    m_rtraversal->sort_by(m_config, sortby, *(rtree().get()), this, viewport_end);
 }
 
 void
@@ -367,23 +353,36 @@ t_ctx2::notify(const t_data_table& flattened, const t_data_table& delta,
     const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
     const t_data_table& existed) {
     psp_log_time(repr() + " notify.enter");
+
+    // Filtered once for every tree
+    bool has_filters = m_config.has_filters();
+    std::pair<t_mask, t_mask> masks;
+    if (has_filters) {
+        masks = m_filter_cache.filter(m_config, *m_state, flattened, prev, current, existed);
+    }
+    const t_mask* msk_prev = has_filters ? &masks.first : nullptr;
+    const t_mask* msk_curr = has_filters ? &masks.second : nullptr;
+
     for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end; ++tree_idx) {
         if (is_rtree_idx(tree_idx)) {
             notify_sparse_tree(rtree(), m_rtraversal, true, m_config.get_aggregates(),
                 m_config.get_sortby_pairs(), m_row_sortby, flattened, delta, prev, current,
-                transitions, existed, m_config, *m_state);
+                transitions, existed, m_config, *m_state, msk_prev, msk_curr);
         } else if (is_ctree_idx(tree_idx)) {
             notify_sparse_tree(ctree(), m_ctraversal, true, m_config.get_aggregates(),
                 m_config.get_sortby_pairs(), m_column_sortby, flattened, delta, prev, current,
-                transitions, existed, m_config, *m_state);
+                transitions, existed, m_config, *m_state, msk_prev, msk_curr);
         } else {
             notify_sparse_tree(m_trees[tree_idx], std::shared_ptr<t_traversal>(0), false,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
                 std::vector<t_sortspec>(), flattened, delta, prev, current, transitions,
-                existed, m_config, *m_state);
+                existed, m_config, *m_state, msk_prev, msk_curr);
         }
     }
 
+    prune_cell_index();
+    update_sketches(flattened, prev, current, existed, msk_prev, msk_curr);
+
     if (!m_sortby.empty()) {
         sort_by(m_sortby);
     }
@@ -416,15 +415,6 @@ t_ctx2::resolve_cells(const std::vector<std::pair<t_uindex, t_uindex>>& cells) c
     t_index n_aggs = m_config.get_num_aggregates();
     std::vector<t_index> c_tvindices = get_ctraversal_indices();
 
-    std::vector<std::vector<t_tscalar>> col_paths(m_ctraversal->size());
-
-    for (t_index cidx = 0, loop_end = c_tvindices.size(); cidx < loop_end; ++cidx) {
-        auto translated = c_tvindices[cidx];
-        const t_tvnode& c_tvnode = m_ctraversal->get_node(translated);
-        col_paths[cidx].reserve(m_config.get_num_cpivots());
-        col_paths[cidx] = get_column_path(c_tvnode);
-    }
-
     t_uindex ncols = get_num_view_columns();
 
     for (t_index idx = 0, loop_end = cells.size(); idx < loop_end; ++idx) {
@@ -439,7 +429,6 @@ t_ctx2::resolve_cells(const std::vector<std::pair<t_uindex, t_uindex>>& cells) c
 
         t_index r_ptidx = r_tvnode.m_tnid;
         t_depth r_depth = r_tvnode.m_depth;
-        std::vector<t_tscalar> r_path = get_row_path(r_tvnode);
         t_index agg_idx = (cell.second - 1) % n_aggs;
         t_uindex translated_cidx = calc_translated_colidx(n_aggs, cell.second);
         if (translated_cidx >= c_tvindices.size()) {
@@ -459,34 +448,103 @@ t_ctx2::resolve_cells(const std::vector<std::pair<t_uindex, t_uindex>>& cells) c
 
         const t_tvnode& c_tvnode = m_ctraversal->get_node(c_tvidx);
         t_index c_ptidx = c_tvnode.m_tnid;
-        const std::vector<t_tscalar>& c_path = col_paths[translated_cidx];
 
         rval[idx].m_agg_index = agg_idx;
 
         if (cell.first == 0) {
             rval[idx].m_idx = c_ptidx;
             rval[idx].m_treenum = 0;
-        } else if (c_path.size() == 0) {
+        } else if (c_ptidx == 0) {
             rval[idx].m_idx = r_ptidx;
             rval[idx].m_treenum = m_trees.size() - 1;
         } else {
-            t_index tree_idx = r_depth;
-            rval[idx].m_treenum = tree_idx;
+            rval[idx].m_treenum = r_depth;
+            rval[idx].m_idx = resolve_cell_node(r_ptidx, r_tvnode, c_ptidx, c_tvnode);
+        }
+    }
 
-            if (r_depth + 1 == static_cast<t_depth>(m_trees.size())) {
-                rval[idx].m_idx = m_trees[tree_idx]->resolve_path(r_ptidx, c_path);
-            } else {
-                t_index path_ptidx = m_trees[tree_idx]->resolve_path(0, r_path);
-                if (path_ptidx < 0) {
-                    rval[idx].m_idx = INVALID_INDEX;
-                } else {
-                    rval[idx].m_idx = m_trees[tree_idx]->resolve_path(path_ptidx, c_path);
-                }
+    return rval;
+}
+
+// Looks up the node for a (row, column) pair in m_cell_index, resolving and
+// recording it on a miss. Missing cells are not recorded, as a later update
+// may create them.
+t_index
+t_ctx2::resolve_cell_node(t_index r_ptidx, const t_tvnode& r_tvnode, t_index c_ptidx,
+    const t_tvnode& c_tvnode) const {
+    auto key = std::make_pair(r_ptidx, c_ptidx);
+    {
+        std::lock_guard<std::mutex> lg(m_cell_index_mtx);
+        auto iter = m_cell_index.find(key);
+        if (iter != m_cell_index.end()) {
+            return iter->second.m_idx;
+        }
+    }
+
+    t_depth tree_idx = r_tvnode.m_depth;
+    std::vector<t_tscalar> c_path = get_column_path(c_tvnode);
+    t_index nidx;
+
+    if (tree_idx + 1 == static_cast<t_depth>(m_trees.size())) {
+        nidx = m_trees[tree_idx]->resolve_path(r_ptidx, c_path);
+    } else {
+        std::vector<t_tscalar> r_path = get_row_path(r_tvnode);
+        t_index path_ptidx = m_trees[tree_idx]->resolve_path(0, r_path);
+        nidx = path_ptidx < 0 ? INVALID_INDEX
+                              : m_trees[tree_idx]->resolve_path(path_ptidx, c_path);
+    }
+
+    if (nidx == INVALID_INDEX) {
+        return nidx;
+    }
+
+    t_ctx2_cell cell;
+    cell.m_treenum = tree_idx;
+    cell.m_idx = nidx;
+    std::lock_guard<std::mutex> lg(m_cell_index_mtx);
+    m_cell_index.insert(std::make_pair(key, cell));
+    m_cell_keys[tree_idx][nidx] = key;
+    return nidx;
+}
+
+// Drops cached cells whose node this update removed. Removing a row or
+// column node removes the nodes of all its cells, and node ids are never
+// reused, so every other entry stays valid.
+void
+t_ctx2::prune_cell_index() {
+    std::lock_guard<std::mutex> lg(m_cell_index_mtx);
+    for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end; ++tree_idx) {
+        t_ctx2_cell_keys& keys = m_cell_keys[tree_idx];
+        if (keys.empty()) {
+            continue;
+        }
+
+        for (t_uindex nidx : m_trees[tree_idx]->get_dropped_nodes()) {
+            auto iter = keys.find(nidx);
+            if (iter != keys.end()) {
+                m_cell_index.erase(iter->second);
+                keys.erase(iter);
             }
         }
     }
+}
 
-    return rval;
+void
+t_ctx2::init_aggcols() {
+    t_uindex naggs = m_config.get_num_aggregates();
+    m_aggcols.clear();
+    m_aggcols.reserve(m_trees.size() * naggs);
+
+    for (t_uindex treeidx = 0, tree_loop_end = m_trees.size(); treeidx < tree_loop_end;
+         ++treeidx) {
+        auto aggtable = m_trees[treeidx]->get_aggtable();
+        t_schema aggschema = aggtable->get_schema();
+
+        for (t_uindex aggidx = 0; aggidx < naggs; ++aggidx) {
+            const std::string& aggname = aggschema.m_columns[aggidx];
+            m_aggcols.push_back(aggtable->get_const_column(aggname).get());
+        }
+    }
 }
 
 t_index
@@ -546,6 +604,7 @@ t_ctx2::get_num_view_columns() const {
 
 std::vector<t_tscalar>
 t_ctx2::get_row_path(t_index idx) const {
+    resume();
     if (idx < 0)
         return std::vector<t_tscalar>();
     return ctx_get_path(rtree(), m_rtraversal, idx);
@@ -553,6 +612,7 @@ t_ctx2::get_row_path(t_index idx) const {
 
 std::vector<t_tscalar>
 t_ctx2::get_row_path(const t_tvnode& node) const {
+    resume();
     std::vector<t_tscalar> rval;
     m_trees.back()->get_path(node.m_tnid, rval);
     return rval;
@@ -560,6 +620,7 @@ t_ctx2::get_row_path(const t_tvnode& node) const {
 
 std::vector<t_tscalar>
 t_ctx2::get_column_path(t_index idx) const {
+    resume();
     if (idx < 0)
         return std::vector<t_tscalar>();
     return ctx_get_path(ctree(), m_ctraversal, idx);
@@ -567,6 +628,7 @@ t_ctx2::get_column_path(t_index idx) const {
 
 std::vector<t_tscalar>
 t_ctx2::get_column_path(const t_tvnode& node) const {
+    resume();
     std::vector<t_tscalar> rval;
     m_trees[0]->get_path(node.m_tnid, rval);
     return rval;
@@ -574,6 +636,7 @@ t_ctx2::get_column_path(const t_tvnode& node) const {
 
 std::vector<t_tscalar>
 t_ctx2::get_column_path_userspace(t_index idx) const {
+    resume();
     t_index translated_idx = translate_column_index(idx);
     if (translated_idx == INVALID_INDEX) {
         return std::vector<t_tscalar>();
@@ -623,6 +686,7 @@ t_ctx2::get_aggregate_name(t_uindex idx) const {
 
 void
 t_ctx2::set_depth(t_header header, t_depth depth) {
+    resume();
     t_depth new_depth;
 
     switch (header) {
@@ -648,6 +712,7 @@ t_ctx2::set_depth(t_header header, t_depth depth) {
 
 std::vector<t_tscalar>
 t_ctx2::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
+    resume();
     tsl::hopscotch_set<t_tscalar> all_pkeys;
 
     auto tree_info = resolve_cells(cells);
@@ -668,6 +733,7 @@ t_ctx2::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const
 
 std::vector<t_tscalar>
 t_ctx2::get_cell_data(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
+    resume();
     std::vector<t_tscalar> rval(cells.size());
     t_tscalar empty;
     empty.set(std::int64_t(0));
@@ -695,6 +761,7 @@ t_ctx2::get_cell_data(const std::vector<std::pair<t_uindex, t_uindex>>& cells) c
  */
 t_stepdelta
 t_ctx2::get_step_delta(t_index bidx, t_index eidx) {
+    resume();
     t_uindex start_row = bidx;
     t_uindex end_row = eidx;
     t_uindex start_col = 1;
@@ -744,6 +811,7 @@ t_ctx2::get_step_delta(t_index bidx, t_index eidx) {
  */
 t_rowdelta
 t_ctx2::get_row_delta() {
+    resume();
     std::vector<t_uindex> rows = get_rows_changed();
     std::vector<t_tscalar> data = get_data(rows);
     t_rowdelta rval(true, rows.size(), data);
@@ -753,6 +821,7 @@ t_ctx2::get_row_delta() {
 
 std::vector<t_uindex>
 t_ctx2::get_rows_changed() {
+    resume();
     t_uindex nrows = get_row_count();
     t_uindex ncols = get_num_view_columns();
     std::vector<t_uindex> rows;
@@ -784,11 +853,13 @@ t_ctx2::get_rows_changed() {
 
 std::vector<t_minmax>
 t_ctx2::get_min_max() const {
-    return m_minmax;
+    resume();
+    return m_trees.back()->get_min_max();
 }
 
 void
 t_ctx2::reset() {
+    m_pending.clear();
     for (t_uindex treeidx = 0, tree_loop_end = m_trees.size(); treeidx < tree_loop_end;
          ++treeidx) {
         std::vector<t_pivot> pivots;
@@ -804,10 +875,32 @@ t_ctx2::reset() {
             = std::make_shared<t_stree>(pivots, m_config.get_aggregates(), m_schema, m_config);
         m_trees[treeidx]->init();
         m_trees[treeidx]->set_deltas_enabled(get_feature_state(CTX_FEAT_DELTA));
+        m_trees[treeidx]->set_minmax_enabled(get_feature_state(CTX_FEAT_MINMAX));
     }
 
     m_rtraversal = std::make_shared<t_traversal>(rtree());
     m_ctraversal = std::make_shared<t_traversal>(ctree());
+    m_cell_index.clear();
+    m_cell_keys.assign(m_trees.size(), t_ctx2_cell_keys());
+    init_aggcols();
+    m_sketches.clear();
+}
+
+void
+t_ctx2::rebuild_from_state() {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    auto expanded_rows = ctx_get_expansion_state(rtree(), m_rtraversal);
+    auto expanded_cols = ctx_get_expansion_state(ctree(), m_ctraversal);
+    auto flattened = m_state->get_pkeyed_table();
+    reset();
+    if (flattened->size() > 0) {
+        step_begin();
+        notify(*flattened);
+        step_end();
+    }
+    ctx_set_expansion_state(*this, HEADER_ROW, rtree(), m_rtraversal, expanded_rows);
+    ctx_set_expansion_state(*this, HEADER_COLUMN, ctree(), m_ctraversal, expanded_cols);
 }
 
 bool
@@ -870,6 +963,7 @@ t_ctx2::get_trees() {
 
 bool
 t_ctx2::has_deltas() const {
+    resume();
     bool has_deltas = false;
     for (t_uindex idx = 0, loop_end = m_trees.size(); idx < loop_end; ++idx) {
         has_deltas = has_deltas || m_trees[idx]->has_deltas();
@@ -879,19 +973,31 @@ t_ctx2::has_deltas() const {
 
 void
 t_ctx2::notify(const t_data_table& flattened) {
+    bool has_filters = m_config.has_filters();
+    t_mask msk;
+    if (has_filters) {
+        msk = m_filter_cache.filter(m_config, *m_state, flattened);
+    }
+    const t_mask* msk_ptr = has_filters ? &msk : nullptr;
+
     for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end; ++tree_idx) {
         if (is_rtree_idx(tree_idx)) {
             notify_sparse_tree(rtree(), m_rtraversal, true, m_config.get_aggregates(),
-                m_config.get_sortby_pairs(), m_row_sortby, flattened, m_config, *m_state);
+                m_config.get_sortby_pairs(), m_row_sortby, flattened, m_config, *m_state,
+                msk_ptr);
         } else if (is_ctree_idx(tree_idx)) {
             notify_sparse_tree(ctree(), m_ctraversal, true, m_config.get_aggregates(),
-                m_config.get_sortby_pairs(), m_column_sortby, flattened, m_config, *m_state);
+                m_config.get_sortby_pairs(), m_column_sortby, flattened, m_config, *m_state,
+                msk_ptr);
         } else {
             notify_sparse_tree(m_trees[tree_idx], std::shared_ptr<t_traversal>(0), false,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
-                std::vector<t_sortspec>(), flattened, m_config, *m_state);
+                std::vector<t_sortspec>(), flattened, m_config, *m_state, msk_ptr);
         }
     }
+
+    prune_cell_index();
+    m_sketches.add_rows(flattened, msk_ptr);
 }
 
 void
@@ -909,6 +1015,7 @@ t_ctx2::get_column_dtype(t_uindex idx) const {
 
 std::vector<t_tscalar>
 t_ctx2::unity_get_row_data(t_uindex idx) const {
+    resume();
     auto rval = get_data(idx, idx + 1, 0, get_column_count());
     if (rval.empty())
         return std::vector<t_tscalar>();
@@ -918,28 +1025,33 @@ t_ctx2::unity_get_row_data(t_uindex idx) const {
 
 std::vector<t_tscalar>
 t_ctx2::unity_get_column_data(t_uindex idx) const {
+    resume();
     PSP_COMPLAIN_AND_ABORT("Not implemented");
     return std::vector<t_tscalar>();
 }
 
 std::vector<t_tscalar>
 t_ctx2::unity_get_row_path(t_uindex idx) const {
+    resume();
     return get_row_path(idx);
 }
 
 std::vector<t_tscalar>
 t_ctx2::unity_get_column_path(t_uindex idx) const {
+    resume();
     auto rv = get_column_path_userspace(idx);
     return rv;
 }
 
 t_uindex
 t_ctx2::unity_get_row_depth(t_uindex idx) const {
+    resume();
     return get_row_path(idx).size();
 }
 
 t_uindex
 t_ctx2::unity_get_column_depth(t_uindex idx) const {
+    resume();
     return get_column_path(idx).size();
 }
 
@@ -984,16 +1096,19 @@ t_ctx2::unity_get_column_count() const {
 
 t_uindex
 t_ctx2::unity_get_row_count() const {
+    resume();
     return get_row_count();
 }
 
 bool
 t_ctx2::unity_get_row_expanded(t_uindex idx) const {
+    resume();
     return m_rtraversal->get_node_expanded(idx);
 }
 
 bool
 t_ctx2::unity_get_column_expanded(t_uindex idx) const {
+    resume();
 
     return m_ctraversal->get_node_expanded(
         calc_translated_colidx(idx, m_config.get_num_aggregates()));
@@ -90,11 +90,13 @@ t_ctx0::step_end() {
 // ASGGrid data interface
 t_index
 t_ctx0::get_row_count() const {
+    resume();
     return m_traversal->size();
 }
 
 t_index
 t_ctx0::get_column_count() const {
+    resume();
     return m_config.get_num_columns();
 }
 
@@ -110,6 +112,7 @@ t_ctx0::get_column_count() const {
  */
 std::vector<t_tscalar>
 t_ctx0::get_data(t_index start_row, t_index end_row, t_index start_col, t_index end_col) const {
+    resume();
     t_uindex ctx_nrows = get_row_count();
     t_uindex ctx_ncols = get_column_count();
     auto ext = sanitize_get_data_extents(
@@ -149,6 +152,7 @@ t_ctx0::get_data(t_index start_row, t_index end_row, t_index start_col, t_index
  */
 std::vector<t_tscalar>
 t_ctx0::get_data(const std::vector<t_uindex>& rows) const {
+    resume();
     t_uindex stride = get_column_count();
     std::vector<t_tscalar> values(rows.size() * stride);
     std::vector<t_tscalar> pkeys = m_traversal->get_pkeys(rows);
@@ -207,6 +211,7 @@ t_ctx0::init() {
 
 std::vector<t_tscalar>
 t_ctx0::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
+    resume();
     if (!m_traversal->validate_cells(cells)) {
         std::vector<t_tscalar> rval;
         return rval;
@@ -225,6 +230,7 @@ t_ctx0::get_all_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) c
 
 std::vector<t_tscalar>
 t_ctx0::get_cell_data(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
+    resume();
     if (!m_traversal->validate_cells(cells)) {
         std::vector<t_tscalar> rval;
         return rval;
@@ -261,6 +267,7 @@ t_ctx0::get_cell_data(const std::vector<std::pair<t_uindex, t_uindex>>& cells) c
  */
 std::vector<t_cellupd>
 t_ctx0::get_cell_delta(t_index bidx, t_index eidx) const {
+    resume();
     tsl::hopscotch_set<t_tscalar> pkeys;
     t_tscalar prev_pkey;
     prev_pkey.set(t_none());
@@ -327,6 +334,7 @@ t_ctx0::get_cell_delta(t_index bidx, t_index eidx) const {
  */
 t_stepdelta
 t_ctx0::get_step_delta(t_index bidx, t_index eidx) {
+    resume();
     bidx = std::min(bidx, m_traversal->size());
     eidx = std::min(eidx, m_traversal->size());
     bool rows_changed = m_rows_changed || !m_traversal->empty_sort_by();
@@ -344,6 +352,7 @@ t_ctx0::get_step_delta(t_index bidx, t_index eidx) {
  */
 t_rowdelta
 t_ctx0::get_row_delta() {
+    resume();
     bool rows_changed = m_rows_changed || !m_traversal->empty_sort_by();
     tsl::hopscotch_set<t_tscalar> pkeys = get_delta_pkeys();
     std::vector<t_uindex> rows = m_traversal->get_row_indices(pkeys);
@@ -356,6 +365,7 @@ t_ctx0::get_row_delta() {
 
 const tsl::hopscotch_set<t_tscalar>&
 t_ctx0::get_delta_pkeys() const {
+    resume();
     return m_delta_pkeys;
 }
 
@@ -371,10 +381,25 @@ t_ctx0::get_sort_by() const {
 
 void
 t_ctx0::reset() {
+    m_pending.clear();
     m_traversal->reset();
     m_deltas = std::make_shared<t_zcdeltas>();
     m_minmax = std::vector<t_minmax>(m_config.get_num_columns());
     m_has_delta = false;
+    m_sketches.clear();
+}
+
+void
+t_ctx0::rebuild_from_state() {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    auto flattened = m_state->get_pkeyed_table();
+    reset();
+    if (flattened->size() > 0) {
+        step_begin();
+        notify(*flattened);
+        step_end();
+    }
 }
 
 t_index
@@ -408,20 +433,20 @@ t_ctx0::notify(const t_data_table& flattened, const t_data_table& delta,
 
     bool delete_encountered = false;
     if (m_config.has_filters()) {
-        t_mask msk_prev = filter_table_for_config(prev, m_config);
-        t_mask msk_curr = filter_table_for_config(curr, m_config);
+        auto masks = m_filter_cache.filter(m_config, *m_state, flattened, prev, curr, existed);
+        const t_mask& msk_prev = masks.first;
+        const t_mask& msk_curr = masks.second;
 
         for (t_uindex idx = 0; idx < nrecs; ++idx) {
             t_tscalar pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx));
 
             std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
             t_op op = static_cast<t_op>(op_);
-            bool existed = *(existed_col->get_nth<bool>(idx));
 
             switch (op) {
                 case OP_INSERT: {
                     bool filter_curr = msk_curr.get(idx);
-                    bool filter_prev = msk_prev.get(idx) && existed;
+                    bool filter_prev = msk_prev.get(idx);
 
                     if (filter_prev) {
                         if (filter_curr) {
@@ -447,6 +472,8 @@ t_ctx0::notify(const t_data_table& flattened, const t_data_table& delta,
         }
         psp_log_time(repr() + " notify.has_filter_path.updated_traversal");
 
+        update_sketches(flattened, prev, curr, existed, &msk_prev, &msk_curr);
+
         // calculate deltas
         calc_step_delta(flattened, prev, curr, transitions);
         m_has_delta = m_deltas->size() > 0 || m_delta_pkeys.size() > 0 || delete_encountered;
@@ -483,6 +510,8 @@ t_ctx0::notify(const t_data_table& flattened, const t_data_table& delta,
 
     psp_log_time(repr() + " notify.no_filter_path.updated_traversal");
 
+    update_sketches(flattened, prev, curr, existed, nullptr, nullptr);
+
     // calculate deltas
     calc_step_delta(flattened, prev, curr, transitions);
     m_has_delta = m_deltas->size() > 0 || m_delta_pkeys.size() > 0 || delete_encountered;
@@ -506,7 +535,7 @@ t_ctx0::notify(const t_data_table& flattened) {
     m_has_delta = true;
 
     if (m_config.has_filters()) {
-        t_mask msk = filter_table_for_config(flattened, m_config);
+        t_mask msk = m_filter_cache.filter(m_config, *m_state, flattened);
 
         for (t_uindex idx = 0; idx < nrecs; ++idx) {
             t_tscalar pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx));
@@ -524,6 +553,7 @@ t_ctx0::notify(const t_data_table& flattened) {
                 } break;
             }
         }
+        m_sketches.add_rows(flattened, &msk);
         return;
     }
 
@@ -538,6 +568,7 @@ t_ctx0::notify(const t_data_table& flattened) {
             } break;
             default: { } break; }
     }
+    m_sketches.add_rows(flattened, nullptr);
 }
 
 void
@@ -594,6 +625,7 @@ t_ctx0::add_delta_pkey(t_tscalar pkey) {
 
 std::vector<t_minmax>
 t_ctx0::get_min_max() const {
+    resume();
     return m_minmax;
 }
 
@@ -629,6 +661,7 @@ t_ctx0::get_trees() {
 
 bool
 t_ctx0::has_deltas() const {
+    resume();
     return m_has_delta;
 }
 
@@ -650,32 +683,38 @@ t_ctx0::get_column_dtype(t_uindex idx) const {
 
 std::vector<t_tscalar>
 t_ctx0::unity_get_row_data(t_uindex idx) const {
+    resume();
     return get_data(idx, idx + 1, 0, get_column_count());
 }
 
 std::vector<t_tscalar>
 t_ctx0::unity_get_column_data(t_uindex idx) const {
+    resume();
     PSP_COMPLAIN_AND_ABORT("Not implemented");
     return std::vector<t_tscalar>();
 }
 
 std::vector<t_tscalar>
 t_ctx0::unity_get_row_path(t_uindex idx) const {
+    resume();
     return std::vector<t_tscalar>(mktscalar(idx));
 }
 
 std::vector<t_tscalar>
 t_ctx0::unity_get_column_path(t_uindex idx) const {
+    resume();
     return std::vector<t_tscalar>();
 }
 
 t_uindex
 t_ctx0::unity_get_row_depth(t_uindex ridx) const {
+    resume();
     return 0;
 }
 
 t_uindex
 t_ctx0::unity_get_column_depth(t_uindex cidx) const {
+    resume();
     return 0;
 }
 
@@ -706,16 +745,19 @@ t_ctx0::unity_get_column_count() const {
 
 t_uindex
 t_ctx0::unity_get_row_count() const {
+    resume();
     return get_row_count();
 }
 
 bool
 t_ctx0::unity_get_row_expanded(t_uindex idx) const {
+    resume();
     return false;
 }
 
 bool
 t_ctx0::unity_get_column_expanded(t_uindex idx) const {
+    resume();
     return false;
 }
 
@@ -0,0 +1,518 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/csv.h>
+#include <perspective/column.h>
+#include <perspective/parallel.h>
+#include <perspective/time.h>
+#include <tsl/hopscotch_map.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+namespace perspective {
+
+// Kinds of value seen in a column while inferring its type
+static const std::uint8_t CSV_SEEN_INT = 1;
+static const std::uint8_t CSV_SEEN_FLOAT = 2;
+static const std::uint8_t CSV_SEEN_BOOL = 4;
+static const std::uint8_t CSV_SEEN_TIME = 8;
+static const std::uint8_t CSV_SEEN_STR = 16;
+
+static bool
+csv_parse_number(const std::string& s, double& out) {
+    const char* bptr = s.c_str();
+    char* eptr = nullptr;
+    out = std::strtod(bptr, &eptr);
+    if (eptr == bptr) {
+        return false;
+    }
+    while (*eptr == ' ' || *eptr == '\t') {
+        ++eptr;
+    }
+    return *eptr == '\0' && std::isfinite(out);
+}
+
+static bool
+csv_parse_bool(const std::string& s, bool& out) {
+    std::string lower(s);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    out = lower == "true";
+    return out || lower == "false";
+}
+
+static std::int64_t
+csv_tm_to_ms(const std::tm& t) {
+    return to_gmtime(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min,
+               t.tm_sec)
+        * 1000;
+}
+
+// Mirrors `infer_type` in the JS binding, except that every integer which
+// fits in 32 bits counts as one: the whole column is scanned, so a leading
+// zero or a large id cannot be mistaken for the column's type.
+static std::uint8_t
+csv_classify(const std::string& s, const t_date_parser& parser) {
+    double fval;
+    if (csv_parse_number(s, fval)) {
+        bool integral = std::fmod(fval, 1.0) == 0.0
+            && fval >= std::numeric_limits<std::int32_t>::min()
+            && fval <= std::numeric_limits<std::int32_t>::max();
+        return integral ? CSV_SEEN_INT : CSV_SEEN_FLOAT;
+    }
+
+    std::tm t = {};
+    if (parser.parse(s, t)) {
+        return CSV_SEEN_TIME;
+    }
+
+    bool bval;
+    if (csv_parse_bool(s, bval)) {
+        return CSV_SEEN_BOOL;
+    }
+
+    return CSV_SEEN_STR;
+}
+
+static t_dtype
+csv_resolve_dtype(std::uint8_t seen) {
+    switch (seen) {
+        case CSV_SEEN_INT:
+            return DTYPE_INT32;
+        case CSV_SEEN_FLOAT:
+        case CSV_SEEN_INT | CSV_SEEN_FLOAT:
+            return DTYPE_FLOAT64;
+        case CSV_SEEN_BOOL:
+            return DTYPE_BOOL;
+        case CSV_SEEN_TIME:
+            return DTYPE_TIME;
+        default:
+            // Empty and mixed columns load as strings
+            return DTYPE_STR;
+    }
+}
+
+t_csv_options::t_csv_options()
+    : m_delimiter(',')
+    , m_quote('"')
+    , m_chunk_size(1 << 20) {}
+
+t_csv_reader::t_csv_reader(std::string text, const t_csv_options& options)
+    : m_text(std::move(text))
+    , m_options(options)
+    , m_header(0, 0) {
+    find_rows();
+    infer_schema();
+}
+
+const t_schema&
+t_csv_reader::get_schema() const {
+    return m_schema;
+}
+
+t_uindex
+t_csv_reader::num_rows() const {
+    return m_rows.size();
+}
+
+t_uindex
+t_csv_reader::num_batches() const {
+    t_uindex chunk_size = std::max(m_options.m_chunk_size, t_uindex(1));
+    t_uindex nchunks = (m_text.size() + chunk_size - 1) / chunk_size;
+    return std::min(std::max(nchunks, t_uindex(1)), t_uindex(m_rows.size()));
+}
+
+t_uindex
+t_csv_reader::batch_begin(t_uindex bidx) const {
+    return bidx * m_rows.size() / num_batches();
+}
+
+t_uindex
+t_csv_reader::batch_end(t_uindex bidx) const {
+    return (bidx + 1) * m_rows.size() / num_batches();
+}
+
+void
+t_csv_reader::find_rows() {
+    const char* text = m_text.data();
+    t_uindex size = m_text.size();
+    t_uindex chunk_size = std::max(m_options.m_chunk_size, t_uindex(1));
+    t_uindex nchunks = (size + chunk_size - 1) / chunk_size;
+    char quote = m_options.m_quote;
+
+    // A newline only ends a row outside quotes, so each chunk first counts
+    // its quotes to learn whether it starts inside a quoted field.
+    std::vector<t_uindex> nquotes(nchunks);
+    std::vector<std::vector<t_uindex>> newlines(nchunks);
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(nchunks), 1,
+            [&](int cidx)
+#else
+        for (t_uindex cidx = 0; cidx < nchunks; ++cidx)
+#endif
+            {
+                t_uindex bidx = cidx * chunk_size;
+                t_uindex eidx = std::min(bidx + chunk_size, size);
+                nquotes[cidx] = std::count(text + bidx, text + eidx, quote);
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+
+    std::vector<std::uint8_t> quoted(nchunks, 0);
+    for (t_uindex cidx = 1; cidx < nchunks; ++cidx) {
+        quoted[cidx] = quoted[cidx - 1] ^ (nquotes[cidx - 1] & 1);
+    }
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(nchunks), 1,
+            [&](int cidx)
+#else
+        for (t_uindex cidx = 0; cidx < nchunks; ++cidx)
+#endif
+            {
+                t_uindex bidx = cidx * chunk_size;
+                t_uindex eidx = std::min(bidx + chunk_size, size);
+                bool in_quote = quoted[cidx];
+                std::vector<t_uindex>& chunk_newlines = newlines[cidx];
+                for (t_uindex idx = bidx; idx < eidx; ++idx) {
+                    if (text[idx] == quote) {
+                        in_quote = !in_quote;
+                    } else if (text[idx] == '\n' && !in_quote) {
+                        chunk_newlines.push_back(idx);
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+
+    std::vector<std::pair<t_uindex, t_uindex>> rows;
+    t_uindex nnewlines = 0;
+    for (const auto& chunk_newlines : newlines) {
+        nnewlines += chunk_newlines.size();
+    }
+    rows.reserve(nnewlines + 1);
+
+    auto push_row = [&](t_uindex bidx, t_uindex eidx) {
+        if (eidx > bidx && text[eidx - 1] == '\r') {
+            --eidx;
+        }
+        if (eidx > bidx) {
+            rows.push_back(std::make_pair(bidx, eidx));
+        }
+    };
+
+    t_uindex row_begin = 0;
+    for (const auto& chunk_newlines : newlines) {
+        for (t_uindex idx : chunk_newlines) {
+            push_row(row_begin, idx);
+            row_begin = idx + 1;
+        }
+    }
+    push_row(row_begin, size);
+
+    if (rows.empty()) {
+        return;
+    }
+
+    m_header = rows.front();
+    m_rows.assign(rows.begin() + 1, rows.end());
+}
+
+void
+t_csv_reader::split_row(
+    const std::pair<t_uindex, t_uindex>& row, std::vector<t_csv_field>& fields) const {
+    const char* text = m_text.data();
+    char delimiter = m_options.m_delimiter;
+    char quote = m_options.m_quote;
+    t_uindex idx = row.first;
+    t_uindex eidx = row.second;
+
+    fields.clear();
+    while (true) {
+        t_csv_field field = {idx, idx, false};
+        if (idx < eidx && text[idx] == quote) {
+            // A doubled quote inside a quoted field is an escaped quote
+            field.m_begin = ++idx;
+            while (idx < eidx) {
+                if (text[idx] == quote) {
+                    if (idx + 1 < eidx && text[idx + 1] == quote) {
+                        field.m_escaped = true;
+                        idx += 2;
+                        continue;
+                    }
+                    break;
+                }
+                ++idx;
+            }
+            field.m_end = idx;
+            while (idx < eidx && text[idx] != delimiter) {
+                ++idx;
+            }
+        } else {
+            while (idx < eidx && text[idx] != delimiter) {
+                ++idx;
+            }
+            field.m_end = idx;
+        }
+
+        fields.push_back(field);
+        if (idx >= eidx) {
+            break;
+        }
+        ++idx;
+    }
+}
+
+std::string
+t_csv_reader::field_str(const t_csv_field& field) const {
+    std::string value(m_text.data() + field.m_begin, field.m_end - field.m_begin);
+    if (field.m_escaped) {
+        char quote = m_options.m_quote;
+        t_uindex widx = 0;
+        for (t_uindex ridx = 0; ridx < value.size(); ++ridx, ++widx) {
+            value[widx] = value[ridx];
+            if (value[ridx] == quote) {
+                ++ridx;
+            }
+        }
+        value.resize(widx);
+    }
+    return value;
+}
+
+void
+t_csv_reader::infer_schema() {
+    if (m_header.first == m_header.second) {
+        return;
+    }
+
+    std::vector<t_csv_field> fields;
+    split_row(m_header, fields);
+
+    std::vector<std::string> names;
+    for (const auto& field : fields) {
+        names.push_back(field_str(field));
+    }
+
+    t_uindex ncols = names.size();
+    t_uindex nbatches = num_batches();
+    std::vector<std::vector<std::uint8_t>> seen(
+        nbatches, std::vector<std::uint8_t>(ncols, 0));
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(nbatches), 1,
+            [&](int bidx)
+#else
+        for (t_uindex bidx = 0; bidx < nbatches; ++bidx)
+#endif
+            {
+                std::vector<t_csv_field> row_fields;
+                std::vector<std::uint8_t>& batch_seen = seen[bidx];
+                for (t_uindex ridx = batch_begin(bidx), loop_end = batch_end(bidx);
+                     ridx < loop_end; ++ridx) {
+                    split_row(m_rows[ridx], row_fields);
+                    t_uindex nfields = std::min(ncols, t_uindex(row_fields.size()));
+                    for (t_uindex cidx = 0; cidx < nfields; ++cidx) {
+                        const t_csv_field& field = row_fields[cidx];
+                        if (field.m_begin == field.m_end
+                            || (batch_seen[cidx] & CSV_SEEN_STR)) {
+                            continue;
+                        }
+                        batch_seen[cidx] |= csv_classify(field_str(field), m_date_parser);
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+
+    std::vector<t_dtype> types(ncols);
+    for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
+        std::uint8_t column_seen = 0;
+        for (const auto& batch_seen : seen) {
+            column_seen |= batch_seen[cidx];
+        }
+        types[cidx] = csv_resolve_dtype(column_seen);
+    }
+
+    m_schema = t_schema(names, types);
+}
+
+void
+t_csv_reader::fill(t_data_table& tbl) const {
+    const std::vector<std::string>& names = m_schema.columns();
+    std::vector<t_dtype> types = m_schema.types();
+    t_uindex ncols = names.size();
+    t_uindex nrows = m_rows.size();
+    t_uindex nbatches = num_batches();
+
+    std::vector<t_column*> columns(ncols);
+    for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
+        PSP_VERBOSE_ASSERT(tbl.get_schema().get_dtype(names[cidx]) == types[cidx],
+            "CSV column type does not match table");
+        columns[cidx] = tbl.get_column(names[cidx]).get();
+    }
+
+    if (tbl.size() < nrows) {
+        tbl.extend(nrows);
+    }
+
+    // String columns first store a code into their batch's distinct values;
+    // the codes are translated to vocabulary indices once every batch is done.
+    std::vector<std::vector<std::vector<std::string>>> distinct(
+        nbatches, std::vector<std::vector<std::string>>(ncols));
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(nbatches), 1,
+            [&](int bidx)
+#else
+        for (t_uindex bidx = 0; bidx < nbatches; ++bidx)
+#endif
+            {
+                std::vector<t_csv_field> row_fields;
+                std::vector<tsl::hopscotch_map<std::string, t_uindex>> codes(ncols);
+                std::vector<std::vector<std::string>>& batch_distinct = distinct[bidx];
+                for (t_uindex ridx = batch_begin(bidx), loop_end = batch_end(bidx);
+                     ridx < loop_end; ++ridx) {
+                    split_row(m_rows[ridx], row_fields);
+                    for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
+                        t_column* col = columns[cidx];
+                        if (cidx >= row_fields.size()
+                            || row_fields[cidx].m_begin == row_fields[cidx].m_end) {
+                            col->clear(ridx);
+                            continue;
+                        }
+
+                        std::string value = field_str(row_fields[cidx]);
+                        switch (types[cidx]) {
+                            case DTYPE_INT32: {
+                                double fval = std::strtod(value.c_str(), nullptr);
+                                col->set_nth<std::int32_t>(
+                                    ridx, static_cast<std::int32_t>(fval));
+                            } break;
+                            case DTYPE_FLOAT64: {
+                                col->set_nth<double>(
+                                    ridx, std::strtod(value.c_str(), nullptr));
+                            } break;
+                            case DTYPE_BOOL: {
+                                bool bval = false;
+                                csv_parse_bool(value, bval);
+                                col->set_nth<bool>(ridx, bval);
+                            } break;
+                            case DTYPE_TIME: {
+                                std::tm t = {};
+                                m_date_parser.parse(value, t);
+                                col->set_nth<std::int64_t>(ridx, csv_tm_to_ms(t));
+                            } break;
+                            case DTYPE_STR: {
+                                auto iter = codes[cidx].find(value);
+                                t_uindex code;
+                                if (iter == codes[cidx].end()) {
+                                    code = batch_distinct[cidx].size();
+                                    codes[cidx].insert(std::make_pair(value, code));
+                                    batch_distinct[cidx].push_back(value);
+                                } else {
+                                    code = iter->second;
+                                }
+                                col->set_nth<t_uindex>(ridx, code);
+                            } break;
+                            default: {
+                                PSP_COMPLAIN_AND_ABORT("Unexpected CSV column type");
+                            }
+                        }
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+
+    // Each column's vocabulary is only touched by one task
+    std::vector<std::vector<std::vector<t_uindex>>> xlate(
+        ncols, std::vector<std::vector<t_uindex>>(nbatches));
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(ncols), 1,
+            [&](int cidx)
+#else
+        for (t_uindex cidx = 0; cidx < ncols; ++cidx)
+#endif
+            {
+                if (types[cidx] == DTYPE_STR) {
+                    t_column* col = columns[cidx];
+                    for (t_uindex bidx = 0; bidx < nbatches; ++bidx) {
+                        for (const std::string& value : distinct[bidx][cidx]) {
+                            xlate[cidx][bidx].push_back(col->get_interned(value));
+                        }
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(nbatches), 1,
+            [&](int bidx)
+#else
+        for (t_uindex bidx = 0; bidx < nbatches; ++bidx)
+#endif
+            {
+                for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
+                    if (types[cidx] != DTYPE_STR) {
+                        continue;
+                    }
+                    t_column* col = columns[cidx];
+                    const std::vector<t_uindex>& batch_xlate = xlate[cidx][bidx];
+                    if (batch_xlate.empty()) {
+                        continue;
+                    }
+                    for (t_uindex ridx = batch_begin(bidx), loop_end = batch_end(bidx);
+                         ridx < loop_end; ++ridx) {
+                        if (col->is_status_enabled()
+                            && *(col->get_nth_status(ridx)) != STATUS_VALID) {
+                            continue;
+                        }
+                        t_uindex* code = col->get_nth<t_uindex>(ridx);
+                        *code = batch_xlate[*code];
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+}
+
+std::shared_ptr<t_data_table>
+t_csv_reader::read() const {
+    auto tbl = std::make_shared<t_data_table>(m_schema);
+    tbl->init();
+    fill(*tbl);
+    return tbl;
+}
+
+} // end namespace perspective
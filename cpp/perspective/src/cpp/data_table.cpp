@@ -258,7 +258,27 @@ t_data_table::flatten() const {
     std::shared_ptr<t_data_table> flattened = std::make_shared<t_data_table>(
         "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
     flattened->init();
-    flatten_body<std::shared_ptr<t_data_table>>(flattened);
+    flatten_body<std::shared_ptr<t_data_table>>(flattened, {this});
+    return flattened;
+}
+
+std::shared_ptr<t_data_table>
+t_data_table::flatten(const std::vector<std::shared_ptr<t_data_table>>& rest) const {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(is_pkey_table(), "Not a pkeyed table");
+
+    std::vector<const t_data_table*> frags{this};
+    for (const auto& tbl : rest) {
+        if (tbl->size() > 0) {
+            frags.push_back(tbl.get());
+        }
+    }
+
+    std::shared_ptr<t_data_table> flattened = std::make_shared<t_data_table>(
+        "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
+    flattened->init();
+    flatten_body<std::shared_ptr<t_data_table>>(flattened, frags);
     return flattened;
 }
 
@@ -400,15 +420,31 @@ t_data_table::clear() {
 }
 
 t_mask
-t_data_table::filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterms_) const {
+t_data_table::filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterms) const {
+    return _filter_cpp(combiner, fterms, nullptr);
+}
+
+t_mask
+t_data_table::filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterms,
+    const std::vector<t_uindex>& rows) const {
+    return _filter_cpp(combiner, fterms, &rows);
+}
+
+t_mask
+t_data_table::_filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterms_,
+    const std::vector<t_uindex>* rows) const {
     auto self = const_cast<t_data_table*>(this);
     auto fterms = fterms_;
 
     t_mask mask(size());
+    t_uindex nrows = rows ? rows->size() : size();
     t_uindex fterm_size = fterms.size();
     std::vector<t_uindex> indices(fterm_size);
     std::vector<const t_column*> columns(fterm_size);
 
+    // IN and NOT IN terms test membership in a hash set of stored values
+    std::vector<std::unique_ptr<t_fterm_bag>> bags(fterm_size);
+
     for (t_uindex idx = 0; idx < fterm_size; ++idx) {
         indices[idx] = m_schema.get_colidx(fterms[idx].m_colname);
         columns[idx] = get_const_column(fterms[idx].m_colname).get();
@@ -419,13 +455,17 @@ t_data_table::filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterm
             auto interned = col->get_interned(thr.get_char_ptr());
             thr.set(interned);
         }
+        if (fterms[idx].m_op == FILTER_OP_IN || fterms[idx].m_op == FILTER_OP_NOT_IN) {
+            bags[idx].reset(new t_fterm_bag(fterms[idx], *columns[idx]));
+        }
     }
 
     switch (combiner) {
         case FILTER_OP_AND: {
             t_tscalar cell_val;
 
-            for (t_uindex ridx = 0, rloop_end = size(); ridx < rloop_end; ++ridx) {
+            for (t_uindex idx = 0, rloop_end = nrows; idx < rloop_end; ++idx) {
+                t_uindex ridx = rows ? (*rows)[idx] : idx;
                 bool pass = true;
 
                 for (t_uindex cidx = 0; cidx < fterm_size; ++cidx) {
@@ -435,6 +475,11 @@ t_data_table::filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterm
                     const auto& ft = fterms[cidx];
                     bool tval;
 
+                    if (bags[cidx]) {
+                        pass = bags[cidx]->is_valid(ridx) && (*bags[cidx])(ridx, true);
+                        continue;
+                    }
+
                     if (ft.m_use_interned) {
                         cell_val.set(*(columns[cidx]->get_nth<t_uindex>(ridx)));
                         tval = ft(cell_val);
@@ -453,9 +498,18 @@ t_data_table::filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fterm
             }
         } break;
         case FILTER_OP_OR: {
-            for (t_uindex ridx = 0, rloop_end = size(); ridx < rloop_end; ++ridx) {
+            for (t_uindex idx = 0, rloop_end = nrows; idx < rloop_end; ++idx) {
+                t_uindex ridx = rows ? (*rows)[idx] : idx;
                 bool pass = false;
                 for (t_uindex cidx = 0; cidx < fterm_size; ++cidx) {
+                    if (bags[cidx]) {
+                        if ((*bags[cidx])(ridx, bags[cidx]->is_valid(ridx))) {
+                            pass = true;
+                            break;
+                        }
+                        continue;
+                    }
+
                     t_tscalar cell_val = columns[cidx]->get_scalar(ridx);
                     if (fterms[cidx](cell_val)) {
                         pass = true;
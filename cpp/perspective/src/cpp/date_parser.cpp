@@ -29,6 +29,12 @@ t_date_parser::t_date_parser() {}
 
 bool
 t_date_parser::is_valid(std::string const& datestring) {
+    std::tm t = {};
+    return parse(datestring, t);
+}
+
+bool
+t_date_parser::parse(std::string const& datestring, std::tm& out) const {
     for (const std::string& fmt : VALID_FORMATS) {
         if (fmt != "") {
             std::tm t = {};
@@ -36,6 +42,7 @@ t_date_parser::is_valid(std::string const& datestring) {
             ss.imbue(std::locale::classic());
             ss >> std::get_time(&t, fmt.c_str());
             if (!ss.fail()) {
+                out = t;
                 return true;
             }
         }
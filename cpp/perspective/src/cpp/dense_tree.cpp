@@ -78,7 +78,7 @@ t_dtree::init() {
     m_sortby_dpthcol.push_back("");
 
     for (t_uindex idx = 0, loop_end = m_pivots.size(); idx < loop_end; ++idx) {
-        auto colname = m_pivots[idx].colname();
+        auto colname = m_pivots[idx].name();
         t_lstore_recipe leaf_args(
             m_dirname, values_colname(colname), DEFAULT_CAPACITY, m_backing_store);
 
@@ -180,7 +180,7 @@ t_dtree::pivot(const t_filter& filter, t_uindex level) {
             m_levels.push_back(std::pair<t_uindex, t_uindex>(nbidx, neidx));
         } else {
             const t_pivot& pivot = m_pivots[pidx - 1];
-            std::string pivot_colname = pivot.colname();
+            std::string pivot_colname = pivot.name();
             pivcol = m_ds->get_const_column(pivot_colname).get();
             t_dtype piv_dtype = pivcol->get_dtype();
 
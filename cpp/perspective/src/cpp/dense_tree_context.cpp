@@ -238,7 +238,7 @@ t_dtree_ctx::pprint_strands_tree() const {
 
     for (const auto& piv : m_tree.get_pivots()) {
         columns.push_back(t_colname_cptr_pair(
-            piv.colname(), m_strands->get_const_column(piv.colname()).get()));
+            piv.name(), m_strands->get_const_column(piv.name()).get()));
     }
 
     for (auto dptidx : m_tree.dfs()) {
@@ -1341,20 +1341,20 @@ namespace binding {
         t_schema output_schema(column_names, data_types); // names + types might have been mutated at this point after implicit index removal
 
         std::uint32_t row_count = accessor["row_count"].as<std::int32_t>();
-        t_data_table data_table(output_schema);
-        data_table.init();
-        data_table.extend(row_count);
+        auto data_table = std::make_shared<t_data_table>(output_schema);
+        data_table->init();
+        data_table->extend(row_count);
         
         // write data at the correct row        
-        _fill_data(data_table, accessor, input_schema, index, offset, limit, is_arrow, is_update);
+        _fill_data(*data_table, accessor, input_schema, index, offset, limit, is_arrow, is_update);
 
         if (!computed.isUndefined()) {
             // re-add computed columns after update, delete, etc.
-            table_add_computed_column(data_table, computed);
+            table_add_computed_column(*data_table, computed);
         }
 
         // calculate offset, limit, and set the gnode
-        tbl->init(data_table, row_count, op);
+        tbl->init(std::move(data_table), row_count, op);
         return tbl;
     }
 
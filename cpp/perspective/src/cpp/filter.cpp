@@ -9,6 +9,8 @@
 
 #include <perspective/first.h>
 #include <perspective/filter.h>
+#include <perspective/column.h>
+#include <cstring>
 
 namespace perspective {
 
@@ -81,6 +83,56 @@ t_fterm::get_expr() const {
     return ss.str();
 }
 
+t_fterm_bag::t_fterm_bag(const t_fterm& fterm, const t_column& column)
+    : m_column(&column)
+    , m_base(static_cast<const std::uint8_t*>(column.data_lstore().get_ptr(0)))
+    , m_width(get_dtype_size(column.get_dtype()))
+    , m_in(fterm.m_op == FILTER_OP_IN)
+    , m_negated(fterm.m_negated) {
+    PSP_VERBOSE_ASSERT(m_width <= sizeof(std::uint64_t), "Unexpected type");
+    t_dtype dtype = column.get_dtype();
+    m_keys.reserve(fterm.m_bag.size());
+
+    for (const auto& value : fterm.m_bag) {
+        if (!value.is_valid() || value.get_dtype() != dtype) {
+            continue;
+        }
+
+        std::uint64_t key = 0;
+        if (dtype == DTYPE_STR) {
+            t_uindex interned;
+            if (!column.string_exists(value.get_char_ptr(), interned)) {
+                continue;
+            }
+            key = interned;
+        } else {
+            std::memcpy(&key, &value.m_data, m_width);
+        }
+        m_keys.insert(key);
+    }
+}
+
+bool
+t_fterm_bag::is_valid(t_uindex idx) const {
+    return !m_column->is_status_enabled() || m_column->is_valid(idx);
+}
+
+bool
+t_fterm_bag::contains(t_uindex idx) const {
+    if (m_keys.empty()) {
+        return false;
+    }
+    std::uint64_t key = 0;
+    std::memcpy(&key, m_base + idx * m_width, m_width);
+    return m_keys.find(key) != m_keys.end();
+}
+
+bool
+t_fterm_bag::operator()(t_uindex idx, bool valid) const {
+    bool rv = (valid && contains(idx)) == m_in;
+    return m_negated ? !rv : rv;
+}
+
 t_filter::t_filter()
     : m_mode(SELECT_MODE_ALL) {}
 
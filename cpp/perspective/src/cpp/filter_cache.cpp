@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/filter_cache.h>
+#include <perspective/filter_utils.h>
+#include <perspective/gnode_state.h>
+
+namespace perspective {
+
+bool
+t_filter_cache::get(t_uindex ridx) const {
+    return ridx < m_passes.size() && m_passes[ridx];
+}
+
+void
+t_filter_cache::set(t_uindex ridx, bool pass) {
+    if (ridx >= m_passes.size()) {
+        m_passes.resize(std::max(ridx + 1, 2 * m_passes.size()), 0);
+    }
+    m_passes[ridx] = pass;
+}
+
+t_mask
+t_filter_cache::filter(
+    const t_config& config, const t_gstate& gstate, const t_data_table& flattened) {
+    t_mask msk;
+
+    // The master table itself, when it has no erased rows, may be indexed
+    // or skip blocks through its zone maps
+    if (&flattened == gstate.get_table().get()
+        && (gstate.filter_indexed(config, msk) || gstate.filter_zoned(config, msk))) {
+        m_passes.assign(flattened.size(), 0);
+        for (auto idx = msk.find_first(); idx != t_mask::m_npos; idx = msk.find_next(idx)) {
+            m_passes[idx] = 1;
+        }
+        return msk;
+    }
+
+    msk = filter_table_for_config(flattened, config);
+    const t_column* pkey_col = flattened.get_const_column("psp_pkey").get();
+
+    for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
+        t_rlookup lookup = gstate.lookup(pkey_col->get_scalar(idx));
+        if (lookup.m_exists) {
+            set(lookup.m_idx, msk.get(idx));
+        }
+    }
+
+    return msk;
+}
+
+std::pair<t_mask, t_mask>
+t_filter_cache::filter(const t_config& config, const t_gstate& gstate,
+    const t_data_table& flattened, const t_data_table& prev, const t_data_table& current,
+    const t_data_table& existed) {
+    t_uindex nrows = flattened.size();
+    t_mask msk_prev(nrows);
+    t_mask msk_curr = filter_table_for_config(current, config);
+
+    const t_column* pkey_col = flattened.get_const_column("psp_pkey").get();
+    const t_column* op_col = flattened.get_const_column("psp_op").get();
+    const t_column* existed_col = existed.get_const_column("psp_existed").get();
+
+    std::vector<t_uindex> deleted;
+    for (t_uindex idx = 0; idx < nrows; ++idx) {
+        if (*(op_col->get_nth<std::uint8_t>(idx)) == OP_DELETE) {
+            deleted.push_back(idx);
+            continue;
+        }
+
+        t_rlookup lookup = gstate.lookup(pkey_col->get_scalar(idx));
+        if (!lookup.m_exists) {
+            continue;
+        }
+
+        // New rows may reuse the index, and the stale verdict, of an erased one
+        if (*(existed_col->get_nth<bool>(idx)) && get(lookup.m_idx)) {
+            msk_prev.set(idx);
+        }
+        set(lookup.m_idx, msk_curr.get(idx));
+    }
+
+    if (!deleted.empty()) {
+        t_mask msk_deleted = filter_table_for_config(prev, config);
+        for (auto idx : deleted) {
+            msk_prev.set(idx, msk_deleted.get(idx));
+        }
+    }
+
+    return std::make_pair(msk_prev, msk_curr);
+}
+
+} // end namespace perspective
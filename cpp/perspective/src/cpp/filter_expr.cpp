@@ -0,0 +1,1143 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/filter_expr.h>
+#include <perspective/column.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace perspective {
+
+// Rows evaluated by each pass of the program.
+static const t_uindex EXPR_BLOCK_SIZE = 1024;
+
+enum t_expr_node_kind {
+    NODE_COLUMN,
+    NODE_NUMBER,
+    NODE_STRING,
+    NODE_BOOL,
+    NODE_UNARY,
+    NODE_BINARY,
+    NODE_IS_NULL,
+    NODE_IS_NOT_NULL
+};
+
+enum t_expr_op {
+    EXPR_OR,
+    EXPR_AND,
+    EXPR_NOT,
+    EXPR_NEG,
+    EXPR_EQ,
+    EXPR_NE,
+    EXPR_LT,
+    EXPR_LTEQ,
+    EXPR_GT,
+    EXPR_GTEQ,
+    EXPR_ADD,
+    EXPR_SUB,
+    EXPR_MUL,
+    EXPR_DIV,
+    EXPR_MOD
+};
+
+struct t_expr_node {
+    t_expr_node_kind m_kind;
+    t_expr_op m_op;
+
+    // String literal, or the name of a column
+    std::string m_str;
+
+    // Number literal, 0 or 1 for booleans, or the index of a column
+    double m_number;
+    t_uindex m_colidx;
+
+    std::unique_ptr<t_expr_node> m_lhs;
+    std::unique_ptr<t_expr_node> m_rhs;
+};
+
+enum t_expr_opcode {
+    INSTR_LOAD_NUM,
+    INSTR_LOAD_BOOL,
+    INSTR_CONST_BOOL,
+    INSTR_BOOL_TO_NUM,
+    INSTR_NEG,
+    INSTR_ARITH,
+    INSTR_CMP,
+    INSTR_STR_CMP_LITERAL,
+    INSTR_STR_CMP_COLUMN,
+    INSTR_AND,
+    INSTR_OR,
+    INSTR_NOT,
+    INSTR_IS_NULL,
+    INSTR_IS_NOT_NULL
+};
+
+/**
+ * One step of a program. Operands are registers, or for arithmetic and
+ * comparisons an immediate in place of a register index of -1. Columns are
+ * indices into t_filter_expr::get_columns.
+ */
+struct t_expr_instr {
+    t_expr_opcode m_opcode;
+    t_expr_op m_op;
+    t_index m_out;
+    t_index m_lhs;
+    t_index m_rhs;
+    double m_imm;
+    t_uindex m_colidx;
+    t_uindex m_rhs_colidx;
+    t_dtype m_dtype;
+    std::string m_literal;
+};
+
+struct t_expr_program {
+    // Types of t_filter_expr::get_columns the program was compiled for
+    std::vector<t_dtype> m_dtypes;
+    std::vector<t_expr_instr> m_instrs;
+    t_uindex m_nregs;
+    t_index m_result;
+};
+
+namespace {
+
+void
+bad_expr(const std::string& expr, const std::string& msg) {
+    throw std::invalid_argument("Bad filter expression `" + expr + "`: " + msg);
+}
+
+/******************************************************************************
+ *
+ * Parsing
+ */
+
+enum t_expr_token_type {
+    TOKEN_END,
+    TOKEN_NUMBER,
+    TOKEN_STRING,
+    TOKEN_COLUMN,
+    TOKEN_WORD,
+    TOKEN_SYMBOL
+};
+
+struct t_expr_token {
+    t_expr_token_type m_type;
+    std::string m_text;
+};
+
+class t_expr_parser {
+public:
+    t_expr_parser(const std::string& expr, std::vector<std::string>& columns)
+        : m_expr(expr)
+        , m_columns(columns)
+        , m_pos(0) {
+        advance();
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse() {
+        auto rval = parse_or();
+        if (m_token.m_type != TOKEN_END) {
+            bad_expr(m_expr, "unexpected `" + m_token.m_text + "`");
+        }
+        return rval;
+    }
+
+private:
+    void
+    advance() {
+        while (
+            m_pos < m_expr.size() && std::isspace(static_cast<unsigned char>(m_expr[m_pos]))) {
+            ++m_pos;
+        }
+
+        m_token.m_text.clear();
+        if (m_pos == m_expr.size()) {
+            m_token.m_type = TOKEN_END;
+            return;
+        }
+
+        char c = m_expr[m_pos];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* begin = m_expr.c_str() + m_pos;
+            char* end = nullptr;
+            std::strtod(begin, &end);
+            if (end == begin) {
+                bad_expr(m_expr, "bad number");
+            }
+            m_token.m_type = TOKEN_NUMBER;
+            m_token.m_text.assign(begin, end - begin);
+            m_pos += end - begin;
+        } else if (c == '\'' || c == '"') {
+            // Quotes are escaped with a backslash
+            m_token.m_type = c == '\'' ? TOKEN_STRING : TOKEN_COLUMN;
+            ++m_pos;
+            while (m_pos < m_expr.size() && m_expr[m_pos] != c) {
+                if (m_expr[m_pos] == '\\' && m_pos + 1 < m_expr.size()) {
+                    ++m_pos;
+                }
+                m_token.m_text.push_back(m_expr[m_pos++]);
+            }
+            if (m_pos == m_expr.size()) {
+                bad_expr(m_expr, "unterminated quote");
+            }
+            ++m_pos;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            t_uindex begin = m_pos;
+            while (m_pos < m_expr.size()
+                && (std::isalnum(static_cast<unsigned char>(m_expr[m_pos]))
+                    || m_expr[m_pos] == '_')) {
+                ++m_pos;
+            }
+            m_token.m_text = m_expr.substr(begin, m_pos - begin);
+
+            std::string lower = m_token.m_text;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            static const char* keywords[]
+                = {"and", "or", "not", "is", "null", "true", "false"};
+            m_token.m_type = TOKEN_COLUMN;
+            for (const char* keyword : keywords) {
+                if (lower == keyword) {
+                    m_token.m_type = TOKEN_WORD;
+                    m_token.m_text = lower;
+                }
+            }
+        } else {
+            static const char* symbols[] = {"==", "!=", "<>", "<=", ">=", "&&", "||", "(", ")",
+                "<", ">", "=", "!", "+", "-", "*", "/", "%"};
+            m_token.m_type = TOKEN_SYMBOL;
+            for (const char* symbol : symbols) {
+                if (m_expr.compare(m_pos, std::strlen(symbol), symbol) == 0) {
+                    m_token.m_text = symbol;
+                    break;
+                }
+            }
+            if (m_token.m_text.empty()) {
+                bad_expr(m_expr, std::string("unexpected `") + c + "`");
+            }
+            m_pos += m_token.m_text.size();
+        }
+    }
+
+    bool
+    accept(t_expr_token_type type, const char* text) {
+        if (m_token.m_type == type && m_token.m_text == text) {
+            advance();
+            return true;
+        }
+        return false;
+    }
+
+    void
+    expect(t_expr_token_type type, const char* text) {
+        if (!accept(type, text)) {
+            bad_expr(m_expr, std::string("expected `") + text + "`");
+        }
+    }
+
+    static std::unique_ptr<t_expr_node>
+    make_node(t_expr_node_kind kind, t_expr_op op, std::unique_ptr<t_expr_node> lhs,
+        std::unique_ptr<t_expr_node> rhs = nullptr) {
+        std::unique_ptr<t_expr_node> rval(new t_expr_node());
+        rval->m_kind = kind;
+        rval->m_op = op;
+        rval->m_number = 0;
+        rval->m_colidx = 0;
+        rval->m_lhs = std::move(lhs);
+        rval->m_rhs = std::move(rhs);
+        return rval;
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_or() {
+        auto rval = parse_and();
+        while (accept(TOKEN_WORD, "or") || accept(TOKEN_SYMBOL, "||")) {
+            rval = make_node(NODE_BINARY, EXPR_OR, std::move(rval), parse_and());
+        }
+        return rval;
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_and() {
+        auto rval = parse_not();
+        while (accept(TOKEN_WORD, "and") || accept(TOKEN_SYMBOL, "&&")) {
+            rval = make_node(NODE_BINARY, EXPR_AND, std::move(rval), parse_not());
+        }
+        return rval;
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_not() {
+        if (accept(TOKEN_WORD, "not") || accept(TOKEN_SYMBOL, "!")) {
+            return make_node(NODE_UNARY, EXPR_NOT, parse_not());
+        }
+        return parse_comparison();
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_comparison() {
+        auto rval = parse_sum();
+        if (accept(TOKEN_WORD, "is")) {
+            bool negated = accept(TOKEN_WORD, "not");
+            expect(TOKEN_WORD, "null");
+            return make_node(
+                negated ? NODE_IS_NOT_NULL : NODE_IS_NULL, EXPR_EQ, std::move(rval));
+        }
+
+        static const std::pair<const char*, t_expr_op> comparisons[] = {{"==", EXPR_EQ},
+            {"=", EXPR_EQ}, {"!=", EXPR_NE}, {"<>", EXPR_NE}, {"<", EXPR_LT},
+            {"<=", EXPR_LTEQ}, {">", EXPR_GT}, {">=", EXPR_GTEQ}};
+        for (const auto& comparison : comparisons) {
+            if (accept(TOKEN_SYMBOL, comparison.first)) {
+                return make_node(NODE_BINARY, comparison.second, std::move(rval), parse_sum());
+            }
+        }
+        return rval;
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_sum() {
+        auto rval = parse_product();
+        while (true) {
+            if (accept(TOKEN_SYMBOL, "+")) {
+                rval = make_node(NODE_BINARY, EXPR_ADD, std::move(rval), parse_product());
+            } else if (accept(TOKEN_SYMBOL, "-")) {
+                rval = make_node(NODE_BINARY, EXPR_SUB, std::move(rval), parse_product());
+            } else {
+                return rval;
+            }
+        }
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_product() {
+        auto rval = parse_unary();
+        while (true) {
+            if (accept(TOKEN_SYMBOL, "*")) {
+                rval = make_node(NODE_BINARY, EXPR_MUL, std::move(rval), parse_unary());
+            } else if (accept(TOKEN_SYMBOL, "/")) {
+                rval = make_node(NODE_BINARY, EXPR_DIV, std::move(rval), parse_unary());
+            } else if (accept(TOKEN_SYMBOL, "%")) {
+                rval = make_node(NODE_BINARY, EXPR_MOD, std::move(rval), parse_unary());
+            } else {
+                return rval;
+            }
+        }
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_unary() {
+        if (accept(TOKEN_SYMBOL, "-")) {
+            return make_node(NODE_UNARY, EXPR_NEG, parse_unary());
+        }
+        return parse_primary();
+    }
+
+    std::unique_ptr<t_expr_node>
+    parse_primary() {
+        if (accept(TOKEN_SYMBOL, "(")) {
+            auto rval = parse_or();
+            expect(TOKEN_SYMBOL, ")");
+            return rval;
+        }
+
+        auto rval = make_node(NODE_NUMBER, EXPR_EQ, nullptr);
+        switch (m_token.m_type) {
+            case TOKEN_NUMBER: {
+                rval->m_number = std::strtod(m_token.m_text.c_str(), nullptr);
+            } break;
+            case TOKEN_STRING: {
+                rval->m_kind = NODE_STRING;
+                rval->m_str = m_token.m_text;
+            } break;
+            case TOKEN_COLUMN: {
+                rval->m_kind = NODE_COLUMN;
+                rval->m_str = m_token.m_text;
+                auto iter = std::find(m_columns.begin(), m_columns.end(), m_token.m_text);
+                rval->m_colidx = iter - m_columns.begin();
+                if (iter == m_columns.end()) {
+                    m_columns.push_back(m_token.m_text);
+                }
+            } break;
+            case TOKEN_WORD: {
+                if (m_token.m_text != "true" && m_token.m_text != "false") {
+                    bad_expr(m_expr, "unexpected `" + m_token.m_text + "`");
+                }
+                rval->m_kind = NODE_BOOL;
+                rval->m_number = m_token.m_text == "true";
+            } break;
+            default: {
+                bad_expr(m_expr,
+                    m_token.m_type == TOKEN_END ? "unexpected end"
+                                                : "unexpected `" + m_token.m_text + "`");
+            }
+        }
+        advance();
+        return rval;
+    }
+
+    const std::string& m_expr;
+    std::vector<std::string>& m_columns;
+    t_uindex m_pos;
+    t_expr_token m_token;
+};
+
+/******************************************************************************
+ *
+ * Compilation
+ */
+
+enum t_expr_value_kind { VALUE_NUM, VALUE_BOOL, VALUE_STR_COLUMN, VALUE_STR_LITERAL };
+
+// Compile time view of a subexpression, either a register or a constant.
+struct t_expr_value {
+    t_expr_value_kind m_kind;
+    bool m_const;
+    t_index m_reg;
+    double m_number;
+    t_uindex m_colidx;
+    std::string m_str;
+};
+
+double
+apply_arith(t_expr_op op, double a, double b) {
+    switch (op) {
+        case EXPR_ADD: return a + b;
+        case EXPR_SUB: return a - b;
+        case EXPR_MUL: return a * b;
+        case EXPR_DIV: return a / b;
+        case EXPR_MOD: return std::fmod(a, b);
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected operator"); }
+    }
+    return 0;
+}
+
+template <typename T>
+bool
+apply_cmp(t_expr_op op, const T& a, const T& b) {
+    switch (op) {
+        case EXPR_EQ: return a == b;
+        case EXPR_NE: return a != b;
+        case EXPR_LT: return a < b;
+        case EXPR_LTEQ: return a <= b;
+        case EXPR_GT: return a > b;
+        case EXPR_GTEQ: return a >= b;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected operator"); }
+    }
+    return false;
+}
+
+// Comparison of strcmp's result against zero
+bool
+apply_str_cmp(t_expr_op op, const char* a, const char* b) {
+    return apply_cmp(op, std::strcmp(a, b), 0);
+}
+
+// Mirrors a comparison so its operands can be swapped.
+t_expr_op
+flip_cmp(t_expr_op op) {
+    switch (op) {
+        case EXPR_LT: return EXPR_GT;
+        case EXPR_LTEQ: return EXPR_GTEQ;
+        case EXPR_GT: return EXPR_LT;
+        case EXPR_GTEQ: return EXPR_LTEQ;
+        default: return op;
+    }
+}
+
+class t_expr_compiler {
+public:
+    t_expr_compiler(const std::string& expr, t_expr_program& program)
+        : m_expr(expr)
+        , m_program(program) {
+        m_program.m_nregs = 0;
+    }
+
+    t_index
+    compile_filter(const t_expr_node& root) {
+        t_expr_value value = compile(root);
+        if (value.m_kind != VALUE_BOOL) {
+            bad_expr(m_expr, "not a boolean expression");
+        }
+        return to_reg(value);
+    }
+
+private:
+    t_expr_value
+    make_value(t_expr_value_kind kind, bool is_const) {
+        t_expr_value rval;
+        rval.m_kind = kind;
+        rval.m_const = is_const;
+        rval.m_reg = -1;
+        rval.m_number = 0;
+        rval.m_colidx = 0;
+        return rval;
+    }
+
+    t_expr_instr&
+    emit(t_expr_opcode opcode, t_expr_value& out) {
+        t_expr_instr instr;
+        instr.m_opcode = opcode;
+        instr.m_op = EXPR_EQ;
+        instr.m_out = static_cast<t_index>(m_program.m_nregs++);
+        instr.m_lhs = -1;
+        instr.m_rhs = -1;
+        instr.m_imm = 0;
+        instr.m_colidx = 0;
+        instr.m_rhs_colidx = 0;
+        instr.m_dtype = DTYPE_NONE;
+        m_program.m_instrs.push_back(instr);
+        out.m_reg = instr.m_out;
+        return m_program.m_instrs.back();
+    }
+
+    // Materializes a constant into a register.
+    t_index
+    to_reg(const t_expr_value& value) {
+        if (!value.m_const) {
+            return value.m_reg;
+        }
+        t_expr_value rval = value;
+        emit(INSTR_CONST_BOOL, rval).m_imm = value.m_number;
+        return rval.m_reg;
+    }
+
+    t_expr_value
+    to_num(const t_expr_value& value) {
+        switch (value.m_kind) {
+            case VALUE_NUM: {
+                return value;
+            }
+            case VALUE_BOOL: {
+                t_expr_value rval = make_value(VALUE_NUM, value.m_const);
+                rval.m_number = value.m_number;
+                if (!value.m_const) {
+                    emit(INSTR_BOOL_TO_NUM, rval).m_lhs = value.m_reg;
+                }
+                return rval;
+            }
+            default: { bad_expr(m_expr, "strings only support comparisons"); }
+        }
+        return value;
+    }
+
+    t_expr_value
+    to_bool(const t_expr_value& value) {
+        if (value.m_kind != VALUE_BOOL) {
+            bad_expr(m_expr, "logical operators need boolean operands");
+        }
+        return value;
+    }
+
+    t_expr_value
+    compile(const t_expr_node& node) {
+        switch (node.m_kind) {
+            case NODE_NUMBER: {
+                t_expr_value rval = make_value(VALUE_NUM, true);
+                rval.m_number = node.m_number;
+                return rval;
+            }
+            case NODE_BOOL: {
+                t_expr_value rval = make_value(VALUE_BOOL, true);
+                rval.m_number = node.m_number;
+                return rval;
+            }
+            case NODE_STRING: {
+                t_expr_value rval = make_value(VALUE_STR_LITERAL, true);
+                rval.m_str = node.m_str;
+                return rval;
+            }
+            case NODE_COLUMN: {
+                return compile_column(node);
+            }
+            case NODE_IS_NULL:
+            case NODE_IS_NOT_NULL: {
+                return compile_is_null(node);
+            }
+            case NODE_UNARY: {
+                return compile_unary(node);
+            }
+            case NODE_BINARY: {
+                return compile_binary(node);
+            }
+        }
+        return make_value(VALUE_BOOL, true);
+    }
+
+    t_expr_value
+    compile_column(const t_expr_node& node) {
+        t_dtype dtype = m_program.m_dtypes[node.m_colidx];
+        switch (dtype) {
+            case DTYPE_INT64:
+            case DTYPE_INT32:
+            case DTYPE_INT16:
+            case DTYPE_INT8:
+            case DTYPE_UINT64:
+            case DTYPE_UINT32:
+            case DTYPE_UINT16:
+            case DTYPE_UINT8:
+            case DTYPE_FLOAT64:
+            case DTYPE_FLOAT32:
+            case DTYPE_TIME:
+            case DTYPE_DATE: {
+                t_expr_value rval = make_value(VALUE_NUM, false);
+                t_expr_instr& instr = emit(INSTR_LOAD_NUM, rval);
+                instr.m_colidx = node.m_colidx;
+                instr.m_dtype = dtype;
+                return rval;
+            }
+            case DTYPE_BOOL: {
+                t_expr_value rval = make_value(VALUE_BOOL, false);
+                emit(INSTR_LOAD_BOOL, rval).m_colidx = node.m_colidx;
+                return rval;
+            }
+            case DTYPE_STR: {
+                t_expr_value rval = make_value(VALUE_STR_COLUMN, false);
+                rval.m_colidx = node.m_colidx;
+                return rval;
+            }
+            default: { bad_expr(m_expr, "column `" + node.m_str + "` has no usable type"); }
+        }
+        return make_value(VALUE_NUM, true);
+    }
+
+    t_expr_value
+    compile_is_null(const t_expr_node& node) {
+        t_expr_value operand = compile(*node.m_lhs);
+        t_expr_value rval = make_value(VALUE_BOOL, operand.m_const);
+        bool is_null = node.m_kind == NODE_IS_NULL;
+        if (operand.m_const) {
+            rval.m_number = !is_null;
+            return rval;
+        }
+
+        t_expr_instr& instr = emit(is_null ? INSTR_IS_NULL : INSTR_IS_NOT_NULL, rval);
+        if (operand.m_kind == VALUE_STR_COLUMN) {
+            instr.m_colidx = operand.m_colidx;
+        } else {
+            instr.m_lhs = operand.m_reg;
+        }
+        return rval;
+    }
+
+    t_expr_value
+    compile_unary(const t_expr_node& node) {
+        t_expr_value operand = compile(*node.m_lhs);
+        if (node.m_op == EXPR_NOT) {
+            operand = to_bool(operand);
+            t_expr_value rval = make_value(VALUE_BOOL, operand.m_const);
+            rval.m_number = !operand.m_number;
+            if (!operand.m_const) {
+                emit(INSTR_NOT, rval).m_lhs = operand.m_reg;
+            }
+            return rval;
+        }
+
+        operand = to_num(operand);
+        t_expr_value rval = make_value(VALUE_NUM, operand.m_const);
+        rval.m_number = -operand.m_number;
+        if (!operand.m_const) {
+            emit(INSTR_NEG, rval).m_lhs = operand.m_reg;
+        }
+        return rval;
+    }
+
+    t_expr_value
+    compile_binary(const t_expr_node& node) {
+        t_expr_value lhs = compile(*node.m_lhs);
+        t_expr_value rhs = compile(*node.m_rhs);
+        switch (node.m_op) {
+            case EXPR_AND:
+            case EXPR_OR: {
+                return compile_logical(node.m_op, to_bool(lhs), to_bool(rhs));
+            }
+            case EXPR_EQ:
+            case EXPR_NE:
+            case EXPR_LT:
+            case EXPR_LTEQ:
+            case EXPR_GT:
+            case EXPR_GTEQ: {
+                bool lhs_str = is_str(lhs);
+                bool rhs_str = is_str(rhs);
+                if (lhs_str || rhs_str) {
+                    if (!lhs_str || !rhs_str) {
+                        bad_expr(m_expr, "strings only compare to strings");
+                    }
+                    return compile_str_cmp(node.m_op, lhs, rhs);
+                }
+                return compile_num(INSTR_CMP, VALUE_BOOL, node.m_op, to_num(lhs), to_num(rhs));
+            }
+            default: {
+                return compile_num(INSTR_ARITH, VALUE_NUM, node.m_op, to_num(lhs), to_num(rhs));
+            }
+        }
+    }
+
+    static bool
+    is_str(const t_expr_value& value) {
+        return value.m_kind == VALUE_STR_COLUMN || value.m_kind == VALUE_STR_LITERAL;
+    }
+
+    t_expr_value
+    compile_logical(t_expr_op op, const t_expr_value& lhs, const t_expr_value& rhs) {
+        if (lhs.m_const && rhs.m_const) {
+            t_expr_value rval = make_value(VALUE_BOOL, true);
+            rval.m_number = op == EXPR_AND ? lhs.m_number && rhs.m_number
+                                           : lhs.m_number || rhs.m_number;
+            return rval;
+        }
+
+        t_index lhs_reg = to_reg(lhs);
+        t_index rhs_reg = to_reg(rhs);
+        t_expr_value rval = make_value(VALUE_BOOL, false);
+        t_expr_instr& instr = emit(op == EXPR_AND ? INSTR_AND : INSTR_OR, rval);
+        instr.m_lhs = lhs_reg;
+        instr.m_rhs = rhs_reg;
+        return rval;
+    }
+
+    t_expr_value
+    compile_num(t_expr_opcode opcode, t_expr_value_kind kind, t_expr_op op,
+        const t_expr_value& lhs, const t_expr_value& rhs) {
+        t_expr_value rval = make_value(kind, lhs.m_const && rhs.m_const);
+        if (rval.m_const) {
+            rval.m_number = opcode == INSTR_CMP ? apply_cmp(op, lhs.m_number, rhs.m_number)
+                                                : apply_arith(op, lhs.m_number, rhs.m_number);
+            return rval;
+        }
+
+        t_expr_instr& instr = emit(opcode, rval);
+        instr.m_op = op;
+        instr.m_lhs = lhs.m_reg;
+        instr.m_rhs = rhs.m_reg;
+        instr.m_imm = lhs.m_const ? lhs.m_number : rhs.m_number;
+        return rval;
+    }
+
+    t_expr_value
+    compile_str_cmp(t_expr_op op, const t_expr_value& lhs, const t_expr_value& rhs) {
+        if (lhs.m_kind == VALUE_STR_LITERAL && rhs.m_kind == VALUE_STR_LITERAL) {
+            t_expr_value rval = make_value(VALUE_BOOL, true);
+            rval.m_number = apply_str_cmp(op, lhs.m_str.c_str(), rhs.m_str.c_str());
+            return rval;
+        }
+
+        t_expr_value rval = make_value(VALUE_BOOL, false);
+        if (lhs.m_kind == VALUE_STR_COLUMN && rhs.m_kind == VALUE_STR_COLUMN) {
+            t_expr_instr& instr = emit(INSTR_STR_CMP_COLUMN, rval);
+            instr.m_op = op;
+            instr.m_colidx = lhs.m_colidx;
+            instr.m_rhs_colidx = rhs.m_colidx;
+            return rval;
+        }
+
+        // Column on the left
+        bool swap = lhs.m_kind == VALUE_STR_LITERAL;
+        t_expr_instr& instr = emit(INSTR_STR_CMP_LITERAL, rval);
+        instr.m_op = swap ? flip_cmp(op) : op;
+        instr.m_colidx = swap ? rhs.m_colidx : lhs.m_colidx;
+        instr.m_literal = swap ? lhs.m_str : rhs.m_str;
+        return rval;
+    }
+
+    const std::string& m_expr;
+    t_expr_program& m_program;
+};
+
+/******************************************************************************
+ *
+ * Evaluation
+ */
+
+// Register file for one block of rows.
+struct t_expr_block {
+    t_expr_block(t_uindex nregs)
+        : m_begin(0)
+        , m_size(0)
+        , m_num(nregs * EXPR_BLOCK_SIZE)
+        , m_bool(nregs * EXPR_BLOCK_SIZE)
+        , m_valid(nregs * EXPR_BLOCK_SIZE) {}
+
+    double*
+    num(t_index reg) {
+        return m_num.data() + reg * EXPR_BLOCK_SIZE;
+    }
+
+    std::uint8_t*
+    boolean(t_index reg) {
+        return m_bool.data() + reg * EXPR_BLOCK_SIZE;
+    }
+
+    std::uint8_t*
+    valid(t_index reg) {
+        return m_valid.data() + reg * EXPR_BLOCK_SIZE;
+    }
+
+    t_uindex m_begin;
+    t_uindex m_size;
+    std::vector<double> m_num;
+    std::vector<std::uint8_t> m_bool;
+    std::vector<std::uint8_t> m_valid;
+};
+
+template <typename T>
+void
+load_num(const t_column* col, t_uindex begin, t_uindex n, double* out) {
+    const T* base = col->get_nth<T>(begin);
+    for (t_uindex idx = 0; idx < n; ++idx) {
+        out[idx] = static_cast<double>(base[idx]);
+    }
+}
+
+void
+load_num(const t_column* col, t_dtype dtype, t_uindex begin, t_uindex n, double* out) {
+    switch (dtype) {
+        case DTYPE_INT64:
+        case DTYPE_TIME: load_num<std::int64_t>(col, begin, n, out); break;
+        case DTYPE_INT32: load_num<std::int32_t>(col, begin, n, out); break;
+        case DTYPE_INT16: load_num<std::int16_t>(col, begin, n, out); break;
+        case DTYPE_INT8: load_num<std::int8_t>(col, begin, n, out); break;
+        case DTYPE_UINT64: load_num<std::uint64_t>(col, begin, n, out); break;
+        case DTYPE_UINT32:
+        case DTYPE_DATE: load_num<std::uint32_t>(col, begin, n, out); break;
+        case DTYPE_UINT16: load_num<std::uint16_t>(col, begin, n, out); break;
+        case DTYPE_UINT8: load_num<std::uint8_t>(col, begin, n, out); break;
+        case DTYPE_FLOAT64: load_num<double>(col, begin, n, out); break;
+        case DTYPE_FLOAT32: load_num<float>(col, begin, n, out); break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected type"); }
+    }
+}
+
+void
+load_valid(const t_column* col, t_uindex begin, t_uindex n, std::uint8_t* out) {
+    if (!col->is_status_enabled()) {
+        std::fill(out, out + n, 1);
+        return;
+    }
+    const t_status* status = col->get_nth_status(begin);
+    for (t_uindex idx = 0; idx < n; ++idx) {
+        out[idx] = status[idx] == STATUS_VALID;
+    }
+}
+
+// Writes `f(lhs, rhs)` and the joint validity of the operands, either of
+// which may be the instruction's immediate.
+template <typename T, typename F>
+void
+eval_binary(const t_expr_instr& instr, t_expr_block& block, T* out, F f) {
+    t_uindex n = block.m_size;
+    std::uint8_t* valid = block.valid(instr.m_out);
+    if (instr.m_lhs < 0) {
+        const double a = instr.m_imm;
+        const double* b = block.num(instr.m_rhs);
+        for (t_uindex idx = 0; idx < n; ++idx) {
+            out[idx] = f(a, b[idx]);
+        }
+        std::copy(block.valid(instr.m_rhs), block.valid(instr.m_rhs) + n, valid);
+    } else if (instr.m_rhs < 0) {
+        const double* a = block.num(instr.m_lhs);
+        const double b = instr.m_imm;
+        for (t_uindex idx = 0; idx < n; ++idx) {
+            out[idx] = f(a[idx], b);
+        }
+        std::copy(block.valid(instr.m_lhs), block.valid(instr.m_lhs) + n, valid);
+    } else {
+        const double* a = block.num(instr.m_lhs);
+        const double* b = block.num(instr.m_rhs);
+        const std::uint8_t* a_valid = block.valid(instr.m_lhs);
+        const std::uint8_t* b_valid = block.valid(instr.m_rhs);
+        for (t_uindex idx = 0; idx < n; ++idx) {
+            out[idx] = f(a[idx], b[idx]);
+            valid[idx] = a_valid[idx] & b_valid[idx];
+        }
+    }
+}
+
+void
+eval_arith(const t_expr_instr& instr, t_expr_block& block) {
+    double* out = block.num(instr.m_out);
+    switch (instr.m_op) {
+        case EXPR_ADD: {
+            eval_binary(instr, block, out, [](double a, double b) { return a + b; });
+        } break;
+        case EXPR_SUB: {
+            eval_binary(instr, block, out, [](double a, double b) { return a - b; });
+        } break;
+        case EXPR_MUL: {
+            eval_binary(instr, block, out, [](double a, double b) { return a * b; });
+        } break;
+        case EXPR_DIV: {
+            eval_binary(instr, block, out, [](double a, double b) { return a / b; });
+        } break;
+        case EXPR_MOD: {
+            eval_binary(instr, block, out, [](double a, double b) { return std::fmod(a, b); });
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected operator"); }
+    }
+}
+
+void
+eval_cmp(const t_expr_instr& instr, t_expr_block& block) {
+    std::uint8_t* out = block.boolean(instr.m_out);
+    switch (instr.m_op) {
+        case EXPR_EQ: {
+            eval_binary(instr, block, out, [](double a, double b) { return a == b; });
+        } break;
+        case EXPR_NE: {
+            eval_binary(instr, block, out, [](double a, double b) { return a != b; });
+        } break;
+        case EXPR_LT: {
+            eval_binary(instr, block, out, [](double a, double b) { return a < b; });
+        } break;
+        case EXPR_LTEQ: {
+            eval_binary(instr, block, out, [](double a, double b) { return a <= b; });
+        } break;
+        case EXPR_GT: {
+            eval_binary(instr, block, out, [](double a, double b) { return a > b; });
+        } break;
+        case EXPR_GTEQ: {
+            eval_binary(instr, block, out, [](double a, double b) { return a >= b; });
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected operator"); }
+    }
+}
+
+// Per call state of a string comparison against a literal: the verdict for
+// each vocabulary id of the column, filled in as ids are met.
+struct t_expr_str_verdicts {
+    enum { VERDICT_UNKNOWN = 2 };
+    std::vector<std::uint8_t> m_verdicts;
+};
+
+void
+eval_str_cmp_literal(const t_expr_instr& instr, t_expr_block& block, const t_column* col,
+    t_expr_str_verdicts& verdicts) {
+    if (verdicts.m_verdicts.empty()) {
+        verdicts.m_verdicts.assign(col->get_vlenidx(), t_expr_str_verdicts::VERDICT_UNKNOWN);
+    }
+
+    std::uint8_t* out = block.boolean(instr.m_out);
+    const std::uint8_t* valid = block.valid(instr.m_out);
+    const t_uindex* ids = col->get_nth<t_uindex>(block.m_begin);
+    const char* literal = instr.m_literal.c_str();
+    for (t_uindex idx = 0, loop_end = block.m_size; idx < loop_end; ++idx) {
+        if (!valid[idx]) {
+            out[idx] = 0;
+            continue;
+        }
+        std::uint8_t& verdict = verdicts.m_verdicts[ids[idx]];
+        if (verdict == t_expr_str_verdicts::VERDICT_UNKNOWN) {
+            verdict = apply_str_cmp(instr.m_op, col->unintern_c(ids[idx]), literal);
+        }
+        out[idx] = verdict;
+    }
+}
+
+void
+eval_str_cmp_column(
+    const t_expr_instr& instr, t_expr_block& block, const t_column* lhs, const t_column* rhs) {
+    std::uint8_t* out = block.boolean(instr.m_out);
+    std::uint8_t* valid = block.valid(instr.m_out);
+    const t_uindex* lhs_ids = lhs->get_nth<t_uindex>(block.m_begin);
+    const t_uindex* rhs_ids = rhs->get_nth<t_uindex>(block.m_begin);
+    for (t_uindex idx = 0, loop_end = block.m_size; idx < loop_end; ++idx) {
+        out[idx] = valid[idx]
+            && apply_str_cmp(
+                instr.m_op, lhs->unintern_c(lhs_ids[idx]), rhs->unintern_c(rhs_ids[idx]));
+    }
+}
+
+void
+eval_logical(const t_expr_instr& instr, t_expr_block& block) {
+    const std::uint8_t* a = block.boolean(instr.m_lhs);
+    const std::uint8_t* b = block.boolean(instr.m_rhs);
+    const std::uint8_t* a_valid = block.valid(instr.m_lhs);
+    const std::uint8_t* b_valid = block.valid(instr.m_rhs);
+    std::uint8_t* out = block.boolean(instr.m_out);
+    std::uint8_t* valid = block.valid(instr.m_out);
+
+    // Three valued: a known false (true) operand decides an and (or)
+    if (instr.m_opcode == INSTR_AND) {
+        for (t_uindex idx = 0, loop_end = block.m_size; idx < loop_end; ++idx) {
+            std::uint8_t t = a_valid[idx] & a[idx] & b_valid[idx] & b[idx];
+            out[idx] = t;
+            valid[idx] = t | (a_valid[idx] & !a[idx]) | (b_valid[idx] & !b[idx]);
+        }
+    } else {
+        for (t_uindex idx = 0, loop_end = block.m_size; idx < loop_end; ++idx) {
+            std::uint8_t t = (a_valid[idx] & a[idx]) | (b_valid[idx] & b[idx]);
+            out[idx] = t;
+            valid[idx] = t | (a_valid[idx] & !a[idx] & b_valid[idx] & !b[idx]);
+        }
+    }
+}
+
+} // end anonymous namespace
+
+t_filter_expr::t_filter_expr(const std::string& expr)
+    : m_expr(expr) {
+    t_expr_parser parser(m_expr, m_columns);
+    m_root = parser.parse();
+}
+
+t_filter_expr::~t_filter_expr() {}
+
+const std::string&
+t_filter_expr::get_expr() const {
+    return m_expr;
+}
+
+const std::vector<std::string>&
+t_filter_expr::get_columns() const {
+    return m_columns;
+}
+
+void
+t_filter_expr::validate(const t_schema& schema) const {
+    get_program(schema);
+}
+
+std::shared_ptr<const t_expr_program>
+t_filter_expr::get_program(const t_schema& schema) const {
+    std::vector<t_dtype> dtypes;
+    for (const auto& colname : m_columns) {
+        if (!schema.has_column(colname)) {
+            bad_expr(m_expr, "unknown column `" + colname + "`");
+        }
+        dtypes.push_back(schema.get_dtype(colname));
+    }
+
+    std::lock_guard<std::mutex> lk(m_program_mtx);
+    if (!m_program || m_program->m_dtypes != dtypes) {
+        auto program = std::make_shared<t_expr_program>();
+        program->m_dtypes = dtypes;
+        t_expr_compiler compiler(m_expr, *program);
+        program->m_result = compiler.compile_filter(*m_root);
+        m_program = program;
+    }
+    return m_program;
+}
+
+t_mask
+t_filter_expr::filter(const t_data_table& tbl) const {
+    std::shared_ptr<const t_expr_program> program = get_program(tbl.get_schema());
+
+    std::vector<const t_column*> columns;
+    for (const auto& colname : m_columns) {
+        columns.push_back(tbl.get_const_column(colname).get());
+    }
+
+    std::vector<t_expr_str_verdicts> verdicts(program->m_instrs.size());
+    t_expr_block block(program->m_nregs);
+    t_mask rval(tbl.size());
+
+    for (t_uindex begin = 0, nrows = tbl.size(); begin < nrows; begin += EXPR_BLOCK_SIZE) {
+        block.m_begin = begin;
+        block.m_size = std::min(EXPR_BLOCK_SIZE, nrows - begin);
+        t_uindex n = block.m_size;
+
+        for (t_uindex iidx = 0, loop_end = program->m_instrs.size(); iidx < loop_end; ++iidx) {
+            const t_expr_instr& instr = program->m_instrs[iidx];
+            const t_column* col = columns.empty() ? nullptr : columns[instr.m_colidx];
+            std::uint8_t* out = block.boolean(instr.m_out);
+            std::uint8_t* valid = block.valid(instr.m_out);
+
+            switch (instr.m_opcode) {
+                case INSTR_LOAD_NUM: {
+                    load_num(col, instr.m_dtype, begin, n, block.num(instr.m_out));
+                    load_valid(col, begin, n, valid);
+                } break;
+                case INSTR_LOAD_BOOL: {
+                    const bool* base = col->get_nth<bool>(begin);
+                    std::copy(base, base + n, out);
+                    load_valid(col, begin, n, valid);
+                } break;
+                case INSTR_CONST_BOOL: {
+                    std::fill(out, out + n, instr.m_imm != 0);
+                    std::fill(valid, valid + n, 1);
+                } break;
+                case INSTR_BOOL_TO_NUM: {
+                    std::copy(block.boolean(instr.m_lhs), block.boolean(instr.m_lhs) + n,
+                        block.num(instr.m_out));
+                    std::copy(block.valid(instr.m_lhs), block.valid(instr.m_lhs) + n, valid);
+                } break;
+                case INSTR_NEG: {
+                    const double* a = block.num(instr.m_lhs);
+                    double* num = block.num(instr.m_out);
+                    for (t_uindex idx = 0; idx < n; ++idx) {
+                        num[idx] = -a[idx];
+                    }
+                    std::copy(block.valid(instr.m_lhs), block.valid(instr.m_lhs) + n, valid);
+                } break;
+                case INSTR_ARITH: {
+                    eval_arith(instr, block);
+                } break;
+                case INSTR_CMP: {
+                    eval_cmp(instr, block);
+                } break;
+                case INSTR_STR_CMP_LITERAL: {
+                    load_valid(col, begin, n, valid);
+                    eval_str_cmp_literal(instr, block, col, verdicts[iidx]);
+                } break;
+                case INSTR_STR_CMP_COLUMN: {
+                    const t_column* rhs = columns[instr.m_rhs_colidx];
+                    std::vector<std::uint8_t> rhs_valid(n);
+                    load_valid(col, begin, n, valid);
+                    load_valid(rhs, begin, n, rhs_valid.data());
+                    for (t_uindex idx = 0; idx < n; ++idx) {
+                        valid[idx] &= rhs_valid[idx];
+                    }
+                    eval_str_cmp_column(instr, block, col, rhs);
+                } break;
+                case INSTR_AND:
+                case INSTR_OR: {
+                    eval_logical(instr, block);
+                } break;
+                case INSTR_NOT: {
+                    const std::uint8_t* a = block.boolean(instr.m_lhs);
+                    for (t_uindex idx = 0; idx < n; ++idx) {
+                        out[idx] = !a[idx];
+                    }
+                    std::copy(block.valid(instr.m_lhs), block.valid(instr.m_lhs) + n, valid);
+                } break;
+                case INSTR_IS_NULL:
+                case INSTR_IS_NOT_NULL: {
+                    if (instr.m_lhs < 0) {
+                        load_valid(col, begin, n, out);
+                    } else {
+                        std::copy(
+                            block.valid(instr.m_lhs), block.valid(instr.m_lhs) + n, out);
+                    }
+                    if (instr.m_opcode == INSTR_IS_NULL) {
+                        for (t_uindex idx = 0; idx < n; ++idx) {
+                            out[idx] = !out[idx];
+                        }
+                    }
+                    std::fill(valid, valid + n, 1);
+                } break;
+            }
+        }
+
+        const std::uint8_t* result = block.boolean(program->m_result);
+        const std::uint8_t* result_valid = block.valid(program->m_result);
+        for (t_uindex idx = 0; idx < n; ++idx) {
+            if (result[idx] & result_valid[idx]) {
+                rval.set(begin + idx);
+            }
+        }
+    }
+
+    return rval;
+}
+
+} // end namespace perspective
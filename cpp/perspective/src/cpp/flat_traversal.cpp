@@ -113,6 +113,7 @@ t_ftrav::fill_sort_elem(std::shared_ptr<const t_gstate> state, const t_config& c
         out_elem.m_row.push_back(
             m_symtable.get_interned_tscalar(state->get(pkey, sortby_colname)));
     }
+    encode_sort_key(out_elem, m_sort_orders);
 }
 
 void
@@ -132,6 +133,7 @@ t_ftrav::fill_sort_elem(std::shared_ptr<const t_gstate> state, const t_config& c
         out_elem.m_row.push_back(
             get_interned_tscalar(row.at(config.get_colidx(sortby_colname))));
     }
+    encode_sort_key(out_elem, m_sort_orders);
 }
 
 void
@@ -143,6 +145,7 @@ t_ftrav::sort_by(std::shared_ptr<const t_gstate> state, const t_config& config,
     t_index size = m_index->size();
     auto sort_elems = std::make_shared<std::vector<t_mselem>>(static_cast<size_t>(size));
     m_sortby = sortby;
+    m_sort_orders = get_sort_orders(sortby);
 
     for (t_index idx = 0; idx < size; ++idx) {
         t_mselem& elem = (*sort_elems)[idx];
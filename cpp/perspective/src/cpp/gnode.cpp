@@ -217,12 +217,121 @@ t_gnode::_send(t_uindex portid, const t_data_table& fragments) {
     iport->send(fragments);
 }
 
+void
+t_gnode::_send(t_uindex portid, std::shared_ptr<t_data_table> fragments) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(portid == 0, "Only simple dataflows supported currently");
+
+    std::shared_ptr<t_port>& iport = m_iports[portid];
+    iport->send(std::move(fragments));
+}
+
+void
+t_gnode::stage(t_uindex portid, std::shared_ptr<t_data_table> fragments) {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(portid == 0, "Only simple dataflows supported currently");
+
+    m_staged.push(portid, std::move(fragments));
+}
+
+void
+t_gnode::stage(t_uindex portid, const t_data_table& fragments) {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(portid == 0, "Only simple dataflows supported currently");
+
+    auto tbl = std::make_shared<t_data_table>(m_ischemas[portid]);
+    tbl->init();
+    tbl->append(fragments);
+    stage(portid, tbl);
+}
+
+bool
+t_gnode::has_staged() const {
+    return !m_staged.empty();
+}
+
+void
+t_gnode::send_staged() {
+    for (auto& staged : m_staged.take()) {
+        _send(staged.first, std::move(staged.second));
+    }
+}
+
 void
 t_gnode::_send_and_process(const t_data_table& fragments) {
     _send(0, fragments);
     _process();
 }
 
+void
+t_gnode::process_column(const t_column* fcolumn, const t_column* scolumn, t_column* dcolumn,
+    t_column* pcolumn, t_column* ccolumn, t_column* tcolumn, const std::uint8_t* op_base,
+    std::vector<t_rlookup>& lkup, std::vector<bool>& prev_pkey_eq_vec,
+    std::vector<t_uindex>& added_vec) {
+    t_dtype col_dtype = fcolumn->get_dtype();
+
+    switch (col_dtype) {
+        case DTYPE_INT64: {
+            _process_helper<std::int64_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_INT32: {
+            _process_helper<std::int32_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_INT16: {
+            _process_helper<std::int16_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_INT8: {
+            _process_helper<std::int8_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_UINT64: {
+            _process_helper<std::uint64_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_UINT32: {
+            _process_helper<std::uint32_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_UINT16: {
+            _process_helper<std::uint16_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_UINT8: {
+            _process_helper<std::uint8_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_FLOAT64: {
+            _process_helper<double>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_FLOAT32: {
+            _process_helper<float>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn, tcolumn,
+                op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_BOOL: {
+            _process_helper<std::uint8_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_TIME: {
+            _process_helper<std::int64_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_DATE: {
+            _process_helper<std::uint32_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        case DTYPE_STR: {
+            _process_helper<std::string>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
+                tcolumn, op_base, lkup, prev_pkey_eq_vec, added_vec);
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unsupported column dtype"); }
+    }
+}
+
 t_value_transition
 t_gnode::calc_transition(bool prev_existed, bool row_pre_existed, bool exists, bool prev_valid,
     bool cur_valid, bool prev_cur_eq, bool prev_pkey_eq) {
@@ -334,12 +443,12 @@ t_gnode::_process_table() {
 
     std::shared_ptr<t_port>& iport = m_iports[0];
 
-    if (iport->get_table()->size() == 0) {
+    if (iport->size() == 0) {
         return nullptr;
     }
 
     m_was_updated = true;
-    std::shared_ptr<t_data_table> flattened(iport->get_table()->flatten());
+    std::shared_ptr<t_data_table> flattened(iport->flatten());
     PSP_GNODE_VERIFY_TABLE(flattened);
     PSP_GNODE_VERIFY_TABLE(get_table());
 
@@ -360,6 +469,9 @@ t_gnode::_process_table() {
 
         m_state->update_history(flattened.get());
         psp_log_time(repr() + " _process.init_path.post_update_history");
+        if (!m_sketches.empty()) {
+            m_sketches.add_rows(*flattened, nullptr);
+        }
         _update_contexts_from_state(*flattened);
         psp_log_time(repr() + " _process.init_path.post_update_contexts_from_state");
         m_oports[PSP_PORT_FLATTENED]->set_table(flattened);
@@ -530,67 +642,8 @@ t_gnode::_process_table() {
             auto ccolumn = ccolumns[colidx];
             auto tcolumn = tcolumns[colidx];
 
-            t_dtype col_dtype = fcolumn->get_dtype();
-
-            switch (col_dtype) {
-                case DTYPE_INT64: {
-                    _process_helper<std::int64_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_INT32: {
-                    _process_helper<std::int32_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_INT16: {
-                    _process_helper<std::int16_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_INT8: {
-                    _process_helper<std::int8_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_UINT64: {
-                    _process_helper<std::uint64_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_UINT32: {
-                    _process_helper<std::uint32_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_UINT16: {
-                    _process_helper<std::uint16_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_UINT8: {
-                    _process_helper<std::uint8_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_FLOAT64: {
-                    _process_helper<double>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_FLOAT32: {
-                    _process_helper<float>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn, tcolumn,
-                        op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_BOOL: {
-                    _process_helper<std::uint8_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_TIME: {
-                    _process_helper<std::int64_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_DATE: {
-                    _process_helper<std::uint32_t>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                case DTYPE_STR: {
-                    _process_helper<std::string>(fcolumn, scolumn, dcolumn, pcolumn, ccolumn,
-                        tcolumn, op_base, lkup, prev_pkey_eq_vec, added_offset);
-                } break;
-                default: { PSP_COMPLAIN_AND_ABORT("Unsupported column dtype"); }
-            }
+            process_column(fcolumn, scolumn, dcolumn, pcolumn, ccolumn, tcolumn, op_base,
+                lkup, prev_pkey_eq_vec, added_offset);
         }
 #ifdef PSP_PARALLEL_FOR
     );
@@ -617,6 +670,13 @@ t_gnode::_process_table() {
 
     psp_log_time(repr() + " _process.noinit_path.post_update_history");
 
+    if (!m_sketches.empty()) {
+        m_sketches.update(*flattened_masked, *prev, *current, *existed, nullptr, nullptr);
+        if (m_sketches.is_stale()) {
+            m_sketches.rebuild(*(m_state->get_pkeyed_table()), nullptr);
+        }
+    }
+
     m_oports[PSP_PORT_FLATTENED]->set_table(flattened_masked);
 
     if (t_env::log_data_gnode_flattened()) {
@@ -670,6 +730,7 @@ t_gnode::_process() {
         m_mode == NODE_PROCESSING_SIMPLE_DATAFLOW, "Only simple dataflows supported currently");
     psp_log_time(repr() + " _process.enter");
 
+    send_staged();
     std::shared_ptr<t_data_table> flattened_masked = _process_table();
     if (flattened_masked) {
         notify_contexts(*flattened_masked);
@@ -720,6 +781,48 @@ t_gnode::get_table_sptr() {
     return m_state->get_table();
 }
 
+void
+t_gnode::enable_sketch(const std::string& colname, t_uindex nbuckets) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_sketches.enable(colname, m_tblschema.get_dtype(colname), nbuckets);
+    if (m_state->mapping_size() > 0) {
+        m_sketches.rebuild(*(m_state->get_pkeyed_table()), nullptr);
+    }
+}
+
+const t_column_sketch&
+t_gnode::get_sketch(const std::string& colname) const {
+    return m_sketches.get_sketch(colname);
+}
+
+void
+t_gnode::create_index(const std::string& colname) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_state->create_index(colname);
+}
+
+void
+t_gnode::save_snapshot(const std::string& dirname) const {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_state->save_snapshot(dirname);
+}
+
+void
+t_gnode::load_snapshot(const std::string& dirname) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_state->load_snapshot(dirname);
+
+    auto flattened = m_state->get_pkeyed_table();
+    if (!m_sketches.empty()) {
+        m_sketches.rebuild(*flattened, nullptr);
+    }
+    _update_contexts_from_state(*flattened);
+}
+
 /**
  * Convenience method for promoting a column.  This is a hack used to
  * interop with javascript more efficiently, and does not handle all
@@ -1164,6 +1267,7 @@ t_gnode::reset() {
     }
 
     m_state->reset();
+    m_sketches.clear();
 }
 
 void
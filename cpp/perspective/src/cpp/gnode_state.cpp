@@ -8,18 +8,129 @@
  */
 
 #include <perspective/first.h>
+#include <perspective/config.h>
 #include <perspective/context_one.h>
 #include <perspective/context_two.h>
 #include <perspective/context_zero.h>
 #include <perspective/gnode_state.h>
 #include <perspective/mask.h>
 #include <perspective/sym_table.h>
+#include <perspective/snapshot.h>
 #ifdef PSP_PARALLEL_FOR
 #include <tbb/tbb.h>
 #endif
 
 namespace perspective {
 
+struct t_scatter_copy {
+    template <typename DATA_T>
+    DATA_T
+    operator()(DATA_T v) const {
+        return v;
+    }
+};
+
+struct t_scatter_remap {
+    t_uindex
+    operator()(t_uindex v) const {
+        return m_remap->translate(v);
+    }
+
+    t_vocab_remap* m_remap;
+};
+
+/**
+ * Writes rows `frows` of `fcolumn` to rows `srows` of `scolumn`. Valid cells
+ * are written through `convert`, cleared cells are reset, and invalid cells
+ * are skipped. DATA_T only needs the width of the column's storage.
+ */
+template <typename DATA_T, typename CONVERT_T>
+static void
+scatter_column(const t_column* fcolumn, t_column* scolumn, const std::vector<t_uindex>& frows,
+    const std::vector<t_uindex>& srows, CONVERT_T convert) {
+    t_uindex nrows = frows.size();
+    if (nrows == 0) {
+        return;
+    }
+
+    const DATA_T* fdata = fcolumn->get_nth<DATA_T>(0);
+    DATA_T* sdata = scolumn->get_nth<DATA_T>(0);
+    const t_status* fstatus = fcolumn->get_nth_status(0);
+
+    // Statuses first, as one byte per row; cleared cells end up invalid.
+    bool all_valid = true;
+    if (scolumn->is_status_enabled()) {
+        t_status* sstatus = scolumn->get_nth_status(0);
+        for (t_uindex idx = 0; idx < nrows; ++idx) {
+            t_status status = fstatus[frows[idx]];
+            all_valid &= status == STATUS_VALID;
+            if (status != STATUS_INVALID) {
+                sstatus[srows[idx]] = status == STATUS_VALID ? STATUS_VALID : STATUS_INVALID;
+            }
+        }
+    } else {
+        for (t_uindex idx = 0; idx < nrows; ++idx) {
+            all_valid &= fstatus[frows[idx]] == STATUS_VALID;
+        }
+    }
+
+    if (all_valid) {
+        for (t_uindex idx = 0; idx < nrows; ++idx) {
+            sdata[srows[idx]] = convert(fdata[frows[idx]]);
+        }
+        return;
+    }
+
+    for (t_uindex idx = 0; idx < nrows; ++idx) {
+        t_uindex fidx = frows[idx];
+        switch (fstatus[fidx]) {
+            case STATUS_VALID: {
+                sdata[srows[idx]] = convert(fdata[fidx]);
+            } break;
+            case STATUS_CLEAR: {
+                sdata[srows[idx]] = DATA_T();
+            } break;
+            default: break;
+        }
+    }
+}
+
+static void
+scatter_column(const t_column* fcolumn, t_column* scolumn, const std::vector<t_uindex>& frows,
+    const std::vector<t_uindex>& srows) {
+    switch (fcolumn->get_dtype()) {
+        case DTYPE_NONE: {
+        } break;
+        case DTYPE_INT64:
+        case DTYPE_UINT64:
+        case DTYPE_FLOAT64:
+        case DTYPE_TIME: {
+            scatter_column<std::uint64_t>(fcolumn, scolumn, frows, srows, t_scatter_copy());
+        } break;
+        case DTYPE_INT32:
+        case DTYPE_UINT32:
+        case DTYPE_FLOAT32:
+        case DTYPE_DATE: {
+            scatter_column<std::uint32_t>(fcolumn, scolumn, frows, srows, t_scatter_copy());
+        } break;
+        case DTYPE_INT16:
+        case DTYPE_UINT16: {
+            scatter_column<std::uint16_t>(fcolumn, scolumn, frows, srows, t_scatter_copy());
+        } break;
+        case DTYPE_INT8:
+        case DTYPE_UINT8:
+        case DTYPE_BOOL: {
+            scatter_column<std::uint8_t>(fcolumn, scolumn, frows, srows, t_scatter_copy());
+        } break;
+        case DTYPE_STR: {
+            // Strings are interned into the table once per distinct value
+            t_vocab_remap remap = scolumn->remap_vocabulary(*fcolumn);
+            scatter_column<t_uindex>(fcolumn, scolumn, frows, srows, t_scatter_remap{&remap});
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected type"); }
+    }
+}
+
 t_gstate::t_gstate(const t_schema& tblschema, const t_schema& pkeyed_schema)
 
     : m_tblschema(tblschema)
@@ -77,6 +188,10 @@ t_gstate::erase(const t_tscalar& pkey) {
 
     m_mapping.erase(iter);
     _mark_deleted(idx);
+    if (!m_indexes.empty()) {
+        m_indexes.mark(idx);
+    }
+    m_zone_maps.mark(idx);
 }
 
 t_uindex
@@ -112,7 +227,6 @@ t_gstate::lookup_or_create(const t_tscalar& pkey) {
 void
 t_gstate::update_history(const t_data_table* tbl) {
     const t_schema& fschema = tbl->get_schema();
-    const t_schema& sschema = m_table->get_schema();
 
     auto pkey_col = tbl->get_const_column("psp_pkey").get();
     auto op_col = tbl->get_const_column("psp_op").get();
@@ -131,13 +245,6 @@ t_gstate::update_history(const t_data_table* tbl) {
         ++count;
     }
 
-    std::vector<t_column*> scolumns(ncols);
-
-    for (t_uindex idx = 0, loop_end = sschema.size(); idx < loop_end; ++idx) {
-        const std::string& cname = sschema.m_columns[idx];
-        scolumns[idx] = stable->get_column(cname).get();
-    }
-
     // insert into new table
     if (size() == 0) {
         m_free.clear();
@@ -157,6 +264,8 @@ t_gstate::update_history(const t_data_table* tbl) {
 
         stable->set_capacity(tbl->get_capacity());
         stable->set_size(tbl->size());
+        m_indexes.invalidate();
+        m_zone_maps.invalidate();
 
         for (t_uindex idx = 0, loop_end = tbl->num_rows(); idx < loop_end; ++idx) {
             t_tscalar pkey = pkey_col->get_scalar(idx);
@@ -184,7 +293,11 @@ t_gstate::update_history(const t_data_table* tbl) {
     }
 
     /* size is not zero */
-    std::vector<t_uindex> stableidx_vec(tbl->num_rows());
+    // Source and destination rows of every insert, shared by all columns
+    std::vector<t_uindex> frows;
+    std::vector<t_uindex> srows;
+    frows.reserve(tbl->num_rows());
+    srows.reserve(tbl->num_rows());
 
     for (t_uindex idx = 0, loop_end = tbl->num_rows(); idx < loop_end; ++idx) {
         t_tscalar pkey = pkey_col->get_scalar(idx);
@@ -193,9 +306,11 @@ t_gstate::update_history(const t_data_table* tbl) {
 
         switch (op) {
             case OP_INSERT: {
-                stableidx_vec[idx] = lookup_or_create(pkey);
-                m_opcol->set_nth<std::uint8_t>(stableidx_vec[idx], OP_INSERT);
-                m_pkcol->set_scalar(stableidx_vec[idx], pkey);
+                t_uindex stableidx = lookup_or_create(pkey);
+                m_opcol->set_nth<std::uint8_t>(stableidx, OP_INSERT);
+                m_pkcol->set_scalar(stableidx, pkey);
+                frows.push_back(idx);
+                srows.push_back(stableidx);
             } break;
             case OP_DELETE: {
                 erase(pkey);
@@ -204,100 +319,39 @@ t_gstate::update_history(const t_data_table* tbl) {
         }
     }
 
+    scatter(tbl, frows, srows);
+}
+
+void
+t_gstate::scatter(const t_data_table* tbl, const std::vector<t_uindex>& frows,
+    const std::vector<t_uindex>& srows) {
+    const t_schema& sschema = m_table->get_schema();
+    t_uindex ncols = sschema.size();
+
+    std::vector<const t_column*> fcolumns(ncols);
+    std::vector<t_column*> scolumns(ncols);
+
+    for (t_uindex idx = 0; idx < ncols; ++idx) {
+        const std::string& cname = sschema.m_columns[idx];
+        fcolumns[idx] = tbl->get_const_column(cname).get();
+        scolumns[idx] = m_table->get_column(cname).get();
+    }
+
 #ifdef PSP_PARALLEL_FOR
     PSP_PFOR(0, int(ncols), 1,
-        [tbl, op_col, &col_translation, &fcolumns, &scolumns, &stableidx_vec](int colidx)
+        [&fcolumns, &scolumns, &frows, &srows](int colidx)
 #else
     for (t_uindex colidx = 0; colidx < ncols; ++colidx)
 #endif
-
-        {
-            const t_column* fcolumn = fcolumns[col_translation[colidx]];
-
-            t_column* scolumn = scolumns[colidx];
-
-            for (t_uindex idx = 0, loop_end = tbl->num_rows(); idx < loop_end; ++idx) {
-                bool is_valid = fcolumn->is_valid(idx);
-                t_uindex stableidx = stableidx_vec[idx];
-
-                if (!is_valid) {
-                    bool is_cleared = fcolumn->is_cleared(idx);
-                    if (is_cleared) {
-                        scolumn->clear(stableidx);
-                    }
-                    continue;
-                }
-
-                const std::uint8_t* op_ptr = op_col->get_nth<std::uint8_t>(idx);
-                t_op op = static_cast<t_op>(*op_ptr);
-
-                if (op == OP_DELETE)
-                    continue;
-
-                switch (fcolumn->get_dtype()) {
-                    case DTYPE_NONE: {
-                    } break;
-                    case DTYPE_INT64: {
-                        scolumn->set_nth<std::int64_t>(
-                            stableidx, *(fcolumn->get_nth<std::int64_t>(idx)));
-                    } break;
-                    case DTYPE_INT32: {
-                        scolumn->set_nth<std::int32_t>(
-                            stableidx, *(fcolumn->get_nth<std::int32_t>(idx)));
-                    } break;
-                    case DTYPE_INT16: {
-                        scolumn->set_nth<std::int16_t>(
-                            stableidx, *(fcolumn->get_nth<std::int16_t>(idx)));
-                    } break;
-                    case DTYPE_INT8: {
-                        scolumn->set_nth<std::int8_t>(
-                            stableidx, *(fcolumn->get_nth<std::int8_t>(idx)));
-                    } break;
-                    case DTYPE_UINT64: {
-                        scolumn->set_nth<std::uint64_t>(
-                            stableidx, *(fcolumn->get_nth<std::uint64_t>(idx)));
-                    } break;
-                    case DTYPE_UINT32: {
-                        scolumn->set_nth<std::uint32_t>(
-                            stableidx, *(fcolumn->get_nth<std::uint32_t>(idx)));
-                    } break;
-                    case DTYPE_UINT16: {
-                        scolumn->set_nth<std::uint16_t>(
-                            stableidx, *(fcolumn->get_nth<std::uint16_t>(idx)));
-                    } break;
-                    case DTYPE_UINT8: {
-                        scolumn->set_nth<std::uint8_t>(
-                            stableidx, *(fcolumn->get_nth<std::uint8_t>(idx)));
-                    } break;
-                    case DTYPE_FLOAT64: {
-                        scolumn->set_nth<double>(stableidx, *(fcolumn->get_nth<double>(idx)));
-                    } break;
-                    case DTYPE_FLOAT32: {
-                        scolumn->set_nth<float>(stableidx, *(fcolumn->get_nth<float>(idx)));
-                    } break;
-                    case DTYPE_BOOL: {
-                        scolumn->set_nth<std::uint8_t>(
-                            stableidx, *(fcolumn->get_nth<std::uint8_t>(idx)));
-                    } break;
-                    case DTYPE_TIME: {
-                        scolumn->set_nth<std::int64_t>(
-                            stableidx, *(fcolumn->get_nth<std::int64_t>(idx)));
-                    } break;
-                    case DTYPE_DATE: {
-                        scolumn->set_nth<std::uint32_t>(
-                            stableidx, *(fcolumn->get_nth<std::uint32_t>(idx)));
-                    } break;
-                    case DTYPE_STR: {
-                        const char* s = fcolumn->get_nth<const char>(idx);
-                        scolumn->set_nth<const char*>(stableidx, s);
-                    } break;
-                    default: { PSP_COMPLAIN_AND_ABORT("Unexpected type"); }
-                }
-            }
-        }
+        { scatter_column(fcolumns[colidx], scolumns[colidx], frows, srows); }
 #ifdef PSP_PARALLEL_FOR
     );
 #endif
+
+    if (!m_indexes.empty()) {
+        m_indexes.mark(srows);
+    }
+    m_zone_maps.mark(srows);
 }
 
 void
@@ -741,6 +795,68 @@ t_gstate::reset() {
     m_table->clear();
     m_mapping.clear();
     m_free.clear();
+    m_indexes.invalidate();
+    m_zone_maps.invalidate();
+}
+
+void
+t_gstate::save_snapshot(const std::string& dirname) const {
+    std::vector<t_uindex> free_rows(m_free.begin(), m_free.end());
+    t_snapshot::save(*m_table, free_rows, dirname);
+}
+
+void
+t_gstate::load_snapshot(const std::string& dirname) {
+    t_snapshot snapshot(dirname);
+    snapshot.load(*m_table);
+
+    m_pkcol = m_table->get_column("psp_pkey");
+    m_opcol = m_table->get_column("psp_op");
+
+    const std::vector<t_uindex>& free_rows = snapshot.get_free_rows();
+    m_free = t_free_items(free_rows.begin(), free_rows.end());
+
+    t_uindex nrows = m_table->size();
+    m_mapping.clear();
+    m_mapping.reserve(nrows - m_free.size());
+    for (t_uindex ridx = 0; ridx < nrows; ++ridx) {
+        if (m_free.find(ridx) == m_free.end()) {
+            m_mapping[m_symtable.get_interned_tscalar(m_pkcol->get_scalar(ridx))] = ridx;
+        }
+    }
+    m_indexes.invalidate();
+    m_zone_maps.invalidate();
+}
+
+void
+t_gstate::create_index(const std::string& colname) {
+    m_indexes.create(colname, m_table->get_const_column(colname)->get_dtype());
+}
+
+bool
+t_gstate::has_index(const std::string& colname) const {
+    return m_indexes.has_index(colname);
+}
+
+bool
+t_gstate::filter_indexed(const t_config& config, t_mask& mask) const {
+    if (config.get_fmode() != FMODE_SIMPLE_CLAUSES || config.get_combiner() != FILTER_OP_AND) {
+        return false;
+    }
+    return m_indexes.filter(*m_table, config.get_fterms(), mask);
+}
+
+bool
+t_gstate::filter_zoned(const t_config& config, t_mask& mask) const {
+    if (config.get_fmode() != FMODE_SIMPLE_CLAUSES || config.get_combiner() != FILTER_OP_AND) {
+        return false;
+    }
+    return m_zone_maps.filter(*m_table, config.get_fterms(), mask);
+}
+
+std::pair<t_tscalar, t_tscalar>
+t_gstate::get_min_max(const std::string& colname) const {
+    return m_zone_maps.get_min_max(*m_table, colname);
 }
 
 t_tscalar
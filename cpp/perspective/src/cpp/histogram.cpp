@@ -9,6 +9,9 @@
 
 #include <perspective/first.h>
 #include <perspective/histogram.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace perspective {
 t_hist_bucket::t_hist_bucket(t_tscalar begin, t_tscalar end, t_uindex count)
@@ -19,9 +22,315 @@ t_hist_bucket::t_hist_bucket(t_tscalar begin, t_tscalar end, t_uindex count)
 t_hist_bucket::t_hist_bucket()
     : m_count(0) {}
 
-t_histogram::t_histogram() {}
+t_histogram::t_histogram()
+    : t_histogram(64) {}
 
 t_histogram::t_histogram(t_uindex nbuckets)
-    : m_buckets(std::vector<t_hist_bucket>(nbuckets)) {}
+    : m_nbuckets(std::max(nbuckets, t_uindex(1)))
+    , m_origin(0)
+    , m_width(0)
+    , m_count(0)
+    , m_counts(m_nbuckets, 0) {}
+
+bool
+t_histogram::contains(double value) const {
+    return value >= m_origin && value < m_origin + m_width * m_nbuckets;
+}
+
+void
+t_histogram::widen() {
+    double span = 2 * m_width * m_nbuckets;
+    double origin = std::floor(m_origin / span) * span;
+
+    // The old range is either the lower or the upper half of the new one
+    t_uindex shift = origin < m_origin ? m_nbuckets : 0;
+    std::vector<std::int64_t> counts(m_nbuckets, 0);
+    for (t_uindex idx = 0; idx < m_nbuckets; ++idx) {
+        counts[(idx + shift) / 2] += m_counts[idx];
+    }
+
+    m_origin = origin;
+    m_width *= 2;
+    std::swap(m_counts, counts);
+}
+
+void
+t_histogram::add(double value, std::int64_t weight) {
+    if (!std::isfinite(value)) {
+        return;
+    }
+
+    if (m_width == 0) {
+        // Start far finer than the value's magnitude; widening is cheap
+        double magnitude = std::max(std::fabs(value), 1.0 / 1024);
+        m_width = std::ldexp(1.0, std::ilogb(magnitude) - 40);
+        double span = m_width * m_nbuckets;
+        m_origin = std::floor(value / span) * span;
+    }
+
+    while (!contains(value)) {
+        widen();
+    }
+
+    t_uindex bidx = std::min(
+        static_cast<t_uindex>((value - m_origin) / m_width), m_nbuckets - 1);
+    m_counts[bidx] += weight;
+    m_count += weight;
+}
+
+void
+t_histogram::merge(const t_histogram& other) {
+    if (other.m_width == 0) {
+        return;
+    }
+
+    if (m_width == 0) {
+        *this = other;
+        return;
+    }
+
+    PSP_VERBOSE_ASSERT(
+        m_nbuckets == other.m_nbuckets, "Cannot merge histograms of different sizes");
+
+    t_histogram rhs(other);
+    while (rhs.m_width < m_width) {
+        rhs.widen();
+    }
+    while (m_width < rhs.m_width) {
+        widen();
+    }
+    while (m_origin != rhs.m_origin) {
+        widen();
+        rhs.widen();
+    }
+
+    for (t_uindex idx = 0; idx < m_nbuckets; ++idx) {
+        m_counts[idx] += rhs.m_counts[idx];
+    }
+    m_count += rhs.m_count;
+}
+
+void
+t_histogram::clear() {
+    *this = t_histogram(m_nbuckets);
+}
+
+t_uindex
+t_histogram::nbuckets() const {
+    return m_nbuckets;
+}
+
+std::int64_t
+t_histogram::count() const {
+    return m_count;
+}
+
+double
+t_histogram::quantile(double q) const {
+    if (m_count <= 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double rank = std::min(std::max(q, 0.0), 1.0) * m_count;
+    double seen = 0;
+    for (t_uindex idx = 0; idx < m_nbuckets; ++idx) {
+        double bcount = m_counts[idx];
+        if (bcount > 0 && seen + bcount >= rank) {
+            return m_origin + m_width * (idx + (rank - seen) / bcount);
+        }
+        seen += bcount;
+    }
+
+    return m_origin + m_width * m_nbuckets;
+}
+
+std::vector<t_hist_bucket>
+t_histogram::get_buckets() const {
+    std::vector<t_hist_bucket> rval;
+    for (t_uindex idx = 0; idx < m_nbuckets; ++idx) {
+        if (m_counts[idx] > 0) {
+            double begin = m_origin + m_width * idx;
+            rval.push_back(t_hist_bucket(mktscalar(begin), mktscalar(begin + m_width),
+                static_cast<t_uindex>(m_counts[idx])));
+        }
+    }
+    return rval;
+}
+
+t_tdigest::t_tdigest(double compression)
+    : m_compression(compression)
+    , m_count(0)
+    , m_min(std::numeric_limits<double>::infinity())
+    , m_max(-std::numeric_limits<double>::infinity()) {}
+
+void
+t_tdigest::add(double value, double weight) {
+    if (!std::isfinite(value) || weight <= 0) {
+        return;
+    }
+
+    m_buffer.push_back(std::make_pair(value, weight));
+    m_count += weight;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+
+    if (m_buffer.size() >= 8 * m_compression) {
+        compress();
+    }
+}
+
+void
+t_tdigest::merge(const t_tdigest& other) {
+    m_buffer.insert(m_buffer.end(), other.m_centroids.begin(), other.m_centroids.end());
+    m_buffer.insert(m_buffer.end(), other.m_buffer.begin(), other.m_buffer.end());
+    m_count += other.m_count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    compress();
+}
+
+void
+t_tdigest::compress() {
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<double, double>> points;
+    points.reserve(m_centroids.size() + m_buffer.size());
+    points.insert(points.end(), m_centroids.begin(), m_centroids.end());
+    points.insert(points.end(), m_buffer.begin(), m_buffer.end());
+    std::sort(points.begin(), points.end());
+    m_buffer.clear();
+    m_centroids.clear();
+
+    // k(q) = delta / 2pi * asin(2q - 1); a centroid spans at most one unit of k
+    const double pi = std::acos(-1.0);
+    auto k_to_q = [&](double k) {
+        double angle = std::min(k * 2 * pi / m_compression, pi / 2);
+        return (std::sin(angle) + 1) / 2;
+    };
+    auto q_to_k = [&](double q) {
+        return m_compression / (2 * pi) * std::asin(2 * std::min(q, 1.0) - 1);
+    };
+
+    std::pair<double, double> cur = points.front();
+    double seen = 0;
+    double qlimit = k_to_q(q_to_k(0) + 1);
+    for (t_uindex idx = 1, loop_end = points.size(); idx < loop_end; ++idx) {
+        const std::pair<double, double>& point = points[idx];
+        if ((seen + cur.second + point.second) / m_count <= qlimit) {
+            double weight = cur.second + point.second;
+            cur.first += (point.first - cur.first) * point.second / weight;
+            cur.second = weight;
+        } else {
+            m_centroids.push_back(cur);
+            seen += cur.second;
+            qlimit = k_to_q(q_to_k(seen / m_count) + 1);
+            cur = point;
+        }
+    }
+    m_centroids.push_back(cur);
+}
+
+void
+t_tdigest::clear() {
+    *this = t_tdigest(m_compression);
+}
+
+double
+t_tdigest::count() const {
+    return m_count;
+}
+
+double
+t_tdigest::quantile(double q) const {
+    if (!m_buffer.empty()) {
+        t_tdigest flushed(*this);
+        flushed.compress();
+        return flushed.quantile(q);
+    }
+
+    if (m_centroids.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    if (m_centroids.size() == 1) {
+        return m_centroids.front().first;
+    }
+
+    // Interpolate between centroid centres, pinning the ends to min/max
+    double rank = std::min(std::max(q, 0.0), 1.0) * m_count;
+    double left = 0;
+    double left_value = m_min;
+    double seen = 0;
+    for (const auto& centroid : m_centroids) {
+        double centre = seen + centroid.second / 2;
+        if (rank <= centre) {
+            if (centre == left) {
+                return centroid.first;
+            }
+            return left_value + (centroid.first - left_value) * (rank - left) / (centre - left);
+        }
+        left = centre;
+        left_value = centroid.first;
+        seen += centroid.second;
+    }
+
+    if (m_count == left) {
+        return m_max;
+    }
+    return left_value + (m_max - left_value) * (rank - left) / (m_count - left);
+}
+
+t_column_sketch::t_column_sketch()
+    : m_nremoved(0) {}
+
+t_column_sketch::t_column_sketch(t_uindex nbuckets)
+    : m_histogram(nbuckets)
+    , m_nremoved(0) {}
+
+void
+t_column_sketch::add(double value) {
+    m_histogram.add(value);
+    m_digest.add(value);
+}
+
+void
+t_column_sketch::remove(double value) {
+    m_histogram.add(value, -1);
+    ++m_nremoved;
+}
+
+void
+t_column_sketch::merge(const t_column_sketch& other) {
+    m_histogram.merge(other.m_histogram);
+    m_digest.merge(other.m_digest);
+    m_nremoved += other.m_nremoved;
+}
+
+void
+t_column_sketch::compress() {
+    m_digest.compress();
+}
+
+std::int64_t
+t_column_sketch::count() const {
+    return m_histogram.count();
+}
+
+double
+t_column_sketch::quantile(double q) const {
+    return m_nremoved == 0 ? m_digest.quantile(q) : m_histogram.quantile(q);
+}
+
+const t_histogram&
+t_column_sketch::get_histogram() const {
+    return m_histogram;
+}
+
+bool
+t_column_sketch::is_stale() const {
+    return m_nremoved > 0 && 2 * m_nremoved >= m_digest.count();
+}
 
 } // end namespace perspective
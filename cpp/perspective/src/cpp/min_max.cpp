@@ -19,6 +19,21 @@ t_minmax::t_minmax()
     m_max = mknone();
 }
 
+void
+t_minmax::update(const t_tscalar& value) {
+    if (m_min.is_none()) {
+        m_min = value;
+    } else {
+        m_min = std::min(value, m_min);
+    }
+
+    if (m_max.is_none()) {
+        m_max = value;
+    } else {
+        m_max = std::max(value, m_max);
+    }
+}
+
 } // end namespace perspective
 
 namespace std {
@@ -12,10 +12,19 @@
 #include <perspective/base.h>
 #include <perspective/multi_sort.h>
 #include <perspective/scalar.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <vector>
 
 namespace perspective {
 
+t_sortkey::t_sortkey()
+    : m_exact(0) {
+    m_words.fill(0);
+    m_tags.fill(0);
+}
+
 t_mselem::t_mselem()
     : m_pkey(mknone())
     , m_order(0)
@@ -46,6 +55,7 @@ t_mselem::t_mselem(const t_tscalar& pkey, const std::vector<t_tscalar>& row)
 t_mselem::t_mselem(const t_mselem& other) {
     m_pkey = other.m_pkey;
     m_row = other.m_row;
+    m_key = other.m_key;
     m_deleted = other.m_deleted;
     m_updated = other.m_updated;
     m_order = other.m_order;
@@ -54,6 +64,7 @@ t_mselem::t_mselem(const t_mselem& other) {
 t_mselem::t_mselem(t_mselem&& other) {
     m_pkey = other.m_pkey;
     m_row = std::move(other.m_row);
+    m_key = other.m_key;
     m_deleted = other.m_deleted;
     m_updated = other.m_updated;
     m_order = other.m_order;
@@ -63,6 +74,7 @@ t_mselem&
 t_mselem::operator=(const t_mselem& other) {
     m_pkey = other.m_pkey;
     m_row = other.m_row;
+    m_key = other.m_key;
     m_deleted = other.m_deleted;
     m_order = other.m_order;
     m_updated = other.m_updated;
@@ -73,6 +85,7 @@ t_mselem&
 t_mselem::operator=(t_mselem&& other) {
     m_pkey = other.m_pkey;
     m_row = std::move(other.m_row);
+    m_key = other.m_key;
     m_deleted = other.m_deleted;
     m_updated = other.m_updated;
     m_order = other.m_order;
@@ -208,6 +221,148 @@ nan_compare(t_sorttype order, const t_tscalar& a, const t_tscalar& b) {
     return rval;
 }
 
+namespace {
+
+// Maps a double onto an unsigned integer with the same ordering
+std::uint64_t
+encode_double(double v) {
+    // -0.0 and 0.0 encode alike
+    if (v == 0) {
+        v = 0;
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+}
+
+std::uint64_t
+encode_int64(std::int64_t v) {
+    return static_cast<std::uint64_t>(v) ^ 0x8000000000000000ULL;
+}
+
+// Big-endian prefix of a string, ordered as strcmp orders the full strings
+// when the words differ.
+std::uint64_t
+encode_str_prefix(const char* s, bool& exact) {
+    std::uint64_t rval = 0;
+    t_uindex idx = 0;
+    for (; idx < sizeof(rval) && s[idx] != 0; ++idx) {
+        rval |= std::uint64_t(static_cast<unsigned char>(s[idx])) << (56 - 8 * idx);
+    }
+    exact = idx < sizeof(rval) || s[idx] == 0;
+    return rval;
+}
+
+// Ascending encoding of a scalar; returns false if it cannot be encoded.
+bool
+encode_sort_value(const t_tscalar& v, bool abs, std::uint64_t& word, bool& exact) {
+    if (!v.is_valid())
+        return false;
+
+    exact = true;
+    if (v.is_floating_point()) {
+        double dbl = v.to_double();
+        if (std::isnan(dbl)) {
+#ifdef PSP_ENABLE_WASM
+            return false;
+#else
+            // NaNs sort before every other value, as in nan_compare
+            word = 0;
+            return true;
+#endif
+        }
+
+        // -0.0 and 0.0 share a word but are not equal scalars
+        exact = dbl != 0;
+        word = encode_double(abs ? std::abs(dbl) : dbl);
+        return true;
+    }
+
+    if (abs) {
+        if (!v.is_numeric())
+            return false;
+        word = encode_double(std::abs(v.to_double()));
+        return true;
+    }
+
+    switch (v.get_dtype()) {
+        case DTYPE_INT64:
+        case DTYPE_TIME: {
+            word = encode_int64(v.m_data.m_int64);
+        } break;
+        case DTYPE_INT32: {
+            word = encode_int64(v.m_data.m_int32);
+        } break;
+        case DTYPE_INT16: {
+            word = encode_int64(v.m_data.m_int16);
+        } break;
+        case DTYPE_INT8: {
+            word = encode_int64(v.m_data.m_int8);
+        } break;
+        case DTYPE_UINT64: {
+            word = v.m_data.m_uint64;
+        } break;
+        case DTYPE_UINT32:
+        case DTYPE_DATE: {
+            word = v.m_data.m_uint32;
+        } break;
+        case DTYPE_UINT16: {
+            word = v.m_data.m_uint16;
+        } break;
+        case DTYPE_UINT8: {
+            word = v.m_data.m_uint8;
+        } break;
+        case DTYPE_BOOL: {
+            word = v.m_data.m_bool;
+        } break;
+        case DTYPE_STR: {
+            word = encode_str_prefix(v.get_char_ptr(), exact);
+        } break;
+        default: { return false; }
+    }
+
+    return true;
+}
+
+} // namespace
+
+void
+encode_sort_key(t_mselem& elem, const std::vector<t_sorttype>& sort_order) {
+    t_sortkey& key = elem.m_key;
+    key = t_sortkey();
+
+    t_uindex nkeys = std::min(
+        {PSP_SORTKEY_WIDTH, t_uindex(sort_order.size()), t_uindex(elem.m_row.size())});
+
+    for (t_uindex idx = 0; idx < nkeys; ++idx) {
+        t_sorttype order = sort_order[idx];
+        if (order == SORTTYPE_NONE)
+            break;
+
+        bool abs = order == SORTTYPE_ASCENDING_ABS || order == SORTTYPE_DESCENDING_ABS;
+        bool exact = false;
+        std::uint64_t word = 0;
+        const t_tscalar& value = elem.m_row[idx];
+        if (!encode_sort_value(value, abs, word, exact))
+            break;
+
+        if (order == SORTTYPE_DESCENDING || order == SORTTYPE_DESCENDING_ABS) {
+            word = ~word;
+        }
+
+        // Equal absolute values of distinct scalars are ordered by pkey
+        if (abs) {
+            exact = false;
+        }
+
+        key.m_words[idx] = word;
+        key.m_tags[idx] = value.m_type + 1;
+        if (exact) {
+            key.m_exact |= 1 << idx;
+        }
+    }
+}
+
 t_multisorter::t_multisorter(const std::vector<t_sorttype>& order)
     : m_sort_order(order) {}
 
@@ -0,0 +1,185 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/pending_notify.h>
+#include <perspective/gnode.h>
+#include <perspective/gnode_state.h>
+#include <perspective/mask.h>
+#include <perspective/rlookup.h>
+
+namespace perspective {
+
+t_pending_notify::t_pending_notify()
+    : m_rebuild(false) {}
+
+void
+t_pending_notify::add(
+    const t_data_table& flattened, const t_data_table& prev, const t_data_table& existed) {
+    if (m_rebuild) {
+        return;
+    }
+
+    if (!m_prev) {
+        m_flattened_schema = flattened.get_schema();
+        m_prev = std::make_shared<t_data_table>(prev.get_schema());
+        m_prev->init();
+    }
+
+    const t_column* pkey_col = flattened.get_const_column("psp_pkey").get();
+    const t_column* op_col = flattened.get_const_column("psp_op").get();
+    const t_column* existed_col = existed.get_const_column("psp_existed").get();
+
+    // Only the first process touching a row knows its values from before
+    t_mask mask(flattened.size());
+    for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
+        t_tscalar pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx));
+        if (*(op_col->get_nth<std::uint8_t>(idx)) == OP_DELETE) {
+            m_deleted.insert(pkey);
+        }
+
+        if (m_rows.find(pkey) != m_rows.end()) {
+            continue;
+        }
+
+        m_rows[pkey] = m_pkeys.size();
+        m_pkeys.push_back(pkey);
+        m_existed.push_back(*(existed_col->get_nth<bool>(idx)));
+        mask.set(idx, true);
+    }
+
+    if (mask.count() > 0) {
+        m_prev->append(*(prev.clone(mask)));
+    }
+}
+
+void
+t_pending_notify::set_rebuild() {
+    clear();
+    m_rebuild = true;
+}
+
+bool
+t_pending_notify::empty() const {
+    return !m_rebuild && m_pkeys.empty();
+}
+
+bool
+t_pending_notify::needs_rebuild() const {
+    return m_rebuild;
+}
+
+t_uindex
+t_pending_notify::size() const {
+    return m_pkeys.size();
+}
+
+/**
+ * Rows deleted since they were recorded become a delete, and rows that were
+ * added or updated an insert of their current values. A row deleted and
+ * added again becomes both, as when a single process deletes and re-adds it.
+ */
+t_process_tables
+t_pending_notify::take(const t_gstate& gstate) {
+    std::shared_ptr<const t_data_table> stable = gstate.get_table();
+
+    std::vector<t_uindex> deletes;
+    std::vector<t_uindex> inserts;
+    std::vector<t_uindex> insert_rows;
+    for (t_uindex pidx = 0, loop_end = m_pkeys.size(); pidx < loop_end; ++pidx) {
+        t_rlookup lookup = gstate.lookup(m_pkeys[pidx]);
+        bool deleted = m_deleted.find(m_pkeys[pidx]) != m_deleted.end();
+        if (m_existed[pidx] && (deleted || !lookup.m_exists)) {
+            deletes.push_back(pidx);
+        }
+        if (lookup.m_exists) {
+            inserts.push_back(pidx);
+            insert_rows.push_back(lookup.m_idx);
+        }
+    }
+
+    t_uindex ndeletes = deletes.size();
+    t_uindex nrows = ndeletes + inserts.size();
+
+    t_process_tables rval;
+    rval.m_flattened = std::make_shared<t_data_table>(m_flattened_schema, nrows);
+    rval.m_flattened->init();
+    rval.m_flattened->set_size(nrows);
+
+    for (const auto& cname : m_flattened_schema.m_columns) {
+        if (cname != "psp_op" && cname != "psp_pkey") {
+            rval.m_flattened->get_column(cname)->copy(
+                stable->get_const_column(cname).get(), insert_rows, ndeletes);
+        }
+    }
+
+    const t_schema& tblschema = m_prev->get_schema();
+    std::vector<t_dtype> trans_types(tblschema.size(), DTYPE_UINT8);
+    t_schema trans_schema(tblschema.m_columns, trans_types);
+    t_schema existed_schema(
+        std::vector<std::string>{"psp_existed"}, std::vector<t_dtype>{DTYPE_BOOL});
+
+    rval.m_delta = std::make_shared<t_data_table>(tblschema, nrows);
+    rval.m_prev = std::make_shared<t_data_table>(tblschema, nrows);
+    rval.m_current = std::make_shared<t_data_table>(tblschema, nrows);
+    rval.m_transitions = std::make_shared<t_data_table>(trans_schema, nrows);
+    rval.m_existed = std::make_shared<t_data_table>(existed_schema, nrows);
+    for (auto tbl : {rval.m_delta, rval.m_prev, rval.m_current, rval.m_transitions,
+             rval.m_existed}) {
+        tbl->init();
+        tbl->set_size(nrows);
+    }
+
+    // Rows are looked up in the recorded prev table rather than the t_gstate
+    t_column* pkey_col = rval.m_flattened->get_column("psp_pkey").get();
+    t_column* op_col = rval.m_flattened->get_column("psp_op").get();
+    t_column* ecolumn = rval.m_existed->get_column("psp_existed").get();
+    std::vector<t_rlookup> lkup(nrows);
+    std::vector<bool> prev_pkey_eq_vec(nrows);
+    std::vector<t_uindex> added_offset(nrows);
+
+    for (t_uindex idx = 0; idx < nrows; ++idx) {
+        bool is_delete = idx < ndeletes;
+        t_uindex pidx = is_delete ? deletes[idx] : inserts[idx - ndeletes];
+        bool readded = !is_delete && m_existed[pidx]
+            && m_deleted.find(m_pkeys[pidx]) != m_deleted.end();
+
+        pkey_col->set_scalar(idx, m_pkeys[pidx]);
+        op_col->set_nth<std::uint8_t>(idx, is_delete ? OP_DELETE : OP_INSERT, STATUS_VALID);
+        lkup[idx] = t_rlookup(pidx, m_existed[pidx]);
+        prev_pkey_eq_vec[idx] = readded;
+        added_offset[idx] = idx;
+        ecolumn->set_nth<bool>(idx, is_delete || (m_existed[pidx] && !readded));
+    }
+
+    const std::uint8_t* op_base = op_col->get_nth<std::uint8_t>(0);
+    for (const auto& cname : tblschema.m_columns) {
+        t_gnode::process_column(rval.m_flattened->get_const_column(cname).get(),
+            m_prev->get_const_column(cname).get(), rval.m_delta->get_column(cname).get(),
+            rval.m_prev->get_column(cname).get(), rval.m_current->get_column(cname).get(),
+            rval.m_transitions->get_column(cname).get(), op_base, lkup, prev_pkey_eq_vec,
+            added_offset);
+    }
+
+    clear();
+    return rval;
+}
+
+void
+t_pending_notify::clear() {
+    m_rebuild = false;
+    m_prev.reset();
+    m_pkeys.clear();
+    m_existed.clear();
+    m_rows.clear();
+    m_deleted.clear();
+    m_symtable.clear();
+}
+
+} // end namespace perspective
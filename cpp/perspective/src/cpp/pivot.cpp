@@ -24,10 +24,34 @@ t_pivot::t_pivot(const std::string& colname)
     , m_name(colname)
     , m_mode(PIVOT_MODE_NORMAL) {}
 
+static const char*
+time_bucket_unit(t_pivot_mode mode) {
+    switch (mode) {
+        case PIVOT_MODE_TIME_BUCKET_MIN:
+            return "minute";
+        case PIVOT_MODE_TIME_BUCKET_HOUR:
+            return "hour";
+        case PIVOT_MODE_TIME_BUCKET_DAY:
+            return "day";
+        case PIVOT_MODE_TIME_BUCKET_WEEK:
+            return "week";
+        case PIVOT_MODE_TIME_BUCKET_MONTH:
+            return "month";
+        case PIVOT_MODE_TIME_BUCKET_YEAR:
+            return "year";
+        default:
+            return 0;
+    }
+}
+
 t_pivot::t_pivot(const std::string& colname, t_pivot_mode mode)
     : m_colname(colname)
     , m_name(colname)
-    , m_mode(mode) {}
+    , m_mode(mode) {
+    if (is_time_bucket()) {
+        m_name = colname + " (" + time_bucket_unit(mode) + ")";
+    }
+}
 
 const std::string&
 t_pivot::name() const {
@@ -44,6 +68,102 @@ t_pivot::mode() const {
     return m_mode;
 }
 
+bool
+t_pivot::is_time_bucket() const {
+    return time_bucket_unit(m_mode) != 0;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, month in [1, 12].
+static std::int64_t
+days_from_civil(std::int64_t y, std::int64_t m, std::int64_t d) {
+    y -= m <= 2;
+    std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    std::int64_t yoe = y - era * 400;
+    std::int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Inverse of days_from_civil.
+static void
+civil_from_days(std::int64_t z, std::int64_t& y, std::int64_t& m, std::int64_t& d) {
+    z += 719468;
+    std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    std::int64_t doe = z - era * 146097;
+    std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    std::int64_t mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = yoe + era * 400 + (m <= 2);
+}
+
+static std::int64_t
+floor_div(std::int64_t a, std::int64_t b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// First day of the bucket holding `days`, for day, week, month and year buckets.
+static std::int64_t
+bucket_days(std::int64_t days, t_pivot_mode mode) {
+    switch (mode) {
+        case PIVOT_MODE_TIME_BUCKET_WEEK: {
+            // 1970-01-01 was a Thursday
+            return days - (days + 3 - floor_div(days + 3, 7) * 7);
+        }
+        case PIVOT_MODE_TIME_BUCKET_MONTH:
+        case PIVOT_MODE_TIME_BUCKET_YEAR: {
+            std::int64_t y, m, d;
+            civil_from_days(days, y, m, d);
+            return days_from_civil(y, mode == PIVOT_MODE_TIME_BUCKET_YEAR ? 1 : m, 1);
+        }
+        default:
+            return days;
+    }
+}
+
+t_tscalar
+t_pivot::bucket(const t_tscalar& value) const {
+    if (!is_time_bucket() || !value.is_valid() || value.is_none()) {
+        return value;
+    }
+
+    static const std::int64_t MS_PER_MIN = 60 * 1000;
+    static const std::int64_t MS_PER_HOUR = 60 * MS_PER_MIN;
+    static const std::int64_t MS_PER_DAY = 24 * MS_PER_HOUR;
+
+    switch (value.get_dtype()) {
+        case DTYPE_TIME: {
+            std::int64_t ms = value.get<std::int64_t>();
+            std::int64_t rval;
+            switch (m_mode) {
+                case PIVOT_MODE_TIME_BUCKET_MIN: {
+                    rval = floor_div(ms, MS_PER_MIN) * MS_PER_MIN;
+                } break;
+                case PIVOT_MODE_TIME_BUCKET_HOUR: {
+                    rval = floor_div(ms, MS_PER_HOUR) * MS_PER_HOUR;
+                } break;
+                default: {
+                    rval = bucket_days(floor_div(ms, MS_PER_DAY), m_mode) * MS_PER_DAY;
+                } break;
+            }
+            return mktscalar(t_time(rval));
+        } break;
+        case DTYPE_DATE: {
+            t_date date = value.get<t_date>();
+            std::int64_t days = bucket_days(
+                days_from_civil(date.year(), date.month() + 1, date.day()), m_mode);
+            std::int64_t y, m, d;
+            civil_from_days(days, y, m, d);
+            return mktscalar(t_date(std::int16_t(y), std::int8_t(m - 1), std::int8_t(d)));
+        } break;
+        default: {
+            PSP_COMPLAIN_AND_ABORT("Time bucket pivots need a time or date column");
+        } break;
+    }
+    return value;
+}
+
 t_pivot_recipe
 t_pivot::get_recipe() const {
     t_pivot_recipe rv;
@@ -65,11 +65,15 @@ t_pool::init() {
 t_uindex
 t_pool::register_gnode(t_gnode* node) {
     std::lock_guard<std::mutex> lg(m_mtx);
+    std::lock_guard<std::shared_timed_mutex> gnodes_lg(m_gnodes_mtx);
 
     m_gnodes.push_back(node);
     t_uindex id = m_gnodes.size() - 1;
     node->set_id(id);
-    node->set_pool_cleanup([this, id]() { this->m_gnodes[id] = 0; });
+    node->set_pool_cleanup([this, id]() {
+        std::lock_guard<std::shared_timed_mutex> cleanup_lg(this->m_gnodes_mtx);
+        this->m_gnodes[id] = 0;
+    });
 
     if (t_env::log_progress()) {
         std::cout << "t_pool.register_gnode node => " << node << " rv => " << id << std::endl;
@@ -81,6 +85,7 @@ t_pool::register_gnode(t_gnode* node) {
 void
 t_pool::unregister_gnode(t_uindex idx) {
     std::lock_guard<std::mutex> lgxo(m_mtx);
+    std::lock_guard<std::shared_timed_mutex> gnodes_lg(m_gnodes_mtx);
 
     if (t_env::log_progress()) {
         std::cout << "t_pool.unregister_gnode idx => " << idx << std::endl;
@@ -91,23 +96,47 @@ t_pool::unregister_gnode(t_uindex idx) {
 
 void
 t_pool::send(t_uindex gnode_id, t_uindex port_id, const t_data_table& table) {
+    if (t_env::log_progress()) {
+        std::cout << "t_pool.send gnode_id => " << gnode_id << " port_id => " << port_id
+                  << " tbl_size => " << table.size() << std::endl;
+    }
+
+    if (t_env::log_data_pool_send()) {
+        std::cout << "t_pool.send" << std::endl;
+        table.pprint();
+    }
+
     {
-        std::lock_guard<std::mutex> lg(m_mtx);
-        m_data_remaining.store(true);
-        if (m_gnodes[gnode_id]) {
-            m_gnodes[gnode_id]->_send(port_id, table);
+        // Held while staging, so the gnode is not unregistered and destroyed under it
+        std::shared_lock<std::shared_timed_mutex> gnodes_lg(m_gnodes_mtx);
+        if (t_gnode* gnode = m_gnodes[gnode_id]) {
+            gnode->stage(port_id, table);
         }
+    }
 
-        if (t_env::log_progress()) {
-            std::cout << "t_pool.send gnode_id => " << gnode_id << " port_id => " << port_id
-                      << " tbl_size => " << table.size() << std::endl;
-        }
+    // Set after staging, so processing that clears it sees the table
+    m_data_remaining.store(true);
+}
+
+void
+t_pool::send(t_uindex gnode_id, t_uindex port_id, std::shared_ptr<t_data_table> table) {
+    if (t_env::log_progress()) {
+        std::cout << "t_pool.send gnode_id => " << gnode_id << " port_id => " << port_id
+                  << " tbl_size => " << table->size() << std::endl;
+    }
 
-        if (t_env::log_data_pool_send()) {
-            std::cout << "t_pool.send" << std::endl;
-            table.pprint();
+    if (t_env::log_data_pool_send()) {
+        std::cout << "t_pool.send" << std::endl;
+        table->pprint();
+    }
+
+    {
+        std::shared_lock<std::shared_timed_mutex> gnodes_lg(m_gnodes_mtx);
+        if (t_gnode* gnode = m_gnodes[gnode_id]) {
+            gnode->stage(port_id, std::move(table));
         }
     }
+    m_data_remaining.store(true);
 }
 
 void
@@ -322,23 +351,18 @@ t_pool::has_python_dep() const {
     return rv;
 }
 
+// t_update_task::run takes m_mtx itself, and notifies after releasing it.
 void
 t_pool::flush() {
-    std::lock_guard<std::mutex> lg(m_mtx);
     if (!m_data_remaining.load())
         return;
 
-    for (t_uindex idx = 0, loop_end = m_gnodes.size(); idx < loop_end; ++idx) {
-        if (m_gnodes[idx]) {
-            t_update_task task(*this);
-            task.run(idx);
-        }
-    }
+    t_update_task task(*this);
+    task.run();
 }
 
 void
 t_pool::flush(t_uindex gnode_id) {
-    std::lock_guard<std::mutex> lg(m_mtx);
     auto work_to_do = m_data_remaining.load();
     if (work_to_do) {
         t_update_task task(*this);
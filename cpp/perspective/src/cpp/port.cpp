@@ -9,9 +9,41 @@
 
 #include <perspective/first.h>
 #include <perspective/port.h>
+#include <algorithm>
 
 namespace perspective {
 
+t_port_staging::t_port_staging()
+    : m_head(nullptr) {}
+
+t_port_staging::~t_port_staging() { take(); }
+
+void
+t_port_staging::push(t_uindex port_id, std::shared_ptr<t_data_table> tbl) {
+    t_node* node = new t_node{t_staged(port_id, std::move(tbl)), m_head.load()};
+    while (!m_head.compare_exchange_weak(node->m_next, node)) {
+    }
+}
+
+std::vector<t_port_staging::t_staged>
+t_port_staging::take() {
+    std::vector<t_staged> rval;
+    t_node* node = m_head.exchange(nullptr);
+    while (node) {
+        t_node* next = node->m_next;
+        rval.push_back(std::move(node->m_staged));
+        delete node;
+        node = next;
+    }
+    std::reverse(rval.begin(), rval.end());
+    return rval;
+}
+
+bool
+t_port_staging::empty() const {
+    return m_head.load() == nullptr;
+}
+
 t_port::t_port(t_port_mode mode, const t_schema& schema)
     : m_schema(schema)
     , m_init(false)
@@ -33,6 +65,10 @@ t_port::init() {
 
 std::shared_ptr<t_data_table>
 t_port::get_table() {
+    for (const auto& tbl : m_queued) {
+        m_table->append(*tbl);
+    }
+    m_queued.clear();
     return m_table;
 }
 
@@ -44,12 +80,40 @@ t_port::set_table(std::shared_ptr<t_data_table> table) {
 
 void
 t_port::send(std::shared_ptr<const t_data_table> table) {
-    m_table->append(*table.get());
+    get_table()->append(*table.get());
 }
 
 void
 t_port::send(const t_data_table& table) {
-    m_table->append(table);
+    get_table()->append(table);
+}
+
+void
+t_port::send(std::shared_ptr<t_data_table> table) {
+    if (!(table->get_schema() == m_schema)) {
+        get_table()->append(*table);
+        return;
+    }
+
+    if (m_table->size() == 0 && m_queued.empty()) {
+        m_table = table;
+    } else {
+        m_queued.push_back(table);
+    }
+}
+
+t_uindex
+t_port::size() const {
+    t_uindex rval = m_table->size();
+    for (const auto& tbl : m_queued) {
+        rval += tbl->size();
+    }
+    return rval;
+}
+
+std::shared_ptr<t_data_table>
+t_port::flatten() const {
+    return m_table->flatten(m_queued);
 }
 
 t_schema
@@ -64,8 +128,9 @@ t_port::release()
     if (!m_table.get())
         return;
 
-    t_uindex size = m_table->size();
+    t_uindex size = this->size();
 
+    m_queued.clear();
     m_table = nullptr;
     m_table = std::make_shared<t_data_table>(
         "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
@@ -81,9 +146,10 @@ t_port::release_or_clear()
     if (!m_table.get())
         return;
 
-    t_uindex size = m_table->size();
+    t_uindex size = this->size();
 
     if (static_cast<double>(size) < 0.4 * double(m_prevsize)) {
+        m_queued.clear();
         m_table->clear();
     } else {
         release();
@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/sketch.h>
+#include <perspective/column.h>
+
+namespace perspective {
+
+void
+t_column_sketches::enable(const std::string& colname, t_dtype dtype, t_uindex nbuckets) {
+    if (!is_numeric_type(dtype)) {
+        PSP_COMPLAIN_AND_ABORT(
+            "Cannot sketch column " + colname + " of type " + get_dtype_descr(dtype));
+    }
+    m_sketches[colname] = t_column_sketch(nbuckets);
+}
+
+bool
+t_column_sketches::has_sketch(const std::string& colname) const {
+    return m_sketches.find(colname) != m_sketches.end();
+}
+
+const t_column_sketch&
+t_column_sketches::get_sketch(const std::string& colname) const {
+    auto iter = m_sketches.find(colname);
+    if (iter == m_sketches.end()) {
+        PSP_COMPLAIN_AND_ABORT("No sketch for column " + colname);
+    }
+    return iter->second;
+}
+
+bool
+t_column_sketches::empty() const {
+    return m_sketches.empty();
+}
+
+void
+t_column_sketches::clear() {
+    for (auto& kv : m_sketches) {
+        kv.second = t_column_sketch(kv.second.get_histogram().nbuckets());
+    }
+}
+
+void
+t_column_sketches::add_rows(const t_data_table& tbl, const t_mask* mask) {
+    t_uindex nrows = tbl.size();
+    const t_column* op_col = tbl.get_schema().has_column("psp_op")
+        ? tbl.get_const_column("psp_op").get()
+        : nullptr;
+
+    for (auto& kv : m_sketches) {
+        const t_column* col = tbl.get_const_column(kv.first).get();
+        t_column_sketch& sketch = kv.second;
+        for (t_uindex idx = 0; idx < nrows; ++idx) {
+            if (mask && !mask->get(idx)) {
+                continue;
+            }
+            if (op_col && *(op_col->get_nth<std::uint8_t>(idx)) == OP_DELETE) {
+                continue;
+            }
+            if (col->is_valid(idx)) {
+                sketch.add(col->get_scalar(idx).to_double());
+            }
+        }
+        sketch.compress();
+    }
+}
+
+void
+t_column_sketches::update(const t_data_table& flattened, const t_data_table& prev,
+    const t_data_table& curr, const t_data_table& existed, const t_mask* msk_prev,
+    const t_mask* msk_curr) {
+    t_uindex nrows = flattened.size();
+    const t_column* op_col = flattened.get_const_column("psp_op").get();
+    const t_column* existed_col = existed.get_const_column("psp_existed").get();
+
+    for (auto& kv : m_sketches) {
+        const t_column* pcol = prev.get_const_column(kv.first).get();
+        const t_column* ccol = curr.get_const_column(kv.first).get();
+        t_column_sketch& sketch = kv.second;
+
+        for (t_uindex idx = 0; idx < nrows; ++idx) {
+            t_op op = static_cast<t_op>(*(op_col->get_nth<std::uint8_t>(idx)));
+            bool had_prev
+                = *(existed_col->get_nth<bool>(idx)) && (!msk_prev || msk_prev->get(idx));
+            bool has_curr = op == OP_INSERT && (!msk_curr || msk_curr->get(idx));
+
+            if (had_prev && pcol->is_valid(idx)) {
+                sketch.remove(pcol->get_scalar(idx).to_double());
+            }
+            if (has_curr && ccol->is_valid(idx)) {
+                sketch.add(ccol->get_scalar(idx).to_double());
+            }
+        }
+        sketch.compress();
+    }
+}
+
+bool
+t_column_sketches::is_stale() const {
+    for (const auto& kv : m_sketches) {
+        if (kv.second.is_stale()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+t_column_sketches::rebuild(const t_data_table& tbl, const t_mask* mask) {
+    clear();
+    add_rows(tbl, mask);
+}
+
+} // end namespace perspective
@@ -0,0 +1,275 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/snapshot.h>
+#include <perspective/column.h>
+#include <perspective/defaults.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace perspective {
+
+static const std::string SNAPSHOT_MAGIC("perspective_snapshot");
+static const t_uindex SNAPSHOT_VERSION = 1;
+
+// Files are padded to this size, as an empty file cannot be mapped
+static const t_uindex SNAPSHOT_MIN_FILE_SIZE = 8;
+
+static std::string
+snapshot_path(const std::string& dirname, const std::string& name) {
+    return dirname + "/" + name;
+}
+
+static std::string
+snapshot_store_name(t_uindex colidx, const std::string& store) {
+    std::stringstream ss;
+    ss << colidx << "_" << store;
+    return ss.str();
+}
+
+// Writes `size` bytes to a temporary file beside `fname` and returns its name.
+static std::string
+write_snapshot_file(const std::string& fname, const void* data, t_uindex size) {
+    std::string tmp_fname = fname + ".tmp";
+    std::ofstream out(tmp_fname, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not open " + tmp_fname);
+    }
+
+    out.write(static_cast<const char*>(data), std::streamsize(size));
+    if (size < SNAPSHOT_MIN_FILE_SIZE) {
+        std::vector<char> padding(SNAPSHOT_MIN_FILE_SIZE - size, 0);
+        out.write(padding.data(), std::streamsize(padding.size()));
+    }
+
+    if (!out) {
+        std::remove(tmp_fname.c_str());
+        throw std::runtime_error("Could not write " + tmp_fname);
+    }
+    return tmp_fname;
+}
+
+void
+t_snapshot::save(const t_data_table& tbl, const std::vector<t_uindex>& free_rows,
+    const std::string& dirname) {
+    const t_schema& schema = tbl.get_schema();
+
+    // Pairs of (written, final) names, renamed once every file is complete
+    std::vector<std::pair<std::string, std::string>> renames;
+
+    auto write = [&](const std::string& name, const void* data, t_uindex size) {
+        std::string fname = snapshot_path(dirname, name);
+        try {
+            renames.emplace_back(write_snapshot_file(fname, data, size), fname);
+        } catch (...) {
+            for (const auto& rename : renames) {
+                std::remove(rename.first.c_str());
+            }
+            throw;
+        }
+    };
+
+    auto write_store = [&](t_uindex colidx, const std::string& store, const t_lstore& lstore) {
+        write(snapshot_store_name(colidx, store), lstore.get_ptr(0), lstore.size());
+        return lstore.size();
+    };
+
+    std::stringstream manifest;
+    manifest << SNAPSHOT_MAGIC << " " << SNAPSHOT_VERSION << "\n"
+             << tbl.size() << " " << schema.size() << " " << free_rows.size() << "\n";
+
+    for (t_uindex cidx = 0, loop_end = schema.size(); cidx < loop_end; ++cidx) {
+        auto col = tbl.get_const_column(cidx);
+        t_dtype dtype = col->get_dtype();
+        bool status_enabled = col->is_status_enabled();
+
+        t_uindex data_size = write_store(cidx, "data", col->data_lstore());
+        t_uindex status_size = 0;
+        t_uindex vlendata_size = 0;
+        t_uindex extents_size = 0;
+
+        if (status_enabled) {
+            status_size = write_store(cidx, "status", col->status_lstore());
+        }
+
+        if (is_vlen_dtype(dtype)) {
+            vlendata_size = write_store(cidx, "vlendata", col->vlendata_lstore());
+            extents_size = write_store(cidx, "extents", col->extents_lstore());
+        }
+
+        const std::string& colname = schema.m_columns[cidx];
+        manifest << static_cast<std::int32_t>(dtype) << " " << status_enabled << " "
+                 << col->get_vlenidx() << " " << data_size << " " << status_size << " "
+                 << vlendata_size << " " << extents_size << " " << colname.size() << " "
+                 << colname << "\n";
+    }
+
+    write("free_rows", free_rows.data(), free_rows.size() * sizeof(t_uindex));
+
+    // The manifest goes last, so a complete one never names missing files
+    std::string manifest_str = manifest.str();
+    write("manifest", manifest_str.data(), manifest_str.size());
+
+    // The old manifest goes first, so a partly replaced directory is not
+    // read as a snapshot whose stores have other sizes
+    std::string manifest_fname = snapshot_path(dirname, "manifest");
+    if (std::remove(manifest_fname.c_str()) != 0 && errno != ENOENT) {
+        throw std::runtime_error("Could not replace " + manifest_fname);
+    }
+
+    for (const auto& rename : renames) {
+        if (std::rename(rename.first.c_str(), rename.second.c_str()) != 0) {
+            throw std::runtime_error("Could not replace " + rename.second);
+        }
+    }
+}
+
+t_snapshot::t_snapshot(const std::string& dirname)
+    : m_dirname(dirname)
+    , m_nrows(0) {
+    std::string manifest_fname = snapshot_path(dirname, "manifest");
+    std::ifstream manifest(manifest_fname);
+    if (!manifest) {
+        throw std::runtime_error("Could not open " + manifest_fname);
+    }
+
+    std::string magic;
+    t_uindex version = 0;
+    manifest >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        throw std::invalid_argument("Unsupported snapshot " + dirname);
+    }
+
+    t_uindex ncols = 0;
+    t_uindex nfree = 0;
+    manifest >> m_nrows >> ncols >> nfree;
+    if (!manifest) {
+        throw std::invalid_argument("Corrupt snapshot manifest " + manifest_fname);
+    }
+
+    std::vector<std::string> columns(ncols);
+    std::vector<t_dtype> types(ncols);
+    std::vector<bool> status_enabled(ncols);
+    m_recipes.resize(ncols);
+
+    for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
+        std::int32_t dtype = 0;
+        bool is_status_enabled = false;
+        t_uindex vlenidx = 0;
+        t_uindex data_size = 0;
+        t_uindex status_size = 0;
+        t_uindex vlendata_size = 0;
+        t_uindex extents_size = 0;
+        t_uindex name_size = 0;
+
+        manifest >> dtype >> is_status_enabled >> vlenidx >> data_size >> status_size
+            >> vlendata_size >> extents_size >> name_size;
+        manifest.get();
+        if (!manifest || dtype < 0 || dtype >= DTYPE_LAST) {
+            throw std::invalid_argument("Corrupt snapshot manifest " + manifest_fname);
+        }
+
+        columns[cidx].resize(name_size);
+        manifest.read(&columns[cidx][0], std::streamsize(name_size));
+        types[cidx] = static_cast<t_dtype>(dtype);
+        status_enabled[cidx] = is_status_enabled;
+
+        t_column_recipe& recipe = m_recipes[cidx];
+        recipe.m_dtype = types[cidx];
+        recipe.m_isvlen = is_vlen_dtype(types[cidx]);
+        recipe.m_data = get_recipe(cidx, "data", data_size);
+        recipe.m_status_enabled = is_status_enabled;
+        if (is_status_enabled) {
+            recipe.m_status = get_recipe(cidx, "status", status_size);
+        }
+        if (recipe.m_isvlen) {
+            recipe.m_vlendata = get_recipe(cidx, "vlendata", vlendata_size);
+            recipe.m_extents = get_recipe(cidx, "extents", extents_size);
+        }
+        recipe.m_vlenidx = vlenidx;
+        recipe.m_size = m_nrows;
+    }
+
+    if (!manifest) {
+        throw std::invalid_argument("Corrupt snapshot manifest " + manifest_fname);
+    }
+
+    m_schema = t_schema(columns, types);
+    m_schema.m_status_enabled = status_enabled;
+
+    std::string free_fname = snapshot_path(dirname, "free_rows");
+    std::ifstream free_rows(free_fname, std::ios::binary);
+    m_free_rows.resize(nfree);
+    free_rows.read(
+        reinterpret_cast<char*>(m_free_rows.data()), std::streamsize(nfree * sizeof(t_uindex)));
+    if (!free_rows) {
+        throw std::invalid_argument("Could not read " + free_fname);
+    }
+}
+
+t_lstore_recipe
+t_snapshot::get_recipe(t_uindex colidx, const std::string& store, t_uindex size) const {
+    std::string name = snapshot_store_name(colidx, store);
+    t_lstore_recipe rval(m_dirname, name, std::max(size, SNAPSHOT_MIN_FILE_SIZE),
+        PSP_DEFAULT_SNAPSHOT_FFLAGS, PSP_DEFAULT_SNAPSHOT_FMODE,
+        PSP_DEFAULT_SNAPSHOT_CREATION_DISPOSITION, PSP_DEFAULT_SNAPSHOT_MPROT,
+        PSP_DEFAULT_SNAPSHOT_MFLAGS, BACKING_STORE_DISK);
+    rval.m_fname = snapshot_path(m_dirname, name);
+    rval.m_from_recipe = true;
+    rval.m_size = size;
+    return rval;
+}
+
+const t_schema&
+t_snapshot::get_schema() const {
+    return m_schema;
+}
+
+t_uindex
+t_snapshot::num_rows() const {
+    return m_nrows;
+}
+
+const std::vector<t_uindex>&
+t_snapshot::get_free_rows() const {
+    return m_free_rows;
+}
+
+void
+t_snapshot::load(t_data_table& tbl) const {
+    const t_schema& schema = tbl.get_schema();
+    if (schema.m_columns != m_schema.m_columns || schema.m_types != m_schema.m_types) {
+        throw std::invalid_argument("Snapshot schema does not match table " + m_dirname);
+    }
+
+    for (t_uindex cidx = 0, loop_end = m_recipes.size(); cidx < loop_end; ++cidx) {
+        auto col = std::make_shared<t_column>(m_recipes[cidx]);
+        col->init();
+        tbl.set_column(cidx, col);
+    }
+
+    // Keeps t_gstate's `capacity - 1` growth check meaningful for empty tables
+    tbl.set_size(m_nrows);
+    tbl.set_capacity(std::max(m_nrows, t_uindex(1)));
+}
+
+std::shared_ptr<t_data_table>
+t_snapshot::load() const {
+    auto tbl = std::make_shared<t_data_table>(m_schema);
+    tbl->init();
+    load(*tbl);
+    return tbl;
+}
+
+} // end namespace perspective
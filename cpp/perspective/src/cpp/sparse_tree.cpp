@@ -20,12 +20,12 @@
 #include <perspective/tracing.h>
 #include <perspective/utils.h>
 #include <perspective/env_vars.h>
+#include <perspective/parallel.h>
 #include <perspective/dense_tree.h>
 #include <perspective/dense_tree_context.h>
 #include <perspective/gnode_state.h>
 #include <perspective/config.h>
 #include <perspective/data_table.h>
-#include <perspective/filter_utils.h>
 #include <perspective/context_two.h>
 #include <set>
 
@@ -78,6 +78,7 @@ t_stree::t_stree(const std::vector<t_pivot>& pivots, const std::vector<t_aggspec
     , m_aggspecs(aggspecs)
     , m_schema(schema)
     , m_cur_aggidx(1)
+    , m_minmax_tracked(false)
     , m_minmax(aggspecs.size())
     , m_has_delta(false) {
     auto g_agg_str = cfg.get_grand_agg_str();
@@ -104,7 +105,7 @@ t_stree::repr() const {
 
 void
 t_stree::init() {
-    m_nodes = std::make_shared<t_treenodes>();
+    m_nodes = std::make_shared<t_stnode_store>();
     m_idxpkey = std::make_shared<t_idxpkey>();
     m_idxleaf = std::make_shared<t_idxleaf>();
 
@@ -139,61 +140,50 @@ t_stree::init() {
 
     m_deltas = std::make_shared<t_tcdeltas>();
     m_features = std::vector<bool>(CTX_FEAT_LAST_FEATURE);
+
+    t_uindex ndepths = m_pivots.size() + 1;
+    m_minmax = std::vector<t_minmax>(columns.size());
+    m_minmax_dirty = std::vector<std::uint8_t>(columns.size(), 1);
+    m_depth_minmax = std::vector<std::vector<t_minmax>>(
+        columns.size(), std::vector<t_minmax>(ndepths));
+    m_depth_minmax_dirty = std::vector<std::vector<std::uint8_t>>(
+        columns.size(), std::vector<std::uint8_t>(ndepths, 1));
     m_init = true;
 }
 
 t_tscalar
 t_stree::get_value(t_index idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Reached end iterator");
-    return iter->m_value;
+    PSP_VERBOSE_ASSERT(m_nodes->contains(idx), "Reached end iterator");
+    return m_nodes->get_value(idx);
 }
 
 t_tscalar
 t_stree::get_sortby_value(t_index idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Reached end iterator");
-    return iter->m_sort_value;
+    PSP_VERBOSE_ASSERT(m_nodes->contains(idx), "Reached end iterator");
+    return m_nodes->get_sort_value(idx);
 }
 
 void
-t_stree::build_strand_table_phase_1(t_tscalar pkey, t_op op, t_uindex idx, t_uindex npivots,
-    t_uindex strand_count_idx, t_uindex aggcolsize, bool force_current_row,
-    const std::vector<const t_column*>& piv_ccols,
-    const std::vector<const t_column*>& piv_tcols,
-    const std::vector<const t_column*>& agg_ccols,
-    const std::vector<const t_column*>& agg_dcols, std::vector<t_column*>& piv_scols,
-    std::vector<t_column*>& agg_acols, t_column* agg_scount, t_column* spkey,
-    t_uindex& insert_count, bool& pivots_neq,
-    const std::vector<std::string>& pivot_like) const {
+t_stree::build_strand_table_phase_1(t_op op, t_uindex idx, t_uindex npivots,
+    bool force_current_row, const std::vector<const t_column*>& piv_tcols,
+    const std::vector<const t_column*>& piv_pcols,
+    const std::vector<const t_column*>& piv_ccols, const std::vector<t_pivot>& piv_sources,
+    std::vector<t_strand_row>& rows, bool& pivots_neq) const {
     pivots_neq = false;
-    std::set<std::string> pivmap;
     bool all_eq_tt = true;
 
-    for (t_uindex pidx = 0, ploop_end = pivot_like.size(); pidx < ploop_end; ++pidx) {
-        const std::string& colname = pivot_like.at(pidx);
-        if (pivmap.find(colname) != pivmap.end()) {
-            continue;
-        }
-        pivmap.insert(colname);
-        piv_scols[pidx]->push_back(piv_ccols[pidx]->get_scalar(idx));
+    for (t_uindex pidx = 0, ploop_end = piv_tcols.size(); pidx < ploop_end; ++pidx) {
         const std::uint8_t* trans_ = piv_tcols[pidx]->get_nth<std::uint8_t>(idx);
         t_value_transition trans = static_cast<t_value_transition>(*trans_);
         if (trans != VALUE_TRANSITION_EQ_TT)
             all_eq_tt = false;
 
-        if (pidx < npivots) {
-            pivots_neq = pivots_neq || pivots_changed(trans);
-        }
-    }
-
-    for (t_uindex aggidx = 0; aggidx < aggcolsize; ++aggidx) {
-        if (aggidx != strand_count_idx) {
-            if (pivots_neq || force_current_row) {
-                agg_acols[aggidx]->push_back(agg_ccols[aggidx]->get_scalar(idx));
-            } else {
-                agg_acols[aggidx]->push_back(agg_dcols[aggidx]->get_scalar(idx));
-            }
+        if (pidx < npivots && !pivots_neq && pivots_changed(trans)) {
+            // A time that moves within its bucket leaves the row in place
+            const t_pivot& source = piv_sources[pidx];
+            pivots_neq = trans != VALUE_TRANSITION_NEQ_TT || !source.is_time_bucket()
+                || source.bucket(piv_pcols[pidx]->get_scalar(idx))
+                    != source.bucket(piv_ccols[pidx]->get_scalar(idx));
         }
     }
 
@@ -209,38 +199,87 @@ t_stree::build_strand_table_phase_1(t_tscalar pkey, t_op op, t_uindex idx, t_uin
             cval = npivots == 0 || !all_eq_tt || pivots_neq || force_current_row ? 1 : 0;
         }
     }
-    agg_scount->push_back<std::int8_t>(cval);
-    spkey->push_back(pkey);
 
-    ++insert_count;
+    t_strand_row row;
+    row.m_idx = idx;
+    row.m_count = cval;
+    row.m_from_prev = false;
+    row.m_use_current = pivots_neq || force_current_row;
+    rows.push_back(row);
 }
 
 void
-t_stree::build_strand_table_phase_2(t_tscalar pkey, t_uindex idx, t_uindex npivots,
-    t_uindex strand_count_idx, t_uindex aggcolsize,
-    const std::vector<const t_column*>& piv_pcols,
-    const std::vector<const t_column*>& agg_pcols, std::vector<t_column*>& piv_scols,
-    std::vector<t_column*>& agg_acols, t_column* agg_scount, t_column* spkey,
-    t_uindex& insert_count, const std::vector<std::string>& pivot_like) const {
-    std::set<std::string> pivmap;
-    for (t_uindex pidx = 0, ploop_end = pivot_like.size(); pidx < ploop_end; ++pidx) {
-        const std::string& colname = pivot_like.at(pidx);
-        if (pivmap.find(colname) != pivmap.end()) {
-            continue;
-        }
-        pivmap.insert(colname);
-        piv_scols[pidx]->push_back(piv_pcols[pidx]->get_scalar(idx));
-    }
-
-    for (t_uindex aggidx = 0; aggidx < aggcolsize; ++aggidx) {
-        if (aggidx != strand_count_idx) {
-            agg_acols[aggidx]->push_back(agg_pcols[aggidx]->get_scalar(idx).negate());
-        }
-    }
+t_stree::build_strand_table_phase_2(t_uindex idx, std::vector<t_strand_row>& rows) const {
+    t_strand_row row;
+    row.m_idx = idx;
+    row.m_count = -1;
+    row.m_from_prev = true;
+    row.m_use_current = false;
+    rows.push_back(row);
+}
 
-    agg_scount->push_back<std::int8_t>(std::int8_t(-1));
-    spkey->push_back(pkey);
-    ++insert_count;
+void
+t_stree::fill_strand_table(const std::vector<t_strand_row>& rows, const t_column* pkey_col,
+    const std::vector<const t_column*>& piv_pcols,
+    const std::vector<const t_column*>& piv_ccols, const std::vector<t_pivot>& piv_sources,
+    std::vector<t_column*>& piv_scols, const std::vector<const t_column*>& agg_pcols,
+    const std::vector<const t_column*>& agg_ccols,
+    const std::vector<const t_column*>& agg_dcols, std::vector<t_column*>& agg_acols,
+    t_uindex strand_count_idx, t_column* spkey) const {
+    t_uindex npivotlike = piv_scols.size();
+    t_uindex aggcolsize = agg_acols.size();
+    t_uindex ncols = npivotlike + aggcolsize + 1;
+
+    // Every output column is filled from the row plan independently.
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(ncols), 1,
+            [&](int colidx)
+#else
+        for (t_uindex colidx = 0; colidx < ncols; ++colidx)
+#endif
+            {
+                if (t_uindex(colidx) < npivotlike) {
+                    t_uindex pidx = colidx;
+                    t_column* scol = piv_scols[pidx];
+                    const t_pivot& source = piv_sources[pidx];
+                    scol->reserve(rows.size());
+                    for (const auto& row : rows) {
+                        const t_column* icol
+                            = row.m_from_prev ? piv_pcols[pidx] : piv_ccols[pidx];
+                        scol->push_back(source.bucket(icol->get_scalar(row.m_idx)));
+                    }
+                } else if (t_uindex(colidx) < npivotlike + aggcolsize) {
+                    t_uindex aggidx = colidx - npivotlike;
+                    t_column* acol = agg_acols[aggidx];
+                    acol->reserve(rows.size());
+                    if (aggidx == strand_count_idx) {
+                        for (const auto& row : rows) {
+                            acol->push_back<std::int8_t>(row.m_count);
+                        }
+                    } else {
+                        for (const auto& row : rows) {
+                            if (row.m_from_prev) {
+                                acol->push_back(
+                                    agg_pcols[aggidx]->get_scalar(row.m_idx).negate());
+                            } else if (row.m_use_current) {
+                                acol->push_back(agg_ccols[aggidx]->get_scalar(row.m_idx));
+                            } else {
+                                acol->push_back(agg_dcols[aggidx]->get_scalar(row.m_idx));
+                            }
+                        }
+                    }
+                } else {
+                    spkey->reserve(rows.size());
+                    for (const auto& row : rows) {
+                        spkey->push_back(pkey_col->get_scalar(row.m_idx));
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
 }
 
 t_build_strand_table_common_rval
@@ -254,19 +293,26 @@ t_stree::build_strand_table_common(const t_data_table& flattened,
     rv.m_flattened_schema = flattened.get_schema();
     std::set<std::string> sschema_colset;
 
-    for (const auto& piv : m_pivots) {
-        const std::string& colname = piv.colname();
-        std::string sortby_colname = config.get_sort_by(colname);
-        auto add_col = [&sschema_colset, &rv](const std::string& cname) {
-            if (sschema_colset.find(cname) == sschema_colset.end()) {
-                rv.m_pivot_like_columns.push_back(cname);
-                rv.m_strand_schema.add_column(cname, rv.m_flattened_schema.get_dtype(cname));
-                sschema_colset.insert(cname);
-            }
-        };
+    auto add_col = [&sschema_colset, &rv](const t_pivot& source) {
+        const std::string& cname = source.name();
+        if (sschema_colset.find(cname) == sschema_colset.end()) {
+            t_dtype dtype = rv.m_flattened_schema.get_dtype(source.colname());
+            PSP_VERBOSE_ASSERT(!source.is_time_bucket() || dtype == DTYPE_TIME
+                    || dtype == DTYPE_DATE,
+                "Time bucket pivots need a time or date column");
+            rv.m_pivot_like_columns.push_back(cname);
+            rv.m_pivot_like_sources.push_back(source);
+            rv.m_strand_schema.add_column(cname, dtype);
+            sschema_colset.insert(cname);
+        }
+    };
 
-        add_col(colname);
-        add_col(sortby_colname);
+    for (const auto& piv : m_pivots) {
+        std::string sortby_colname = config.get_sort_by(piv.name());
+        add_col(piv);
+        if (sortby_colname != piv.name()) {
+            add_col(t_pivot(sortby_colname));
+        }
     }
 
     rv.m_pivsize = sschema_colset.size();
@@ -278,12 +324,8 @@ t_stree::build_strand_table_common(const t_data_table& flattened,
                 const std::string& depname = dep.name();
                 aggcolset.insert(depname);
 
-                if (aggspec.is_non_delta()
-                    && sschema_colset.find(depname) == sschema_colset.end()) {
-                    rv.m_pivot_like_columns.push_back(depname);
-                    rv.m_strand_schema.add_column(
-                        depname, rv.m_flattened_schema.get_dtype(depname));
-                    sschema_colset.insert(depname);
+                if (aggspec.is_non_delta()) {
+                    add_col(t_pivot(depname));
                 }
             }
         }
@@ -306,7 +348,8 @@ t_stree::build_strand_table_common(const t_data_table& flattened,
 std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>>
 t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& delta,
     const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
-    const std::vector<t_aggspec>& aggspecs, const t_config& config) const {
+    const std::vector<t_aggspec>& aggspecs, const t_config& config, const t_mask* msk_prev,
+    const t_mask* msk_curr) const {
 
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
@@ -330,13 +373,12 @@ t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& d
     std::vector<const t_column*> piv_tcols(npivotlike);
     std::vector<t_column*> piv_scols(npivotlike);
 
-    t_uindex insert_count = 0;
-
     for (t_uindex pidx = 0; pidx < npivotlike; ++pidx) {
         const std::string& piv = rv.m_strand_schema.m_columns[pidx];
-        piv_pcols[pidx] = prev.get_const_column(piv).get();
-        piv_ccols[pidx] = current.get_const_column(piv).get();
-        piv_tcols[pidx] = transitions.get_const_column(piv).get();
+        const std::string& source = rv.m_pivot_like_sources[pidx].colname();
+        piv_pcols[pidx] = prev.get_const_column(source).get();
+        piv_ccols[pidx] = current.get_const_column(source).get();
+        piv_tcols[pidx] = transitions.get_const_column(source).get();
         piv_scols[pidx] = strands->get_column(piv).get();
     }
 
@@ -368,21 +410,19 @@ t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& d
 
     t_column* spkey = strands->get_column("psp_pkey").get();
 
-    t_mask msk_prev, msk_curr;
-
-    if (config.has_filters()) {
-        msk_prev = filter_table_for_config(prev, config);
-        msk_curr = filter_table_for_config(current, config);
-    }
+    // Filter verdicts come from the context, null without filters
+    bool has_filters = msk_curr != nullptr;
 
-    bool has_filters = config.has_filters();
+    // Decide which source rows make up the strand table serially, then
+    // build the columns from that plan.
+    std::vector<t_strand_row> rows;
+    rows.reserve(flattened.size());
 
     if (has_filters) {
         for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
-            bool filter_prev = msk_prev.get(idx);
-            bool filter_curr = msk_curr.get(idx);
+            bool filter_prev = msk_prev->get(idx);
+            bool filter_curr = msk_curr->get(idx);
 
-            t_tscalar pkey = pkey_col->get_scalar(idx);
             std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
             t_op op = static_cast<t_op>(op_);
             bool pivots_neq;
@@ -392,54 +432,44 @@ t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& d
                 continue;
             } else if (!filter_prev && filter_curr) {
                 // apply current row
-                build_strand_table_phase_1(pkey, op, idx, rv.m_pivsize, strand_count_idx,
-                    aggcolsize, true, piv_ccols, piv_tcols, agg_ccols, agg_dcols, piv_scols,
-                    agg_acols, agg_scount, spkey, insert_count, pivots_neq,
-                    rv.m_pivot_like_columns);
+                build_strand_table_phase_1(op, idx, rv.m_pivsize, true, piv_tcols, piv_pcols,
+                    piv_ccols, rv.m_pivot_like_sources, rows, pivots_neq);
             } else if (filter_prev && !filter_curr) {
                 // reverse prev row
-                build_strand_table_phase_2(pkey, idx, rv.m_pivsize, strand_count_idx,
-                    aggcolsize, piv_pcols, agg_pcols, piv_scols, agg_acols, agg_scount, spkey,
-                    insert_count, rv.m_pivot_like_columns);
+                build_strand_table_phase_2(idx, rows);
             } else if (filter_prev && filter_curr) {
                 // should be handled as normal
-                build_strand_table_phase_1(pkey, op, idx, rv.m_pivsize, strand_count_idx,
-                    aggcolsize, false, piv_ccols, piv_tcols, agg_ccols, agg_dcols, piv_scols,
-                    agg_acols, agg_scount, spkey, insert_count, pivots_neq,
-                    rv.m_pivot_like_columns);
+                build_strand_table_phase_1(op, idx, rv.m_pivsize, false, piv_tcols, piv_pcols,
+                    piv_ccols, rv.m_pivot_like_sources, rows, pivots_neq);
 
                 if (op == OP_DELETE || !pivots_neq) {
                     continue;
                 }
 
-                build_strand_table_phase_2(pkey, idx, rv.m_pivsize, strand_count_idx,
-                    aggcolsize, piv_pcols, agg_pcols, piv_scols, agg_acols, agg_scount, spkey,
-                    insert_count, rv.m_pivot_like_columns);
+                build_strand_table_phase_2(idx, rows);
             }
         }
     } else {
         for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
-
-            t_tscalar pkey = pkey_col->get_scalar(idx);
             std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
             t_op op = static_cast<t_op>(op_);
             bool pivots_neq;
 
-            build_strand_table_phase_1(pkey, op, idx, rv.m_pivsize, strand_count_idx,
-                aggcolsize, false, piv_ccols, piv_tcols, agg_ccols, agg_dcols, piv_scols,
-                agg_acols, agg_scount, spkey, insert_count, pivots_neq,
-                rv.m_pivot_like_columns);
+            build_strand_table_phase_1(op, idx, rv.m_pivsize, false, piv_tcols, piv_pcols,
+                piv_ccols, rv.m_pivot_like_sources, rows, pivots_neq);
 
             if (op == OP_DELETE || !pivots_neq) {
                 continue;
             }
 
-            build_strand_table_phase_2(pkey, idx, rv.m_pivsize, strand_count_idx, aggcolsize,
-                piv_pcols, agg_pcols, piv_scols, agg_acols, agg_scount, spkey, insert_count,
-                rv.m_pivot_like_columns);
+            build_strand_table_phase_2(idx, rows);
         }
     }
 
+    fill_strand_table(rows, pkey_col.get(), piv_pcols, piv_ccols, rv.m_pivot_like_sources,
+        piv_scols, agg_pcols, agg_ccols, agg_dcols, agg_acols, strand_count_idx, spkey);
+
+    t_uindex insert_count = rows.size();
     strands->reserve(insert_count);
     strands->set_size(insert_count);
     aggs->reserve(insert_count);
@@ -453,7 +483,7 @@ t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& d
 // notably pivot changed rows will be added
 std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>>
 t_stree::build_strand_table(const t_data_table& flattened,
-    const std::vector<t_aggspec>& aggspecs, const t_config& config) const {
+    const std::vector<t_aggspec>& aggspecs, const t_config& config, const t_mask* msk) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
 
@@ -479,7 +509,8 @@ t_stree::build_strand_table(const t_data_table& flattened,
 
     for (t_uindex pidx = 0; pidx < npivotlike; ++pidx) {
         const std::string& piv = rv.m_strand_schema.m_columns[pidx];
-        piv_fcols[pidx] = flattened.get_const_column(piv).get();
+        const std::string& source = rv.m_pivot_like_sources[pidx].colname();
+        piv_fcols[pidx] = flattened.get_const_column(source).get();
         piv_scols[pidx] = strands->get_column(piv).get();
     }
 
@@ -505,16 +536,10 @@ t_stree::build_strand_table(const t_data_table& flattened,
 
     t_column* spkey = strands->get_column("psp_pkey").get();
 
-    t_mask msk;
-
-    if (config.has_filters()) {
-        msk = filter_table_for_config(flattened, config);
-    }
-
-    bool has_filters = config.has_filters();
+    bool has_filters = msk != nullptr;
 
     for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
-        bool filter = !has_filters || msk.get(idx);
+        bool filter = !has_filters || msk->get(idx);
         t_tscalar pkey = pkey_col->get_scalar(idx);
         std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
         t_op op = static_cast<t_op>(op_);
@@ -526,7 +551,8 @@ t_stree::build_strand_table(const t_data_table& flattened,
 
         for (t_uindex pidx = 0, ploop_end = rv.m_pivot_like_columns.size(); pidx < ploop_end;
              ++pidx) {
-            piv_scols[pidx]->push_back(piv_fcols[pidx]->get_scalar(idx));
+            piv_scols[pidx]->push_back(
+                rv.m_pivot_like_sources[pidx].bucket(piv_fcols[pidx]->get_scalar(idx)));
         }
 
         for (t_uindex aggidx = 0; aggidx < aggcolsize; ++aggidx) {
@@ -601,11 +627,8 @@ t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
     t_filter filter;
 
     // update root
-    auto root_iter = m_nodes->get<by_idx>().find(0);
-    auto root_node = *root_iter;
-    t_index root_nstrands = *(scount->get_nth<t_index>(0)) + root_node.m_nstrands;
-    root_node.set_nstrands(root_nstrands);
-    m_nodes->get<by_idx>().replace(root_iter, root_node);
+    t_index root_nstrands = *(scount->get_nth<t_index>(0)) + m_nodes->get_nstrands(0);
+    m_nodes->set_nstrands(0, root_nstrands);
 
     t_tree_unify_rec unif_rec(0, 0, 0, root_nstrands);
     m_tree_unification_records.push_back(unif_rec);
@@ -631,15 +654,15 @@ t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
 
         t_uindex src_ridx = dptidx;
 
-        auto iter = m_nodes->get<by_pidx_hash>().find(std::make_tuple(p_sptidx, value));
+        t_index existing = m_nodes->find_child(p_sptidx, value);
 
         auto nstrands = *(scount->get_nth<std::int64_t>(dptidx));
 
-        if (iter == m_nodes->get<by_pidx_hash>().end() && nstrands < 0) {
+        if (existing == INVALID_INDEX && nstrands < 0) {
             continue;
         }
 
-        if (iter == m_nodes->get<by_pidx_hash>().end()) {
+        if (existing == INVALID_INDEX) {
             // create node and enqueue
             sptidx = genidx();
             t_uindex aggsize = m_aggregates->size();
@@ -659,32 +682,24 @@ t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
                 m_newleaves.insert(sptidx);
             }
 
-            auto insert_pair = m_nodes->insert(node);
-            if (!insert_pair.second) {
-                auto failed_because = *(insert_pair.first);
-                std::cout << "failed because of " << failed_because << std::endl;
-            }
-            PSP_VERBOSE_ASSERT(insert_pair.second, "Failed to insert node");
+            bool inserted = m_nodes->insert(node);
+            PSP_VERBOSE_ASSERT(inserted, "Failed to insert node");
             t_tree_unify_rec unif_rec(sptidx, src_ridx, dst_ridx, nstrands);
             m_tree_unification_records.push_back(unif_rec);
         } else {
-            sptidx = iter->m_idx;
+            sptidx = existing;
 
             // update node
-            t_tnode node = *iter;
-            node.set_sort_value(sortby_value);
+            m_nodes->set_sort_value(sptidx, sortby_value);
 
-            t_uindex dst_ridx = node.m_aggidx;
+            t_uindex dst_ridx = m_nodes->get_aggidx(sptidx);
 
-            nstrands = node.m_nstrands + nstrands;
+            nstrands = m_nodes->get_nstrands(sptidx) + nstrands;
 
             t_tree_unify_rec unif_rec(sptidx, src_ridx, dst_ridx, nstrands);
             m_tree_unification_records.push_back(unif_rec);
 
-            sptidx = iter->m_idx;
-            node.set_nstrands(nstrands);
-            PSP_VERBOSE_ASSERT(m_nodes->get<by_pidx_hash>().replace(iter, node), ,
-                "Failed to replace"); // middle argument ignored
+            m_nodes->set_nstrands(sptidx, nstrands);
         }
 
         populate_pkey_idx(ctx, dtree, dptidx, sptidx, ndepth, new_idx_pkey);
@@ -713,10 +728,7 @@ t_stree::mark_zero_desc() {
     }
 
     for (auto n : z_desc) {
-        auto iter = m_nodes->get<by_idx>().find(n);
-        auto node = *iter;
-        node.set_nstrands(0);
-        m_nodes->get<by_idx>().replace(iter, node);
+        m_nodes->set_nstrands(n, 0);
     }
 }
 
@@ -781,13 +793,51 @@ t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate)
         }
     }
 
+    std::vector<const t_tree_unify_rec*> records;
+    records.reserve(m_tree_unification_records.size());
     for (const auto& r : m_tree_unification_records) {
-        if (!node_exists(r.m_sptidx)) {
-            continue;
+        if (node_exists(r.m_sptidx)) {
+            records.push_back(&r);
         }
+    }
+
+    // Scaled aggregates read other destination columns, so every other
+    // column is finished before they run. Columns within a group are
+    // independent and are updated in parallel.
+    std::vector<std::vector<t_uindex>> col_groups(2);
+    for (t_uindex idx : cols_topo_sorted) {
+        col_groups[is_col_scaled_aggregate(idx) ? 1 : 0].push_back(idx);
+    }
 
-        update_agg_table(
-            r.m_sptidx, agg_update_info, r.m_daggidx, r.m_saggidx, r.m_nstrands, gstate);
+    std::vector<std::vector<t_tcdelta>> col_deltas(col_cnt);
+    std::vector<std::uint8_t> col_has_delta(col_cnt, 0);
+
+    for (const auto& cols : col_groups) {
+        psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+            PSP_PFOR(0, int(cols.size()), 1,
+                [&](int i)
+#else
+            for (t_uindex i = 0, loop_end = cols.size(); i < loop_end; ++i)
+#endif
+                {
+                    t_uindex idx = cols[i];
+                    bool has_delta = false;
+                    update_agg_table(
+                        idx, agg_update_info, records, gstate, col_deltas[idx], has_delta);
+                    col_has_delta[idx] = has_delta;
+                }
+#ifdef PSP_PARALLEL_FOR
+            );
+#endif
+        });
+    }
+
+    for (t_uindex idx = 0; idx < col_cnt; ++idx) {
+        m_has_delta = m_has_delta || col_has_delta[idx];
+        for (const auto& delta : col_deltas[idx]) {
+            m_deltas->insert(delta);
+        }
     }
 }
 
@@ -798,18 +848,7 @@ t_stree::genidx() {
 
 std::vector<t_uindex>
 t_stree::get_children(t_uindex idx) const {
-    t_by_pidx_ipair iterators = m_nodes->get<by_pidx>().equal_range(idx);
-
-    t_uindex nchild = std::distance(iterators.first, iterators.second);
-
-    std::vector<t_uindex> temp(nchild);
-
-    t_index count = 0;
-    for (iter_by_pidx iter = iterators.first; iter != iterators.second; ++iter) {
-        temp[count] = iter->m_idx;
-        ++count;
-    }
-    return temp;
+    return m_nodes->get_children(idx);
 }
 
 t_uindex
@@ -819,17 +858,18 @@ t_stree::size() const {
 
 void
 t_stree::get_child_nodes(t_uindex idx, t_tnodevec& nodes) const {
-    t_index num_children = get_num_children(idx);
-    t_tnodevec temp(num_children);
-    auto iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    std::copy(iterators.first, iterators.second, temp.begin());
+    const std::vector<t_uindex>& children = m_nodes->get_children(idx);
+    t_tnodevec temp;
+    temp.reserve(children.size());
+    for (auto cidx : children) {
+        temp.push_back(m_nodes->get(cidx));
+    }
     std::swap(nodes, temp);
 }
 
 t_uindex
 t_stree::get_num_children(t_uindex ptidx) const {
-    auto iterators = m_nodes->get<by_pidx>().equal_range(ptidx);
-    return std::distance(iterators.first, iterators.second);
+    return m_nodes->get_num_children(ptidx);
 }
 
 t_uindex
@@ -852,14 +892,23 @@ t_stree::gen_aggidx() {
 }
 
 void
-t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_ridx,
-    t_uindex dst_ridx, t_index nstrands, const t_gstate& gstate) {
-    for (t_uindex idx : info.m_dst_topo_sorted) {
-        const t_column* src = info.m_src[idx];
-        t_column* dst = info.m_dst[idx];
-        const t_aggspec& spec = info.m_aggspecs[idx];
+t_stree::update_agg_table(t_uindex idx, const t_agg_update_info& info,
+    const std::vector<const t_tree_unify_rec*>& records, const t_gstate& gstate,
+    std::vector<t_tcdelta>& deltas, bool& has_delta) {
+    const t_column* src = info.m_src[idx];
+    t_column* dst = info.m_dst[idx];
+    const t_aggspec& spec = info.m_aggspecs[idx];
+    bool deltas_enabled = m_features.at(CTX_FEAT_DELTA);
+
+    for (const t_tree_unify_rec* r : records) {
+        t_uindex nidx = r->m_sptidx;
+        t_uindex src_ridx = r->m_daggidx;
+        t_uindex dst_ridx = r->m_saggidx;
+        t_index nstrands = r->m_nstrands;
         t_tscalar new_value = mknone();
         t_tscalar old_value = mknone();
+        bool track_minmax = m_minmax_tracked && nidx != 0;
+        t_tscalar prior = track_minmax ? dst->get_scalar(dst_ridx) : mknone();
 
         switch (spec.agg()) {
             case AGGTYPE_PCT_SUM_PARENT:
@@ -953,9 +1002,9 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
 
                 if (new_value.m_type == DTYPE_STR) {
                     if (is_unique) {
-                        new_value = m_symtable.get_interned_tscalar(new_value);
+                        new_value = intern_tscalar(new_value);
                     } else {
-                        new_value = m_symtable.get_interned_tscalar("-");
+                        new_value = intern_tscalar("-");
                     }
                     dst->set_scalar(dst_ridx, new_value);
                 } else {
@@ -1022,7 +1071,7 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
                              iter != vset.end(); ++iter) {
                             ss << *iter << ", ";
                         }
-                        return m_symtable.get_interned_tscalar(ss.str().c_str());
+                        return intern_tscalar(ss.str().c_str());
                     }));
 
                 dst->set_scalar(dst_ridx, new_value);
@@ -1031,7 +1080,6 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
                 const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
                 const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
 
-                t_column* dst = info.m_dst[idx];
                 old_value.set(dst->get_scalar(dst_ridx));
 
                 double agg1 = src_1->get_scalar(dst_ridx).to_double();
@@ -1050,7 +1098,6 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
                 const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
                 const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
 
-                t_column* dst = info.m_dst[idx];
                 old_value.set(dst->get_scalar(dst_ridx));
 
                 double v = (src_1->get_scalar(dst_ridx).to_double() * spec.get_agg_one_weight())
@@ -1063,7 +1110,6 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
                 const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
                 const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
 
-                t_column* dst = info.m_dst[idx];
                 old_value.set(dst->get_scalar(dst_ridx));
 
                 double v = (src_1->get_scalar(dst_ridx).to_double() * spec.get_agg_one_weight())
@@ -1240,11 +1286,11 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
 
                 if (is_leaf(nidx) && is_unique) {
                     if (new_value.m_type == DTYPE_STR) {
-                        new_value = m_symtable.get_interned_tscalar(new_value);
+                        new_value = intern_tscalar(new_value);
                     }
                 } else {
                     if (new_value.m_type == DTYPE_STR) {
-                        new_value = m_symtable.get_interned_tscalar("");
+                        new_value = intern_tscalar("");
                     } else {
                         dst->set_valid(dst_ridx, false);
                         new_value = old_value;
@@ -1257,26 +1303,36 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_r
             default: { PSP_COMPLAIN_AND_ABORT("Not implemented"); }
         } // end switch
 
+        if (track_minmax) {
+            t_tscalar stored = dst->get_scalar(dst_ridx);
+            track_min_max(idx, m_nodes->get_depth(nidx), prior, &stored);
+        }
+
         bool val_neq = old_value != new_value;
 
-        m_has_delta = m_has_delta || val_neq;
-        bool deltas_enabled = m_features.at(CTX_FEAT_DELTA);
+        has_delta = has_delta || val_neq;
         if (deltas_enabled && val_neq) {
-            m_deltas->insert(t_tcdelta(nidx, idx, old_value, new_value));
+            deltas.push_back(t_tcdelta(nidx, idx, old_value, new_value));
         }
 
     } // end for
 }
 
+t_tscalar
+t_stree::intern_tscalar(const t_tscalar& s) {
+    std::lock_guard<std::mutex> lock(m_symtable_mutex);
+    return m_symtable.get_interned_tscalar(s);
+}
+
+t_tscalar
+t_stree::intern_tscalar(const char* s) {
+    std::lock_guard<std::mutex> lock(m_symtable_mutex);
+    return m_symtable.get_interned_tscalar(s);
+}
+
 std::vector<t_uindex>
 t_stree::zero_strands() const {
-    auto iterators = m_nodes->get<by_nstrands>().equal_range(0);
-    std::vector<t_uindex> rval;
-
-    for (auto& iter = iterators.first; iter != iterators.second; ++iter) {
-        rval.push_back(iter->m_idx);
-    }
-    return rval;
+    return m_nodes->get_zero_strands();
 }
 
 std::set<t_uindex>
@@ -1310,12 +1366,11 @@ t_stree::non_zero_ids(
 
 t_uindex
 t_stree::get_parent_idx(t_uindex ptidx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(ptidx);
-    if (iter == m_nodes->get<by_idx>().end()) {
+    if (!m_nodes->contains(ptidx)) {
         std::cout << "Failed in tree => " << repr() << std::endl;
         PSP_VERBOSE_ASSERT(false, "Did not find node");
     }
-    return iter->m_pidx;
+    return m_nodes->get_pidx(ptidx);
 }
 
 std::vector<t_uindex>
@@ -1334,16 +1389,13 @@ t_stree::get_ancestry(t_uindex idx) const {
 
 t_index
 t_stree::get_sibling_idx(t_index p_ptidx, t_index p_nchild, t_uindex c_ptidx) const {
-    t_by_pidx_ipair iterators = m_nodes->get<by_pidx>().equal_range(p_ptidx);
-    iter_by_pidx c_iter = m_nodes->project<by_pidx>(m_nodes->get<by_idx>().find(c_ptidx));
-    return std::distance(iterators.first, c_iter);
+    return m_nodes->get_child_position(p_ptidx, c_ptidx);
 }
 
 t_uindex
 t_stree::get_aggidx(t_uindex idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Failed in get_aggidx");
-    return iter->m_aggidx;
+    PSP_VERBOSE_ASSERT(m_nodes->contains(idx), "Failed in get_aggidx");
+    return m_nodes->get_aggidx(idx);
 }
 
 std::shared_ptr<const t_data_table>
@@ -1358,9 +1410,8 @@ t_stree::_get_aggtable() {
 
 t_stree::t_tnode
 t_stree::get_node(t_uindex idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Failed in get_node");
-    return *iter;
+    PSP_VERBOSE_ASSERT(m_nodes->contains(idx), "Failed in get_node");
+    return m_nodes->get(idx);
 }
 
 void
@@ -1371,9 +1422,8 @@ t_stree::get_path(t_uindex idx, std::vector<t_tscalar>& rval) const {
         return;
 
     while (1) {
-        iter_by_idx iter = m_nodes->get<by_idx>().find(curidx);
-        rval.push_back(iter->m_value);
-        curidx = iter->m_pidx;
+        rval.push_back(m_nodes->get_value(curidx));
+        curidx = m_nodes->get_pidx(curidx);
         if (curidx == 0) {
             break;
         }
@@ -1383,13 +1433,7 @@ t_stree::get_path(t_uindex idx, std::vector<t_tscalar>& rval) const {
 
 t_uindex
 t_stree::resolve_child(t_uindex root, const t_tscalar& datum) const {
-    auto iter = m_nodes->get<by_pidx_hash>().find(std::make_tuple(root, datum));
-
-    if (iter == m_nodes->get<by_pidx_hash>().end()) {
-        return INVALID_INDEX;
-    }
-
-    return iter->m_idx;
+    return m_nodes->find_child(root, datum);
 }
 
 void
@@ -1406,7 +1450,7 @@ t_stree::clear_aggregates(const std::vector<t_uindex>& indices) {
 
 void
 t_stree::drop_zero_strands() {
-    auto iterators = m_nodes->get<by_nstrands>().equal_range(0);
+    auto zeros = m_nodes->get_zero_strands();
 
     std::vector<t_uindex> leaves;
 
@@ -1414,10 +1458,18 @@ t_stree::drop_zero_strands() {
 
     std::vector<t_uindex> node_ids;
 
-    for (auto iter = iterators.first; iter != iterators.second; ++iter) {
-        if (iter->m_depth == lst)
-            leaves.push_back(iter->m_idx);
-        node_ids.push_back(iter->m_aggidx);
+    for (auto nidx : zeros) {
+        if (m_nodes->get_depth(nidx) == lst)
+            leaves.push_back(nidx);
+        node_ids.push_back(m_nodes->get_aggidx(nidx));
+
+        if (m_minmax_tracked && nidx != 0) {
+            t_depth depth = m_nodes->get_depth(nidx);
+            t_uindex aggidx = m_nodes->get_aggidx(nidx);
+            for (t_uindex cidx = 0, loop_end = m_aggcols.size(); cidx < loop_end; ++cidx) {
+                track_min_max(cidx, depth, m_aggcols[cidx]->get_scalar(aggidx), nullptr);
+            }
+        }
     }
 
     clear_aggregates(node_ids);
@@ -1432,9 +1484,16 @@ t_stree::drop_zero_strands() {
         }
     }
 
-    auto iterators2 = m_nodes->get<by_nstrands>().equal_range(0);
+    for (auto nidx : zeros) {
+        m_nodes->erase(nidx);
+    }
+
+    m_dropped_nodes = std::move(zeros);
+}
 
-    m_nodes->get<by_nstrands>().erase(iterators2.first, iterators2.second);
+const std::vector<t_uindex>&
+t_stree::get_dropped_nodes() const {
+    return m_dropped_nodes;
 }
 
 void
@@ -1506,8 +1565,7 @@ t_stree::get_leaves(t_uindex idx) const {
 
 t_depth
 t_stree::get_depth(t_uindex ptidx) const {
-    auto iter = m_nodes->get<by_idx>().find(ptidx);
-    return iter->m_depth;
+    return m_nodes->get_depth(ptidx);
 }
 
 void
@@ -1541,29 +1599,16 @@ t_stree::get_drd_indices(
 
 std::vector<t_uindex>
 t_stree::get_child_idx(t_uindex idx) const {
-    t_index num_children = get_num_children(idx);
-    std::vector<t_uindex> children(num_children);
-    auto iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    t_index count = 0;
-    while (iterators.first != iterators.second) {
-        children[count] = iterators.first->m_idx;
-        ++count;
-        ++iterators.first;
-    }
-    return children;
+    return m_nodes->get_children(idx);
 }
 
 std::vector<std::pair<t_index, t_index>>
 t_stree::get_child_idx_depth(t_uindex idx) const {
-    t_index num_children = get_num_children(idx);
-    std::vector<std::pair<t_index, t_index>> children(num_children);
-    auto iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    t_index count = 0;
-    while (iterators.first != iterators.second) {
-        children[count]
-            = std::pair<t_index, t_index>(iterators.first->m_idx, iterators.first->m_depth);
-        ++count;
-        ++iterators.first;
+    const std::vector<t_uindex>& cidxs = m_nodes->get_children(idx);
+    std::vector<std::pair<t_index, t_index>> children(cidxs.size());
+    for (t_uindex count = 0, loop_end = cidxs.size(); count < loop_end; ++count) {
+        children[count] = std::pair<t_index, t_index>(
+            cidxs[count], m_nodes->get_depth(cidxs[count]));
     }
     return children;
 }
@@ -1589,9 +1634,8 @@ t_stree::last_level() const {
 
 bool
 t_stree::is_leaf(t_uindex nidx) const {
-    auto iter = m_nodes->get<by_idx>().find(nidx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Did not find node");
-    return iter->m_depth == last_level();
+    PSP_VERBOSE_ASSERT(m_nodes->contains(nidx), "Did not find node");
+    return m_nodes->get_depth(nidx) == last_level();
 }
 
 std::vector<t_uindex>
@@ -1625,12 +1669,10 @@ t_stree::resolve_path(t_uindex root, const std::vector<t_tscalar>& path) const {
         return curidx;
 
     for (t_index i = path.size() - 1; i >= 0; i--) {
-        iter_by_pidx_hash iter
-            = m_nodes->get<by_pidx_hash>().find(std::make_tuple(curidx, path[i]));
-        if (iter == m_nodes->get<by_pidx_hash>().end()) {
+        curidx = m_nodes->find_child(curidx, path[i]);
+        if (curidx == INVALID_INDEX) {
             return INVALID_INDEX;
         }
-        curidx = iter->m_idx;
     }
 
     return curidx;
@@ -1673,7 +1715,7 @@ t_stree::get_aggregates_for_sorting(t_uindex nidx, const std::vector<t_index>& a
                 std::vector<t_tscalar> row_path;
                 get_path(nidx, row_path);
 
-                auto target_tree = ctx2->get_trees()[get_node(nidx).m_depth];
+                auto target_tree = ctx2->get_trees()[get_depth(nidx)];
                 t_index target = target_tree->resolve_path(0, row_path);
                 if (target != INVALID_INDEX)
                     target = target_tree->resolve_path(target, col_path);
@@ -1707,14 +1749,8 @@ t_stree::get_aggregate(t_index idx, t_index aggnum) const {
 
 void
 t_stree::get_child_indices(t_index idx, std::vector<t_index>& out_data) const {
-    t_index num_children = get_num_children(idx);
-    std::vector<t_index> temp(num_children);
-    t_by_pidx_ipair iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    t_index count = 0;
-    for (iter_by_pidx iter = iterators.first; iter != iterators.second; ++iter) {
-        temp[count] = iter->m_idx;
-        ++count;
-    }
+    const std::vector<t_uindex>& children = m_nodes->get_children(idx);
+    std::vector<t_index> temp(children.begin(), children.end());
     std::swap(out_data, temp);
 }
 
@@ -1728,6 +1764,7 @@ void
 t_stree::clear() {
     m_nodes->clear();
     clear_deltas();
+    mark_min_max_dirty();
 }
 
 void
@@ -1743,6 +1780,11 @@ t_stree::set_deltas_enabled(bool enabled_state) {
 void
 t_stree::set_minmax_enabled(bool enabled_state) {
     m_features[CTX_FEAT_MINMAX] = enabled_state;
+    if (enabled_state != m_minmax_tracked) {
+        m_minmax_tracked = enabled_state;
+        mark_min_max_dirty();
+        refresh_min_max();
+    }
 }
 
 void
@@ -1750,22 +1792,122 @@ t_stree::set_feature_state(t_ctx_feature feature, bool state) {
     m_features[feature] = state;
 }
 
+t_minmax
+t_stree::scan_min_max(t_uindex aggidx, t_index depth) const {
+    const t_column* col = m_aggcols[aggidx];
+    t_minmax minmax;
+
+    for (t_uindex nidx = 1, loop_end = m_nodes->capacity(); nidx < loop_end; ++nidx) {
+        if (!m_nodes->contains(nidx)
+            || (depth >= 0 && m_nodes->get_depth(nidx) != t_depth(depth)))
+            continue;
+        minmax.update(col->get_scalar(m_nodes->get_aggidx(nidx)));
+    }
+    return minmax;
+}
+
+void
+t_stree::track_min_max(
+    t_uindex aggidx, t_depth depth, const t_tscalar& prior, const t_tscalar* value) {
+    if (value && *value == prior) {
+        return;
+    }
+
+    auto fold = [&prior, value](t_minmax& minmax, std::uint8_t& dirty) {
+        if (dirty) {
+            return;
+        }
+        if (!minmax.m_min.is_none() && (prior == minmax.m_min || prior == minmax.m_max)) {
+            dirty = 1;
+        } else if (value) {
+            minmax.update(*value);
+        }
+    };
+
+    fold(m_minmax[aggidx], m_minmax_dirty[aggidx]);
+    if (depth < m_depth_minmax[aggidx].size()) {
+        fold(m_depth_minmax[aggidx][depth], m_depth_minmax_dirty[aggidx][depth]);
+    }
+}
+
+void
+t_stree::mark_min_max_dirty() {
+    std::fill(m_minmax_dirty.begin(), m_minmax_dirty.end(), 1);
+    for (auto& dirty : m_depth_minmax_dirty) {
+        std::fill(dirty.begin(), dirty.end(), 1);
+    }
+}
+
+// Each aggregate column only touches its own slots, so columns are rescanned
+// in parallel.
+void
+t_stree::refresh_min_max() {
+    if (!m_minmax_tracked) {
+        return;
+    }
+
+    t_uindex naggs = m_aggspecs.size();
+
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(naggs), 1,
+            [&](int cidx)
+#else
+        for (t_uindex cidx = 0; cidx < naggs; ++cidx)
+#endif
+            {
+                if (m_minmax_dirty[cidx]) {
+                    m_minmax[cidx] = scan_min_max(cidx, -1);
+                    m_minmax_dirty[cidx] = 0;
+                }
+
+                for (t_uindex depth = 0, loop_end = m_depth_minmax[cidx].size();
+                     depth < loop_end; ++depth) {
+                    if (m_depth_minmax_dirty[cidx][depth]) {
+                        m_depth_minmax[cidx][depth] = scan_min_max(cidx, depth);
+                        m_depth_minmax_dirty[cidx][depth] = 0;
+                    }
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+}
+
 t_minmax
 t_stree::get_agg_min_max(t_uindex aggidx, t_depth depth) const {
-    auto iterators = m_nodes->get<by_depth>().equal_range(depth);
-    return get_agg_min_max(iterators.first, iterators.second, aggidx);
+    if (!m_minmax_tracked || depth >= m_depth_minmax[aggidx].size()
+        || m_depth_minmax_dirty[aggidx][depth]) {
+        return scan_min_max(aggidx, depth);
+    }
+    return m_depth_minmax[aggidx][depth];
 }
 
 std::vector<t_minmax>
 t_stree::get_min_max() const {
     t_uindex naggs = m_aggspecs.size();
     std::vector<t_minmax> rval(naggs);
-    for (t_uindex cidx = 0; cidx < naggs; ++cidx) {
 
-        auto biter = m_nodes->get<by_idx>().begin();
-        auto eiter = m_nodes->get<by_idx>().end();
-        rval[cidx] = get_agg_min_max(biter, eiter, cidx);
-    }
+    psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(naggs), 1,
+            [&](int cidx)
+#else
+        for (t_uindex cidx = 0; cidx < naggs; ++cidx)
+#endif
+            {
+                if (m_minmax_tracked && !m_minmax_dirty[cidx]) {
+                    rval[cidx] = m_minmax[cidx];
+                } else {
+                    rval[cidx] = scan_min_max(cidx, -1);
+                }
+            }
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    });
+
     return rval;
 }
 
@@ -1823,9 +1965,20 @@ t_stree::first_last_helper(t_uindex nidx, const t_aggspec& spec, const t_gstate&
 }
 
 bool
-t_stree::node_exists(t_uindex idx) {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    return iter != m_nodes->get<by_idx>().end();
+t_stree::node_exists(t_uindex idx) const {
+    return m_nodes->contains(idx);
+}
+
+std::vector<t_uindex>
+t_stree::get_updated_nodes() const {
+    std::vector<t_uindex> rval;
+    rval.reserve(m_tree_unification_records.size());
+    for (const auto& r : m_tree_unification_records) {
+        if (r.m_sptidx != 0 && m_nodes->contains(r.m_sptidx)) {
+            rval.push_back(r.m_sptidx);
+        }
+    }
+    return rval;
 }
 
 t_data_table*
@@ -1833,7 +1986,7 @@ t_stree::get_aggtable() {
     return m_aggregates.get();
 }
 
-std::pair<iter_by_idx, bool>
+bool
 t_stree::insert_node(const t_tnode& node) {
     return m_nodes->insert(node);
 }
@@ -1851,9 +2004,8 @@ t_stree::get_sortby_path(t_uindex idx, std::vector<t_tscalar>& rval) const {
         return;
 
     while (1) {
-        iter_by_idx iter = m_nodes->get<by_idx>().find(curidx);
-        rval.push_back(iter->m_sort_value);
-        curidx = iter->m_pidx;
+        rval.push_back(m_nodes->get_sort_value(curidx));
+        curidx = m_nodes->get_pidx(curidx);
         if (curidx == 0) {
             break;
         }
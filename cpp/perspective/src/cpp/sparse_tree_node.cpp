@@ -9,6 +9,8 @@
 
 #include <perspective/first.h>
 #include <perspective/sparse_tree_node.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
 
 namespace perspective {
 
@@ -35,6 +37,254 @@ t_stnode::set_sort_value(t_tscalar sv) {
     m_sort_value.set(sv);
 }
 
+t_stnode_key::t_stnode_key(t_uindex pidx, const t_tscalar& value)
+    : m_pidx(pidx)
+    , m_value(value) {}
+
+bool
+t_stnode_key::operator==(const t_stnode_key& rhs) const {
+    return m_pidx == rhs.m_pidx && m_value == rhs.m_value;
+}
+
+size_t
+t_stnode_key_hash::operator()(const t_stnode_key& key) const {
+    std::size_t seed = hash_value(key.m_value);
+    boost::hash_combine(seed, key.m_pidx);
+    return seed;
+}
+
+t_stnode_store::t_stnode_store()
+    : m_size(0) {}
+
+bool
+t_stnode_store::insert(const t_stnode& node) {
+    t_uindex idx = node.m_idx;
+
+    if (contains(idx))
+        return false;
+
+    t_stnode_key key(node.m_pidx, node.m_value);
+    if (m_child_map.find(key) != m_child_map.end())
+        return false;
+
+    reserve_idx(idx);
+    if (node.m_pidx != root_pidx())
+        reserve_idx(node.m_pidx);
+
+    m_pidx[idx] = node.m_pidx;
+    m_depth[idx] = node.m_depth;
+    m_value[idx].set(node.m_value);
+    m_sort_value[idx].set(node.m_sort_value);
+    m_nstrands[idx] = node.m_nstrands;
+    m_aggidx[idx] = node.m_aggidx;
+    m_live[idx] = true;
+    m_children[idx].clear();
+    ++m_size;
+
+    m_child_map.insert(std::make_pair(key, idx));
+    link_child(idx);
+    update_zero_strands(idx);
+    return true;
+}
+
+void
+t_stnode_store::erase(t_uindex idx) {
+    if (!contains(idx))
+        return;
+
+    unlink_child(idx);
+    m_child_map.erase(t_stnode_key(m_pidx[idx], m_value[idx]));
+    m_zero_strands.erase(idx);
+    std::vector<t_uindex>().swap(m_children[idx]);
+    m_live[idx] = false;
+    --m_size;
+}
+
+void
+t_stnode_store::clear() {
+    m_pidx.clear();
+    m_depth.clear();
+    m_value.clear();
+    m_sort_value.clear();
+    m_nstrands.clear();
+    m_aggidx.clear();
+    m_live.clear();
+    m_children.clear();
+    m_child_map.clear();
+    m_zero_strands.clear();
+    m_size = 0;
+}
+
+t_uindex
+t_stnode_store::size() const {
+    return m_size;
+}
+
+t_uindex
+t_stnode_store::capacity() const {
+    return m_live.size();
+}
+
+bool
+t_stnode_store::contains(t_uindex idx) const {
+    return idx < m_live.size() && m_live[idx];
+}
+
+t_stnode
+t_stnode_store::get(t_uindex idx) const {
+    return t_stnode(idx, m_pidx[idx], m_value[idx], m_depth[idx], m_sort_value[idx],
+        m_nstrands[idx], m_aggidx[idx]);
+}
+
+t_uindex
+t_stnode_store::get_pidx(t_uindex idx) const {
+    return m_pidx[idx];
+}
+
+std::uint8_t
+t_stnode_store::get_depth(t_uindex idx) const {
+    return m_depth[idx];
+}
+
+const t_tscalar&
+t_stnode_store::get_value(t_uindex idx) const {
+    return m_value[idx];
+}
+
+const t_tscalar&
+t_stnode_store::get_sort_value(t_uindex idx) const {
+    return m_sort_value[idx];
+}
+
+t_uindex
+t_stnode_store::get_nstrands(t_uindex idx) const {
+    return m_nstrands[idx];
+}
+
+t_uindex
+t_stnode_store::get_aggidx(t_uindex idx) const {
+    return m_aggidx[idx];
+}
+
+void
+t_stnode_store::set_nstrands(t_uindex idx, t_uindex nstrands) {
+    m_nstrands[idx] = nstrands;
+    update_zero_strands(idx);
+}
+
+void
+t_stnode_store::set_sort_value(t_uindex idx, const t_tscalar& sort_value) {
+    const t_tscalar& old_value = m_sort_value[idx];
+
+    if (!(old_value < sort_value) && !(sort_value < old_value)) {
+        m_sort_value[idx].set(sort_value);
+        return;
+    }
+
+    unlink_child(idx);
+    m_sort_value[idx].set(sort_value);
+    link_child(idx);
+}
+
+const std::vector<t_uindex>&
+t_stnode_store::get_children(t_uindex idx) const {
+    static const std::vector<t_uindex> empty;
+    if (idx >= m_children.size())
+        return empty;
+    return m_children[idx];
+}
+
+t_uindex
+t_stnode_store::get_num_children(t_uindex idx) const {
+    return get_children(idx).size();
+}
+
+t_uindex
+t_stnode_store::get_child_position(t_uindex pidx, t_uindex cidx) const {
+    const std::vector<t_uindex>& children = get_children(pidx);
+    auto iter = std::lower_bound(children.begin(), children.end(), cidx,
+        [this](t_uindex a, t_uindex b) { return child_less(a, b); });
+
+    while (iter != children.end() && *iter != cidx) {
+        ++iter;
+    }
+
+    return std::distance(children.begin(), iter);
+}
+
+t_index
+t_stnode_store::find_child(t_uindex pidx, const t_tscalar& value) const {
+    auto iter = m_child_map.find(t_stnode_key(pidx, value));
+    if (iter == m_child_map.end())
+        return INVALID_INDEX;
+    return iter->second;
+}
+
+std::vector<t_uindex>
+t_stnode_store::get_zero_strands() const {
+    std::vector<t_uindex> rval(m_zero_strands.begin(), m_zero_strands.end());
+    std::sort(rval.begin(), rval.end());
+    return rval;
+}
+
+bool
+t_stnode_store::child_less(t_uindex a, t_uindex b) const {
+    if (m_sort_value[a] < m_sort_value[b])
+        return true;
+    if (m_sort_value[b] < m_sort_value[a])
+        return false;
+    return m_value[a] < m_value[b];
+}
+
+void
+t_stnode_store::link_child(t_uindex idx) {
+    t_uindex pidx = m_pidx[idx];
+    if (pidx == root_pidx())
+        return;
+
+    std::vector<t_uindex>& siblings = m_children[pidx];
+    auto iter = std::upper_bound(siblings.begin(), siblings.end(), idx,
+        [this](t_uindex a, t_uindex b) { return child_less(a, b); });
+    siblings.insert(iter, idx);
+}
+
+void
+t_stnode_store::unlink_child(t_uindex idx) {
+    t_uindex pidx = m_pidx[idx];
+    if (pidx == root_pidx() || pidx >= m_children.size())
+        return;
+
+    std::vector<t_uindex>& siblings = m_children[pidx];
+    auto iter = siblings.begin() + get_child_position(pidx, idx);
+    if (iter != siblings.end())
+        siblings.erase(iter);
+}
+
+void
+t_stnode_store::reserve_idx(t_uindex idx) {
+    if (idx < m_live.size())
+        return;
+
+    t_uindex nsize = idx + 1;
+    m_pidx.resize(nsize);
+    m_depth.resize(nsize);
+    m_value.resize(nsize);
+    m_sort_value.resize(nsize);
+    m_nstrands.resize(nsize);
+    m_aggidx.resize(nsize);
+    m_live.resize(nsize, false);
+    m_children.resize(nsize);
+}
+
+void
+t_stnode_store::update_zero_strands(t_uindex idx) {
+    if (m_nstrands[idx] == 0) {
+        m_zero_strands.insert(idx);
+    } else {
+        m_zero_strands.erase(idx);
+    }
+}
+
 t_stpkey::t_stpkey(t_uindex idx, t_tscalar pkey)
     : m_idx(idx)
     , m_pkey(pkey) {}
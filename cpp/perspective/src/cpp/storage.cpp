@@ -235,11 +235,16 @@ t_lstore::~t_lstore() {
 
             bool dont_delete = std::getenv("PSP_DO_NOT_DELETE_TABLES") != 0;
 
-            if (!dont_delete) {
+            // Files named by a recipe belong to whoever wrote them
+            if (!dont_delete && !m_from_recipe) {
                 rmfile(m_fname);
             }
         } break;
         case BACKING_STORE_MEMORY: {
+            if (m_exported_base) {
+                // Freed once the last exported array is released
+                m_exported_base.reset();
+            } else
 #ifdef _MSC_VER
             if (m_alignment >= 2) {
                 _aligned_free(m_base); // seriously
@@ -350,7 +355,14 @@ t_lstore::reserve_impl(t_uindex capacity, bool allow_shrink) {
         case BACKING_STORE_MEMORY: {
             void* base = 0;
 
-            if (m_alignment < 2) {
+            if (m_exported_base) {
+                // Exported arrays keep the old buffer alive, so move to a copy
+                base = malloc(size_t(capacity));
+                if (base != 0) {
+                    memcpy(base, m_base, size_t(std::min(ocapacity, capacity)));
+                    m_exported_base.reset();
+                }
+            } else if (m_alignment < 2) {
                 base = realloc(m_base, size_t(capacity));
             } else {
 // nontrivial alignment
@@ -389,7 +401,11 @@ t_lstore::reserve_impl(t_uindex capacity, bool allow_shrink) {
             PSP_VERBOSE_ASSERT(m_alignment < 2,
                 "nontrivial alignments currently "
                 "unsupported for BACKING_STORE_DISK");
-            resize_mapping(capacity);
+            if (is_copy_on_write()) {
+                detach_mapping(capacity);
+            } else {
+                resize_mapping(capacity);
+            }
             ++m_version;
         } break;
         default: { PSP_COMPLAIN_AND_ABORT("unknown backing medium"); }
@@ -401,6 +417,42 @@ t_lstore::reserve_impl(t_uindex capacity, bool allow_shrink) {
     }
 }
 
+void
+t_lstore::unshare() {
+    void* base = malloc(size_t(m_capacity));
+    PSP_VERBOSE_ASSERT(base != 0, "malloc failed");
+    memcpy(base, m_base, size_t(m_capacity));
+    m_exported_base.reset();
+    {
+        t_unlock_store tmp(this);
+        m_base = base;
+        ++m_version;
+    }
+}
+
+// Copies a private mapping to memory so it can grow; the snapshot file is
+// left untouched.
+void
+t_lstore::detach_mapping(t_uindex capacity) {
+    void* base = malloc(size_t(capacity));
+    PSP_VERBOSE_ASSERT(base != 0, "malloc failed");
+    memcpy(base, m_base, size_t(std::min(m_capacity, capacity)));
+
+    destroy_mapping();
+    close_file(m_fd);
+
+    t_unlock_store tmp(this);
+    m_base = base;
+    m_capacity = capacity;
+    m_backing_store = BACKING_STORE_MEMORY;
+}
+
+bool
+t_lstore::is_copy_on_write() const {
+    return m_backing_store == BACKING_STORE_DISK
+        && (m_mflags & PSP_DEFAULT_SNAPSHOT_MFLAGS) != 0;
+}
+
 // Assumes store has been initted
 void
 t_lstore::load(const std::string& fname) {
@@ -410,6 +462,8 @@ t_lstore::load(const std::string& fname) {
     t_rfmapping imap;
     map_file_read(fname, imap);
     reserve(imap.m_size);
+    if (m_exported_base)
+        unshare();
     memcpy(m_base, imap.m_base, size_t(imap.m_size));
     m_size = imap.m_size;
     PSP_CHECK_CAPACITY();
@@ -474,6 +528,8 @@ t_lstore::push_back(const void* ptr, t_uindex len) {
     }
 
     PSP_VERBOSE_ASSERT(m_size + len < m_capacity, "Insufficient capacity.");
+    if (m_exported_base)
+        unshare();
 
     memcpy(static_cast<unsigned char*>(m_base) + m_size, ptr, size_t(len));
 
@@ -486,6 +542,8 @@ t_lstore::push_back(const void* ptr, t_uindex len) {
 
 void*
 t_lstore::get_ptr(t_uindex offset) {
+    if (m_exported_base)
+        unshare();
     return static_cast<void*>(static_cast<unsigned char*>(m_base) + offset);
 }
 
@@ -519,20 +577,26 @@ void
 t_lstore::clear() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    if (m_exported_base)
+        unshare();
 #ifndef PSP_ENABLE_WASM
     memset(m_base, 0, size_t(capacity()));
 #endif
     {
         t_unlock_store tmp(this);
         m_size = 0;
+        ++m_version;
     }
 }
 
 t_lstore_recipe
 t_lstore::get_recipe() const {
+    // Copies of a private mapping are private too, so they live in memory
+    t_backing_store backing_store
+        = is_copy_on_write() ? BACKING_STORE_MEMORY : m_backing_store;
     t_lstore_recipe rval(m_dirname, m_colname, m_capacity, PSP_DEFAULT_SHARED_RO_FFLAGS,
         PSP_DEFAULT_SHARED_RO_FMODE, PSP_DEFAULT_SHARED_RO_CREATION_DISPOSITION,
-        PSP_DEFAULT_SHARED_RO_MPROT, PSP_DEFAULT_SHARED_RO_MFLAGS, m_backing_store);
+        PSP_DEFAULT_SHARED_RO_MPROT, PSP_DEFAULT_SHARED_RO_MFLAGS, backing_store);
     rval.m_fname = m_fname;
     rval.m_from_recipe = true;
     rval.m_size = m_size;
@@ -545,6 +609,8 @@ t_lstore::fill(const t_lstore& other) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     reserve(other.size());
+    if (m_exported_base)
+        unshare();
     memcpy(m_base, const_cast<void*>(other.m_base), size_t(other.size()));
     set_size(other.size());
 }
@@ -556,6 +622,8 @@ t_lstore::fill(const t_lstore& other, const t_mask& mask, t_uindex elem_size) {
     reserve(mask.size() * elem_size);
 
     PSP_VERBOSE_ASSERT(mask.size() * elem_size <= m_size, "Not enough space to fill");
+    if (m_exported_base)
+        unshare();
 
     t_uindex offset = 0;
 
@@ -604,7 +672,25 @@ t_lstore::_as_numpy(t_dtype dtype) {
     py::tuple shape = py::make_tuple(m_size / get_dtype_size(dtype));
     py::tuple stride = py::make_tuple(get_dtype_size(dtype));
 
-    np::ndarray result = np::from_data(m_base, npdtype, shape, stride, py::object());
+    if (m_backing_store != BACKING_STORE_MEMORY || m_alignment >= 2) {
+        // Mapped and aligned stores are not shared, hand out a copy
+        return np::from_data(static_cast<const void*>(m_base), npdtype, shape, stride,
+            py::object())
+            .copy();
+    }
+
+    if (!m_exported_base) {
+        m_exported_base = std::shared_ptr<void>(m_base, free);
+    }
+
+    auto handle = new std::shared_ptr<void>(m_exported_base);
+    PyObject* capsule = PyCapsule_New(handle, nullptr, [](PyObject* cap) {
+        delete static_cast<std::shared_ptr<void>*>(PyCapsule_GetPointer(cap, nullptr));
+    });
+    py::object owner{py::handle<>(capsule)};
+
+    np::ndarray result = np::from_data(
+        static_cast<const void*>(m_base), npdtype, shape, stride, owner);
 
     return result;
     // PSP_VERBOSE_ASSERT(rval, "Null array found!");
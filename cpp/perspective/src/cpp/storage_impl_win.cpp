@@ -48,6 +48,10 @@ t_lstore::t_lstore(const t_lstore_recipe& a)
     , m_from_recipe(a.m_from_recipe) {
     if (m_from_recipe) {
         m_fname = a.m_fname;
+        // A mapped file already holds the contents described by the recipe
+        if (m_backing_store == BACKING_STORE_DISK) {
+            m_size = a.m_size;
+        }
         return;
     }
 
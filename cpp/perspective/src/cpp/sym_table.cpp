@@ -22,9 +22,7 @@ std::mutex sym_table_mutex;
 t_symtable::t_symtable() {}
 
 t_symtable::~t_symtable() {
-    for (auto& kv : m_mapping) {
-        free(const_cast<char*>(kv.second));
-    }
+    clear();
 }
 
 const char*
@@ -69,6 +67,14 @@ t_symtable::size() const {
     return m_mapping.size();
 }
 
+void
+t_symtable::clear() {
+    for (auto& kv : m_mapping) {
+        free(const_cast<char*>(kv.second));
+    }
+    m_mapping.clear();
+}
+
 static t_symtable*
 get_symtable() {
     static t_symtable* sym = 0;
@@ -29,24 +29,24 @@ Table::Table(std::shared_ptr<t_pool> pool, std::vector<std::string> column_names
     }
 
 void
-Table::init(t_data_table& data_table, std::uint32_t row_count, const t_op op) {
+Table::init(std::shared_ptr<t_data_table> data_table, std::uint32_t row_count, const t_op op) {
     /**
      * For the Table to be initialized correctly, make sure that the operation and index columns are
      * processed before the new offset is calculated. Calculating the offset before the `process_op_column`
      * and `process_index_column` causes primary keys to be misaligned.
      */
-    process_op_column(data_table, op);
+    process_op_column(*data_table, op);
     calculate_offset(row_count);
 
     if (!m_gnode_set) {
         // create a new gnode, send it to the table
-        auto new_gnode = make_gnode(data_table.get_schema());
+        auto new_gnode = make_gnode(data_table->get_schema());
         set_gnode(new_gnode);
         m_pool->register_gnode(m_gnode.get());
     }
 
     PSP_VERBOSE_ASSERT(m_gnode_set, "gnode is not set!");
-    m_pool->send(m_gnode->get_id(), 0, data_table);
+    m_pool->send(m_gnode->get_id(), 0, std::move(data_table));
 
     m_init = true;
 }
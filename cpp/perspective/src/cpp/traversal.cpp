@@ -32,7 +32,8 @@ t_vdnode::t_vdnode(bool expanded, bool has_children)
     , m_has_children(has_children) {}
 
 t_traversal::t_traversal(std::shared_ptr<const t_stree> tree)
-    : m_tree(tree) {
+    : m_tree(tree)
+    , m_sorted_extent(std::numeric_limits<t_index>::max()) {
     t_stnode_vec rchildren;
     tree->get_child_nodes(0, rchildren);
     populate_root_children(rchildren);
@@ -40,6 +41,7 @@ t_traversal::t_traversal(std::shared_ptr<const t_stree> tree)
 
 void
 t_traversal::populate_root_children(const t_stnode_vec& rchildren) {
+    clear_pending_sort();
     m_nodes = std::make_shared<std::vector<t_tvnode>>(rchildren.size() + 1);
 
     // Initialize root
@@ -74,6 +76,7 @@ t_traversal::populate_root_children(std::shared_ptr<const t_stree> tree) {
 
 t_index
 t_traversal::expand_node(t_index exp_idx) {
+    complete_sort();
     t_tvnode& exp_tvnode = (*m_nodes)[exp_idx];
 
     if (exp_tvnode.m_expanded) {
@@ -116,6 +119,7 @@ t_traversal::expand_node(t_index exp_idx) {
 
 t_index
 t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx, t_ctx2* ctx2) {
+    complete_sort();
     t_tvnode& exp_tvnode = (*m_nodes)[exp_idx];
 
     if (exp_tvnode.m_expanded) {
@@ -141,17 +145,19 @@ t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx,
         t_index num_aggs = sortby.size();
         std::vector<t_tscalar> aggregates(num_aggs);
 
+        std::vector<t_sorttype> sort_orders = get_sort_orders(sortby);
+
         t_uindex child_idx = 0;
         for (t_stnode_vec::const_iterator iter = tchildren.begin(); iter != tchildren.end();
              ++iter) {
             m_tree->get_aggregates_for_sorting(
                 iter->m_idx, sortby_agg_indices, aggregates, ctx2);
             (*sortelems)[count] = t_mselem(aggregates, child_idx);
+            encode_sort_key((*sortelems)[count], sort_orders);
             ++count;
             ++child_idx;
         }
 
-        std::vector<t_sorttype> sort_orders = get_sort_orders(sortby);
         t_multisorter sorter(sortelems, sort_orders);
         argsort(sorted_idx, sorter);
     } else {
@@ -189,6 +195,7 @@ t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx,
 
 t_index
 t_traversal::collapse_node(t_index idx) {
+    complete_sort();
     t_tvnode& node = (*m_nodes)[idx];
 
     if (!node.m_expanded) {
@@ -220,6 +227,7 @@ t_traversal::collapse_node(t_index idx) {
 void
 t_traversal::add_node(const std::vector<t_sortspec>& sortby,
     const std::vector<t_uindex>& indices, t_index insert_level_idx, t_ctx2* ctx2) {
+    complete_sort();
     std::vector<t_sortspec> dummy = sortby;
     std::vector<t_index> tv_indices;
     t_index collapsed_ancestor = INVALID_INDEX;
@@ -302,6 +310,7 @@ t_traversal::update_sucessors(t_index nidx, t_index n_changed) {
 
 t_index
 t_traversal::get_tree_index(t_index idx) const {
+    ensure_sorted(idx + 1);
     return (*m_nodes)[idx].m_tnid;
 }
 
@@ -312,11 +321,13 @@ t_traversal::size() const {
 
 t_depth
 t_traversal::get_depth(t_index idx) const {
+    ensure_sorted(idx + 1);
     return (*m_nodes)[idx].m_depth;
 }
 
 t_index
 t_traversal::get_traversal_index(t_index idx) {
+    complete_sort();
     t_index rval = INVALID_INDEX;
 
     for (t_index i = 0, loop_end = m_nodes->size(); i < loop_end; ++i) {
@@ -330,6 +341,7 @@ t_traversal::get_traversal_index(t_index idx) {
 
 std::vector<t_vdnode>
 t_traversal::get_view_nodes(t_index bidx, t_index eidx) const {
+    ensure_sorted(eidx);
     std::vector<t_vdnode> vec(eidx - bidx);
     for (t_index i = bidx; i < eidx; i++) {
         t_index idx = i - bidx;
@@ -405,6 +417,7 @@ t_traversal::validate_cells(const std::vector<std::pair<t_uindex, t_uindex>>& ce
 
 t_index
 t_traversal::remove_subtree(t_index idx) {
+    complete_sort();
     t_tvnode& node = (*m_nodes)[idx];
 
     // Calculate span of descendents
@@ -445,11 +458,13 @@ t_traversal::pprint() const {
 
 t_tvnode
 t_traversal::get_node(t_index idx) const {
+    ensure_sorted(idx + 1);
     return (*m_nodes)[idx];
 }
 
 void
 t_traversal::get_leaves(std::vector<t_index>& out_data) const {
+    ensure_sorted(size());
     for (t_index curidx = 0, loop_end = m_nodes->size(); curidx < loop_end; ++curidx) {
         if (!(*m_nodes)[curidx].m_expanded) {
             out_data.push_back(curidx);
@@ -472,6 +487,26 @@ t_traversal::get_child_indices(
     }
 }
 
+void
+t_traversal::reorder_children(t_index h_tvidx, const std::vector<t_index>& children) {
+    if (std::is_sorted(children.begin(), children.end())) {
+        return;
+    }
+
+    std::vector<t_tvnode> new_nodes;
+    new_nodes.reserve((*m_nodes)[h_tvidx].m_ndesc);
+
+    for (t_index c_otvidx : children) {
+        const t_tvnode& child = (*m_nodes)[c_otvidx];
+        t_index c_rel_idx = new_nodes.size();
+        new_nodes.insert(new_nodes.end(), m_nodes->begin() + c_otvidx,
+            m_nodes->begin() + c_otvidx + child.m_ndesc + 1);
+        new_nodes[c_rel_idx].m_rel_pidx = c_rel_idx + 1;
+    }
+
+    std::copy(new_nodes.begin(), new_nodes.end(), m_nodes->begin() + h_tvidx + 1);
+}
+
 void
 t_traversal::print_stats() {
     std::cout << "Traversal size => " << m_nodes->size() << std::endl;
@@ -542,6 +577,7 @@ t_traversal::set_depth(const std::vector<t_sortspec>& sortby, t_depth depth, t_c
 
 std::vector<t_ftreenode>
 t_traversal::get_flattened_tree(t_index idx, t_depth stop_depth) const {
+    ensure_sorted(size());
     std::queue<t_index> queue;
     queue.push(idx);
     std::vector<t_ftreenode> rvec;
@@ -585,6 +621,7 @@ t_traversal::get_flattened_tree(t_index idx, t_depth stop_depth) const {
 
 t_index
 t_traversal::tree_index_lookup(t_index idx, t_index bidx) const {
+    ensure_sorted(size());
     t_index tvidx = INVALID_INDEX;
     for (t_index i = bidx, loop_end = m_nodes->size(); i < loop_end; ++i) {
         if ((*m_nodes)[i].m_tnid == idx) {
@@ -644,6 +681,7 @@ t_traversal::get_expanded(std::vector<t_index>& expanded_tidx) const {
 
 void
 t_traversal::drop_tree_indices(const std::vector<t_uindex>& indices) {
+    complete_sort();
     for (auto idx : indices) {
         t_index tvidx = tree_index_lookup(idx, 0);
         if (tvidx == INVALID_INDEX) {
@@ -666,8 +704,49 @@ t_traversal::get_tree() const {
 
 bool
 t_traversal::get_node_expanded(t_index idx) const {
+    ensure_sorted(idx + 1);
     if (idx < 0 || static_cast<t_uindex>(idx) > m_nodes->size())
         return false;
     return m_nodes->at(idx).m_expanded;
 }
+
+void
+t_traversal::complete_sort() {
+    ensure_sorted(std::numeric_limits<t_index>::max());
+}
+
+bool
+t_traversal::has_pending_sort() const {
+    return m_sorted_extent != std::numeric_limits<t_index>::max();
+}
+
+void
+t_traversal::ensure_sorted(t_index eidx) const {
+    if (eidx <= m_sorted_extent) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(m_sort_mtx);
+    if (eidx <= m_sorted_extent) {
+        return;
+    }
+
+    for (auto head : m_pending_heads) {
+        std::vector<t_index> unused;
+        sort_subtree(head, m_pending_sortby, *m_tree, nullptr, INVALID_INDEX, unused);
+    }
+
+    m_pending_heads.clear();
+    m_pending_sortby.clear();
+    m_sorted_extent = std::numeric_limits<t_index>::max();
+}
+
+void
+t_traversal::clear_pending_sort() {
+    std::lock_guard<std::mutex> lk(m_sort_mtx);
+    m_pending_heads.clear();
+    m_pending_sortby.clear();
+    m_sorted_extent = std::numeric_limits<t_index>::max();
+}
+
 } // end namespace perspective
@@ -29,6 +29,10 @@ notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
     const std::vector<t_sortspec>& ctx_sortby, const t_gstate& gstate) {
     t_filter fltr;
+
+    // A viewport-first sort may still reference nodes this update removes
+    if (process_traversal)
+        traversal->complete_sort();
     if (t_env::log_data_nsparse_strands()) {
         std::cout << "nsparse_strands" << std::endl;
         strands->pprint();
@@ -134,10 +138,10 @@ notify_sparse_tree(std::shared_ptr<t_stree> tree, std::shared_ptr<t_traversal> t
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
     const t_data_table& delta, const t_data_table& prev, const t_data_table& current,
     const t_data_table& transitions, const t_data_table& existed, const t_config& config,
-    const t_gstate& gstate) {
+    const t_gstate& gstate, const t_mask* msk_prev, const t_mask* msk_curr) {
 
     auto strand_values = tree->build_strand_table(
-        flattened, delta, prev, current, transitions, aggregates, config);
+        flattened, delta, prev, current, transitions, aggregates, config, msk_prev, msk_curr);
 
     auto strands = strand_values.first;
     auto strand_deltas = strand_values.second;
@@ -150,8 +154,8 @@ notify_sparse_tree(std::shared_ptr<t_stree> tree, std::shared_ptr<t_traversal> t
     bool process_traversal, const std::vector<t_aggspec>& aggregates,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
-    const t_config& config, const t_gstate& gstate) {
-    auto strand_values = tree->build_strand_table(flattened, aggregates, config);
+    const t_config& config, const t_gstate& gstate, const t_mask* msk) {
+    auto strand_values = tree->build_strand_table(flattened, aggregates, config, msk);
 
     auto strands = strand_values.first;
     auto strand_deltas = strand_values.second;
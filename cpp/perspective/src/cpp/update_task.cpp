@@ -17,18 +17,24 @@ t_update_task::t_update_task(t_pool& pool)
 
 void
 t_update_task::run() {
-    auto work_to_do = m_pool.m_data_remaining.load();
-    if (work_to_do) {
-        m_pool.m_data_remaining.store(true);
-        for (auto g : m_pool.m_gnodes) {
-            if (g)
-                g->_process();
-        }
-        for (auto g : m_pool.m_gnodes) {
-            if (g)
-                g->clear_output_ports();
+    {
+        // Released before notifying, as callbacks may register or unregister
+        // contexts, which take the same lock
+        std::lock_guard<std::mutex> lg(m_pool.m_mtx);
+
+        // Cleared before gnodes take their staged tables, so tables staged
+        // meanwhile leave it set for the next run
+        auto work_to_do = m_pool.m_data_remaining.exchange(false);
+        if (work_to_do) {
+            for (auto g : m_pool.m_gnodes) {
+                if (g)
+                    g->_process();
+            }
+            for (auto g : m_pool.m_gnodes) {
+                if (g)
+                    g->clear_output_ports();
+            }
         }
-        m_pool.m_data_remaining.store(false);
     }
     m_pool.py_notify_userspace();
     m_pool.inc_epoch();
@@ -36,18 +42,19 @@ t_update_task::run() {
 
 void
 t_update_task::run(t_uindex gnode_id) {
-    auto work_to_do = m_pool.m_data_remaining.load();
-    if (work_to_do) {
-        for (auto g : m_pool.m_gnodes) {
-            if (g)
-                g->_process();
-        }
-        m_pool.m_data_remaining.store(true);
-        for (auto g : m_pool.m_gnodes) {
-            if (g)
-                g->clear_output_ports();
+    {
+        std::lock_guard<std::mutex> lg(m_pool.m_mtx);
+        auto work_to_do = m_pool.m_data_remaining.exchange(false);
+        if (work_to_do) {
+            for (auto g : m_pool.m_gnodes) {
+                if (g)
+                    g->_process();
+            }
+            for (auto g : m_pool.m_gnodes) {
+                if (g)
+                    g->clear_output_ports();
+            }
         }
-        m_pool.m_data_remaining.store(false);
     }
     m_pool.py_notify_userspace();
     m_pool.inc_epoch();
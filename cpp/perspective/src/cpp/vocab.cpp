@@ -245,4 +245,16 @@ t_vocab::get_vlenidx() const {
     return m_vlenidx;
 }
 
+t_vocab_remap::t_vocab_remap(const t_vocab& src, t_vocab& dst)
+    : m_src(&src)
+    , m_dst(&dst)
+    , m_remap(src.get_vlenidx(), std::numeric_limits<t_uindex>::max()) {}
+
+void
+t_vocab_remap::translate(t_uindex* ids, const t_status* status, t_uindex n) {
+    for (t_uindex idx = 0; idx < n; ++idx) {
+        ids[idx] = !status || status[idx] == STATUS_VALID ? translate(ids[idx]) : 0;
+    }
+}
+
 } // end namespace perspective
@@ -0,0 +1,351 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/zone_map.h>
+#include <perspective/column.h>
+#include <perspective/date.h>
+#include <perspective/time.h>
+#include <algorithm>
+#include <cmath>
+
+namespace perspective {
+
+template <typename DATA_T>
+static bool
+is_nan(DATA_T v) {
+    return false;
+}
+
+static bool
+is_nan(double v) {
+    return std::isnan(v);
+}
+
+static bool
+is_nan(float v) {
+    return std::isnan(v);
+}
+
+t_zone::t_zone()
+    : m_min(mknone())
+    , m_max(mknone())
+    , m_nvalid(0)
+    , m_nnull(0) {}
+
+/**
+ * Summarizes rows [begin, end) of `column`, read as DATA_T and reported as
+ * VALUE_T, e.g. dates are compared by their raw representation.
+ */
+template <typename DATA_T, typename VALUE_T = DATA_T>
+static t_zone
+summarize(const t_column& column, t_uindex begin, t_uindex end) {
+    t_zone zone;
+    const DATA_T* data = column.get_nth<DATA_T>(0);
+    const t_status* status = column.is_status_enabled() ? column.get_nth_status(0) : nullptr;
+
+    bool has_range = false;
+    DATA_T min = DATA_T();
+    DATA_T max = DATA_T();
+    for (t_uindex ridx = begin; ridx < end; ++ridx) {
+        if (status && status[ridx] != STATUS_VALID) {
+            ++zone.m_nnull;
+            continue;
+        }
+
+        ++zone.m_nvalid;
+        DATA_T v = data[ridx];
+        if (is_nan(v)) {
+            continue;
+        }
+        if (!has_range) {
+            min = v;
+            max = v;
+            has_range = true;
+        } else {
+            min = std::min(min, v);
+            max = std::max(max, v);
+        }
+    }
+
+    if (has_range) {
+        zone.m_min = mktscalar(VALUE_T(min));
+        zone.m_max = mktscalar(VALUE_T(max));
+    }
+    return zone;
+}
+
+static t_zone
+summarize(const t_column& column, t_uindex begin, t_uindex end) {
+    switch (column.get_dtype()) {
+        case DTYPE_INT64: {
+            return summarize<std::int64_t>(column, begin, end);
+        }
+        case DTYPE_INT32: {
+            return summarize<std::int32_t>(column, begin, end);
+        }
+        case DTYPE_INT16: {
+            return summarize<std::int16_t>(column, begin, end);
+        }
+        case DTYPE_INT8: {
+            return summarize<std::int8_t>(column, begin, end);
+        }
+        case DTYPE_UINT64: {
+            return summarize<std::uint64_t>(column, begin, end);
+        }
+        case DTYPE_UINT32: {
+            return summarize<std::uint32_t>(column, begin, end);
+        }
+        case DTYPE_UINT16: {
+            return summarize<std::uint16_t>(column, begin, end);
+        }
+        case DTYPE_UINT8: {
+            return summarize<std::uint8_t>(column, begin, end);
+        }
+        case DTYPE_FLOAT64: {
+            return summarize<double>(column, begin, end);
+        }
+        case DTYPE_FLOAT32: {
+            return summarize<float>(column, begin, end);
+        }
+        case DTYPE_BOOL: {
+            return summarize<bool>(column, begin, end);
+        }
+        case DTYPE_DATE: {
+            return summarize<std::uint32_t, t_date>(column, begin, end);
+        }
+        case DTYPE_TIME: {
+            return summarize<std::int64_t, t_time>(column, begin, end);
+        }
+        default: {
+            PSP_COMPLAIN_AND_ABORT(
+                "Cannot summarize column of type " + get_dtype_descr(column.get_dtype()));
+        }
+    }
+    return t_zone();
+}
+
+// Whether `value` lies within [m_min, m_max].
+static bool
+in_range(const t_zone& zone, const t_tscalar& value) {
+    return !(value < zone.m_min) && !(zone.m_max < value);
+}
+
+/**
+ * Whether any row of `zone` may pass `fterm`, or true if that cannot be
+ * told. The terms of filter_cpp fail null cells, except for IS_NULL.
+ */
+static bool
+may_match(const t_zone& zone, const t_fterm& fterm, t_dtype dtype) {
+    if (fterm.m_negated) {
+        return true;
+    }
+
+    switch (fterm.m_op) {
+        case FILTER_OP_IS_NULL: {
+            return zone.m_nnull > 0;
+        }
+        case FILTER_OP_IS_NOT_NULL:
+        case FILTER_OP_IS_VALID: {
+            return zone.m_nvalid > 0;
+        }
+        case FILTER_OP_EQ:
+        case FILTER_OP_LT:
+        case FILTER_OP_LTEQ:
+        case FILTER_OP_GT:
+        case FILTER_OP_GTEQ:
+        case FILTER_OP_IN: {
+        } break;
+        default: { return true; }
+    }
+
+    if (zone.m_nvalid == 0) {
+        return false;
+    }
+
+    std::vector<t_tscalar> values;
+    if (fterm.m_op == FILTER_OP_IN) {
+        values = fterm.m_bag;
+    } else {
+        values.push_back(fterm.m_threshold);
+    }
+
+    bool any = false;
+    for (const auto& value : values) {
+        t_tscalar coerced = value.coerce_numeric_dtype(dtype);
+        if (!coerced.is_valid() || coerced.get_dtype() != dtype) {
+            if (fterm.m_op == FILTER_OP_IN) {
+                continue;
+            }
+            return true;
+        }
+
+        // NaNs are outside every range, but a NaN threshold may match one
+        if (coerced.is_floating_point() && std::isnan(coerced.to_double())) {
+            return true;
+        }
+        if (zone.m_min.is_none()) {
+            continue;
+        }
+
+        switch (fterm.m_op) {
+            case FILTER_OP_LT: {
+                any |= zone.m_min < coerced;
+            } break;
+            case FILTER_OP_LTEQ: {
+                any |= !(coerced < zone.m_min);
+            } break;
+            case FILTER_OP_GT: {
+                any |= coerced < zone.m_max;
+            } break;
+            case FILTER_OP_GTEQ: {
+                any |= !(zone.m_max < coerced);
+            } break;
+            default: {
+                any |= in_range(zone, coerced);
+            } break;
+        }
+    }
+    return any;
+}
+
+t_zone_maps::t_zone_maps(t_uindex block_size)
+    : m_block_size(block_size) {}
+
+void
+t_zone_maps::mark(t_uindex ridx) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_zones.empty()) {
+        return;
+    }
+    t_uindex bidx = ridx / m_block_size;
+    if (bidx >= m_dirty.size()) {
+        m_dirty.resize(bidx + 1);
+    }
+    m_dirty.set(bidx);
+}
+
+void
+t_zone_maps::mark(const std::vector<t_uindex>& rows) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_zones.empty()) {
+        return;
+    }
+    for (auto ridx : rows) {
+        t_uindex bidx = ridx / m_block_size;
+        if (bidx >= m_dirty.size()) {
+            m_dirty.resize(bidx + 1);
+        }
+        m_dirty.set(bidx);
+    }
+}
+
+void
+t_zone_maps::invalidate() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_zones.clear();
+    m_dirty.clear();
+}
+
+const std::vector<t_zone>&
+t_zone_maps::refresh(const t_data_table& tbl, const std::string& colname) {
+    m_zones[colname];
+
+    t_uindex nrows = tbl.size();
+    t_uindex nblocks = (nrows + m_block_size - 1) / m_block_size;
+    for (auto& column_zones : m_zones) {
+        const t_column& column = *(tbl.get_const_column(column_zones.first));
+        std::vector<t_zone>& zones = column_zones.second;
+
+        t_uindex nsummarized = std::min(zones.size(), nblocks);
+        zones.resize(nblocks);
+        for (t_uindex bidx = 0; bidx < nblocks; ++bidx) {
+            bool dirty = bidx < m_dirty.size() && m_dirty.test(bidx);
+            if (bidx < nsummarized && !dirty) {
+                continue;
+            }
+            t_uindex begin = bidx * m_block_size;
+            zones[bidx] = summarize(column, begin, std::min(begin + m_block_size, nrows));
+        }
+    }
+
+    m_dirty.reset();
+    return m_zones[colname];
+}
+
+bool
+t_zone_maps::filter(const t_data_table& tbl, const std::vector<t_fterm>& fterms, t_mask& mask) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    t_uindex nrows = tbl.size();
+    t_uindex nblocks = (nrows + m_block_size - 1) / m_block_size;
+    boost::dynamic_bitset<> skipped(nblocks);
+
+    for (const auto& fterm : fterms) {
+        t_dtype dtype = tbl.get_const_column(fterm.m_colname)->get_dtype();
+        if (!is_linear_order_type(dtype)) {
+            continue;
+        }
+
+        const std::vector<t_zone>& zones = refresh(tbl, fterm.m_colname);
+        for (t_uindex bidx = 0; bidx < nblocks; ++bidx) {
+            if (!skipped.test(bidx) && !may_match(zones[bidx], fterm, dtype)) {
+                skipped.set(bidx);
+            }
+        }
+    }
+
+    if (skipped.none()) {
+        return false;
+    }
+
+    std::vector<t_uindex> rows;
+    for (t_uindex bidx = 0; bidx < nblocks; ++bidx) {
+        if (skipped.test(bidx)) {
+            continue;
+        }
+        for (t_uindex ridx = bidx * m_block_size,
+                      loop_end = std::min(ridx + m_block_size, nrows);
+             ridx < loop_end; ++ridx) {
+            rows.push_back(ridx);
+        }
+    }
+
+    mask = tbl.filter_cpp(FILTER_OP_AND, fterms, rows);
+    return true;
+}
+
+std::pair<t_tscalar, t_tscalar>
+t_zone_maps::get_min_max(const t_data_table& tbl, const std::string& colname) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    t_tscalar min = mknone();
+    t_tscalar max = mknone();
+
+    for (const auto& zone : refresh(tbl, colname)) {
+        if (zone.m_min.is_none()) {
+            continue;
+        }
+        if (min.is_none() || zone.m_min < min) {
+            min = zone.m_min;
+        }
+        if (max.is_none() || max < zone.m_max) {
+            max = zone.m_max;
+        }
+    }
+
+    return std::make_pair(min, max);
+}
+
+std::vector<t_zone>
+t_zone_maps::get_zones(const t_data_table& tbl, const std::string& colname) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return refresh(tbl, colname);
+}
+
+} // end namespace perspective
@@ -104,6 +104,7 @@ public:
 
     // idx is in items
     const t_status* get_nth_status(t_uindex idx) const;
+    t_status* get_nth_status(t_uindex idx);
 
     // idx is in items
     template <typename T>
@@ -122,6 +123,11 @@ public:
 
     const t_lstore& data_lstore() const;
 
+    // Only meaningful when status is enabled, or for string columns
+    const t_lstore& status_lstore() const;
+    const t_lstore& vlendata_lstore() const;
+    const t_lstore& extents_lstore() const;
+
     t_uindex size() const;
 
     t_uindex get_vlenidx() const;
@@ -195,12 +201,21 @@ public:
 
     t_uindex get_interned(const std::string& s);
     t_uindex get_interned(const char* s);
+
+    // Looks `s` up in the vocabulary without interning it.
+    bool string_exists(const char* s, t_uindex& interned) const;
     void _rebuild_map();
 
     void borrow_vocabulary(const t_column& o);
 
+    // Translates string ids of `other` into this column's vocabulary.
+    t_vocab_remap remap_vocabulary(const t_column& other);
+
 #ifdef PSP_ENABLE_PYTHON
+    // Zero-copy, read-only views; string columns yield their vocab indices
     np::ndarray _as_numpy();
+    np::ndarray _status_as_numpy();
+    py::list _vocab_as_list() const;
 #endif
 
 private:
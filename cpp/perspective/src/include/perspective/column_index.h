@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/column.h>
+#include <perspective/data_table.h>
+#include <perspective/filter.h>
+#include <perspective/mask.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * A secondary index over one column of a table, by row index. Strings keep
+ * a sorted list of rows per vocabulary id; other types keep (value, row)
+ * pairs sorted by value. Either way an index costs a few words per row,
+ * whatever the cardinality of the column. Only valid cells are indexed.
+ *
+ * Lookups return a superset of the rows passing a term, in ascending order,
+ * and callers verify every candidate: e.g. floats that compare equal but
+ * differ in their bits are found together.
+ */
+class PERSPECTIVE_EXPORT t_column_index {
+public:
+    static std::unique_ptr<t_column_index> make(t_dtype dtype);
+
+    virtual ~t_column_index();
+
+    virtual void rebuild(const t_column& column) = 0;
+
+    // Re-reads `rows`, sorted and unique, of a column otherwise unchanged
+    // since the last rebuild or update.
+    virtual void update(const t_column& column, const std::vector<t_uindex>& rows) = 0;
+
+    // Candidate rows for `fterm`; false if the index cannot narrow it down.
+    virtual bool lookup(
+        const t_column& column, const t_fterm& fterm, std::vector<t_uindex>& rows) const = 0;
+};
+
+/**
+ * The indexes of a t_gstate's master table. Writes only mark their rows;
+ * indexes catch up when next used, so a table ticking faster than new
+ * views are opened on it pays little for them.
+ */
+class PERSPECTIVE_EXPORT t_column_indexes {
+public:
+    t_column_indexes();
+
+    void create(const std::string& colname, t_dtype dtype);
+    bool has_index(const std::string& colname) const;
+    bool empty() const;
+
+    void mark(t_uindex ridx);
+    void mark(const std::vector<t_uindex>& rows);
+
+    // Rebuilds every index on next use, e.g. after the table is replaced.
+    void invalidate();
+
+    // Rows of `tbl` passing every one of `fterms`, found through the indexes
+    // of those that have one; false if none does.
+    bool filter(const t_data_table& tbl, const std::vector<t_fterm>& fterms, t_mask& mask);
+
+private:
+    void refresh(const t_data_table& tbl);
+
+    std::mutex m_mtx;
+    std::map<std::string, std::unique_ptr<t_column_index>> m_indexes;
+    std::vector<t_uindex> m_dirty;
+    bool m_stale;
+};
+
+} // end namespace perspective
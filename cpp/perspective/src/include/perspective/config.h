@@ -16,6 +16,7 @@
 #include <perspective/config.h>
 #include <perspective/pivot.h>
 #include <perspective/filter.h>
+#include <perspective/filter_expr.h>
 #include <perspective/sort_specification.h>
 
 namespace perspective {
@@ -160,6 +161,12 @@ public:
     std::string unity_get_column_display_name(t_uindex idx) const;
     t_fmode get_fmode() const;
 
+    // Filters with `expr` in place of the clauses; see t_filter_expr. Throws
+    // std::invalid_argument, leaving the config unchanged, if `expr` does not
+    // compile against `schema`.
+    void set_filter_expr(const std::string& expr, const t_schema& schema);
+    std::shared_ptr<const t_filter_expr> get_filter_expr() const;
+
     inline const std::string&
     get_grand_agg_str() const {
         return m_grand_agg_str;
@@ -188,7 +195,7 @@ private:
     std::string m_child_pkey_column;
     std::string m_grouping_label_column;
     t_fmode m_fmode;
-    std::vector<std::string> m_filter_exprs;
+    std::shared_ptr<const t_filter_expr> m_filter_expr;
     std::string m_grand_agg_str;
 };
 
@@ -12,6 +12,8 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/config.h>
+#include <perspective/filter_cache.h>
+#include <perspective/filter_utils.h>
 #include <perspective/schema.h>
 #include <perspective/exports.h>
 #include <perspective/min_max.h>
@@ -21,6 +23,10 @@
 #include <perspective/slice.h>
 #include <perspective/range.h>
 #include <perspective/gnode_state.h>
+#include <perspective/pending_notify.h>
+#include <perspective/sketch.h>
+#include <atomic>
+#include <mutex>
 
 namespace perspective {
 
@@ -66,6 +72,23 @@ public:
 
     bool failed() const;
 
+    // A lazy context is not notified on each process. It records the rows
+    // each one touched, and applies them as a single update on the next read
+    // or an explicit resume. Concurrent readers replay it once, the others
+    // waiting for it to finish.
+    void set_lazy(bool lazy);
+    bool get_lazy() const;
+    void defer_notify(
+        const t_data_table& flattened, const t_data_table& prev, const t_data_table& existed);
+    void defer_rebuild();
+    bool has_pending_update() const;
+    void resume() const;
+
+    // Distribution sketches of numeric columns over the rows this context's
+    // filters select, kept current by each notify.
+    void enable_sketch(const std::string& colname, t_uindex nbuckets);
+    const t_column_sketch& get_sketch(const std::string& colname) const;
+
     t_ctx_common<t_ctxbase>
     common() {
         return t_ctx_common<t_ctxbase>(this);
@@ -81,15 +104,26 @@ public:
     std::vector<t_tscalar> get_data() const;
 
 protected:
+    void update_sketches(const t_data_table& flattened, const t_data_table& prev,
+        const t_data_table& curr, const t_data_table& existed, const t_mask* msk_prev,
+        const t_mask* msk_curr);
+    void rebuild_sketches();
+
     t_schema m_schema;
     t_config m_config;
     bool m_rows_changed;
     bool m_columns_changed;
     std::string m_name;
     std::shared_ptr<t_gstate> m_state;
+    t_filter_cache m_filter_cache;
     bool m_init;
     std::vector<bool> m_features;
-    std::vector<t_minmax> m_minmax;
+    bool m_lazy;
+    mutable t_pending_notify m_pending;
+    // Recursive, as the replayed notify goes through readers that resume
+    mutable std::recursive_mutex m_pending_mtx;
+    mutable std::atomic<bool> m_has_pending;
+    t_column_sketches m_sketches;
 };
 
 template <typename DERIVED_T>
@@ -104,7 +138,9 @@ template <typename DERIVED_T>
 t_ctxbase<DERIVED_T>::t_ctxbase()
     : m_rows_changed(true)
     , m_columns_changed(true)
-    , m_init(false) {
+    , m_init(false)
+    , m_lazy(false)
+    , m_has_pending(false) {
     m_features = std::vector<bool>(CTX_FEAT_LAST_FEATURE);
     m_features[CTX_FEAT_ENABLED] = true;
 }
@@ -116,7 +152,9 @@ t_ctxbase<DERIVED_T>::t_ctxbase(const t_schema& schema, const t_config& config)
     , m_config(config)
     , m_rows_changed(true)
     , m_columns_changed(true)
-    , m_init(false) {
+    , m_init(false)
+    , m_lazy(false)
+    , m_has_pending(false) {
     m_features = std::vector<bool>(CTX_FEAT_LAST_FEATURE);
     m_features[CTX_FEAT_ENABLED] = true;
 }
@@ -187,6 +225,128 @@ t_ctxbase<DERIVED_T>::failed() const {
     return false;
 }
 
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::set_lazy(bool lazy) {
+    m_lazy = lazy;
+    if (!lazy) {
+        resume();
+    }
+}
+
+template <typename DERIVED_T>
+bool
+t_ctxbase<DERIVED_T>::get_lazy() const {
+    return m_lazy;
+}
+
+// Once the recorded rows are as many as the table's, a rebuild is cheaper.
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::defer_notify(
+    const t_data_table& flattened, const t_data_table& prev, const t_data_table& existed) {
+    std::lock_guard<std::recursive_mutex> lk(m_pending_mtx);
+    m_pending.add(flattened, prev, existed);
+    if (!m_pending.needs_rebuild() && m_pending.size() >= m_state->mapping_size()) {
+        m_pending.set_rebuild();
+    }
+    m_has_pending = !m_pending.empty();
+}
+
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::defer_rebuild() {
+    std::lock_guard<std::recursive_mutex> lk(m_pending_mtx);
+    m_pending.set_rebuild();
+    m_has_pending = true;
+}
+
+template <typename DERIVED_T>
+bool
+t_ctxbase<DERIVED_T>::has_pending_update() const {
+    std::lock_guard<std::recursive_mutex> lk(m_pending_mtx);
+    return !m_pending.empty();
+}
+
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::resume() const {
+    if (!m_has_pending) {
+        return;
+    }
+
+    // Readers arriving during the replay wait here, and find nothing left.
+    std::lock_guard<std::recursive_mutex> lk(m_pending_mtx);
+    if (m_pending.empty()) {
+        m_has_pending = false;
+        return;
+    }
+
+    // Applying the update goes through the context's own notify path.
+    auto self = const_cast<DERIVED_T*>(static_cast<const DERIVED_T*>(this));
+    if (m_pending.needs_rebuild()) {
+        m_pending.clear();
+        self->rebuild_from_state();
+        m_has_pending = false;
+        return;
+    }
+
+    t_process_tables tables = m_pending.take(*m_state);
+    if (tables.m_flattened->size() > 0) {
+        self->step_begin();
+        self->notify(*tables.m_flattened, *tables.m_delta, *tables.m_prev, *tables.m_current,
+            *tables.m_transitions, *tables.m_existed);
+        self->step_end();
+    }
+    m_has_pending = false;
+}
+
+// Sketches are rebuilt from the state once removals have made them stale.
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::enable_sketch(const std::string& colname, t_uindex nbuckets) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    resume();
+    m_sketches.enable(colname, m_schema.get_dtype(colname), nbuckets);
+    if (m_state && m_state->mapping_size() > 0) {
+        rebuild_sketches();
+    }
+}
+
+template <typename DERIVED_T>
+const t_column_sketch&
+t_ctxbase<DERIVED_T>::get_sketch(const std::string& colname) const {
+    resume();
+    return m_sketches.get_sketch(colname);
+}
+
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::update_sketches(const t_data_table& flattened, const t_data_table& prev,
+    const t_data_table& curr, const t_data_table& existed, const t_mask* msk_prev,
+    const t_mask* msk_curr) {
+    if (m_sketches.empty()) {
+        return;
+    }
+    m_sketches.update(flattened, prev, curr, existed, msk_prev, msk_curr);
+    if (m_sketches.is_stale()) {
+        rebuild_sketches();
+    }
+}
+
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::rebuild_sketches() {
+    auto tbl = m_state->get_pkeyed_table();
+    if (m_config.has_filters()) {
+        t_mask msk = filter_table_for_config(*tbl, m_config);
+        m_sketches.rebuild(*tbl, &msk);
+    } else {
+        m_sketches.rebuild(*tbl, nullptr);
+    }
+}
+
 template <typename DERIVED_T>
 bool
 t_ctxbase<DERIVED_T>::get_feature_state(t_ctx_feature feature) const {
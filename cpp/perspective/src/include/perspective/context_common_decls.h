@@ -36,6 +36,9 @@ void init();
 
 void reset();
 
+// Rebuild from the gnode state, keeping the expansion state
+void rebuild_from_state();
+
 t_index sidedness() const;
 
 bool get_deltas_enabled() const;
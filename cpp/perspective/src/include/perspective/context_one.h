@@ -30,6 +30,9 @@ public:
 
     // ASGGrid data interface
 
+    // Sort rows, deferring subtrees that start at or after viewport_end
+    void sort_by(const std::vector<t_sortspec>& sortby, t_index viewport_end);
+
     t_index open(t_header header, t_index idx);
     t_index open(t_index idx);
     t_index close(t_index idx);
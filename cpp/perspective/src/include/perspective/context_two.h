@@ -17,9 +17,26 @@
 #include <perspective/traversal_nodes.h>
 #include <perspective/traversal.h>
 #include <perspective/data_table.h>
+#include <boost/functional/hash.hpp>
+#include <tsl/hopscotch_map.h>
+#include <mutex>
 
 namespace perspective {
 
+// (row tree node, column tree node) -> node in m_trees[m_treenum] holding the
+// cell's aggregates, or INVALID_INDEX if that combination has no data.
+struct t_ctx2_cell {
+    t_depth m_treenum;
+    t_index m_idx;
+};
+
+typedef tsl::hopscotch_map<std::pair<t_index, t_index>, t_ctx2_cell,
+    boost::hash<std::pair<t_index, t_index>>>
+    t_ctx2_cell_index;
+
+// Node in one of m_trees -> the t_ctx2_cell_index key cached for it
+typedef tsl::hopscotch_map<t_index, std::pair<t_index, t_index>> t_ctx2_cell_keys;
+
 class PERSPECTIVE_EXPORT t_ctx2 : public t_ctxbase<t_ctx2> {
 public:
 #include <perspective/context_common_decls.h>
@@ -48,6 +65,9 @@ public:
 
     void column_sort_by(const std::vector<t_sortspec>& sortby);
 
+    // Sort rows, deferring subtrees that start at or after viewport_end
+    void sort_by(const std::vector<t_sortspec>& sortby, t_index viewport_end);
+
     void set_depth(t_header header, t_depth depth);
 
     using t_ctxbase<t_ctx2>::get_data;
@@ -71,6 +91,13 @@ protected:
 
     t_uindex calc_translated_colidx(t_uindex n_aggs, t_uindex cidx) const;
 
+    t_index resolve_cell_node(t_index r_ptidx, const t_tvnode& r_tvnode, t_index c_ptidx,
+        const t_tvnode& c_tvnode) const;
+
+    void init_aggcols();
+
+    void prune_cell_index();
+
 private:
     std::shared_ptr<t_traversal> m_rtraversal;
     std::shared_ptr<t_traversal> m_ctraversal;
@@ -83,6 +110,12 @@ private:
     bool m_row_depth_set;
     t_depth m_column_depth;
     bool m_column_depth_set;
+    // Filled by const readers under m_cell_index_mtx, pruned by notify
+    mutable t_ctx2_cell_index m_cell_index;
+    mutable std::vector<t_ctx2_cell_keys> m_cell_keys;
+    mutable std::mutex m_cell_index_mtx;
+    // Aggregate columns by treeidx * naggs + aggidx
+    std::vector<const t_column*> m_aggcols;
 };
 
 } // end namespace perspective
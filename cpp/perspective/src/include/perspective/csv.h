@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/schema.h>
+#include <perspective/data_table.h>
+#include <perspective/date_parser.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace perspective {
+
+struct PERSPECTIVE_EXPORT t_csv_options {
+    t_csv_options();
+
+    char m_delimiter;
+    char m_quote;
+
+    // Bytes of input scanned by each task; rows are rebalanced afterwards.
+    t_uindex m_chunk_size;
+};
+
+// Byte range of one field in the source text, excluding enclosing quotes.
+struct t_csv_field {
+    t_uindex m_begin;
+    t_uindex m_end;
+    bool m_escaped;
+};
+
+/**
+ * Parses delimited text into typed columns without going through a binding's
+ * accessor. Row boundaries are found and rows are tokenized in parallel
+ * chunks, column types are inferred over every row with the rules of the JS
+ * binding's `infer_type`, and values are written straight into column
+ * storage. String columns are interned through per-chunk dictionaries, so
+ * each distinct value only touches the shared vocabulary once.
+ *
+ * The first row holds the column names; empty fields are loaded as invalid.
+ */
+class PERSPECTIVE_EXPORT t_csv_reader {
+public:
+    // Keeps `text`; move it in to avoid copying large inputs.
+    t_csv_reader(std::string text, const t_csv_options& options = t_csv_options());
+
+    const t_schema& get_schema() const;
+    t_uindex num_rows() const;
+
+    // Fills `tbl` from row 0; `tbl` must be inited with every reader column.
+    void fill(t_data_table& tbl) const;
+
+    std::shared_ptr<t_data_table> read() const;
+
+private:
+    void find_rows();
+    void infer_schema();
+
+    void split_row(
+        const std::pair<t_uindex, t_uindex>& row, std::vector<t_csv_field>& fields) const;
+    std::string field_str(const t_csv_field& field) const;
+
+    // Row ranges handed to each parallel task.
+    t_uindex num_batches() const;
+    t_uindex batch_begin(t_uindex bidx) const;
+    t_uindex batch_end(t_uindex bidx) const;
+
+    std::string m_text;
+    t_csv_options m_options;
+    t_date_parser m_date_parser;
+
+    // [begin, end) of each data row; the header is kept separately.
+    std::vector<std::pair<t_uindex, t_uindex>> m_rows;
+    std::pair<t_uindex, t_uindex> m_header;
+    t_schema m_schema;
+};
+
+} // end namespace perspective
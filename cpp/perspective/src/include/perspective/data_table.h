@@ -29,6 +29,7 @@ template <typename DATA_T>
 struct t_rowpack {
     DATA_T m_pkey;
     t_index m_idx;
+    t_uindex m_frag;
     t_op m_op;
 };
 
@@ -89,6 +90,11 @@ public:
 
     std::shared_ptr<t_data_table> flatten() const;
 
+    // Flattens this table followed by `rest`, as if they had been appended
+    // to it, without copying them into one table first.
+    std::shared_ptr<t_data_table> flatten(
+        const std::vector<std::shared_ptr<t_data_table>>& rest) const;
+
     bool is_pkey_table() const;
     bool is_same_shape(t_data_table& tbl) const;
 
@@ -103,6 +109,10 @@ public:
     void reset();
 
     t_mask filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fops) const;
+
+    // Only tests `rows`; every other row fails.
+    t_mask filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fops,
+        const std::vector<t_uindex>& rows) const;
     t_data_table* clone_(const t_mask& mask) const;
     std::shared_ptr<t_data_table> clone(const t_mask& mask) const;
     std::shared_ptr<t_data_table> clone() const;
@@ -130,16 +140,22 @@ public:
 
 protected:
     template <typename FLATTENED_T>
-    void flatten_body(FLATTENED_T flattened) const;
+    void flatten_body(
+        FLATTENED_T flattened, const std::vector<const t_data_table*>& frags) const;
 
     template <typename FLATTENED_T, typename PKEY_T>
-    void flatten_helper_1(FLATTENED_T flattened) const;
+    void flatten_helper_1(
+        FLATTENED_T flattened, const std::vector<const t_data_table*>& frags) const;
 
     template <typename DATA_T, typename ROWPACK_VEC_T>
     void flatten_helper_2(ROWPACK_VEC_T& sorted, std::vector<t_flatten_record>& fltrecs,
-        const t_column* scol, t_column* dcol) const;
+        const std::vector<const t_column*>& scols, std::vector<t_vocab_remap>& remaps,
+        t_column* dcol) const;
     std::string repr() const;
 
+    t_mask _filter_cpp(t_filter_op combiner, const std::vector<t_fterm>& fops,
+        const std::vector<t_uindex>* rows) const;
+
 private:
     std::string m_name;
     std::string m_dirname;
@@ -153,52 +169,65 @@ private:
 
 PERSPECTIVE_EXPORT bool operator==(const t_data_table& lhs, const t_data_table& rhs);
 
+// Maps a string id of one fragment to the flattened vocabulary.
+template <typename DATA_T>
+inline DATA_T
+flatten_remap(DATA_T value, t_vocab_remap& remap) {
+    return value;
+}
+
+inline t_uindex
+flatten_remap(t_uindex value, t_vocab_remap& remap) {
+    return remap.translate(value);
+}
+
 template <typename FLATTENED_T>
 void
-t_data_table::flatten_body(FLATTENED_T flattened) const {
+t_data_table::flatten_body(
+    FLATTENED_T flattened, const std::vector<const t_data_table*>& frags) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     PSP_VERBOSE_ASSERT(is_pkey_table(), "Not a pkeyed table");
 
     switch (get_const_column("psp_pkey")->get_dtype()) {
         case DTYPE_INT64: {
-            flatten_helper_1<FLATTENED_T, std::int64_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::int64_t>(flattened, frags);
         } break;
         case DTYPE_INT32: {
-            flatten_helper_1<FLATTENED_T, std::int32_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::int32_t>(flattened, frags);
         } break;
         case DTYPE_INT16: {
-            flatten_helper_1<FLATTENED_T, std::int16_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::int16_t>(flattened, frags);
         } break;
         case DTYPE_INT8: {
-            flatten_helper_1<FLATTENED_T, std::int8_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::int8_t>(flattened, frags);
         } break;
         case DTYPE_UINT64: {
-            flatten_helper_1<FLATTENED_T, std::uint64_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::uint64_t>(flattened, frags);
         } break;
         case DTYPE_UINT32: {
-            flatten_helper_1<FLATTENED_T, std::uint32_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::uint32_t>(flattened, frags);
         } break;
         case DTYPE_UINT16: {
-            flatten_helper_1<FLATTENED_T, std::uint16_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::uint16_t>(flattened, frags);
         } break;
         case DTYPE_UINT8: {
-            flatten_helper_1<FLATTENED_T, std::uint8_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::uint8_t>(flattened, frags);
         } break;
         case DTYPE_TIME: {
-            flatten_helper_1<FLATTENED_T, std::int64_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::int64_t>(flattened, frags);
         } break;
         case DTYPE_DATE: {
-            flatten_helper_1<FLATTENED_T, std::uint32_t>(flattened);
+            flatten_helper_1<FLATTENED_T, std::uint32_t>(flattened, frags);
         } break;
         case DTYPE_STR: {
-            flatten_helper_1<FLATTENED_T, t_uindex>(flattened);
+            flatten_helper_1<FLATTENED_T, t_uindex>(flattened, frags);
         } break;
         case DTYPE_FLOAT64: {
-            flatten_helper_1<FLATTENED_T, double>(flattened);
+            flatten_helper_1<FLATTENED_T, double>(flattened, frags);
         } break;
         case DTYPE_FLOAT32: {
-            flatten_helper_1<FLATTENED_T, float>(flattened);
+            flatten_helper_1<FLATTENED_T, float>(flattened, frags);
         } break;
         default: { PSP_COMPLAIN_AND_ABORT("Unsupported key type"); }
     }
@@ -209,15 +238,18 @@ t_data_table::flatten_body(FLATTENED_T flattened) const {
 template <typename DATA_T, typename ROWPACK_VEC_T>
 void
 t_data_table::flatten_helper_2(ROWPACK_VEC_T& sorted, std::vector<t_flatten_record>& fltrecs,
-    const t_column* scol, t_column* dcol) const {
+    const std::vector<const t_column*>& scols, std::vector<t_vocab_remap>& remaps,
+    t_column* dcol) const {
     for (const auto& rec : fltrecs) {
         bool added = false;
         t_index fragidx = 0;
+        t_uindex frag = 0;
         t_status status = STATUS_INVALID;
         for (t_index spanidx = rec.m_eidx - 1; spanidx >= t_index(rec.m_bidx); --spanidx) {
             const auto& sort_rec = sorted[spanidx];
             fragidx = sort_rec.m_idx;
-            status = *(scol->get_nth_status(fragidx));
+            frag = sort_rec.m_frag;
+            status = *(scols[frag]->get_nth_status(fragidx));
             if (status != STATUS_INVALID) {
                 added = true;
                 break;
@@ -225,51 +257,83 @@ t_data_table::flatten_helper_2(ROWPACK_VEC_T& sorted, std::vector<t_flatten_reco
         }
 
         if (added) {
-            dcol->set_nth<DATA_T>(rec.m_store_idx, *(scol->get_nth<DATA_T>(fragidx)), status);
+            DATA_T value = *(scols[frag]->get_nth<DATA_T>(fragidx));
+            if (!remaps.empty()) {
+                value = flatten_remap(value, remaps[frag]);
+            }
+            dcol->set_nth<DATA_T>(rec.m_store_idx, value, status);
         }
     }
 }
 
 template <typename FLATTENED_T, typename PKEY_T>
 void
-t_data_table::flatten_helper_1(FLATTENED_T flattened) const {
+t_data_table::flatten_helper_1(
+    FLATTENED_T flattened, const std::vector<const t_data_table*>& frags) const {
 
-    t_uindex frags_size = size();
+    t_uindex nfrags = frags.size();
+    t_uindex frags_size = 0;
 
-    PSP_VERBOSE_ASSERT(is_same_shape(*flattened), "Misaligned shaped found");
+    for (auto frag : frags) {
+        PSP_VERBOSE_ASSERT(frag->is_same_shape(*flattened), "Misaligned shaped found");
+        frags_size += frag->size();
+    }
 
     if (frags_size == 0)
         return;
 
-    std::vector<const t_column*> s_columns;
+    std::vector<std::vector<const t_column*>> s_columns;
     std::vector<t_column*> d_columns;
 
     for (const auto& colname : m_schema.m_columns) {
         if (colname != "psp_pkey" && colname != "psp_op") {
-            s_columns.push_back(get_const_column(colname).get());
+            std::vector<const t_column*> scols(nfrags);
+            for (t_uindex frag = 0; frag < nfrags; ++frag) {
+                scols[frag] = frags[frag]->get_const_column(colname).get();
+            }
+            s_columns.push_back(scols);
             d_columns.push_back(flattened->get_column(colname).get());
         }
     }
 
-    const t_column* s_pkey_col = get_const_column("psp_pkey").get();
-    const t_column* s_op_col = get_const_column("psp_op").get();
-
     t_column* d_pkey_col = flattened->get_column("psp_pkey").get();
     t_column* d_op_col = flattened->get_column("psp_op").get();
 
     typedef std::vector<t_rowpack<PKEY_T>> t_rpvec;
 
     std::vector<t_rowpack<PKEY_T>> sorted(frags_size);
-    for (t_uindex fragidx = 0; fragidx < frags_size; ++fragidx) {
-        sorted[fragidx].m_pkey = *(s_pkey_col->get_nth<PKEY_T>(fragidx));
-        sorted[fragidx].m_op = static_cast<t_op>(*(s_op_col->get_nth<std::uint8_t>(fragidx)));
-        sorted[fragidx].m_idx = fragidx;
+    t_uindex sortidx = 0;
+    for (t_uindex frag = 0; frag < nfrags; ++frag) {
+        const t_column* s_pkey_col = frags[frag]->get_const_column("psp_pkey").get();
+        const t_column* s_op_col = frags[frag]->get_const_column("psp_op").get();
+
+        // Fragments have vocabularies of their own, so strings are interned
+        // into the flattened columns as rows are taken from them
+        std::vector<t_vocab_remap> pkey_remap;
+        if (s_pkey_col->get_dtype() == DTYPE_STR) {
+            pkey_remap.push_back(d_pkey_col->remap_vocabulary(*s_pkey_col));
+        }
+
+        for (t_uindex fragidx = 0, loop_end = frags[frag]->size(); fragidx < loop_end;
+             ++fragidx, ++sortidx) {
+            PKEY_T pkey = *(s_pkey_col->get_nth<PKEY_T>(fragidx));
+            if (!pkey_remap.empty()) {
+                pkey = flatten_remap(pkey, pkey_remap[0]);
+            }
+            sorted[sortidx].m_pkey = pkey;
+            sorted[sortidx].m_op
+                = static_cast<t_op>(*(s_op_col->get_nth<std::uint8_t>(fragidx)));
+            sorted[sortidx].m_idx = fragidx;
+            sorted[sortidx].m_frag = frag;
+        }
     }
 
     struct t_packcomp {
         bool
         operator()(const t_rowpack<PKEY_T>& a, const t_rowpack<PKEY_T>& b) const {
-            return a.m_pkey < b.m_pkey || (!(b.m_pkey < a.m_pkey) && a.m_idx < b.m_idx);
+            if (a.m_pkey < b.m_pkey || b.m_pkey < a.m_pkey)
+                return a.m_pkey < b.m_pkey;
+            return a.m_frag < b.m_frag || (a.m_frag == b.m_frag && a.m_idx < b.m_idx);
         }
     };
 
@@ -285,7 +349,7 @@ t_data_table::flatten_helper_1(FLATTENED_T flattened) const {
         }
     }
 
-    flattened->reserve(size());
+    flattened->reserve(frags_size);
 
     std::vector<t_flatten_record> fltrecs;
 
@@ -334,56 +398,77 @@ t_data_table::flatten_helper_1(FLATTENED_T flattened) const {
 
 #ifdef PSP_PARALLEL_FOR
     PSP_PFOR(0, int(ndata_cols), 1,
-        [&s_columns, &sorted, &d_columns, &fltrecs, this](int colidx)
+        [&s_columns, &sorted, &d_columns, &fltrecs, nfrags, this](int colidx)
 #else
     for (t_uindex colidx = 0; colidx < ndata_cols; ++colidx)
 #endif
         {
-            auto scol = s_columns[colidx];
+            const auto& scol = s_columns[colidx];
             auto dcol = d_columns[colidx];
 
-            switch (scol->get_dtype()) {
+            std::vector<t_vocab_remap> remaps;
+            if (dcol->get_dtype() == DTYPE_STR) {
+                for (t_uindex frag = 0; frag < nfrags; ++frag) {
+                    remaps.push_back(dcol->remap_vocabulary(*scol[frag]));
+                }
+            }
+
+            switch (dcol->get_dtype()) {
                 case DTYPE_INT64: {
-                    this->flatten_helper_2<std::int64_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::int64_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_INT32: {
-                    this->flatten_helper_2<std::int32_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::int32_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_INT16: {
-                    this->flatten_helper_2<std::int16_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::int16_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_INT8: {
-                    this->flatten_helper_2<std::int8_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::int8_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_UINT64: {
-                    this->flatten_helper_2<std::uint64_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::uint64_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_UINT32: {
-                    this->flatten_helper_2<std::uint32_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::uint32_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_UINT16: {
-                    this->flatten_helper_2<std::uint16_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::uint16_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_UINT8: {
-                    this->flatten_helper_2<std::uint8_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::uint8_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_FLOAT64: {
-                    this->flatten_helper_2<double, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<double, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_FLOAT32: {
-                    this->flatten_helper_2<float, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<float, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_BOOL: {
-                    this->flatten_helper_2<std::uint8_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::uint8_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_TIME: {
-                    this->flatten_helper_2<std::int64_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::int64_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_DATE: {
-                    this->flatten_helper_2<std::uint32_t, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<std::uint32_t, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 case DTYPE_STR: {
-                    this->flatten_helper_2<t_uindex, t_rpvec>(sorted, fltrecs, scol, dcol);
+                    this->flatten_helper_2<t_uindex, t_rpvec>(
+                        sorted, fltrecs, scol, remaps, dcol);
                 } break;
                 default: { PSP_COMPLAIN_AND_ABORT("Unsupported column dtype"); }
             }
@@ -392,24 +477,6 @@ t_data_table::flatten_helper_1(FLATTENED_T flattened) const {
     );
 #endif
 
-#ifdef PSP_PARALLEL_FOR
-    PSP_PFOR(0, int(m_schema.get_num_columns()),
-        [&flattened, this](int colidx)
-#else
-    for (t_uindex colidx = 0, loop_end = m_schema.get_num_columns(); colidx < loop_end;
-         ++colidx)
-#endif
-        {
-            const auto& colname = this->m_schema.m_columns[colidx];
-            auto col = get_const_column(colname).get();
-            if (col->get_dtype() == DTYPE_STR) {
-                flattened->get_column(colname)->copy_vocabulary(col);
-            }
-        }
-#ifdef PSP_PARALLEL_FOR
-    );
-#endif
-
     d_pkey_col->valid_raw_fill();
     d_op_col->valid_raw_fill();
 }
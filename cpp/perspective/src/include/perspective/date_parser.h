@@ -11,6 +11,7 @@
 #include <memory>
 #include <vector>
 #include <locale>
+#include <ctime>
 #include <perspective/first.h>
 #include <perspective/exports.h>
 
@@ -22,6 +23,9 @@ public:
 
     bool is_valid(std::string const& datestring);
 
+    // Parses `datestring` with the first matching format into `out`.
+    bool parse(std::string const& datestring, std::tm& out) const;
+
 private:
     static const std::string VALID_FORMATS[12];
 };
@@ -29,6 +29,12 @@ const t_fflag PSP_DEFAULT_SHARED_RO_FMODE = FILE_SHARE_READ | FILE_SHARE_WRITE;
 const t_fflag PSP_DEFAULT_SHARED_RO_CREATION_DISPOSITION = OPEN_ALWAYS;
 const t_fflag PSP_DEFAULT_SHARED_RO_MPROT = PAGE_READONLY;
 const t_fflag PSP_DEFAULT_SHARED_RO_MFLAGS = FILE_MAP_READ;
+
+const t_fflag PSP_DEFAULT_SNAPSHOT_FFLAGS = GENERIC_READ;
+const t_fflag PSP_DEFAULT_SNAPSHOT_FMODE = FILE_SHARE_READ;
+const t_fflag PSP_DEFAULT_SNAPSHOT_CREATION_DISPOSITION = OPEN_EXISTING;
+const t_fflag PSP_DEFAULT_SNAPSHOT_MPROT = PAGE_WRITECOPY;
+const t_fflag PSP_DEFAULT_SNAPSHOT_MFLAGS = FILE_MAP_COPY;
 #else
 const t_fflag PSP_DEFAULT_FFLAGS = O_RDWR | O_TRUNC | O_CREAT;
 const t_fflag PSP_DEFAULT_FMODE = S_IRUSR | S_IWUSR | S_IROTH | S_IRGRP | S_IWGRP;
@@ -41,5 +47,11 @@ const t_fflag PSP_DEFAULT_SHARED_RO_FMODE = S_IRUSR;
 const t_fflag PSP_DEFAULT_SHARED_RO_CREATION_DISPOSITION = 0;
 const t_fflag PSP_DEFAULT_SHARED_RO_MPROT = PROT_READ;
 const t_fflag PSP_DEFAULT_SHARED_RO_MFLAGS = MAP_SHARED;
+
+const t_fflag PSP_DEFAULT_SNAPSHOT_FFLAGS = O_RDONLY;
+const t_fflag PSP_DEFAULT_SNAPSHOT_FMODE = S_IRUSR;
+const t_fflag PSP_DEFAULT_SNAPSHOT_CREATION_DISPOSITION = 0;
+const t_fflag PSP_DEFAULT_SNAPSHOT_MPROT = PROT_READ | PROT_WRITE;
+const t_fflag PSP_DEFAULT_SNAPSHOT_MFLAGS = MAP_PRIVATE;
 #endif
 } // end namespace perspective
@@ -10,6 +10,7 @@
 #pragma once
 #include <perspective/first.h>
 #include <perspective/exports.h>
+#include <algorithm>
 #include <cstdlib>
 
 namespace perspective {
@@ -158,6 +159,14 @@ struct PERSPECTIVE_EXPORT t_env {
         static const bool rv = std::getenv("PSP_BACKOUT_EQ_INVALID_INVALID") != 0;
         return rv;
     }
+
+    // Worker threads used by parallel tree updates, 0 leaves the choice to TBB.
+    static inline int
+    max_threads() {
+        static const char* env = std::getenv("PSP_MAX_THREADS");
+        static const int rv = env != 0 ? std::max(std::atoi(env), 0) : 0;
+        return rv;
+    }
 };
 
 } // end namespace perspective
@@ -16,11 +16,14 @@
 #include <perspective/scalar.h>
 #include <perspective/exports.h>
 #include <boost/scoped_ptr.hpp>
+#include <tsl/hopscotch_set.h>
 #include <functional>
 #include <set>
 
 namespace perspective {
 
+class t_column;
+
 // Filter operators
 template <typename DATA_T, template <typename> class OP_T>
 struct t_operator_base {
@@ -163,6 +166,34 @@ struct PERSPECTIVE_EXPORT t_fterm {
     bool m_use_interned;
 };
 
+/**
+ * The bag of an IN or NOT IN term resolved against one column, so that
+ * membership is a hash lookup of the cell as stored: strings by their id in
+ * the column's vocabulary, other types by their bits. Bag values missing
+ * from the vocabulary, or not of the column's type, can never match and are
+ * dropped up front.
+ */
+class PERSPECTIVE_EXPORT t_fterm_bag {
+public:
+    t_fterm_bag(const t_fterm& fterm, const t_column& column);
+
+    bool is_valid(t_uindex idx) const;
+
+    // The term's verdict for the cell at `idx`, which counts as in no bag
+    // unless `valid`.
+    bool operator()(t_uindex idx, bool valid) const;
+
+private:
+    bool contains(t_uindex idx) const;
+
+    const t_column* m_column;
+    const std::uint8_t* m_base;
+    t_uindex m_width;
+    bool m_in;
+    bool m_negated;
+    tsl::hopscotch_set<std::uint64_t> m_keys;
+};
+
 class PERSPECTIVE_EXPORT t_filter {
 public:
     t_filter();
@@ -0,0 +1,55 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/config.h>
+#include <perspective/data_table.h>
+#include <perspective/mask.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace perspective {
+
+class t_gstate;
+
+/**
+ * A context's last filter verdict for every row of its t_gstate, by the
+ * row's index in the master table. An update then only filters the current
+ * values of its rows: the verdict on their previous values is the one
+ * recorded when those values were current.
+ *
+ * Rows deleted by an update have already left the t_gstate, so when an
+ * update deletes anything its previous values are filtered as well.
+ */
+class PERSPECTIVE_EXPORT t_filter_cache {
+public:
+    // Filters `flattened`, whose rows are all in `gstate`, e.g. the whole
+    // table for a new context; the master table is filtered through its
+    // indexes or zone maps where it can be.
+    t_mask filter(
+        const t_config& config, const t_gstate& gstate, const t_data_table& flattened);
+
+    // Returns the (previous, current) verdicts for the rows of an update;
+    // rows that did not exist before it fail the previous one.
+    std::pair<t_mask, t_mask> filter(const t_config& config, const t_gstate& gstate,
+        const t_data_table& flattened, const t_data_table& prev, const t_data_table& current,
+        const t_data_table& existed);
+
+private:
+    bool get(t_uindex ridx) const;
+    void set(t_uindex ridx, bool pass);
+
+    std::vector<std::uint8_t> m_passes;
+};
+
+} // end namespace perspective
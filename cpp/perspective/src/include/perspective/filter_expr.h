@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/data_table.h>
+#include <perspective/mask.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace perspective {
+
+struct t_expr_node;
+struct t_expr_program;
+
+/**
+ * A boolean filter over the columns of a table, e.g.
+ *
+ *     ("bid" + "ask") / 2 > 100 and not ("side" == 'sell' or "qty" is null)
+ *
+ * Columns are double quoted or bare identifiers, strings single quoted. The
+ * operators are `or`, `and`, `not`, the comparisons, `+ - * / %`, unary
+ * minus and `is [not] null`; `&&`, `||` and `!` are accepted as well.
+ *
+ * The expression is parsed once. On first use against a set of column types
+ * it is compiled into a flat program of typed instructions, each of which is
+ * a loop over a block of rows, so rows are never walked through the syntax
+ * tree. Arithmetic is in double precision. Nulls follow SQL: arithmetic on a
+ * null is null, a comparison with a null is unknown, and only rows where the
+ * whole expression is true pass.
+ *
+ * Syntax errors, unknown columns and type errors throw std::invalid_argument.
+ */
+class PERSPECTIVE_EXPORT t_filter_expr {
+public:
+    t_filter_expr(const std::string& expr);
+    ~t_filter_expr();
+
+    const std::string& get_expr() const;
+
+    // Columns read by the expression, in order of first use.
+    const std::vector<std::string>& get_columns() const;
+
+    // Compiles the expression for the column types of `schema`.
+    void validate(const t_schema& schema) const;
+
+    t_mask filter(const t_data_table& tbl) const;
+
+private:
+    std::shared_ptr<const t_expr_program> get_program(const t_schema& schema) const;
+
+    std::string m_expr;
+    std::shared_ptr<const t_expr_node> m_root;
+    std::vector<std::string> m_columns;
+
+    // Tables of one config share their column types, so one program is kept.
+    mutable std::mutex m_program_mtx;
+    mutable std::shared_ptr<const t_expr_program> m_program;
+};
+
+} // end namespace perspective
@@ -22,6 +22,9 @@ filter_table_for_config(const t_data_table& tbl, const t_config& config) {
         case FMODE_SIMPLE_CLAUSES: {
             return tbl.filter_cpp(config.get_combiner(), config.get_fterms());
         } break;
+        case FMODE_JIT_EXPR: {
+            return config.get_filter_expr()->filter(tbl);
+        } break;
         default: {}
     }
 
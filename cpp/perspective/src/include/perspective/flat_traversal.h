@@ -99,6 +99,7 @@ private:
     t_pkeyidx_map m_pkeyidx;
     t_pkmselem_map m_new_elems;
     std::vector<t_sortspec> m_sortby;
+    std::vector<t_sorttype> m_sort_orders;
     std::shared_ptr<std::vector<t_mselem>> m_index;
     t_symtable m_symtable;
 };
@@ -20,6 +20,7 @@
 #include <perspective/rlookup.h>
 #include <perspective/gnode_state.h>
 #include <perspective/sparse_tree.h>
+#include <perspective/sketch.h>
 #ifdef PSP_PARALLEL_FOR
 #include <tbb/parallel_sort.h>
 #include <tbb/tbb.h>
@@ -77,7 +78,17 @@ public:
     // send data to input port with at index idx
     // schema should match port schema
     void _send(t_uindex idx, const t_data_table& fragments);
+    void _send(t_uindex idx, std::shared_ptr<t_data_table> fragments);
     void _send_and_process(const t_data_table& fragments);
+
+    // Stage `fragments` for port `idx` from any thread, concurrently with
+    // other producers and with _process, which moves staged tables into
+    // their ports in the order they were staged. The const overload copies
+    // `fragments` on the calling thread.
+    void stage(t_uindex idx, std::shared_ptr<t_data_table> fragments);
+    void stage(t_uindex idx, const t_data_table& fragments);
+    bool has_staged() const;
+
     void _process();
     void _process_self();
     void _register_context(const std::string& name, t_ctx_type type, std::int64_t ptr);
@@ -133,6 +144,18 @@ public:
 
     t_uindex mapping_size() const;
 
+    // Persists the table state; loading replaces it and rebuilds every
+    // registered context from the loaded rows.
+    void save_snapshot(const std::string& dirname) const;
+    void load_snapshot(const std::string& dirname);
+
+    // Distribution sketches of numeric columns, kept current by each step
+    void enable_sketch(const std::string& colname, t_uindex nbuckets);
+    const t_column_sketch& get_sketch(const std::string& colname) const;
+
+    // Indexes a column, so new views filtering on it skip scanning the table
+    void create_index(const std::string& colname);
+
     // helper function for tests
     std::shared_ptr<t_data_table> tstep(std::shared_ptr<const t_data_table> input_table);
 
@@ -145,6 +168,14 @@ public:
     void register_context(const std::string& name, std::shared_ptr<t_ctx2> ctx);
     void register_context(const std::string& name, std::shared_ptr<t_ctx_grouped_pkey> ctx);
 
+    // Fills the delta, prev, current and transitions of one column for the
+    // rows of `fcolumn`, each looked up in `scolumn` by `lkup`, as a process
+    // does; lazy contexts replay their pending processes through it too.
+    static void process_column(const t_column* fcolumn, const t_column* scolumn,
+        t_column* dcolumn, t_column* pcolumn, t_column* ccolumn, t_column* tcolumn,
+        const std::uint8_t* op_base, std::vector<t_rlookup>& lkup,
+        std::vector<bool>& prev_pkey_eq_vec, std::vector<t_uindex>& added_vec);
+
 protected:
     bool have_context(const std::string& name) const;
     void notify_contexts(const t_data_table& flattened);
@@ -164,19 +195,24 @@ protected:
     void set_ctx_state(void* ptr);
 
     template <typename DATA_T>
-    void _process_helper(const t_column* fcolumn, const t_column* scolumn, t_column* dcolumn,
-        t_column* pcolumn, t_column* ccolumn, t_column* tcolumn, const std::uint8_t* op_base,
-        std::vector<t_rlookup>& lkup, std::vector<bool>& prev_pkey_eq_vec,
-        std::vector<t_uindex>& added_vec);
+    static void _process_helper(const t_column* fcolumn, const t_column* scolumn,
+        t_column* dcolumn, t_column* pcolumn, t_column* ccolumn, t_column* tcolumn,
+        const std::uint8_t* op_base, std::vector<t_rlookup>& lkup,
+        std::vector<bool>& prev_pkey_eq_vec, std::vector<t_uindex>& added_vec);
 
-    t_value_transition calc_transition(bool prev_existed, bool row_pre_existed, bool exists,
-        bool prev_valid, bool cur_valid, bool prev_cur_eq, bool prev_pkey_eq);
+    static t_value_transition calc_transition(bool prev_existed, bool row_pre_existed,
+        bool exists, bool prev_valid, bool cur_valid, bool prev_cur_eq, bool prev_pkey_eq);
 
     void _update_contexts_from_state(const t_data_table& tbl);
     void _update_contexts_from_state();
     void clear_deltas();
 
 private:
+    PSP_NON_COPYABLE(t_gnode);
+
+    // Sends every staged table to its port, oldest first.
+    void send_staged();
+
     void populate_icols_in_flattened(
         const std::vector<t_rlookup>& lkup, std::shared_ptr<t_data_table>& flat) const;
 
@@ -189,6 +225,7 @@ private:
     bool m_init;
     std::vector<std::shared_ptr<t_port>> m_iports;
     std::vector<std::shared_ptr<t_port>> m_oports;
+    t_port_staging m_staged;
     t_sctxhmap m_contexts;
     std::shared_ptr<t_gstate> m_state;
     t_uindex m_id;
@@ -197,6 +234,7 @@ private:
     std::set<std::string> m_expr_icols;
     std::function<void()> m_pool_cleanup;
     bool m_was_updated;
+    t_column_sketches m_sketches;
 };
 
 template <>
@@ -245,6 +283,11 @@ void
 t_gnode::notify_context(CTX_T* ctx, const t_data_table& flattened, const t_data_table& delta,
     const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
     const t_data_table& existed) {
+    if (ctx->get_lazy()) {
+        ctx->defer_notify(flattened, prev, existed);
+        return;
+    }
+
     auto t1 = std::chrono::high_resolution_clock::now();
     ctx->step_begin();
     ctx->notify(flattened, delta, prev, current, transitions, existed);
@@ -277,6 +320,11 @@ t_gnode::update_context_from_state(CTX_T* ctx, const t_data_table& flattened) {
     if (flattened.size() == 0)
         return;
 
+    if (ctx->get_lazy()) {
+        ctx->defer_rebuild();
+        return;
+    }
+
     ctx->step_begin();
     ctx->notify(flattened);
     ctx->step_end();
@@ -12,6 +12,8 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/data_table.h>
+#include <perspective/column_index.h>
+#include <perspective/zone_map.h>
 #include <tsl/hopscotch_map.h>
 #include <tsl/hopscotch_set.h>
 #include <perspective/mask.h>
@@ -20,6 +22,8 @@
 
 namespace perspective {
 
+class t_config;
+
 std::pair<t_tscalar, t_tscalar> get_vec_min_max(const std::vector<t_tscalar>& vec);
 
 class PERSPECTIVE_EXPORT t_gstate {
@@ -39,6 +43,11 @@ public:
     void erase(const t_tscalar& pkey);
 
     void update_history(const t_data_table* tbl);
+
+    // Writes rows `frows` of `tbl` to rows `srows` of the master table,
+    // which must already exist; invalid cells are skipped.
+    void scatter(const t_data_table* tbl, const std::vector<t_uindex>& frows,
+        const std::vector<t_uindex>& srows);
     t_mask get_cpp_mask() const;
 
     t_tscalar get_value(const t_tscalar& pkey, const std::string& colname) const;
@@ -100,9 +109,30 @@ public:
 
     void reset();
 
+    // Writes the table and its erased rows to `dirname`; the pkey mapping is
+    // rebuilt from the pkey column when the snapshot is loaded.
+    void save_snapshot(const std::string& dirname) const;
+    void load_snapshot(const std::string& dirname);
+
     const t_schema& get_port_schema() const;
     std::vector<t_uindex> get_pkeys_idx(const std::vector<t_tscalar>& pkeys) const;
 
+    // Indexes a column of the master table, kept current as rows are written.
+    void create_index(const std::string& colname);
+    bool has_index(const std::string& colname) const;
+
+    // Filters the master table through its indexes; false unless `config`
+    // has simple clauses joined by AND, one of which an index narrows down.
+    bool filter_indexed(const t_config& config, t_mask& mask) const;
+
+    // Filters the master table, scanning only the blocks its zone maps do
+    // not rule out; false unless `config` has simple clauses joined by AND
+    // and some block is skipped.
+    bool filter_zoned(const t_config& config, t_mask& mask) const;
+
+    // Smallest and largest valid value of a column, none if it has none.
+    std::pair<t_tscalar, t_tscalar> get_min_max(const std::string& colname) const;
+
 protected:
     t_dtype get_pkey_dtype() const;
 
@@ -116,6 +146,8 @@ private:
     t_symtable m_symtable;
     std::shared_ptr<t_column> m_pkcol;
     std::shared_ptr<t_column> m_opcol;
+    mutable t_column_indexes m_indexes;
+    mutable t_zone_maps m_zone_maps;
 };
 
 template <typename FN_T>
@@ -12,6 +12,7 @@
 #include <perspective/raw_types.h>
 #include <perspective/scalar.h>
 #include <perspective/exports.h>
+#include <vector>
 
 namespace perspective {
 
@@ -24,12 +25,95 @@ struct PERSPECTIVE_EXPORT t_hist_bucket {
     t_uindex m_count;
 };
 
+/**
+ * Fixed-bucket histogram over a range that widens as values arrive. Bucket
+ * widths are powers of two and the range start is a multiple of the range
+ * length, so widening, removing a value and merging two histograms with the
+ * same bucket count are all exact.
+ */
 struct PERSPECTIVE_EXPORT t_histogram {
 
     t_histogram();
     t_histogram(t_uindex nbuckets);
 
-    std::vector<t_hist_bucket> m_buckets;
+    // A negative weight removes values added earlier.
+    void add(double value, std::int64_t weight = 1);
+    void merge(const t_histogram& other);
+    void clear();
+
+    t_uindex nbuckets() const;
+    std::int64_t count() const;
+
+    // Interpolates linearly within the bucket holding the q-th value.
+    double quantile(double q) const;
+
+    // Non-empty buckets in ascending order.
+    std::vector<t_hist_bucket> get_buckets() const;
+
+private:
+    bool contains(double value) const;
+    void widen();
+
+    t_uindex m_nbuckets;
+    double m_origin;
+    double m_width;
+    std::int64_t m_count;
+    std::vector<std::int64_t> m_counts;
+};
+
+/**
+ * Merging t-digest: values are buffered and folded into centroids whose size
+ * is bounded by the arcsine scale function, giving accurate tails.
+ */
+class PERSPECTIVE_EXPORT t_tdigest {
+public:
+    t_tdigest(double compression = 100);
+
+    void add(double value, double weight = 1);
+    void merge(const t_tdigest& other);
+    void compress();
+    void clear();
+
+    double count() const;
+    double quantile(double q) const;
+
+private:
+    double m_compression;
+    double m_count;
+    double m_min;
+    double m_max;
+
+    // (mean, weight), sorted by mean after compress()
+    std::vector<std::pair<double, double>> m_centroids;
+    std::vector<std::pair<double, double>> m_buffer;
+};
+
+/**
+ * Distribution of one column. A t-digest cannot forget values, so once rows
+ * are updated or removed quantiles come from the histogram until the owner
+ * rebuilds the sketch (see `is_stale`).
+ */
+class PERSPECTIVE_EXPORT t_column_sketch {
+public:
+    t_column_sketch();
+    t_column_sketch(t_uindex nbuckets);
+
+    void add(double value);
+    void remove(double value);
+    void merge(const t_column_sketch& other);
+    void compress();
+
+    std::int64_t count() const;
+    double quantile(double q) const;
+    const t_histogram& get_histogram() const;
+
+    // True once removals make up half the values the digest has seen.
+    bool is_stale() const;
+
+private:
+    t_histogram m_histogram;
+    t_tdigest m_digest;
+    t_uindex m_nremoved;
 };
 
 } // end namespace perspective
@@ -20,6 +20,9 @@ struct PERSPECTIVE_EXPORT t_minmax {
 
     t_minmax();
 
+    // Widen the extents to include value
+    void update(const t_tscalar& value);
+
     t_index m_min_count;
     t_index m_max_count;
     t_tscalar m_min;
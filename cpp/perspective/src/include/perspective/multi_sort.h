@@ -13,10 +13,28 @@
 #include <perspective/scalar.h>
 #include <perspective/exports.h>
 #include <perspective/comparators.h>
+#include <array>
 #include <vector>
 
 namespace perspective {
 
+// Number of leading sort values encoded into a t_sortkey
+const t_uindex PSP_SORTKEY_WIDTH = 4;
+
+// Order-preserving integer encodings of the leading sort values of a
+// t_mselem, with descending orders already inverted. Words of two elements
+// are comparable when their tags match and are nonzero; a zero tag marks a
+// value that was not encoded. An equal pair of words only settles the
+// column if its exact bit is set, e.g. strings longer than the 8 byte
+// prefix are not exact.
+struct PERSPECTIVE_EXPORT t_sortkey {
+    t_sortkey();
+
+    std::array<std::uint64_t, PSP_SORTKEY_WIDTH> m_words;
+    std::array<std::uint8_t, PSP_SORTKEY_WIDTH> m_tags;
+    std::uint8_t m_exact;
+};
+
 struct PERSPECTIVE_EXPORT t_mselem {
     t_mselem();
     t_mselem(const std::vector<t_tscalar>& row);
@@ -28,6 +46,7 @@ struct PERSPECTIVE_EXPORT t_mselem {
     t_mselem& operator=(t_mselem&& other);
 
     std::vector<t_tscalar> m_row;
+    t_sortkey m_key;
     t_tscalar m_pkey;
     t_uindex m_order;
     bool m_deleted;
@@ -80,6 +99,11 @@ struct PERSPECTIVE_EXPORT t_nancmp {
 PERSPECTIVE_EXPORT t_nancmp nan_compare(
     t_sorttype order, const t_tscalar& a, const t_tscalar& b);
 
+// Fill elem.m_key from elem.m_row. Must be called with the same sort order
+// the element is later compared under.
+PERSPECTIVE_EXPORT void encode_sort_key(
+    t_mselem& elem, const std::vector<t_sorttype>& sort_order);
+
 inline PERSPECTIVE_EXPORT bool
 cmp_mselem(const t_mselem& a, const t_mselem& b, const std::vector<t_sorttype>& sort_order) {
     typedef std::pair<double, t_tscalar> dpair;
@@ -89,10 +113,28 @@ cmp_mselem(const t_mselem& a, const t_mselem& b, const std::vector<t_sorttype>&
         return false;
     }
 
+    // Settle as many columns as possible on the encoded keys, then fall back
+    // to comparing scalars from the first column they cannot decide.
+    t_uindex bidx = 0;
+    for (t_uindex loop_end = std::min(PSP_SORTKEY_WIDTH, t_uindex(sort_order.size()));
+         bidx < loop_end; ++bidx) {
+        std::uint8_t tag = a.m_key.m_tags[bidx];
+        if (tag == 0 || tag != b.m_key.m_tags[bidx])
+            break;
+
+        std::uint64_t first = a.m_key.m_words[bidx];
+        std::uint64_t second = b.m_key.m_words[bidx];
+        if (first != second)
+            return first < second;
+
+        if (!(a.m_key.m_exact & b.m_key.m_exact & (1 << bidx)))
+            break;
+    }
+
     t_tscalar first_pkey = a.m_pkey;
     t_tscalar second_pkey = b.m_pkey;
 
-    for (int idx = 0, loop_end = sort_order.size(); idx < loop_end; ++idx) {
+    for (int idx = bidx, loop_end = sort_order.size(); idx < loop_end; ++idx) {
         const t_tscalar& first = a.m_row[idx];
         const t_tscalar& second = b.m_row[idx];
 
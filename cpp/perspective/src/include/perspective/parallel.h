@@ -0,0 +1,41 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/env_vars.h>
+#ifdef PSP_PARALLEL_FOR
+#include <tbb/task_arena.h>
+#endif
+
+namespace perspective {
+
+#ifdef PSP_PARALLEL_FOR
+// Process-wide arena bounding the workers used by PSP_PFOR, sized from
+// PSP_MAX_THREADS.
+inline tbb::task_arena&
+psp_task_arena() {
+    static tbb::task_arena arena(
+        t_env::max_threads() > 0 ? t_env::max_threads() : tbb::task_arena::automatic);
+    return arena;
+}
+#endif
+
+template <typename FUNC_T>
+void
+psp_parallel_execute(FUNC_T&& fn) {
+#ifdef PSP_PARALLEL_FOR
+    psp_task_arena().execute(fn);
+#else
+    fn();
+#endif
+}
+
+} // end namespace perspective
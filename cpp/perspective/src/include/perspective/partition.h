@@ -13,6 +13,9 @@
 #include <perspective/raw_types.h>
 #include <perspective/column.h>
 #include <perspective/node_processor_types.h>
+#include <boost/functional/hash.hpp>
+#include <tsl/hopscotch_map.h>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 
@@ -125,4 +128,82 @@ partition(const t_column* PSP_RESTRICT data_, t_column* PSP_RESTRICT leaves_, t_
     }
 }
 
+// Storage type of a pivot column. Rows are grouped on these raw values,
+// strings on their interned vocab ids.
+template <int DTYPE_T>
+struct t_pivot_rawtype;
+
+#define PSP_PIVOT_RAWTYPE(DTYPE, TYPE)                                                         \
+    template <>                                                                                \
+    struct t_pivot_rawtype<DTYPE> {                                                            \
+        typedef TYPE type;                                                                     \
+    };
+
+PSP_PIVOT_RAWTYPE(DTYPE_STR, t_uindex)
+PSP_PIVOT_RAWTYPE(DTYPE_INT64, std::int64_t)
+PSP_PIVOT_RAWTYPE(DTYPE_INT32, std::int32_t)
+PSP_PIVOT_RAWTYPE(DTYPE_INT16, std::int16_t)
+PSP_PIVOT_RAWTYPE(DTYPE_INT8, std::int8_t)
+PSP_PIVOT_RAWTYPE(DTYPE_UINT64, std::uint64_t)
+PSP_PIVOT_RAWTYPE(DTYPE_UINT32, std::uint32_t)
+PSP_PIVOT_RAWTYPE(DTYPE_UINT16, std::uint16_t)
+PSP_PIVOT_RAWTYPE(DTYPE_UINT8, std::uint8_t)
+PSP_PIVOT_RAWTYPE(DTYPE_FLOAT64, double)
+PSP_PIVOT_RAWTYPE(DTYPE_FLOAT32, float)
+PSP_PIVOT_RAWTYPE(DTYPE_BOOL, bool)
+
+#undef PSP_PIVOT_RAWTYPE
+
+// Distinct values of a range of leaves, numbered in order of first
+// appearance.
+struct t_pivot_groups {
+    // group of each leaf in the range
+    std::vector<t_uindex> m_gids;
+    // number of leaves in each group
+    std::vector<t_uindex> m_counts;
+    // a row holding the value of each group
+    std::vector<t_uindex> m_reps;
+    // value of each group, and group ids in sorted value order
+    std::vector<t_tscalar> m_keys;
+    std::vector<t_uindex> m_order;
+};
+
+template <int DTYPE_T>
+inline void
+hash_group(const t_column* PSP_RESTRICT data_, const t_column* PSP_RESTRICT leaves_,
+    t_uindex bidx, t_uindex eidx, t_pivot_groups& groups) {
+    typedef typename t_pivot_rawtype<DTYPE_T>::type t_raw;
+    typedef std::pair<std::uint64_t, std::uint8_t> t_key;
+
+    const t_uindex* leaves = leaves_->get_nth<t_uindex>(0);
+    const t_raw* base = data_->get_nth<t_raw>(0);
+    bool has_status = data_->is_status_enabled();
+
+    groups.m_gids.resize(eidx - bidx);
+    groups.m_counts.clear();
+    groups.m_reps.clear();
+
+    tsl::hopscotch_map<t_key, t_uindex, boost::hash<t_key>> gidmap;
+
+    for (t_uindex idx = bidx; idx < eidx; ++idx) {
+        t_uindex ridx = leaves[idx];
+        t_key key(0, has_status ? *(data_->get_nth_status(ridx)) : STATUS_VALID);
+        std::memcpy(&key.first, base + ridx, sizeof(t_raw));
+
+        auto iter = gidmap.find(key);
+        t_uindex gid;
+        if (iter == gidmap.end()) {
+            gid = groups.m_counts.size();
+            gidmap.insert(std::make_pair(key, gid));
+            groups.m_counts.push_back(0);
+            groups.m_reps.push_back(ridx);
+        } else {
+            gid = iter->second;
+        }
+
+        groups.m_gids[idx - bidx] = gid;
+        groups.m_counts[gid] += 1;
+    }
+}
+
 } // end namespace perspective
@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/data_table.h>
+#include <perspective/scalar.h>
+#include <perspective/sym_table.h>
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
+#include <memory>
+#include <vector>
+
+namespace perspective {
+
+class t_gstate;
+
+// The tables a gnode process notifies its contexts with.
+struct PERSPECTIVE_EXPORT t_process_tables {
+    std::shared_ptr<t_data_table> m_flattened;
+    std::shared_ptr<t_data_table> m_delta;
+    std::shared_ptr<t_data_table> m_prev;
+    std::shared_ptr<t_data_table> m_current;
+    std::shared_ptr<t_data_table> m_transitions;
+    std::shared_ptr<t_data_table> m_existed;
+};
+
+/**
+ * The processes a lazy context has not been notified of yet. Only the rows
+ * they touched are kept, each with its values from before the first of them,
+ * so that they replay as a single process from those values to the current
+ * ones of the t_gstate. A context notified from the whole state instead, e.g.
+ * on the first load, is rebuilt.
+ */
+class PERSPECTIVE_EXPORT t_pending_notify {
+public:
+    t_pending_notify();
+
+    // Records a process, from its flattened, prev and existed tables.
+    void add(const t_data_table& flattened, const t_data_table& prev,
+        const t_data_table& existed);
+
+    // Rebuilds the context instead, dropping what was recorded.
+    void set_rebuild();
+
+    bool empty() const;
+    bool needs_rebuild() const;
+
+    // Number of distinct rows recorded
+    t_uindex size() const;
+
+    // The recorded processes as one, given the current `gstate`; clears them.
+    t_process_tables take(const t_gstate& gstate);
+
+    void clear();
+
+private:
+    bool m_rebuild;
+    t_schema m_flattened_schema;
+    std::shared_ptr<t_data_table> m_prev;
+    std::vector<t_tscalar> m_pkeys;
+    std::vector<bool> m_existed;
+    tsl::hopscotch_map<t_tscalar, t_uindex> m_rows;
+    tsl::hopscotch_set<t_tscalar> m_deleted;
+    // Owns the string pkeys recorded since the last clear
+    t_symtable m_symtable;
+};
+
+} // end namespace perspective
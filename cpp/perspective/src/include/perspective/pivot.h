@@ -12,6 +12,7 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/raw_types.h>
+#include <perspective/scalar.h>
 #include <perspective/exports.h>
 
 namespace perspective {
@@ -27,12 +28,21 @@ class PERSPECTIVE_EXPORT t_pivot {
 public:
     t_pivot(const t_pivot_recipe& r);
     t_pivot(const std::string& column);
+    // Time bucket pivots are named after their column and bucket, e.g.
+    // "ts (month)", so several can group the same column.
     t_pivot(const std::string& column, t_pivot_mode mode);
 
     const std::string& name() const;
     const std::string& colname() const;
 
     t_pivot_mode mode() const;
+    bool is_time_bucket() const;
+
+    // Start of the minute, hour, day, week (from Monday), month or year in
+    // UTC holding `value`, of the same type. Times are milliseconds since
+    // the epoch and date months count from 0, as the bindings write them.
+    // Other pivots, nones and invalid values return `value`.
+    t_tscalar bucket(const t_tscalar& value) const;
 
     t_pivot_recipe get_recipe() const;
 
@@ -13,6 +13,7 @@
 #include <perspective/gnode.h>
 #include <perspective/exports.h>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
 
 #ifdef PSP_ENABLE_WASM
@@ -57,8 +58,13 @@ public:
 
     void unregister_context(t_uindex gnode_id, const std::string& name);
 
+    // Stage `table` on the gnode; see t_gnode::stage. Producers do not wait
+    // on each other or on processing, only on gnode registration.
     void send(t_uindex gnode_id, t_uindex port_id, const t_data_table& table);
 
+    // As above, handing `table` to the port without copying it.
+    void send(t_uindex gnode_id, t_uindex port_id, std::shared_ptr<t_data_table> table);
+
     void _process();
     void _process_helper();
     void init();
@@ -89,7 +95,13 @@ protected:
     bool validate_gnode_id(t_uindex gnode_id) const;
 
 private:
+    // Serializes processing and context registration
     std::mutex m_mtx;
+
+    // Guards m_gnodes against registration while producers look up gnodes.
+    // Producers hold it shared while staging; unregistering, and a gnode's
+    // destructor, take it exclusively and so wait for them.
+    std::shared_timed_mutex m_gnodes_mtx;
     std::vector<t_gnode*> m_gnodes;
 
 #ifdef PSP_ENABLE_WASM
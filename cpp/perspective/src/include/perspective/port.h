@@ -11,6 +11,9 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/data_table.h>
+#include <atomic>
+#include <utility>
+#include <vector>
 
 namespace perspective {
 
@@ -19,6 +22,35 @@ enum t_port_mode {
     PORT_MODE_PKEYED, // pkeys and op present
 };
 
+/**
+ * Tables staged for the input ports of a gnode by any number of producer
+ * threads. push is lock-free; take detaches everything pushed so far, in
+ * push order, for the single thread that processes the gnode. Not copyable,
+ * as staged tables belong to one gnode.
+ */
+class PERSPECTIVE_EXPORT t_port_staging {
+public:
+    typedef std::pair<t_uindex, std::shared_ptr<t_data_table>> t_staged;
+
+    t_port_staging();
+    t_port_staging(const t_port_staging& other) = delete;
+    ~t_port_staging();
+    t_port_staging& operator=(const t_port_staging& other) = delete;
+
+    void push(t_uindex port_id, std::shared_ptr<t_data_table> tbl);
+    std::vector<t_staged> take();
+    bool empty() const;
+
+private:
+    struct t_node {
+        t_staged m_staged;
+        t_node* m_next;
+    };
+
+    // Newest first
+    std::atomic<t_node*> m_head;
+};
+
 class PERSPECTIVE_EXPORT t_port {
 public:
     t_port(t_port_mode mode, const t_schema& schema);
@@ -31,6 +63,16 @@ public:
     void send(std::shared_ptr<const t_data_table> tbl);
     void send(const t_data_table& tbl);
 
+    // Takes `tbl` without copying it: an empty port adopts it, otherwise it
+    // is queued behind the tables already sent. The sender must not modify
+    // it afterwards. get_table() appends queued tables; flatten() does not.
+    void send(std::shared_ptr<t_data_table> tbl);
+
+    // Rows sent since the port was last released or cleared
+    t_uindex size() const;
+
+    std::shared_ptr<t_data_table> flatten() const;
+
     t_schema get_schema() const;
 
     void release();
@@ -41,6 +83,7 @@ private:
     t_schema m_schema;
     bool m_init;
     std::shared_ptr<t_data_table> m_table;
+    std::vector<std::shared_ptr<t_data_table>> m_queued;
     t_uindex m_prevsize;
 };
 
@@ -0,0 +1,55 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/histogram.h>
+#include <perspective/data_table.h>
+#include <perspective/mask.h>
+#include <map>
+#include <string>
+
+namespace perspective {
+
+/**
+ * Column sketches kept in step with a table. Each gnode step removes the
+ * prior value and adds the current value of every changed row, so answering
+ * a distribution or percentile query never touches the table itself.
+ *
+ * Masks restrict a step to the rows a view's filters select; a null mask
+ * selects every row.
+ */
+class PERSPECTIVE_EXPORT t_column_sketches {
+public:
+    // Only numeric columns can be sketched.
+    void enable(const std::string& colname, t_dtype dtype, t_uindex nbuckets);
+    bool has_sketch(const std::string& colname) const;
+    const t_column_sketch& get_sketch(const std::string& colname) const;
+    bool empty() const;
+
+    // Drops every value, keeping the sketched columns.
+    void clear();
+
+    // Adds the valid values of inserted rows.
+    void add_rows(const t_data_table& tbl, const t_mask* mask);
+
+    void update(const t_data_table& flattened, const t_data_table& prev,
+        const t_data_table& curr, const t_data_table& existed, const t_mask* msk_prev,
+        const t_mask* msk_curr);
+
+    bool is_stale() const;
+    void rebuild(const t_data_table& tbl, const t_mask* mask);
+
+private:
+    std::map<std::string, t_column_sketch> m_sketches;
+};
+
+} // end namespace perspective
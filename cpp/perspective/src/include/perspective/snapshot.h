@@ -0,0 +1,69 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/schema.h>
+#include <perspective/storage.h>
+#include <perspective/data_table.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * A table persisted to a directory: one file per column store (data,
+ * status, and the vlendata and extents of string vocabularies) and a
+ * `manifest` holding the schema, the row count and the size of every store.
+ *
+ * Loading maps each file privately rather than reading it, so a table
+ * reopens without touching its data. Pages are shared with the page cache
+ * until first written, after which the written page belongs to the process;
+ * a store that has to grow moves to memory. Saving writes each file beside
+ * its predecessor and renames it into place, so a directory can be saved
+ * over while tables loaded from it are alive. The directory has no manifest
+ * until every other file is in place.
+ */
+class PERSPECTIVE_EXPORT t_snapshot {
+public:
+    // Reads the manifest of the snapshot in `dirname`. Throws
+    // std::runtime_error if it cannot be opened, and std::invalid_argument
+    // if it or the free_rows file is not from a supported snapshot.
+    t_snapshot(const std::string& dirname);
+
+    // `free_rows` lists rows of `tbl` that hold no data, e.g. the
+    // rows a t_gstate has erased; they are restored by get_free_rows.
+    // Throws std::runtime_error if a file cannot be written.
+    static void save(const t_data_table& tbl, const std::vector<t_uindex>& free_rows,
+        const std::string& dirname);
+
+    const t_schema& get_schema() const;
+    t_uindex num_rows() const;
+    const std::vector<t_uindex>& get_free_rows() const;
+
+    // Replaces every column of `tbl`, which must be inited with get_schema();
+    // throws std::invalid_argument otherwise.
+    void load(t_data_table& tbl) const;
+
+    std::shared_ptr<t_data_table> load() const;
+
+private:
+    t_lstore_recipe get_recipe(t_uindex colidx, const std::string& store, t_uindex size) const;
+
+    std::string m_dirname;
+    t_schema m_schema;
+    t_uindex m_nrows;
+    std::vector<t_column_recipe> m_recipes;
+    std::vector<t_uindex> m_free_rows;
+};
+
+} // end namespace perspective
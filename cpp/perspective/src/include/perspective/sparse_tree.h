@@ -16,7 +16,6 @@ SUPPRESS_WARNINGS_VC(4503)
 #include <perspective/exports.h>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
-#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 #include <perspective/sort_specification.h>
@@ -34,6 +33,7 @@ SUPPRESS_WARNINGS_VC(4503)
 #include <deque>
 #include <sstream>
 #include <queue>
+#include <mutex>
 
 namespace perspective {
 
@@ -48,16 +48,6 @@ using namespace boost::multi_index;
 typedef std::pair<t_depth, t_index> t_dptipair;
 typedef std::vector<t_dptipair> t_dptipairvec;
 
-struct by_idx {};
-
-struct by_depth {};
-
-struct by_pidx {};
-
-struct by_pidx_hash {};
-
-struct by_nstrands {};
-
 struct by_idx_pkey {};
 
 struct by_idx_lfidx {};
@@ -70,23 +60,20 @@ struct t_build_strand_table_common_rval {
     t_schema m_aggschema;
     t_uindex m_npivotlike;
     std::vector<std::string> m_pivot_like_columns;
+
+    // Where each pivot-like strand column is read from and how it is bucketed
+    std::vector<t_pivot> m_pivot_like_sources;
     t_uindex m_pivsize;
 };
 
-typedef multi_index_container<t_stnode,
-    indexed_by<ordered_unique<tag<by_idx>, BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_idx)>,
-        hashed_non_unique<tag<by_depth>,
-            BOOST_MULTI_INDEX_MEMBER(t_stnode, std::uint8_t, m_depth)>,
-        hashed_non_unique<tag<by_nstrands>,
-            BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_nstrands)>,
-        ordered_unique<tag<by_pidx>,
-            composite_key<t_stnode, BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_pidx),
-                BOOST_MULTI_INDEX_MEMBER(t_stnode, t_tscalar, m_sort_value),
-                BOOST_MULTI_INDEX_MEMBER(t_stnode, t_tscalar, m_value)>>,
-        ordered_unique<tag<by_pidx_hash>,
-            composite_key<t_stnode, BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_pidx),
-                BOOST_MULTI_INDEX_MEMBER(t_stnode, t_tscalar, m_value)>>>>
-    t_treenodes;
+// A planned strand table row; the columns are filled from the plan
+// independently of each other.
+struct t_strand_row {
+    t_uindex m_idx;
+    std::int8_t m_count;
+    bool m_from_prev;
+    bool m_use_current;
+};
 
 typedef multi_index_container<t_stpkey,
     indexed_by<ordered_unique<tag<by_idx_pkey>,
@@ -100,14 +87,6 @@ typedef multi_index_container<t_stleaves,
             BOOST_MULTI_INDEX_MEMBER(t_stleaves, t_uindex, m_lfidx)>>>>
     t_idxleaf;
 
-typedef t_treenodes::index<by_idx>::type index_by_idx;
-typedef t_treenodes::index<by_pidx>::type index_by_pidx;
-
-typedef t_treenodes::index<by_idx>::type::iterator iter_by_idx;
-typedef t_treenodes::index<by_pidx>::type::iterator iter_by_pidx;
-typedef t_treenodes::index<by_pidx_hash>::type::iterator iter_by_pidx_hash;
-typedef std::pair<iter_by_pidx, iter_by_pidx> t_by_pidx_ipair;
-
 typedef t_idxpkey::index<by_idx_pkey>::type::iterator iter_by_idx_pkey;
 
 typedef std::pair<iter_by_idx_pkey, iter_by_idx_pkey> t_by_idx_pkey_ipair;
@@ -152,31 +131,23 @@ public:
     t_tscalar get_value(t_index idx) const;
     t_tscalar get_sortby_value(t_index idx) const;
 
-    void build_strand_table_phase_1(t_tscalar pkey, t_op op, t_uindex idx, t_uindex npivots,
-        t_uindex strand_count_idx, t_uindex aggcolsize, bool force_current_row,
-        const std::vector<const t_column*>& piv_pcolcontexts,
-        const std::vector<const t_column*>& piv_tcols,
-        const std::vector<const t_column*>& agg_ccols,
-        const std::vector<const t_column*>& agg_dcols, std::vector<t_column*>& piv_scols,
-        std::vector<t_column*>& agg_acols, t_column* agg_scountspar, t_column* spkey,
-        t_uindex& insert_count, bool& pivots_neq,
-        const std::vector<std::string>& pivot_like) const;
-
-    void build_strand_table_phase_2(t_tscalar pkey, t_uindex idx, t_uindex npivots,
-        t_uindex strand_count_idx, t_uindex aggcolsize,
+    void build_strand_table_phase_1(t_op op, t_uindex idx, t_uindex npivots,
+        bool force_current_row, const std::vector<const t_column*>& piv_tcols,
         const std::vector<const t_column*>& piv_pcols,
-        const std::vector<const t_column*>& agg_pcols, std::vector<t_column*>& piv_scols,
-        std::vector<t_column*>& agg_acols, t_column* agg_scount, t_column* spkey,
-        t_uindex& insert_count, const std::vector<std::string>& pivot_like) const;
+        const std::vector<const t_column*>& piv_ccols, const std::vector<t_pivot>& piv_sources,
+        std::vector<t_strand_row>& rows, bool& pivots_neq) const;
+
+    void build_strand_table_phase_2(t_uindex idx, std::vector<t_strand_row>& rows) const;
 
     std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>> build_strand_table(
         const t_data_table& flattened, const t_data_table& delta, const t_data_table& prev,
         const t_data_table& current, const t_data_table& transitions,
-        const std::vector<t_aggspec>& aggspecs, const t_config& config) const;
+        const std::vector<t_aggspec>& aggspecs, const t_config& config, const t_mask* msk_prev,
+        const t_mask* msk_curr) const;
 
     std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>> build_strand_table(
         const t_data_table& flattened, const std::vector<t_aggspec>& aggspecs,
-        const t_config& config) const;
+        const t_config& config, const t_mask* msk) const;
 
     void update_shape_from_static(const t_dtree_ctx& ctx);
     void update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate);
@@ -213,6 +184,9 @@ public:
 
     void drop_zero_strands();
 
+    // Nodes removed by the last call to drop_zero_strands
+    const std::vector<t_uindex>& get_dropped_nodes() const;
+
     void add_pkey(t_uindex idx, t_tscalar pkey);
     void remove_pkey(t_uindex idx, t_tscalar pkey);
     void add_leaf(t_uindex nidx, t_uindex lfidx);
@@ -246,15 +220,18 @@ public:
 
     void set_deltas_enabled(bool enabled_state);
 
+    // Keeps aggregate extents current through updates; set when the context
+    // is configured. Without it, reading an extent scans the tree.
     void set_minmax_enabled(bool enabled_state);
 
     void set_feature_state(t_ctx_feature feature, bool state);
 
-    template <typename ITER_T>
-    t_minmax get_agg_min_max(ITER_T biter, ITER_T eiter, t_uindex aggidx) const;
     t_minmax get_agg_min_max(t_uindex aggidx, t_depth depth) const;
     std::vector<t_minmax> get_min_max() const;
 
+    // Rescans the tracked extents that lost an extreme, e.g. at step end.
+    void refresh_min_max();
+
     void clear_deltas();
 
     const std::shared_ptr<t_tcdeltas>& get_deltas() const;
@@ -264,13 +241,17 @@ public:
     t_tscalar first_last_helper(
         t_uindex nidx, const t_aggspec& spec, const t_gstate& gstate) const;
 
-    bool node_exists(t_uindex nidx);
+    bool node_exists(t_uindex nidx) const;
+
+    // Nodes whose aggregates or sort values were written by the last
+    // update, excluding the root and any node dropped since.
+    std::vector<t_uindex> get_updated_nodes() const;
 
     t_data_table* get_aggtable();
 
     void clear_aggregates(const std::vector<t_uindex>& indices);
 
-    std::pair<iter_by_idx, bool> insert_node(const t_tnode& node);
+    bool insert_node(const t_tnode& node);
     bool has_deltas() const;
     void set_has_deltas(bool v);
 
@@ -291,8 +272,28 @@ protected:
     t_uindex genidx();
     t_uindex gen_aggidx();
     std::vector<t_uindex> get_children(t_uindex idx) const;
-    void update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_ridx,
-        t_uindex dst_ridx, t_index nstrands, const t_gstate& gstate);
+    void update_agg_table(t_uindex idx, const t_agg_update_info& info,
+        const std::vector<const t_tree_unify_rec*>& records, const t_gstate& gstate,
+        std::vector<t_tcdelta>& deltas, bool& has_delta);
+
+    // Folds a change of one aggregate cell into the tracked extents; a null
+    // `value` means the node was removed.
+    void track_min_max(t_uindex aggidx, t_depth depth, const t_tscalar& prior,
+        const t_tscalar* value);
+    void mark_min_max_dirty();
+    // A negative depth scans every non-root node
+    t_minmax scan_min_max(t_uindex aggidx, t_index depth) const;
+
+    void fill_strand_table(const std::vector<t_strand_row>& rows, const t_column* pkey_col,
+        const std::vector<const t_column*>& piv_pcols,
+        const std::vector<const t_column*>& piv_ccols, const std::vector<t_pivot>& piv_sources,
+        std::vector<t_column*>& piv_scols, const std::vector<const t_column*>& agg_pcols,
+        const std::vector<const t_column*>& agg_ccols,
+        const std::vector<const t_column*>& agg_dcols, std::vector<t_column*>& agg_acols,
+        t_uindex strand_count_idx, t_column* spkey) const;
+
+    t_tscalar intern_tscalar(const t_tscalar& s);
+    t_tscalar intern_tscalar(const char* s);
 
     bool is_leaf(t_uindex nidx) const;
 
@@ -305,7 +306,7 @@ protected:
 private:
     std::vector<t_pivot> m_pivots;
     bool m_init;
-    std::shared_ptr<t_treenodes> m_nodes;
+    std::shared_ptr<t_stnode_store> m_nodes;
     std::shared_ptr<t_idxpkey> m_idxpkey;
     std::shared_ptr<t_idxleaf> m_idxleaf;
     t_uindex m_curidx;
@@ -319,40 +320,21 @@ private:
     t_sidxmap m_smap;
     std::vector<const t_column*> m_aggcols;
     std::shared_ptr<t_tcdeltas> m_deltas;
+
+    // Extents are only tracked when enabled; dirty ones lost an extreme and
+    // are rescanned by refresh_min_max, readers scanning until then.
+    bool m_minmax_tracked;
     std::vector<t_minmax> m_minmax;
+    std::vector<std::uint8_t> m_minmax_dirty;
+    std::vector<std::vector<t_minmax>> m_depth_minmax;
+    std::vector<std::vector<std::uint8_t>> m_depth_minmax_dirty;
     t_tree_unify_rec_vec m_tree_unification_records;
+    std::vector<t_uindex> m_dropped_nodes;
     std::vector<bool> m_features;
     t_symtable m_symtable;
+    std::mutex m_symtable_mutex;
     bool m_has_delta;
     std::string m_grand_agg_str;
 };
 
-template <typename ITER_T>
-t_minmax
-t_stree::get_agg_min_max(ITER_T biter, ITER_T eiter, t_uindex aggidx) const {
-    auto aggcols = m_aggregates->get_const_columns();
-    auto col = aggcols[aggidx];
-    t_minmax minmax;
-
-    for (auto iter = biter; iter != eiter; ++iter) {
-        if (iter->m_idx == 0)
-            continue;
-        t_uindex aggidx = iter->m_aggidx;
-        t_tscalar v = col->get_scalar(aggidx);
-
-        if (minmax.m_min.is_none()) {
-            minmax.m_min = v;
-        } else {
-            minmax.m_min = std::min(v, minmax.m_min);
-        }
-
-        if (minmax.m_max.is_none()) {
-            minmax.m_max = v;
-        } else {
-            minmax.m_max = std::max(v, minmax.m_max);
-        }
-    }
-    return minmax;
-}
-
 } // end namespace perspective
@@ -11,6 +11,9 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/scalar.h>
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
+#include <vector>
 
 namespace perspective {
 struct PERSPECTIVE_EXPORT t_stnode {
@@ -33,6 +36,86 @@ struct PERSPECTIVE_EXPORT t_stnode {
 
 typedef std::vector<t_stnode> t_stnode_vec;
 
+struct PERSPECTIVE_EXPORT t_stnode_key {
+    t_stnode_key(t_uindex pidx, const t_tscalar& value);
+
+    bool operator==(const t_stnode_key& rhs) const;
+
+    t_uindex m_pidx;
+    t_tscalar m_value;
+};
+
+struct PERSPECTIVE_EXPORT t_stnode_key_hash {
+    size_t operator()(const t_stnode_key& key) const;
+};
+
+// Flat node table for t_stree. Node fields are stored as parallel
+// arrays indexed by node idx, every parent owns a vector of its
+// children ordered by (sort_value, value), and (pidx, value) resolves
+// to a child through a single hash map.
+class PERSPECTIVE_EXPORT t_stnode_store {
+public:
+    typedef tsl::hopscotch_map<t_stnode_key, t_uindex, t_stnode_key_hash> t_child_map;
+
+    t_stnode_store();
+
+    bool insert(const t_stnode& node);
+    void erase(t_uindex idx);
+    void clear();
+
+    // Number of live nodes
+    t_uindex size() const;
+
+    // One past the largest idx ever stored, live or not
+    t_uindex capacity() const;
+
+    bool contains(t_uindex idx) const;
+
+    t_stnode get(t_uindex idx) const;
+
+    t_uindex get_pidx(t_uindex idx) const;
+    std::uint8_t get_depth(t_uindex idx) const;
+    const t_tscalar& get_value(t_uindex idx) const;
+    const t_tscalar& get_sort_value(t_uindex idx) const;
+    t_uindex get_nstrands(t_uindex idx) const;
+    t_uindex get_aggidx(t_uindex idx) const;
+
+    void set_nstrands(t_uindex idx, t_uindex nstrands);
+    void set_sort_value(t_uindex idx, const t_tscalar& sort_value);
+
+    // Children of idx in (sort_value, value) order
+    const std::vector<t_uindex>& get_children(t_uindex idx) const;
+    t_uindex get_num_children(t_uindex idx) const;
+
+    // Position of cidx amongst the children of pidx
+    t_uindex get_child_position(t_uindex pidx, t_uindex cidx) const;
+
+    // Returns INVALID_INDEX if pidx has no child with value
+    t_index find_child(t_uindex pidx, const t_tscalar& value) const;
+
+    // Live nodes with zero strands, in idx order
+    std::vector<t_uindex> get_zero_strands() const;
+
+private:
+    bool child_less(t_uindex a, t_uindex b) const;
+    void link_child(t_uindex idx);
+    void unlink_child(t_uindex idx);
+    void reserve_idx(t_uindex idx);
+    void update_zero_strands(t_uindex idx);
+
+    std::vector<t_uindex> m_pidx;
+    std::vector<std::uint8_t> m_depth;
+    std::vector<t_tscalar> m_value;
+    std::vector<t_tscalar> m_sort_value;
+    std::vector<t_uindex> m_nstrands;
+    std::vector<t_uindex> m_aggidx;
+    std::vector<bool> m_live;
+    std::vector<std::vector<t_uindex>> m_children;
+    t_child_map m_child_map;
+    tsl::hopscotch_set<t_uindex> m_zero_strands;
+    t_uindex m_size;
+};
+
 struct PERSPECTIVE_EXPORT t_stpkey {
     t_stpkey(t_uindex idx, t_tscalar pkey);
     t_stpkey();
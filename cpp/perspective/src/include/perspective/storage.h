@@ -208,8 +208,16 @@ public:
         return size() == 0;
     }
 
+    // True for stores mapping a snapshot privately: pages are shared with
+    // the file until first written, and growing moves the store to memory.
+    bool is_copy_on_write() const;
+
 #ifdef PSP_ENABLE_PYTHON
     /* Python bits */
+    // Read-only array aliasing the store. The array shares ownership of the
+    // buffer, so it outlives the store. The store is copy-on-write from then
+    // on: the first write or reallocation moves it to a new buffer and bumps
+    // get_version(), and the array keeps the values it was handed.
     np::ndarray _as_numpy(t_dtype dtype);
 #endif
 
@@ -220,6 +228,11 @@ protected:
 
 private:
     void reserve_impl(t_uindex capacity, bool allow_shrink);
+
+    // Moves the store off a buffer exported to numpy, so that arrays already
+    // handed out never see a later write; every mutable access calls it.
+    void unshare();
+    void detach_mapping(t_uindex capacity);
     t_handle create_file();
     void* create_mapping();
     void resize_mapping(t_uindex cap_new);
@@ -242,6 +255,8 @@ private:
     t_backing_store m_backing_store;
     bool m_init;
     double m_resize_factor;
+    // Owns m_base once it has been exported to numpy
+    std::shared_ptr<void> m_exported_base;
     t_uindex m_version;
     bool m_from_recipe;
 
@@ -251,7 +266,7 @@ private:
     // page_size. this invariant is checked in
     // the constructor if
     // mprotect is enabled
-    char m_padding[3820];
+    char m_padding[3804];
 #endif
 };
 
@@ -279,6 +294,8 @@ struct t_unlock_store {
 template <typename T>
 void
 t_lstore::push_back(T value) {
+    if (m_exported_base)
+        unshare();
     if (m_size + sizeof(T) >= m_capacity)
         reserve(static_cast<t_uindex>(std::ceil(
             m_capacity + m_size + sizeof(T)))); // reserve will multiply by m_resize_factor
@@ -298,6 +315,8 @@ template <typename T>
 T*
 t_lstore::get(t_uindex idx) {
     STORAGE_CHECK_ACCESS_GET(idx);
+    if (m_exported_base)
+        unshare();
     T* ptr = reinterpret_cast<T*>(static_cast<unsigned char*>(m_base) + idx);
     return ptr;
 }
@@ -314,6 +333,8 @@ template <typename T>
 T*
 t_lstore::get_nth(t_uindex idx) {
     STORAGE_CHECK_ACCESS_GET(idx);
+    if (m_exported_base)
+        unshare();
     return static_cast<T*>(m_base) + idx;
 }
 
@@ -328,6 +349,8 @@ template <typename T>
 void
 t_lstore::set_nth(t_uindex idx, T v) {
     STORAGE_CHECK_ACCESS(idx);
+    if (m_exported_base)
+        unshare();
     T* tgt = static_cast<T*>(m_base) + idx;
     *tgt = v;
 }
@@ -338,6 +361,8 @@ t_lstore::extend(t_uindex idx) {
     t_uindex osize = m_size;
     t_uindex nsize = m_size + idx * sizeof(T);
     reserve(nsize);
+    if (m_exported_base)
+        unshare();
     {
         t_unlock_store tmp(this);
         m_size = nsize;
@@ -356,6 +381,8 @@ t_lstore::extend() {
 template <typename DATA_T>
 void
 t_lstore::raw_fill(DATA_T v) {
+    if (m_exported_base)
+        unshare();
     auto biter = static_cast<DATA_T*>(m_base);
     auto eiter = reinterpret_cast<DATA_T*>(static_cast<char*>(m_base) + size());
     std::fill(biter, eiter, v);
@@ -27,6 +27,9 @@ public:
     t_tscalar get_interned_tscalar(const t_tscalar& s);
     t_uindex size() const;
 
+    // Frees every interned string; scalars returned so far are invalidated.
+    void clear();
+
 private:
     t_mapping m_mapping;
 };
@@ -46,13 +46,14 @@ public:
 
     /**
      * @brief Register the given `t_data_table` with the underlying pool and gnode, thus
-     * allowing operations on it.
+     * allowing operations on it. The table is handed to the gnode's input port
+     * without being copied, and must not be modified afterwards.
      *
      * @param data_table
      * @param row_count
      * @param op
      */
-    void init(t_data_table& data_table, std::uint32_t row_count, const t_op op);
+    void init(std::shared_ptr<t_data_table> data_table, std::uint32_t row_count, const t_op op);
 
     /**
      * @brief The size of the underlying `t_data_table`, i.e. a row count
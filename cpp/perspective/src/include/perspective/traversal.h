@@ -19,9 +19,15 @@
 #include <perspective/sparse_tree_node.h>
 #include <perspective/sparse_tree.h>
 #include <perspective/arg_sort.h>
+#include <perspective/parallel.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <queue>
+#include <unordered_set>
 
 SUPPRESS_WARNINGS_VC(4503)
 
@@ -72,9 +78,26 @@ public:
 
     void get_leaves(std::vector<t_index>& out_data) const;
 
+    // If viewport_end is valid, only subtrees that start above it are sorted
+    // immediately; the rest are finished on first access or by complete_sort.
+    // This only applies when `src` is the traversal's own tree and there is
+    // no `ctx2`, whose column state the sort could otherwise outlive. Const
+    // accessors may finish the sort; they are safe to call concurrently.
     template <typename SRC_T>
     void sort_by(const t_config& config, const std::vector<t_sortspec>& sortby,
-        const SRC_T& src, t_ctx2* ctx2 = nullptr);
+        const SRC_T& src, t_ctx2* ctx2 = nullptr, t_index viewport_end = INVALID_INDEX);
+
+    void complete_sort();
+
+    // Restores the order of every sibling set with a child in `updated`,
+    // leaving all other sets as they are. Children that did not change are
+    // still in order, so the changed ones are merged back in by binary
+    // search; the result is the same as a full sort_by.
+    template <typename SRC_T>
+    void resort_nodes(const std::vector<t_sortspec>& sortby, const SRC_T& src,
+        const std::vector<t_uindex>& updated);
+
+    bool has_pending_sort() const;
 
     void get_child_indices(
         t_index nidx, std::vector<std::pair<t_index, t_index>>& out_data) const;
@@ -109,111 +132,268 @@ public:
     void populate_root_children(std::shared_ptr<const t_stree> tree);
 
 private:
+    template <typename SRC_T>
+    void sort_children(t_index h_otvidx, const std::vector<t_sortspec>& sortby,
+        const std::vector<t_index>& sortby_agg_indices, const SRC_T& src, t_ctx2* ctx2,
+        std::vector<t_index>& out_children) const;
+
+    // Writes through m_nodes, below root_tvidx only.
+    template <typename SRC_T>
+    void sort_subtree(t_index root_tvidx, const std::vector<t_sortspec>& sortby,
+        const SRC_T& src, t_ctx2* ctx2, t_index viewport_end,
+        std::vector<t_index>& deferred) const;
+
+    template <typename SRC_T>
+    void merge_children(t_index h_tvidx, const std::vector<t_sortspec>& sortby,
+        const std::vector<t_index>& sortby_agg_indices, const SRC_T& src,
+        const std::unordered_set<t_index>& changed, std::vector<t_index>& out_children) const;
+
+    // Moves the subtrees of h_tvidx's children into the order of `children`.
+    void reorder_children(t_index h_tvidx, const std::vector<t_index>& children);
+
+    void ensure_sorted(t_index eidx) const;
+
+    void clear_pending_sort();
+
     std::shared_ptr<const t_stree> m_tree;
     std::shared_ptr<std::vector<t_tvnode>> m_nodes;
+
+    // Subtree roots left in their previous order by a viewport-first sort, to
+    // be sorted from m_tree by m_pending_sortby. Nodes below m_sorted_extent
+    // are final, so readers only take m_sort_mtx to go past it.
+    mutable std::mutex m_sort_mtx;
+    mutable std::vector<t_index> m_pending_heads;
+    mutable std::vector<t_sortspec> m_pending_sortby;
+    mutable std::atomic<t_index> m_sorted_extent;
 };
 
 template <typename SRC_T>
 void
 t_traversal::sort_by(const t_config& config, const std::vector<t_sortspec>& sortby,
-    const SRC_T& src, t_ctx2* ctx2) {
-    std::vector<t_tvnode> new_nodes(m_nodes->size());
+    const SRC_T& src, t_ctx2* ctx2, t_index viewport_end) {
+    clear_pending_sort();
 
-    // Pair is -> (old tvidx, new tvidx)
-    std::vector<std::pair<t_index, t_index>> queue;
+    if (ctx2 || static_cast<const void*>(&src) != m_tree.get()) {
+        viewport_end = INVALID_INDEX;
+    }
 
-    // Add root to queue
-    new_nodes[0] = (*m_nodes)[0];
-    queue.emplace_back(std::pair<t_index, t_index>(0, 0));
+    std::vector<t_index> deferred;
+    sort_subtree(0, sortby, src, ctx2, viewport_end, deferred);
 
-    std::vector<t_index> sortby_agg_indices(sortby.size());
+    if (!deferred.empty()) {
+        std::lock_guard<std::mutex> lk(m_sort_mtx);
+        m_pending_heads = deferred;
+        m_pending_sortby = sortby;
+        m_sorted_extent = *std::min_element(deferred.begin(), deferred.end()) + 1;
+    }
+}
 
-    t_uindex scount = 0;
+// Writes the traversal indices of h_otvidx's children to out_children in
+// sorted order.
+template <typename SRC_T>
+void
+t_traversal::sort_children(t_index h_otvidx, const std::vector<t_sortspec>& sortby,
+    const std::vector<t_index>& sortby_agg_indices, const SRC_T& src, t_ctx2* ctx2,
+    std::vector<t_index>& out_children) const {
+    std::vector<std::pair<t_index, t_index>> h_children;
+    get_child_indices(h_otvidx, h_children);
+
+    auto n_changed = h_children.size();
+    std::vector<t_index> sorted_idx(n_changed);
+    auto sortelems = std::make_shared<std::vector<t_mselem>>(size_t(n_changed));
+    std::vector<t_tscalar> aggregates(sortby.size());
+    std::vector<t_sorttype> sort_orders = get_sort_orders(sortby);
+
+    for (t_uindex i = 0, loop_end = n_changed; i < loop_end; i++) {
+        src.get_aggregates_for_sorting(
+            h_children[i].second, sortby_agg_indices, aggregates, ctx2);
+        (*sortelems)[i] = t_mselem(aggregates, static_cast<t_uindex>(i));
+        encode_sort_key((*sortelems)[i], sort_orders);
+    }
+
+    t_multisorter sorter(sortelems, sort_orders);
+    argsort(sorted_idx, sorter);
+
+    out_children.resize(n_changed);
+    for (t_uindex i = 0, loop_end = n_changed; i < loop_end; i++) {
+        out_children[i] = h_children[sorted_idx[i]].first;
+    }
+}
+
+template <typename SRC_T>
+void
+t_traversal::resort_nodes(const std::vector<t_sortspec>& sortby, const SRC_T& src,
+    const std::vector<t_uindex>& updated) {
+    complete_sort();
+    if (updated.empty()) {
+        return;
+    }
+
+    std::unordered_set<t_index> changed(updated.begin(), updated.end());
+    const std::vector<t_tvnode>& nodes = *m_nodes;
+
+    // Reordering a sibling set only moves nodes below its parent, so heads
+    // are visited last to first to keep the remaining indices valid.
+    std::vector<t_index> heads;
+    for (t_index tvidx = 1, loop_end = nodes.size(); tvidx < loop_end; ++tvidx) {
+        if (changed.count(nodes[tvidx].m_tnid) != 0) {
+            heads.push_back(tvidx - nodes[tvidx].m_rel_pidx);
+        }
+    }
+
+    std::sort(heads.begin(), heads.end(), std::greater<t_index>());
+    heads.erase(std::unique(heads.begin(), heads.end()), heads.end());
+
+    std::vector<t_index> sortby_agg_indices;
+    sortby_agg_indices.reserve(sortby.size());
     for (const auto& s : sortby) {
-        sortby_agg_indices[scount] = s.m_agg_index;
-        ++scount;
+        sortby_agg_indices.push_back(s.m_agg_index);
     }
 
-    // while queue is not empty
-    while (!queue.empty()) {
-        // get head
-        const std::pair<t_index, t_index> head_info = queue.back();
-        queue.pop_back();
+    std::vector<t_index> children;
+    for (t_index h_tvidx : heads) {
+        merge_children(h_tvidx, sortby, sortby_agg_indices, src, changed, children);
+        reorder_children(h_tvidx, children);
+    }
+}
 
-        // Heads idx in current traversal
-        t_index h_ctvidx = head_info.first;
+// Writes the traversal indices of h_tvidx's children to out_children in
+// sorted order, given that only the children in `changed` may be out of
+// place. Ties are broken on the current position, as in sort_children.
+template <typename SRC_T>
+void
+t_traversal::merge_children(t_index h_tvidx, const std::vector<t_sortspec>& sortby,
+    const std::vector<t_index>& sortby_agg_indices, const SRC_T& src,
+    const std::unordered_set<t_index>& changed, std::vector<t_index>& out_children) const {
+    std::vector<std::pair<t_index, t_index>> h_children;
+    get_child_indices(h_tvidx, h_children);
+
+    std::vector<t_sorttype> sort_orders = get_sort_orders(sortby);
+    std::vector<t_tscalar> aggregates(sortby.size());
+    t_multisorter sorter(sort_orders);
+
+    auto get_elem = [&](t_uindex cidx) {
+        src.get_aggregates_for_sorting(
+            h_children[cidx].second, sortby_agg_indices, aggregates, nullptr);
+        t_mselem elem(aggregates, cidx);
+        encode_sort_key(elem, sort_orders);
+        return elem;
+    };
+
+    // Keys are built once per child, not on every probe of the merge
+    std::vector<t_mselem> kept;
+    std::vector<t_mselem> moved;
+    for (t_uindex cidx = 0, loop_end = h_children.size(); cidx < loop_end; ++cidx) {
+        if (changed.count(h_children[cidx].second) != 0) {
+            moved.push_back(get_elem(cidx));
+        } else {
+            kept.push_back(get_elem(cidx));
+        }
+    }
 
-        // Heads idx in new traversal
-        t_index h_ntvidx = head_info.second;
+    std::sort(moved.begin(), moved.end(), sorter);
 
-        const t_tvnode& head = (*m_nodes)[h_ctvidx];
+    out_children.clear();
+    out_children.reserve(h_children.size());
 
-        std::vector<std::pair<t_index, t_index>> h_children;
-        get_child_indices(h_ctvidx, h_children);
+    auto kept_it = kept.begin();
+    for (const auto& elem : moved) {
+        auto next_it = std::partition_point(kept_it, kept.end(),
+            [&](const t_mselem& kept_elem) { return !sorter(elem, kept_elem); });
 
-        if (!h_children.empty()) {
-            // Get sorted indices
-            auto n_changed = h_children.size();
-            std::vector<t_index> sorted_idx(n_changed);
-            std::vector<t_index> children_ptidx(n_changed);
-            auto sortelems = std::make_shared<std::vector<t_mselem>>(size_t(n_changed));
-            auto num_aggs = sortby.size();
-            std::vector<t_tscalar> aggregates(num_aggs);
+        for (; kept_it != next_it; ++kept_it) {
+            out_children.push_back(h_children[kept_it->m_order].first);
+        }
 
-            for (t_uindex i = 0, loop_end = n_changed; i < loop_end; i++) {
-                children_ptidx[i] = h_children[i].second;
+        out_children.push_back(h_children[elem.m_order].first);
+    }
 
-                src.get_aggregates_for_sorting(
-                    children_ptidx[i], sortby_agg_indices, aggregates, ctx2);
+    for (; kept_it != kept.end(); ++kept_it) {
+        out_children.push_back(h_children[kept_it->m_order].first);
+    }
+}
 
-                (*sortelems)[i] = t_mselem(aggregates, static_cast<t_uindex>(i));
-            }
+// Sorts the subtree rooted at root_tvidx in place. Each level's sibling sets
+// are sorted in parallel, and the new positions of the children follow from
+// prefix sums over their subtree sizes. Subtrees that would start at or below
+// viewport_end are copied unsorted and reported in deferred.
+template <typename SRC_T>
+void
+t_traversal::sort_subtree(t_index root_tvidx, const std::vector<t_sortspec>& sortby,
+    const SRC_T& src, t_ctx2* ctx2, t_index viewport_end,
+    std::vector<t_index>& deferred) const {
+    const std::vector<t_tvnode>& nodes = *m_nodes;
+    const t_tvnode& root = nodes[root_tvidx];
 
-            std::vector<t_sorttype> sort_orders = get_sort_orders(sortby);
-            t_multisorter sorter(sortelems, sort_orders);
-            argsort(sorted_idx, sorter);
-
-            std::int32_t nchild = n_changed;
-            t_index ndesc = head.m_ndesc;
-
-            // Fast path - if none of heads children are
-            // expanded
-            if (ndesc == nchild) {
-                // Set contiguous block in traversal for
-                // children
-                auto bidx = h_ntvidx + 1;
-                auto eidx = bidx + nchild;
-
-                for (t_index idx = bidx; idx < eidx; idx++) {
-                    t_index cidx = sorted_idx[idx - bidx];
-                    t_index c_otvidx = h_children[cidx].first;
-                    new_nodes[idx] = (*m_nodes)[c_otvidx];
-                    new_nodes[idx].m_rel_pidx = idx - bidx + 1;
-                }
-            } else {
-                t_index c_ntvidx = h_ntvidx + 1;
+    // Indices into new_nodes are relative to root_tvidx
+    std::vector<t_tvnode> new_nodes(root.m_ndesc + 1);
+    new_nodes[0] = root;
+
+    std::vector<t_index> sortby_agg_indices(sortby.size());
 
-                for (t_uindex idx = 0, loop_end = h_children.size(); idx < loop_end; idx++) {
-                    // For each child of head
-                    t_index cidx = sorted_idx[idx];
-                    t_index c_otvidx = h_children[cidx].first;
+    t_uindex scount = 0;
+    for (const auto& s : sortby) {
+        sortby_agg_indices[scount] = s.m_agg_index;
+        ++scount;
+    }
 
-                    const t_tvnode& child = (*m_nodes)[c_otvidx];
+    // Pair is -> (old tvidx, new tvidx)
+    std::vector<std::pair<t_index, t_index>> heads;
+    if (root.m_nchild > 0) {
+        heads.emplace_back(std::pair<t_index, t_index>(root_tvidx, 0));
+    }
 
-                    // Enqueue child if it is expanded
-                    if (child.m_expanded) {
-                        queue.emplace_back(std::pair<t_index, t_index>(c_otvidx, c_ntvidx));
+    while (!heads.empty()) {
+        std::vector<std::vector<t_index>> sorted_children(heads.size());
+
+        psp_parallel_execute([&]() {
+#ifdef PSP_PARALLEL_FOR
+            PSP_PFOR(0, int(heads.size()), 1,
+                [&](int hidx)
+#else
+            for (t_uindex hidx = 0, loop_end = heads.size(); hidx < loop_end; ++hidx)
+#endif
+                {
+                    sort_children(heads[hidx].first, sortby, sortby_agg_indices, src, ctx2,
+                        sorted_children[hidx]);
+                }
+#ifdef PSP_PARALLEL_FOR
+            );
+#endif
+        });
+
+        std::vector<std::pair<t_index, t_index>> next_heads;
+
+        for (t_uindex hidx = 0, loop_end = heads.size(); hidx < loop_end; ++hidx) {
+            t_index h_ntvidx = heads[hidx].second;
+            t_index c_ntvidx = h_ntvidx + 1;
+
+            for (t_index c_otvidx : sorted_children[hidx]) {
+                const t_tvnode& child = nodes[c_otvidx];
+
+                if (child.m_nchild > 0) {
+                    if (viewport_end >= 0 && root_tvidx + c_ntvidx >= viewport_end) {
+                        std::copy(nodes.begin() + c_otvidx,
+                            nodes.begin() + c_otvidx + child.m_ndesc + 1,
+                            new_nodes.begin() + c_ntvidx);
+                        deferred.push_back(root_tvidx + c_ntvidx);
+                    } else {
+                        next_heads.emplace_back(
+                            std::pair<t_index, t_index>(c_otvidx, c_ntvidx));
                     }
-
-                    new_nodes[c_ntvidx] = (*m_nodes)[c_otvidx];
-                    new_nodes[c_ntvidx].m_rel_pidx = c_ntvidx - h_ntvidx;
-                    c_ntvidx = c_ntvidx + child.m_ndesc + 1;
                 }
+
+                new_nodes[c_ntvidx] = child;
+                new_nodes[c_ntvidx].m_rel_pidx = c_ntvidx - h_ntvidx;
+                c_ntvidx = c_ntvidx + child.m_ndesc + 1;
             }
         }
+
+        std::swap(heads, next_heads);
     }
 
-    std::swap(*m_nodes, new_nodes);
+    // The root keeps its place, and may be read concurrently by ensure_sorted
+    std::copy(new_nodes.begin() + 1, new_nodes.end(), m_nodes->begin() + root_tvidx + 1);
 }
 
 } // end namespace perspective
@@ -30,14 +30,14 @@ PERSPECTIVE_EXPORT void notify_sparse_tree(std::shared_ptr<t_stree> tree,
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
     const t_data_table& delta, const t_data_table& prev, const t_data_table& current,
     const t_data_table& transitions, const t_data_table& existed, const t_config& config,
-    const t_gstate& gstate);
+    const t_gstate& gstate, const t_mask* msk_prev, const t_mask* msk_curr);
 
 PERSPECTIVE_EXPORT void notify_sparse_tree(std::shared_ptr<t_stree> tree,
     std::shared_ptr<t_traversal> traversal, bool process_traversal,
     const std::vector<t_aggspec>& aggregates,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
-    const t_config& config, const t_gstate& gstate);
+    const t_config& config, const t_gstate& gstate, const t_mask* msk);
 
 template <typename CONTEXT_T>
 void
@@ -17,6 +17,7 @@
 #include <functional>
 #include <limits>
 #include <cmath>
+#include <vector>
 #include <tsl/hopscotch_map.h>
 
 namespace perspective {
@@ -82,4 +83,36 @@ private:
     std::shared_ptr<t_lstore> m_extents;
 };
 
+/**
+ * Translates string ids of one vocabulary into another. Each distinct source
+ * id is interned into the destination the first time it is translated, so
+ * merging string columns costs a hash lookup per distinct string rather
+ * than per row. The source must not grow while the remap is in use.
+ */
+class PERSPECTIVE_EXPORT t_vocab_remap {
+public:
+    t_vocab_remap(const t_vocab& src, t_vocab& dst);
+
+    t_uindex translate(t_uindex idx);
+
+    // Translates `n` source ids in place. Only valid cells, per `status`,
+    // hold an id; the rest are set to 0. A null `status` marks all valid.
+    void translate(t_uindex* ids, const t_status* status, t_uindex n);
+
+private:
+    const t_vocab* m_src;
+    t_vocab* m_dst;
+    std::vector<t_uindex> m_remap;
+};
+
+inline t_uindex
+t_vocab_remap::translate(t_uindex idx) {
+    PSP_VERBOSE_ASSERT(idx < m_remap.size(), "Vocabulary id out of range");
+    t_uindex& rval = m_remap[idx];
+    if (rval == std::numeric_limits<t_uindex>::max()) {
+        rval = m_dst->get_interned(m_src->unintern_c(idx));
+    }
+    return rval;
+}
+
 } // end namespace perspective
@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/data_table.h>
+#include <perspective/filter.h>
+#include <perspective/mask.h>
+#include <perspective/scalar.h>
+#include <boost/dynamic_bitset.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perspective {
+
+const t_uindex PSP_ZONE_MAP_BLOCK_SIZE = 65536;
+
+// Summary of one block of a column; NaNs count as valid but have no range.
+struct PERSPECTIVE_EXPORT t_zone {
+    t_zone();
+
+    t_tscalar m_min;
+    t_tscalar m_max;
+    t_uindex m_nvalid;
+    t_uindex m_nnull;
+};
+
+/**
+ * Per-block summaries of the numeric, date and time columns of a t_gstate's
+ * master table. A column is summarized when first asked about; after that,
+ * writes only mark their blocks, which are summarized again when next used.
+ * Appending to a table then only rescans its last blocks.
+ */
+class PERSPECTIVE_EXPORT t_zone_maps {
+public:
+    t_zone_maps(t_uindex block_size = PSP_ZONE_MAP_BLOCK_SIZE);
+
+    void mark(t_uindex ridx);
+    void mark(const std::vector<t_uindex>& rows);
+
+    // Summarizes every block again on next use, e.g. after the table is replaced.
+    void invalidate();
+
+    // Rows of `tbl` passing every one of `fterms`, scanning only the blocks
+    // that may hold one; false if no block can be skipped.
+    bool filter(const t_data_table& tbl, const std::vector<t_fterm>& fterms, t_mask& mask);
+
+    // Smallest and largest valid value of a column, none if it has none.
+    std::pair<t_tscalar, t_tscalar> get_min_max(
+        const t_data_table& tbl, const std::string& colname);
+
+    std::vector<t_zone> get_zones(const t_data_table& tbl, const std::string& colname);
+
+private:
+    // Summarizes the marked blocks of every column, `colname` included.
+    const std::vector<t_zone>& refresh(const t_data_table& tbl, const std::string& colname);
+
+    std::mutex m_mtx;
+    t_uindex m_block_size;
+    std::map<std::string, std::vector<t_zone>> m_zones;
+    boost::dynamic_bitset<> m_dirty;
+};
+
+} // end namespace perspective
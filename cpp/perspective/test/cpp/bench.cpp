@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/base.h>
+#include <perspective/data_table.h>
+#include <perspective/gnode_state.h>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace perspective;
+
+/**
+ * Times t_gstate::update_history writing updates of every existing row into
+ * the master table, i.e. the steady state of a ticking table, and the
+ * t_gstate::scatter step of it on its own.
+ *
+ * Usage: psp_bench [nrows] [iterations]
+ */
+
+static std::shared_ptr<t_data_table>
+make_update(const t_schema& schema, t_uindex nrows, std::int64_t tick) {
+    auto tbl = std::make_shared<t_data_table>(schema, nrows);
+    tbl->init();
+    tbl->extend(nrows);
+
+    auto op = tbl->get_column("psp_op");
+    auto pkey = tbl->get_column("psp_pkey");
+    auto i = tbl->get_column("i");
+    auto f = tbl->get_column("f");
+    auto d = tbl->get_column("d");
+    auto s = tbl->get_column("s");
+
+    static const char* names[] = {"alpha", "beta", "gamma", "delta", "epsilon"};
+
+    for (t_uindex ridx = 0; ridx < nrows; ++ridx) {
+        std::int64_t v = static_cast<std::int64_t>(ridx) + tick;
+        op->set_nth<std::uint8_t>(ridx, OP_INSERT);
+        pkey->set_nth<std::int64_t>(ridx, static_cast<std::int64_t>(ridx));
+        i->set_nth<std::int64_t>(ridx, v);
+        f->set_nth<double>(ridx, v * 0.5);
+        d->set_nth<std::int32_t>(ridx, static_cast<std::int32_t>(v));
+        s->set_nth<const char*>(ridx, names[v % 5]);
+    }
+
+    // Every tenth value is left out of the update
+    for (t_uindex ridx = 0; ridx < nrows; ridx += 10) {
+        f->set_valid(ridx, false);
+    }
+
+    return tbl;
+}
+
+int
+main(int argc, char** argv) {
+    t_uindex nrows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    t_uindex iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+
+    t_schema tblschema{
+        {"i", "f", "d", "s"}, {DTYPE_INT64, DTYPE_FLOAT64, DTYPE_INT32, DTYPE_STR}};
+    t_schema schema{{"psp_op", "psp_pkey", "i", "f", "d", "s"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_INT32, DTYPE_STR}};
+
+    t_gstate state(tblschema, schema);
+    state.init();
+    state.update_history(make_update(schema, nrows, 0).get());
+
+    std::vector<std::shared_ptr<t_data_table>> updates;
+    for (t_uindex tick = 1; tick <= iterations; ++tick) {
+        updates.push_back(make_update(schema, nrows, static_cast<std::int64_t>(tick)));
+    }
+
+    double cells = double(nrows) * double(iterations) * double(schema.size());
+
+    // Bytes of data and status read from the update and written to the table
+    double row_bytes = 1 + 8 + 8 + 8 + 4 + 8 + double(schema.size());
+    double bytes = 2 * row_bytes * double(nrows) * double(iterations);
+
+    auto report = [&](const std::string& name, std::function<void(const t_data_table*)> fn) {
+        auto begin = std::chrono::high_resolution_clock::now();
+        for (const auto& tbl : updates) {
+            fn(tbl.get());
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - begin).count();
+
+        std::cout << name << ": " << seconds * 1e3 / iterations << " ms per update, "
+                  << seconds * 1e9 / cells << " ns per cell, " << bytes / seconds / 1e9
+                  << " GB/s" << std::endl;
+    };
+
+    std::cout << nrows << " rows x " << schema.size() << " columns x " << iterations
+              << " updates" << std::endl;
+
+    // Including pkey lookups
+    report("update_history", [&state](const t_data_table* tbl) { state.update_history(tbl); });
+
+    // Rows of every update land in the same place, in order
+    std::vector<t_uindex> rows(nrows);
+    for (t_uindex ridx = 0; ridx < nrows; ++ridx) {
+        rows[ridx] = ridx;
+    }
+    report("scatter",
+        [&state, &rows](const t_data_table* tbl) { state.scatter(tbl, rows, rows); });
+
+    return 0;
+}
@@ -22,13 +22,24 @@
 #include <perspective/storage.h>
 #include <perspective/none.h>
 #include <perspective/gnode.h>
+#include <perspective/gnode_state.h>
 #include <perspective/sym_table.h>
+#include <perspective/multi_sort.h>
+#include <perspective/csv.h>
+#include <perspective/snapshot.h>
+#include <perspective/pool.h>
 #include <gtest/gtest.h>
 #include <random>
+#include <thread>
 #include <limits>
 #include <cmath>
 #include <cstdint>
 #include <sstream>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <unistd.h>
 
 using namespace perspective;
 
@@ -2171,7 +2182,7 @@ TEST(GNODE_TEST, get_registered_contexts)
     EXPECT_EQ(gn->get_contexts_last_updated().size(), 3);
 
     auto recipe = gn->get_recipe();
-    auto gn2 = t_gnode(recipe);
+    t_gnode gn2(recipe);
 
     EXPECT_TRUE(gn->was_updated());
 
@@ -2208,3 +2219,1405 @@ TEST(GNODE_TEST, get_registered_contexts)
 
     gn->reset();
 }
+
+TEST(SPARSE_TREE, node_store)
+{
+    t_stnode_store nodes;
+    nodes.insert(t_stnode(0, root_pidx(), "root"_ts, 0, "root"_ts, 3, 0));
+    nodes.insert(t_stnode(1, 0, "b"_ts, 1, 2_ts, 1, 1));
+    nodes.insert(t_stnode(2, 0, "a"_ts, 1, 3_ts, 1, 2));
+    nodes.insert(t_stnode(3, 0, "c"_ts, 1, 1_ts, 1, 3));
+
+    EXPECT_FALSE(nodes.insert(t_stnode(4, 0, "a"_ts, 1, 0_ts, 1, 4)));
+    EXPECT_EQ(nodes.size(), 4);
+    EXPECT_EQ(nodes.get_children(0), (std::vector<t_uindex>{3, 1, 2}));
+    EXPECT_EQ(nodes.find_child(0, "a"_ts), 2);
+    EXPECT_EQ(nodes.find_child(0, "d"_ts), INVALID_INDEX);
+
+    nodes.set_sort_value(2, 0_ts);
+    EXPECT_EQ(nodes.get_children(0), (std::vector<t_uindex>{2, 3, 1}));
+    EXPECT_EQ(nodes.get_child_position(0, 1), 2);
+
+    nodes.set_nstrands(3, 0);
+    EXPECT_EQ(nodes.get_zero_strands(), std::vector<t_uindex>{3});
+
+    nodes.erase(3);
+    EXPECT_EQ(nodes.size(), 3);
+    EXPECT_FALSE(nodes.contains(3));
+    EXPECT_TRUE(nodes.get_zero_strands().empty());
+    EXPECT_EQ(nodes.get_children(0), (std::vector<t_uindex>{2, 1}));
+    EXPECT_EQ(nodes.find_child(0, "c"_ts), INVALID_INDEX);
+}
+
+class I64Ctx1MultiAggTest : public CtxTest<I64Ctx1MultiAggTest, t_ctx1>
+{
+public:
+    t_schema
+    get_ischema()
+    {
+        return t_schema{{"psp_op", "psp_pkey", "x", "y"},
+            {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    }
+
+    t_config
+    get_config()
+    {
+        return t_config{{"x"},
+            std::vector<t_aggspec>{{"sum_y", AGGTYPE_SUM, "y"}, {"count_y", AGGTYPE_COUNT, "y"},
+                {"mean_y", AGGTYPE_MEAN, "y"}}};
+    }
+};
+
+// clang-format off
+TEST_F(I64Ctx1MultiAggTest, test_1)
+{
+    t_testdata data{
+        {{{iop, 1_ts, 1_ts, 2_ts}, {iop, 2_ts, 2_ts, 4_ts}},
+            {"Grand Aggregate"_ts, 6_ts, 2_ts, 3._ts, 1_ts, 2_ts, 1_ts, 2._ts,
+                2_ts, 4_ts, 1_ts, 4._ts}},
+        {{{iop, 1_ts, 2_ts, 6_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 2_ts, 5._ts, 2_ts, 10_ts, 2_ts, 5._ts}}};
+
+    run(data);
+}
+// clang-format on
+
+TEST(CONTEXT_ONE, viewport_first_sort)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "b", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"a", "b"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    auto full = t_ctx1::build(sch, cfg);
+    auto partial = t_ctx1::build(sch, cfg);
+    gn->register_context("full", full);
+    gn->register_context("partial", partial);
+
+    std::vector<std::vector<t_tscalar>> data;
+    for (std::int64_t i = 0; i < 40; ++i) {
+        data.push_back({iop, mktscalar(i), mktscalar(i % 5), mktscalar(i % 7),
+            mktscalar((i * 13) % 17)});
+    }
+
+    t_data_table tbl(sch, data);
+    gn->_send_and_process(tbl);
+
+    full->set_depth(1);
+    partial->set_depth(1);
+
+    std::vector<t_sortspec> sortby{{0, SORTTYPE_DESCENDING}};
+    full->sort_by(sortby);
+    partial->sort_by(sortby, 4);
+
+    auto nrows = full->get_row_count();
+    auto ncols = full->get_column_count();
+    EXPECT_EQ(partial->get_data(0, 4, 0, ncols), full->get_data(0, 4, 0, ncols));
+    EXPECT_EQ(partial->get_data(0, nrows, 0, ncols), full->get_data(0, nrows, 0, ncols));
+
+    // Concurrent readers may both reach the pending part of the sort
+    partial->sort_by(std::vector<t_sortspec>{{0, SORTTYPE_ASCENDING}}, 4);
+    full->sort_by(std::vector<t_sortspec>{{0, SORTTYPE_ASCENDING}});
+    auto expected = full->get_data(0, nrows, 0, ncols);
+    std::vector<std::vector<t_tscalar>> results(4);
+    std::vector<std::thread> readers;
+    for (auto& result : results) {
+        readers.emplace_back([&]() { result = partial->get_data(0, nrows, 0, ncols); });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (const auto& result : results) {
+        EXPECT_EQ(result, expected);
+    }
+}
+
+TEST(CONTEXT_TWO, cell_index_after_update)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "r", "c", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg({"r"}, {"c"}, {{"sum_x", AGGTYPE_SUM, "x"}});
+    auto warm = t_ctx2::build(sch, cfg);
+    auto cold = t_ctx2::build(sch, cfg);
+    gn->register_context("warm", warm);
+    gn->register_context("cold", cold);
+
+    auto step = [&gn, &sch](const std::vector<std::vector<t_tscalar>>& data) {
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    auto all_data = [](std::shared_ptr<t_ctx2> ctx) {
+        ctx->set_depth(HEADER_ROW, 1);
+        ctx->set_depth(HEADER_COLUMN, 1);
+        return ctx->get_data(0, ctx->get_row_count(), 0, ctx->get_column_count());
+    };
+
+    step({{iop, 1_ts, 1_ts, 1_ts, 10_ts}, {iop, 2_ts, 2_ts, 2_ts, 20_ts}});
+    all_data(warm);
+
+    // Fills a previously empty cell and empties another
+    step({{iop, 3_ts, 1_ts, 2_ts, 30_ts}, {dop, 2_ts, 2_ts, 2_ts, 20_ts}});
+
+    EXPECT_EQ(all_data(warm), all_data(cold));
+
+    // Updates a cached cell in place and empties the one filled above, keeping
+    // its row and column
+    step({{iop, 1_ts, 1_ts, 1_ts, 15_ts}, {dop, 3_ts, 1_ts, 2_ts, 30_ts},
+        {iop, 5_ts, 2_ts, 2_ts, 50_ts}});
+
+    EXPECT_EQ(all_data(warm), all_data(cold));
+
+    // Refills the emptied cell, which gets a new node
+    step({{iop, 4_ts, 1_ts, 2_ts, 40_ts}});
+
+    EXPECT_EQ(all_data(warm), all_data(cold));
+}
+
+TEST(CONTEXT_ONE, lazy_context_resumes_on_read)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "b", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"a", "b"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    auto eager = t_ctx1::build(sch, cfg);
+    auto lazy = t_ctx1::build(sch, cfg);
+    gn->register_context("eager", eager);
+    gn->register_context("lazy", lazy);
+    lazy->set_lazy(true);
+
+    auto step = [&gn, &sch](std::int64_t offset) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = 0; i < 20; ++i) {
+            auto pkey = i + offset;
+            data.push_back({iop, mktscalar(pkey), mktscalar(pkey % 3), mktscalar(pkey % 4),
+                mktscalar(pkey * 2)});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    step(0);
+    EXPECT_TRUE(lazy->has_pending_update());
+    eager->open(1);
+    lazy->open(1);
+
+    step(10);
+    step(25);
+    EXPECT_TRUE(lazy->has_pending_update());
+
+    auto ncols = eager->get_column_count();
+    auto eager_data = eager->get_data(0, eager->get_row_count(), 0, ncols);
+    auto lazy_data = lazy->get_data(0, lazy->get_row_count(), 0, ncols);
+    EXPECT_FALSE(lazy->has_pending_update());
+    EXPECT_EQ(lazy_data, eager_data);
+}
+
+TEST(CONTEXT_ONE, lazy_context_concurrent_readers_replay_once)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"a"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    auto eager = t_ctx1::build(sch, cfg);
+    auto lazy = t_ctx1::build(sch, cfg);
+    gn->register_context("eager", eager);
+    gn->register_context("lazy", lazy);
+    lazy->set_lazy(true);
+
+    auto step = [&gn, &sch](std::int64_t offset) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = 0; i < 500; ++i) {
+            auto pkey = i + offset;
+            data.push_back({iop, mktscalar(pkey), mktscalar(pkey % 7), mktscalar(pkey)});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    step(0);
+    lazy->get_row_count();
+    step(250);
+    step(600);
+
+    auto nrows = eager->get_row_count();
+    auto ncols = eager->get_column_count();
+    auto expected = eager->get_data(0, nrows, 0, ncols);
+    std::vector<std::vector<t_tscalar>> results(4);
+    std::vector<std::thread> readers;
+    for (auto& result : results) {
+        readers.emplace_back([&lazy, &result, nrows, ncols]() {
+            result = lazy->get_data(0, nrows, 0, ncols);
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_FALSE(lazy->has_pending_update());
+    for (const auto& result : results) {
+        EXPECT_EQ(result, expected);
+    }
+}
+
+TEST(SYMTABLE, clear_frees_interned_strings)
+{
+    t_symtable symtable;
+    std::string s(64, 'x');
+    symtable.get_interned_tscalar(s.c_str());
+    EXPECT_EQ(symtable.size(), 1);
+
+    symtable.clear();
+    EXPECT_EQ(symtable.size(), 0);
+    EXPECT_EQ(symtable.get_interned_tscalar(s.c_str()).to_string(), s);
+}
+
+TEST(CONTEXT_ONE, lazy_context_replays_deferred_updates)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "s", "b", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_INT64, DTYPE_FLOAT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg0{{"s", "b", "x"}, FILTER_OP_AND,
+        {t_fterm("b", FILTER_OP_EQ, mktscalar<std::int64_t>(1), {})}};
+    t_config cfg1{{"s"}, {{"sum_x", AGGTYPE_SUM, "x"}}, FILTER_OP_AND,
+        {t_fterm("x", FILTER_OP_GT, mktscalar(50.0), {})}};
+    t_config cfg2{{"s"}, {"b"}, {{"sum_x", AGGTYPE_SUM, "x"}}};
+    std::vector<std::shared_ptr<t_ctx0>> ctx0s{
+        t_ctx0::build(sch, cfg0), t_ctx0::build(sch, cfg0)};
+    std::vector<std::shared_ptr<t_ctx1>> ctx1s{
+        t_ctx1::build(sch, cfg1), t_ctx1::build(sch, cfg1)};
+    std::vector<std::shared_ptr<t_ctx2>> ctx2s{
+        t_ctx2::build(sch, cfg2), t_ctx2::build(sch, cfg2)};
+    for (int lazy = 0; lazy < 2; ++lazy) {
+        auto suffix = std::to_string(lazy);
+        gn->register_context("ctx0_" + suffix, ctx0s[lazy]);
+        gn->register_context("ctx1_" + suffix, ctx1s[lazy]);
+        gn->register_context("ctx2_" + suffix, ctx2s[lazy]);
+        ctx0s[lazy]->set_lazy(lazy);
+        ctx1s[lazy]->set_lazy(lazy);
+        ctx2s[lazy]->set_lazy(lazy);
+    }
+
+    auto step = [&gn, &sch](std::int64_t begin, std::int64_t end, std::int64_t shift,
+                    t_tscalar op) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = begin; i < end; ++i) {
+            std::string s = "s" + std::to_string((i + shift) % 5);
+            data.push_back({op, mktscalar(i), mktscalar(s.c_str()), mktscalar((i + shift) % 3),
+                mktscalar(double(i + 10 * shift))});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    auto all_data = [](std::shared_ptr<t_ctx2> ctx) {
+        ctx->set_depth(HEADER_ROW, 1);
+        ctx->set_depth(HEADER_COLUMN, 1);
+        return ctx->get_data(0, ctx->get_row_count(), 0, ctx->get_column_count());
+    };
+
+    // The first load rebuilds; later ones replay only the rows they touched
+    step(0, 200, 0, iop);
+    ctx0s[1]->get_row_count();
+    ctx1s[1]->set_depth(1);
+    all_data(ctx2s[1]);
+
+    // Moves rows between groups, deletes some, adds back a few of those
+    step(0, 30, 1, iop);
+    step(20, 40, 0, dop);
+    step(25, 35, 2, iop);
+    step(0, 10, 3, iop);
+    step(200, 220, 4, iop);
+    EXPECT_TRUE(ctx1s[1]->has_pending_update());
+
+    EXPECT_EQ(ctx1s[1]->get_row_path(2), ctx1s[0]->get_row_path(2));
+    EXPECT_FALSE(ctx1s[1]->has_pending_update());
+    EXPECT_EQ(ctx1s[1]->get_data(0, ctx1s[1]->get_row_count(), 0, 2),
+        ctx1s[0]->get_data(0, ctx1s[0]->get_row_count(), 0, 2));
+
+    auto ncols0 = ctx0s[0]->get_column_count();
+    EXPECT_EQ(ctx0s[1]->get_data(0, ctx0s[1]->get_row_count(), 0, ncols0),
+        ctx0s[0]->get_data(0, ctx0s[0]->get_row_count(), 0, ncols0));
+    EXPECT_EQ(all_data(ctx2s[1]), all_data(ctx2s[0]));
+}
+
+TEST(CONTEXT_ONE, string_pivot_groups_sorted)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "s", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"s"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    auto ctx = t_ctx1::build(sch, cfg);
+    gn->register_context("ctx", ctx);
+
+    std::vector<const char*> names{"delta", "alpha", "charlie", "bravo"};
+    std::vector<std::vector<t_tscalar>> data;
+    for (std::int64_t i = 0; i < 1000; ++i) {
+        data.push_back({iop, mktscalar(i), mktscalar(names[i % 4]), mktscalar(i % 4)});
+    }
+
+    t_data_table tbl(sch, data);
+    gn->_send_and_process(tbl);
+
+    ctx->set_depth(1);
+    auto out = ctx->get_data(0, ctx->get_row_count(), 0, ctx->get_column_count());
+    std::vector<t_tscalar> expected{mktscalar("Grand Aggregate"), 1500_ts, "alpha"_ts, 250_ts,
+        "bravo"_ts, 750_ts, "charlie"_ts, 500_ts, "delta"_ts, 0_ts};
+    EXPECT_EQ(out, expected);
+}
+
+TEST(CONTEXT_ONE, multi_level_pivot)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "b", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"a", "b"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    auto ctx = t_ctx1::build(sch, cfg);
+    gn->register_context("ctx", ctx);
+
+    std::map<std::int64_t, std::map<std::int64_t, std::int64_t>> sums;
+    std::vector<std::vector<t_tscalar>> data;
+    for (std::int64_t i = 0; i < 500; ++i) {
+        std::int64_t a = (i * 7) % 11;
+        std::int64_t b = (i * 5) % 13;
+        sums[a][b] += i;
+        data.push_back({iop, mktscalar(i), mktscalar(a), mktscalar(b), mktscalar(i)});
+    }
+
+    t_data_table tbl(sch, data);
+    gn->_send_and_process(tbl);
+
+    ctx->set_depth(2);
+    auto out = ctx->get_data(0, ctx->get_row_count(), 0, ctx->get_column_count());
+
+    std::vector<t_tscalar> expected{
+        mktscalar("Grand Aggregate"), mktscalar<std::int64_t>(124750)};
+    for (const auto& akv : sums) {
+        std::int64_t asum = 0;
+        for (const auto& bkv : akv.second) {
+            asum += bkv.second;
+        }
+        expected.push_back(mktscalar(akv.first));
+        expected.push_back(mktscalar(asum));
+        for (const auto& bkv : akv.second) {
+            expected.push_back(mktscalar(bkv.first));
+            expected.push_back(mktscalar(bkv.second));
+        }
+    }
+    EXPECT_EQ(out, expected);
+}
+
+TEST(MULTI_SORT, encoded_keys_match_scalar_order)
+{
+    std::vector<const char*> strs{"", "a", "abcdefgh", "abcdefghi", "abcdefghj", "b", "ab"};
+    std::vector<double> dbls{-2.5, -0.0, 0.0, 1.0, 2.5, -1.0,
+        std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::infinity()};
+
+    std::vector<t_mselem> elems;
+    for (t_uindex idx = 0; idx < 200; ++idx) {
+        std::vector<t_tscalar> row{mktscalar(strs[(idx * 3) % strs.size()]),
+            mktscalar(dbls[(idx * 5) % dbls.size()]),
+            mktscalar<std::int64_t>(std::int64_t(idx % 7) - 3)};
+        if (idx % 11 == 0) {
+            row[2] = mknone();
+        }
+        elems.push_back(t_mselem(mktscalar<std::int64_t>(idx), row));
+    }
+
+    std::vector<std::vector<t_sorttype>> orders{
+        {SORTTYPE_ASCENDING, SORTTYPE_DESCENDING, SORTTYPE_ASCENDING},
+        {SORTTYPE_DESCENDING, SORTTYPE_ASCENDING_ABS, SORTTYPE_DESCENDING_ABS},
+        {SORTTYPE_ASCENDING, SORTTYPE_NONE, SORTTYPE_DESCENDING}};
+
+    for (const auto& order : orders) {
+        t_multisorter sorter(order);
+        auto plain = elems;
+        auto encoded = elems;
+        for (auto& elem : encoded) {
+            encode_sort_key(elem, order);
+        }
+
+        std::stable_sort(plain.begin(), plain.end(), sorter);
+        std::stable_sort(encoded.begin(), encoded.end(), sorter);
+        for (t_uindex idx = 0; idx < elems.size(); ++idx) {
+            EXPECT_EQ(encoded[idx].m_pkey, plain[idx].m_pkey);
+        }
+    }
+}
+
+TEST(CSV, parses_chunks_into_typed_columns) {
+    std::string text = "i,f,b,t,s\r\n"
+                       "1,1.5,true,2019-01-02 03:04:05,\"a,\"\"x\"\"\nb\"\r\n"
+                       "2,,FALSE,2019-01-03 00:00:00,c\r\n"
+                       "\n"
+                       "3,7,false,,c\r\n";
+
+    t_csv_options options;
+    options.m_chunk_size = 8;
+    t_csv_reader reader(std::move(text), options);
+
+    t_schema expected({"i", "f", "b", "t", "s"},
+        {DTYPE_INT32, DTYPE_FLOAT64, DTYPE_BOOL, DTYPE_TIME, DTYPE_STR});
+    EXPECT_EQ(reader.get_schema(), expected);
+    EXPECT_EQ(reader.num_rows(), 3);
+
+    auto tbl = reader.read();
+    EXPECT_EQ(tbl->size(), 3);
+
+    auto i = tbl->get_column("i");
+    auto f = tbl->get_column("f");
+    auto b = tbl->get_column("b");
+    auto t = tbl->get_column("t");
+    auto s = tbl->get_column("s");
+
+    EXPECT_EQ(*i->get_nth<std::int32_t>(2), 3);
+    EXPECT_EQ(*f->get_nth<double>(0), 1.5);
+    EXPECT_FALSE(f->is_valid(1));
+    EXPECT_TRUE(*b->get_nth<bool>(0));
+    EXPECT_FALSE(*b->get_nth<bool>(1));
+    EXPECT_EQ(*t->get_nth<std::int64_t>(0), to_gmtime(2019, 1, 2, 3, 4, 5) * 1000);
+    EXPECT_FALSE(t->is_valid(2));
+    EXPECT_EQ(s->get_scalar(0).to_string(), "a,\"x\"\nb");
+    EXPECT_EQ(s->get_scalar(1).to_string(), "c");
+    EXPECT_EQ(*s->get_nth<t_uindex>(1), *s->get_nth<t_uindex>(2));
+}
+
+TEST(SKETCH, tracks_updates_and_filters)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "g", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_FLOAT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+    gn->enable_sketch("x", 64);
+
+    t_config cfg{{"g", "x"}, FILTER_OP_AND,
+        {t_fterm("g", FILTER_OP_EQ, mktscalar<std::int64_t>(0), {})}};
+    auto ctx0 = t_ctx0::build(sch, cfg);
+    gn->register_context("ctx0", ctx0);
+    ctx0->enable_sketch("x", 64);
+
+    // Pivoted contexts keep the same sketches, a lazy one included
+    std::vector<t_fterm> fterms{t_fterm("g", FILTER_OP_EQ, mktscalar<std::int64_t>(0), {})};
+    auto ctx1 = t_ctx1::build(sch, t_config{{"g"}, {{"sum_x", AGGTYPE_SUM, "x"}},
+                                       FILTER_OP_AND, fterms});
+    auto ctx2 = t_ctx2::build(sch, t_config{{"g"}, {"g"}, {{"sum_x", AGGTYPE_SUM, "x"}},
+                                       TOTALS_BEFORE, FILTER_OP_AND, fterms});
+    gn->register_context("ctx1", ctx1);
+    gn->register_context("ctx2", ctx2);
+    ctx1->set_lazy(true);
+    ctx1->enable_sketch("x", 64);
+    ctx2->enable_sketch("x", 64);
+
+    auto step = [&gn, &sch](std::int64_t begin, std::int64_t end, double shift, t_tscalar op) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = begin; i < end; ++i) {
+            data.push_back({op, mktscalar(i), mktscalar(i % 2), mktscalar(i + shift)});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    step(0, 1000, 0, iop);
+    EXPECT_EQ(gn->get_sketch("x").count(), 1000);
+    EXPECT_NEAR(gn->get_sketch("x").quantile(0.5), 500, 5);
+    EXPECT_EQ(ctx0->get_sketch("x").count(), 500);
+
+    // Shifted rows are removed from their old buckets
+    step(0, 600, 1000, iop);
+    EXPECT_EQ(gn->get_sketch("x").count(), 1000);
+    EXPECT_NEAR(gn->get_sketch("x").quantile(0.5), 1100, 40);
+    EXPECT_EQ(ctx0->get_sketch("x").count(), 500);
+
+    step(0, 300, 0, dop);
+    EXPECT_EQ(gn->get_sketch("x").count(), 700);
+    EXPECT_EQ(ctx0->get_sketch("x").count(), 350);
+    EXPECT_NEAR(gn->get_sketch("x").quantile(0), 600, 5);
+    for (const t_column_sketch* sketch : {&ctx1->get_sketch("x"), &ctx2->get_sketch("x")}) {
+        EXPECT_EQ(sketch->count(), 350);
+        EXPECT_EQ(sketch->quantile(0.5), ctx0->get_sketch("x").quantile(0.5));
+    }
+
+    t_histogram merged(64);
+    merged.merge(gn->get_sketch("x").get_histogram());
+    merged.merge(ctx0->get_sketch("x").get_histogram());
+    EXPECT_EQ(merged.count(), 1050);
+}
+
+TEST(CONTEXT_ONE, incremental_min_max_matches_scan)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"a"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    auto ctx = t_ctx1::build(sch, cfg);
+    ctx->set_minmax_enabled(true);
+    gn->register_context("ctx", ctx);
+
+    auto step = [&gn, &sch](std::int64_t begin, std::int64_t end, std::int64_t scale,
+                    t_tscalar op) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = begin; i < end; ++i) {
+            data.push_back({op, mktscalar(i), mktscalar(i % 7), mktscalar(i * scale)});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    // A context without tracking scans its whole tree on each read
+    auto check = [&gn, &sch, &cfg, &ctx]() {
+        auto scanned = t_ctx1::build(sch, cfg);
+        gn->register_context("scanned", scanned);
+        auto expected = scanned->get_min_max();
+        auto expected_depth = scanned->get_agg_min_max(0, 1);
+        gn->_unregister_context("scanned");
+
+        auto actual = ctx->get_min_max();
+        auto actual_depth = ctx->get_agg_min_max(0, 1);
+        EXPECT_EQ(actual[0].m_min, expected[0].m_min);
+        EXPECT_EQ(actual[0].m_max, expected[0].m_max);
+        EXPECT_EQ(actual_depth.m_min, expected_depth.m_min);
+        EXPECT_EQ(actual_depth.m_max, expected_depth.m_max);
+    };
+
+    step(0, 50, 1, iop);
+    check();
+    step(40, 50, 10, iop);
+    check();
+    step(40, 50, -1, iop);
+    check();
+    step(0, 49, 1, dop);
+    check();
+}
+
+TEST(CONTEXT_ONE, incremental_sort_matches_full_sort)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "b", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"a", "b"}, {"sum_x", AGGTYPE_SUM, "x"}};
+    std::vector<t_sortspec> sortby{{0, SORTTYPE_DESCENDING}};
+    auto ctx = t_ctx1::build(sch, cfg);
+    gn->register_context("ctx", ctx);
+    ctx->set_depth(1);
+    ctx->sort_by(sortby);
+
+    auto step = [&gn, &sch](std::int64_t begin, std::int64_t end, std::int64_t a,
+                    std::int64_t scale, t_tscalar op) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = begin; i < end; ++i) {
+            data.push_back({op, mktscalar(i), mktscalar(a < 0 ? i % 8 : a),
+                mktscalar(i % 5), mktscalar((i * scale) % 23)});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    // A context registered after the fact sorts everything from scratch
+    auto check = [&gn, &sch, &cfg, &sortby, &ctx]() {
+        auto full = t_ctx1::build(sch, cfg);
+        gn->register_context("full", full);
+        full->set_depth(1);
+        full->sort_by(sortby);
+
+        auto nrows = full->get_row_count();
+        auto ncols = full->get_column_count();
+        EXPECT_EQ(ctx->get_row_count(), nrows);
+        EXPECT_EQ(ctx->get_data(0, nrows, 0, ncols), full->get_data(0, nrows, 0, ncols));
+        for (t_index ridx = 0; ridx < nrows; ++ridx) {
+            EXPECT_EQ(ctx->get_row_path(ridx), full->get_row_path(ridx));
+        }
+        gn->_unregister_context("full");
+    };
+
+    step(0, 200, -1, 7, iop);
+    check();
+    step(3, 5, -1, 11, iop);
+    check();
+    step(200, 203, 100, 1, iop);
+    check();
+    step(10, 12, 3, 1, iop);
+    check();
+    step(0, 8, -1, 1, dop);
+    check();
+}
+
+TEST(SNAPSHOT, reopens_gnode_state)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "s", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_FLOAT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+
+    auto step = [&sch](std::shared_ptr<t_gnode> gn, std::int64_t begin, std::int64_t end,
+                    double shift, t_tscalar op) {
+        static const char* names[] = {"a", "bb", "ccc"};
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = begin; i < end; ++i) {
+            data.push_back({op, mktscalar(i), mktscalar(names[i % 3]), mktscalar(i + shift)});
+        }
+        t_data_table tbl(sch, data);
+        gn->_send_and_process(tbl);
+    };
+
+    auto contents = [](std::shared_ptr<t_gnode> gn) {
+        auto tbl = gn->get_sorted_pkeyed_table();
+        std::vector<std::string> rval;
+        for (t_uindex ridx = 0; ridx < tbl->size(); ++ridx) {
+            for (const char* colname : {"psp_pkey", "s", "x"}) {
+                rval.push_back(tbl->get_const_column(colname)->get_scalar(ridx).to_string());
+            }
+        }
+        return rval;
+    };
+
+    char dirname_template[] = "/tmp/psp_snapshot_XXXXXX";
+    std::string dirname = mkdtemp(dirname_template);
+
+    auto gn = t_gnode::build(options);
+    step(gn, 0, 100, 0, iop);
+    step(gn, 10, 20, 0, dop);
+    gn->save_snapshot(dirname);
+    auto saved = contents(gn);
+
+    // Contexts registered before the load are rebuilt from the loaded rows
+    auto loaded = t_gnode::build(options);
+    auto ctx0 = t_ctx0::build(sch, t_config{{"s", "x"}});
+    loaded->register_context("ctx0", ctx0);
+    loaded->load_snapshot(dirname);
+    EXPECT_EQ(contents(loaded), saved);
+    EXPECT_EQ(ctx0->get_row_count(), 90);
+
+    // Writes in place, appends past the mapped capacity and reuse of erased rows
+    for (auto g : {gn, loaded}) {
+        step(g, 0, 5, 1000, iop);
+        step(g, 100, 200, 0, iop);
+        step(g, 10, 12, 0, iop);
+    }
+    EXPECT_EQ(contents(loaded), contents(gn));
+    EXPECT_EQ(ctx0->get_row_count(), 192);
+
+    // None of it reached the snapshot files
+    auto reloaded = t_gnode::build(options);
+    reloaded->load_snapshot(dirname);
+    EXPECT_EQ(contents(reloaded), saved);
+
+    t_snapshot snapshot(dirname);
+    EXPECT_EQ(snapshot.num_rows(), 100);
+    EXPECT_EQ(snapshot.get_free_rows().size(), 10);
+
+    // Saving over a snapshot with live tables mapped from it
+    gn->save_snapshot(dirname);
+    auto resaved = t_gnode::build(options);
+    resaved->load_snapshot(dirname);
+    EXPECT_EQ(contents(resaved), contents(gn));
+    EXPECT_EQ(contents(reloaded), saved);
+
+    for (t_uindex cidx = 0; cidx < sch.size(); ++cidx) {
+        for (const char* store : {"data", "status", "vlendata", "extents"}) {
+            std::stringstream ss;
+            ss << dirname << "/" << cidx << "_" << store;
+            std::remove(ss.str().c_str());
+        }
+    }
+    std::remove((dirname + "/manifest").c_str());
+    std::remove((dirname + "/free_rows").c_str());
+    EXPECT_EQ(rmdir(dirname.c_str()), 0);
+}
+
+TEST(SNAPSHOT, bad_snapshots_throw)
+{
+    t_schema sch{{"x"}, {DTYPE_INT64}};
+    t_data_table tbl(sch, {{1_ts}, {2_ts}});
+
+    char dirname_template[] = "/tmp/psp_snapshot_XXXXXX";
+    std::string dirname = mkdtemp(dirname_template);
+    std::string missing = dirname + "/missing";
+
+    EXPECT_THROW(t_snapshot::save(tbl, {}, missing), std::runtime_error);
+    EXPECT_THROW(t_snapshot snapshot(missing), std::runtime_error);
+
+    t_snapshot::save(tbl, {1}, dirname);
+    t_data_table other(t_schema{{"y"}, {DTYPE_INT64}});
+    other.init();
+    EXPECT_THROW(t_snapshot(dirname).load(other), std::invalid_argument);
+
+    // A short free_rows file, then a manifest that is not one
+    std::ofstream(dirname + "/free_rows", std::ios::trunc);
+    EXPECT_THROW(t_snapshot snapshot(dirname), std::invalid_argument);
+    std::ofstream(dirname + "/manifest", std::ios::trunc) << "perspective_snapshot 1\nx";
+    EXPECT_THROW(t_snapshot snapshot(dirname), std::invalid_argument);
+
+    for (const char* name : {"0_data", "0_status", "manifest", "free_rows"}) {
+        std::remove((dirname + "/" + name).c_str());
+    }
+    EXPECT_EQ(rmdir(dirname.c_str()), 0);
+}
+
+TEST(PORT, queued_tables_flatten_like_appended_ones)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "s", "x"},
+        {DTYPE_UINT8, DTYPE_STR, DTYPE_STR, DTYPE_FLOAT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+
+    // Each batch interns its strings in its own order
+    auto batch = [&sch](std::int64_t begin, std::int64_t end, t_tscalar op) {
+        static const char* names[] = {"a", "bb", "ccc", "dddd"};
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = end - 1; i >= begin; --i) {
+            std::string pkey = "k" + std::to_string(i);
+            t_tscalar x = i % 5 == 0 ? mknone() : mktscalar(double(i));
+            data.push_back({op, mktscalar(get_interned_cstr(pkey.c_str())),
+                mktscalar(names[(i + begin) % 4]), x});
+        }
+        auto tbl = std::make_shared<t_data_table>(sch, data);
+        return tbl;
+    };
+
+    auto contents = [](std::shared_ptr<t_gnode> gn) {
+        auto tbl = gn->get_sorted_pkeyed_table();
+        std::vector<std::string> rval;
+        for (t_uindex ridx = 0; ridx < tbl->size(); ++ridx) {
+            for (const char* colname : {"psp_pkey", "s", "x"}) {
+                rval.push_back(tbl->get_const_column(colname)->get_scalar(ridx).to_string());
+            }
+        }
+        return rval;
+    };
+
+    auto moved = t_gnode::build(options);
+    auto copied = t_gnode::build(options);
+
+    // An empty port adopts the table it is sent
+    auto first = batch(0, 50, iop);
+    moved->_send(0, first);
+    EXPECT_EQ(moved->_get_itable(0), first.get());
+    copied->_send(0, *batch(0, 50, iop));
+
+    for (auto tbl : {batch(40, 80, iop), batch(10, 20, dop), batch(15, 30, iop)}) {
+        moved->_send(0, tbl);
+        copied->_send(0, *tbl);
+    }
+    moved->_process();
+    copied->_process();
+    EXPECT_EQ(contents(moved), contents(copied));
+    EXPECT_EQ(moved->mapping_size(), 75);
+
+    for (auto tbl : {batch(70, 90, iop), batch(0, 5, dop)}) {
+        moved->_send(0, tbl);
+        copied->_send(0, *tbl);
+    }
+    moved->_process();
+    copied->_process();
+    EXPECT_EQ(contents(moved), contents(copied));
+    EXPECT_EQ(moved->mapping_size(), 80);
+}
+
+TEST(VOCAB, merges_translate_string_ids)
+{
+    t_schema sch{{"s"}, {DTYPE_STR}};
+    auto strings = [](const t_column& col) {
+        std::vector<std::string> rval;
+        for (t_uindex ridx = 0; ridx < col.size(); ++ridx) {
+            rval.push_back(col.get_scalar(ridx).to_string());
+        }
+        return rval;
+    };
+
+    t_data_table dst(sch, {{mktscalar("x")}, {mktscalar("y")}});
+    t_data_table src(sch, {{mktscalar("z")}, {mktscalar("y")}, {mktscalar("z")}});
+    dst.append(src);
+
+    auto col = dst.get_column("s");
+    EXPECT_EQ(strings(*col), (std::vector<std::string>{"x", "y", "z", "y", "z"}));
+
+    // "" and each distinct string once
+    EXPECT_EQ(col->_get_vocab()->get_vlenidx(), 4);
+
+    // A masked clone carries only the strings of the selected rows
+    t_mask mask(col->size());
+    mask.set(2, true);
+    mask.set(4, true);
+    auto cloned = col->clone(mask);
+    EXPECT_EQ(cloned->get_scalar(0).to_string(), "z");
+    EXPECT_EQ(cloned->get_scalar(1).to_string(), "z");
+    EXPECT_EQ(cloned->_get_vocab()->get_vlenidx(), 2);
+
+    // The id held by a null cell is not translated, even when out of range
+    t_data_table nulls(sch, {{mktscalar("w")}, {mknull(DTYPE_STR)}});
+    auto ncol = nulls.get_column("s");
+    *(ncol->get_nth<t_uindex>(1)) = 1000;
+
+    t_data_table appended(sch, {{mktscalar("x")}});
+    appended.append(nulls);
+    auto acol = appended.get_column("s");
+    EXPECT_EQ(acol->get_scalar(1).to_string(), "w");
+    EXPECT_FALSE(acol->is_valid(2));
+    EXPECT_EQ(*(acol->get_nth<t_uindex>(2)), 0);
+
+    t_mask nmask(ncol->size());
+    nmask.set(1, true);
+    auto ncloned = ncol->clone(nmask);
+    EXPECT_FALSE(ncloned->is_valid(0));
+    EXPECT_EQ(*(ncloned->get_nth<t_uindex>(0)), 0);
+
+    t_column copied(*ncol);
+    copied.init();
+    copied.copy(ncol.get(), std::vector<t_uindex>{1, 0}, 0);
+    EXPECT_FALSE(copied.is_valid(0));
+    EXPECT_EQ(copied.get_scalar(1).to_string(), "w");
+}
+
+TEST(GSTATE, scatter_writes_valid_and_cleared_cells)
+{
+    t_schema tblschema{{"i", "b", "s"}, {DTYPE_INT32, DTYPE_BOOL, DTYPE_STR}};
+    t_schema sch{{"psp_op", "psp_pkey", "i", "b", "s"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT32, DTYPE_BOOL, DTYPE_STR}};
+
+    auto update = [&sch](std::int64_t begin, std::int64_t end, std::int32_t shift) {
+        static const char* names[] = {"a", "bb", "ccc"};
+        std::vector<std::vector<t_tscalar>> data;
+        for (std::int64_t i = begin; i < end; ++i) {
+            data.push_back({iop, mktscalar(i), mktscalar(std::int32_t(i) + shift),
+                mktscalar(i % 2 == 0), mktscalar(names[(i + shift) % 3])});
+        }
+        return std::make_shared<t_data_table>(sch, data);
+    };
+
+    auto contents = [](t_gstate& state) {
+        auto tbl = state.get_pkeyed_table();
+        std::vector<std::string> rval;
+        for (t_uindex ridx = 0; ridx < tbl->size(); ++ridx) {
+            for (const char* colname : {"psp_pkey", "i", "b", "s"}) {
+                rval.push_back(tbl->get_const_column(colname)->get_scalar(ridx).to_string());
+            }
+        }
+        return rval;
+    };
+
+    t_gstate state(tblschema, sch);
+    state.init();
+    state.update_history(update(0, 6, 0).get());
+
+    auto tbl = update(2, 8, 1);
+    tbl->get_column("i")->clear(0);
+    tbl->get_column("s")->clear(1);
+    tbl->get_column("i")->unset(2);
+    tbl->get_column("s")->unset(3);
+    state.update_history(tbl.get());
+
+    // Rows 2 and 3 keep their invalid cells, rows 4 and 5 null their cleared ones
+    EXPECT_EQ(contents(state),
+        (std::vector<std::string>{"0", "0", "1", "a", "1", "1", "0", "bb", "2", "2", "1", "a",
+            "3", "4", "0", "a", "4", "null", "1", "ccc", "5", "6", "0", "null", "6", "7", "1",
+            "bb", "7", "8", "0", "ccc"}));
+}
+
+TEST(POOL, concurrent_producers_overlap_processing)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"}, {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+
+    t_pool pool;
+    auto gn = t_gnode::build(options);
+    auto gnode_id = pool.register_gnode(gn.get());
+    auto ctx0 = t_ctx0::build(sch, t_config{{"x"}});
+    gn->register_context("ctx0", ctx0);
+
+    // Each producer owns a range of keys and rewrites it batch by batch
+    const std::int64_t nproducers = 4;
+    const std::int64_t nbatches = 50;
+    const std::int64_t nkeys = 100;
+    std::atomic<std::int64_t> running(nproducers);
+    std::vector<std::thread> producers;
+    for (std::int64_t p = 0; p < nproducers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (std::int64_t b = 0; b < nbatches; ++b) {
+                std::vector<std::vector<t_tscalar>> data;
+                for (std::int64_t k = p * nkeys; k < (p + 1) * nkeys; ++k) {
+                    data.push_back({iop, mktscalar(k), mktscalar(double(b))});
+                }
+                if (b % 2 == 0) {
+                    pool.send(gnode_id, 0, std::make_shared<t_data_table>(sch, data));
+                } else {
+                    pool.send(gnode_id, 0, t_data_table(sch, data));
+                }
+            }
+            --running;
+        });
+    }
+
+    while (running.load() > 0) {
+        pool.flush();
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    pool.flush();
+
+    EXPECT_FALSE(gn->has_staged());
+    EXPECT_EQ(gn->mapping_size(), t_uindex(nproducers * nkeys));
+    EXPECT_EQ(ctx0->get_row_count(), nproducers * nkeys);
+
+    // Every key holds its producer's last batch
+    auto x = gn->get_table()->get_const_column("x");
+    for (t_uindex ridx = 0; ridx < x->size(); ++ridx) {
+        EXPECT_EQ(*x->get_nth<double>(ridx), double(nbatches - 1));
+    }
+}
+
+TEST(PIVOT, time_buckets)
+{
+    // Milliseconds since the epoch, as the bindings store times
+    auto at = [](std::int32_t y, std::int32_t m, std::int32_t d, std::int32_t h,
+                  std::int32_t mi) {
+        return mktscalar(t_time(to_gmtime(y, m, d, h, mi, 0) * 1000));
+    };
+    auto bucket = [](t_pivot_mode mode, const t_tscalar& value) {
+        return t_pivot("t", mode).bucket(value);
+    };
+
+    // Thursday 2024-03-14 13:45:10.5
+    t_tscalar t = mktscalar(t_time(at(2024, 3, 14, 13, 45).get<std::int64_t>() + 10500));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_MIN, t), at(2024, 3, 14, 13, 45));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_HOUR, t), at(2024, 3, 14, 13, 0));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_DAY, t), at(2024, 3, 14, 0, 0));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_WEEK, t), at(2024, 3, 11, 0, 0));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_MONTH, t), at(2024, 3, 1, 0, 0));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_YEAR, t), at(2024, 1, 1, 0, 0));
+
+    // Before the epoch
+    t_tscalar old = at(1969, 12, 31, 23, 59);
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_DAY, old), at(1969, 12, 31, 0, 0));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_WEEK, old), at(1969, 12, 29, 0, 0));
+
+    // Dates keep 0-based months
+    t_tscalar d = mktscalar(t_date(2024, 2, 14));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_DAY, d), d);
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_WEEK, d), mktscalar(t_date(2024, 2, 11)));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_MONTH, d), mktscalar(t_date(2024, 2, 1)));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_YEAR, d), mktscalar(t_date(2024, 0, 1)));
+    EXPECT_EQ(bucket(PIVOT_MODE_TIME_BUCKET_MONTH, mknone()), mknone());
+
+    // Two buckets of the same column in one context, kept up to date
+    t_schema sch{{"psp_op", "psp_pkey", "t", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_TIME, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{t_pivot("t", PIVOT_MODE_TIME_BUCKET_MONTH),
+                     t_pivot("t", PIVOT_MODE_TIME_BUCKET_DAY)},
+        {t_aggspec("sum_x", AGGTYPE_SUM, "x")}};
+    auto ctx = t_ctx1::build(sch, cfg);
+    gn->register_context("ctx", ctx);
+
+    auto row = [&at](std::int64_t pkey, std::int32_t m, std::int32_t d, std::int32_t h,
+                   std::int64_t x) {
+        return std::vector<t_tscalar>{
+            iop, mktscalar(pkey), at(2024, m, d, h, 0), mktscalar(x)};
+    };
+    gn->_send_and_process(t_data_table(sch,
+        {row(0, 1, 5, 1, 1), row(1, 1, 5, 23, 2), row(2, 1, 20, 0, 4), row(3, 2, 1, 0, 8)}));
+
+    // Row 1 moves within its day and row 2 to another month
+    gn->_send_and_process(t_data_table(sch, {row(1, 1, 5, 2, 16), row(2, 2, 1, 12, 32)}));
+
+    ctx->set_depth(2);
+    auto out = ctx->get_data(0, ctx->get_row_count(), 0, ctx->get_column_count());
+    auto day = [&at](std::int32_t m, std::int32_t d) { return at(2024, m, d, 0, 0); };
+    std::vector<t_tscalar> expected{mktscalar("Grand Aggregate"), mktscalar<std::int64_t>(57),
+        day(1, 1), mktscalar<std::int64_t>(17), day(1, 5), mktscalar<std::int64_t>(17),
+        day(2, 1), mktscalar<std::int64_t>(40), day(2, 1), mktscalar<std::int64_t>(40)};
+    EXPECT_EQ(out, expected);
+}
+
+TEST(FILTER, expressions)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "bid", "ask", "side", "live"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT32, DTYPE_FLOAT64, DTYPE_STR, DTYPE_BOOL}};
+    auto row = [](std::int64_t pkey, t_tscalar bid, double ask, const char* side, bool live) {
+        return std::vector<t_tscalar>{
+            iop, mktscalar(pkey), bid, mktscalar(ask), mktscalar(side), mktscalar(live)};
+    };
+    auto bid = [](std::int32_t v) { return mktscalar(v); };
+    t_data_table tbl(sch,
+        {row(0, bid(10), 12, "buy", true), row(1, bid(20), 21, "sell", false),
+            row(2, mknull(DTYPE_INT32), 30, "buy", true), row(3, bid(40), 41, "sell", true)});
+
+    auto rows = [&tbl](const std::string& expr) {
+        t_mask mask = t_filter_expr(expr).filter(tbl);
+        std::vector<t_uindex> rval;
+        for (t_uindex idx = 0; idx < mask.size(); ++idx) {
+            if (mask.get(idx)) {
+                rval.push_back(idx);
+            }
+        }
+        return rval;
+    };
+
+    using t_rows = std::vector<t_uindex>;
+    EXPECT_EQ(rows("(bid + ask) / 2 > 15 and side == 'sell'"), (t_rows{1, 3}));
+    EXPECT_EQ(rows("!live or \"bid\" * 2 < ask"), (t_rows{1}));
+    EXPECT_EQ(rows("side < 'sell' and -bid < -5"), (t_rows{0}));
+    EXPECT_EQ(rows("live == true and 2 * 3 > 5"), (t_rows{0, 2, 3}));
+    EXPECT_EQ(rows("side != 'hold' and ask % 10 = 1"), (t_rows{1, 3}));
+
+    // Nulls are unknown rather than false
+    EXPECT_EQ(rows("bid is null"), (t_rows{2}));
+    EXPECT_EQ(rows("bid > 0 or ask > 0"), (t_rows{0, 1, 2, 3}));
+    EXPECT_EQ(rows("not bid > 15"), (t_rows{0}));
+
+    // Applied to the initial rows and to every update
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"bid", "side"}};
+    cfg.set_filter_expr("bid >= 20 and (side == 'sell' or ask - bid > 5)", sch);
+    auto ctx0 = t_ctx0::build(sch, cfg);
+    gn->register_context("ctx0", ctx0);
+
+    gn->_send_and_process(tbl);
+    EXPECT_EQ(ctx0->get_row_count(), 2);
+
+    gn->_send_and_process(t_data_table(
+        sch, {row(0, bid(25), 31, "buy", true), row(3, bid(40), 42, "buy", true)}));
+    auto out = ctx0->get_data(0, ctx0->get_row_count(), 0, ctx0->get_column_count());
+    EXPECT_EQ(out, (std::vector<t_tscalar>{
+                       bid(25), mktscalar("buy"), bid(20), mktscalar("sell")}));
+
+    // Errors are reported when the expression is set
+    t_config bad_cfg{{"bid"}};
+    EXPECT_THROW(bad_cfg.set_filter_expr("bid > (1", sch), std::invalid_argument);
+    EXPECT_THROW(bad_cfg.set_filter_expr("price > 1", sch), std::invalid_argument);
+    EXPECT_THROW(bad_cfg.set_filter_expr("side + 1 > 2", sch), std::invalid_argument);
+    EXPECT_THROW(bad_cfg.set_filter_expr("bid + 1", sch), std::invalid_argument);
+    EXPECT_EQ(bad_cfg.get_fmode(), FMODE_SIMPLE_CLAUSES);
+}
+
+TEST(FILTER, in_and_not_in)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "sym", "qty"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_INT32}};
+    auto row = [](std::int64_t pkey, t_tscalar sym, std::int32_t qty) {
+        return std::vector<t_tscalar>{iop, mktscalar(pkey), sym, mktscalar(qty)};
+    };
+    t_data_table tbl(sch,
+        {row(0, mktscalar("a"), 1), row(1, mktscalar("b"), 2), row(2, mknull(DTYPE_STR), 3),
+            row(3, mktscalar("c"), 4), row(4, mktscalar("a"), 5)});
+
+    // Most of the bag is not in the column's vocabulary
+    std::vector<t_tscalar> syms;
+    for (std::int32_t i = 0; i < 5000; ++i) {
+        syms.push_back(mktscalar(get_interned_cstr(("id" + std::to_string(i)).c_str())));
+    }
+    syms.push_back(mktscalar("a"));
+    syms.push_back(mktscalar("c"));
+    std::vector<t_tscalar> qtys{mktscalar(2.0), mktscalar<std::int64_t>(4), mknone()};
+
+    auto rows = [&tbl](t_filter_op combiner, const std::vector<t_fterm>& fterms) {
+        t_mask mask = tbl.filter_cpp(combiner, fterms);
+        std::vector<t_uindex> rval;
+        for (t_uindex idx = 0; idx < mask.size(); ++idx) {
+            if (mask.get(idx)) {
+                rval.push_back(idx);
+            }
+        }
+        return rval;
+    };
+    auto term = [](const std::string& colname, t_filter_op op,
+                    const std::vector<t_tscalar>& bag, bool negated = false) {
+        return t_fterm(colname, op, mknone(), bag, negated, false);
+    };
+
+    using t_rows = std::vector<t_uindex>;
+    EXPECT_EQ(rows(FILTER_OP_AND, {term("sym", FILTER_OP_IN, syms)}), (t_rows{0, 3, 4}));
+    EXPECT_EQ(rows(FILTER_OP_AND, {term("sym", FILTER_OP_NOT_IN, syms)}), (t_rows{1}));
+    EXPECT_EQ(rows(FILTER_OP_AND, {term("qty", FILTER_OP_IN, qtys)}), (t_rows{1, 3}));
+    EXPECT_EQ(rows(FILTER_OP_AND, {term("qty", FILTER_OP_IN, qtys, true)}), (t_rows{0, 2, 4}));
+    EXPECT_EQ(rows(FILTER_OP_AND,
+                  {term("sym", FILTER_OP_IN, syms), term("qty", FILTER_OP_NOT_IN, qtys)}),
+        (t_rows{0, 4}));
+    EXPECT_EQ(rows(FILTER_OP_AND, {term("sym", FILTER_OP_IN, {})}), (t_rows{}));
+
+    // Null cells are in no bag
+    EXPECT_EQ(rows(FILTER_OP_OR,
+                  {term("sym", FILTER_OP_NOT_IN, syms), term("qty", FILTER_OP_IN, qtys)}),
+        (t_rows{1, 2, 3}));
+}
+
+TEST(FILTER, cached_verdicts_follow_updates)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "g", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    std::vector<t_fterm> fterms{t_fterm("x", FILTER_OP_GT, mktscalar<std::int64_t>(10), {})};
+    t_config cfg0{{"g", "x"}, FILTER_OP_AND, fterms};
+    t_config cfg1{{"g"}, {t_aggspec("sum_x", AGGTYPE_SUM, "x")}, FILTER_OP_AND, fterms};
+    t_config cfg2{{"g"}, {"g"}, {t_aggspec("sum_x", AGGTYPE_SUM, "x")}, TOTALS_BEFORE,
+        FILTER_OP_AND, fterms};
+    auto ctx0 = t_ctx0::build(sch, cfg0);
+    auto ctx1 = t_ctx1::build(sch, cfg1);
+    auto ctx2 = t_ctx2::build(sch, cfg2);
+    gn->register_context("ctx0", ctx0);
+    gn->register_context("ctx1", ctx1);
+    gn->register_context("ctx2", ctx2);
+
+    auto step = [&gn, &sch](const std::vector<std::pair<std::int64_t, std::int64_t>>& rows,
+                    t_tscalar op) {
+        std::vector<std::vector<t_tscalar>> data;
+        for (const auto& row : rows) {
+            data.push_back({op, mktscalar(row.first), mktscalar(row.first % 3),
+                mktscalar(row.second)});
+        }
+        gn->_send_and_process(t_data_table(sch, data));
+    };
+
+    std::vector<std::pair<std::int64_t, std::int64_t>> rows;
+    for (std::int64_t i = 0; i < 10; ++i) {
+        rows.push_back({i, i * 3});
+    }
+    step(rows, iop);
+
+    // Rows leave and join the filter, and are deleted inside and outside it
+    step({{5, 1}, {1, 50}}, iop);
+    step({{9, 0}, {0, 0}}, dop);
+    step({{8, 0}}, dop);
+
+    // New rows reuse the erased ones' indices, then move across the filter
+    step({{20, 50}, {21, 100}}, iop);
+    step({{20, 30}, {21, 2}}, iop);
+
+    // Contexts registered now filter the final state from scratch
+    auto fresh0 = t_ctx0::build(sch, cfg0);
+    auto fresh1 = t_ctx1::build(sch, cfg1);
+    auto fresh2 = t_ctx2::build(sch, cfg2);
+    gn->register_context("fresh0", fresh0);
+    gn->register_context("fresh1", fresh1);
+    gn->register_context("fresh2", fresh2);
+
+    EXPECT_EQ(ctx0->get_row_count(), 5);
+    EXPECT_EQ(ctx0->get_data(0, 5, 0, 2), fresh0->get_data(0, 5, 0, 2));
+    ctx1->set_depth(1);
+    fresh1->set_depth(1);
+    EXPECT_EQ(ctx1->get_data(0, ctx1->get_row_count(), 0, 2),
+        fresh1->get_data(0, fresh1->get_row_count(), 0, 2));
+    ctx2->set_depth(HEADER_ROW, 1);
+    fresh2->set_depth(HEADER_ROW, 1);
+    EXPECT_EQ(ctx2->get_data(0, ctx2->get_row_count(), 0, ctx2->get_column_count()),
+        fresh2->get_data(0, fresh2->get_row_count(), 0, fresh2->get_column_count()));
+}
+
+TEST(FILTER, indexed_columns)
+{
+    t_schema tblschema{{"sym", "px", "qty"}, {DTYPE_STR, DTYPE_FLOAT64, DTYPE_INT32}};
+    t_schema sch{{"psp_op", "psp_pkey", "sym", "px", "qty"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_FLOAT64, DTYPE_INT32}};
+    t_gstate state(tblschema, sch);
+    state.init();
+    state.create_index("sym");
+    state.create_index("px");
+
+    static const char* syms[] = {"a", "b", "c"};
+    auto step = [&state, &sch](const std::vector<std::vector<t_tscalar>>& data) {
+        t_data_table tbl(sch, data);
+        state.update_history(&tbl);
+    };
+    auto row = [](t_tscalar op, std::int64_t pkey, const char* sym, double px) {
+        return std::vector<t_tscalar>{op, mktscalar(pkey), mktscalar(sym), mktscalar(px),
+            mktscalar(static_cast<std::int32_t>(pkey % 7))};
+    };
+
+    std::vector<std::vector<t_tscalar>> data;
+    for (std::int64_t i = 0; i < 1000; ++i) {
+        data.push_back(row(iop, i, syms[i % 3], i * 0.5));
+    }
+    step(data);
+
+    auto term = [](const std::string& colname, t_filter_op op, t_tscalar threshold,
+                    const std::vector<t_tscalar>& bag = {}) {
+        return t_fterm(colname, op, threshold, bag);
+    };
+    std::vector<std::vector<t_fterm>> filters{
+        {term("sym", FILTER_OP_EQ, mktscalar("b"))},
+        {term("sym", FILTER_OP_EQ, mktscalar("zzz"))},
+        {term("sym", FILTER_OP_IN, mknone(), {mktscalar("a"), mktscalar("zzz")})},
+        {term("px", FILTER_OP_LT, mktscalar(10.0))},
+        {term("px", FILTER_OP_GTEQ, mktscalar<std::int64_t>(30))},
+        {term("px", FILTER_OP_IN, mknone(), {mktscalar(1.5), mktscalar(40.0)})},
+        {term("sym", FILTER_OP_EQ, mktscalar("c")), term("px", FILTER_OP_LTEQ, mktscalar(20.0)),
+            term("qty", FILTER_OP_GT, mktscalar<std::int32_t>(2))}};
+
+    // Indexed masks match a scan of the master table
+    auto check = [&state, &filters]() {
+        for (const auto& fterms : filters) {
+            t_config cfg{{"sym"}, FILTER_OP_AND, fterms};
+            t_mask mask;
+            ASSERT_TRUE(state.filter_indexed(cfg, mask));
+            t_mask expected = state.get_table()->filter_cpp(FILTER_OP_AND, fterms);
+            ASSERT_EQ(mask.size(), expected.size());
+            for (t_uindex idx = 0; idx < mask.size(); ++idx) {
+                EXPECT_EQ(mask.get(idx), expected.get(idx)) << fterms[0].get_expr() << idx;
+            }
+        }
+    };
+    check();
+
+    // Updates, deletes and inserts into the erased rows catch up incrementally
+    data.clear();
+    for (std::int64_t i = 0; i < 10; ++i) {
+        data.push_back(row(iop, i, syms[(i + 1) % 3], 100 - i * 0.5));
+        data.push_back(row(dop, 50 + i, "a", 0));
+    }
+    step(data);
+    step({row(iop, 200, "zzz", 1.5), row(iop, 201, "b", -1)});
+    check();
+
+    // Terms without an index, or that it cannot narrow, leave it unused
+    t_mask mask;
+    EXPECT_FALSE(state.filter_indexed(
+        t_config{{"sym"}, FILTER_OP_AND, {term("px", FILTER_OP_NE, mktscalar(1.5))}}, mask));
+    EXPECT_FALSE(state.filter_indexed(
+        t_config{{"sym"}, FILTER_OP_AND, {term("qty", FILTER_OP_EQ, mktscalar(1))}}, mask));
+
+    // New views on an indexed gnode start from the indexed mask
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+    gn->create_index("sym");
+    data.clear();
+    for (std::int64_t i = 0; i < 10; ++i) {
+        data.push_back(row(iop, i, syms[i % 3], i));
+    }
+    gn->_send_and_process(t_data_table(sch, data));
+    auto ctx = t_ctx0::build(sch, t_config{{"sym", "px"}, FILTER_OP_AND, filters[0]});
+    gn->register_context("ctx", ctx);
+    EXPECT_EQ(ctx->get_data(0, 10, 0, 2),
+        (std::vector<t_tscalar>{mktscalar("b"), mktscalar(1.0), mktscalar("b"), mktscalar(4.0),
+            mktscalar("b"), mktscalar(7.0)}));
+}
+
+TEST(FILTER, zone_maps)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "t", "px"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_FLOAT64}};
+    std::vector<std::vector<t_tscalar>> data;
+    for (std::int64_t i = 0; i < 20; ++i) {
+        data.push_back({iop, mktscalar(i), mktscalar(i * 10), mktscalar(i * 0.5)});
+    }
+    data[5][3] = mktscalar(std::numeric_limits<double>::quiet_NaN());
+    data[9][3] = mknull(DTYPE_FLOAT64);
+    t_data_table tbl(sch, data);
+
+    // Blocks of four rows
+    t_zone_maps zone_maps(4);
+    auto zones = zone_maps.get_zones(tbl, "px");
+    ASSERT_EQ(zones.size(), 5);
+    EXPECT_EQ(zones[1].m_min, mktscalar(2.0));
+    EXPECT_EQ(zones[1].m_max, mktscalar(3.5));
+    EXPECT_EQ(zones[1].m_nvalid, 4);
+    EXPECT_EQ(zones[2].m_nnull, 1);
+
+    auto rows = [](const t_mask& mask) {
+        std::vector<t_uindex> rval;
+        for (t_uindex idx = 0; idx < mask.size(); ++idx) {
+            if (mask.get(idx)) {
+                rval.push_back(idx);
+            }
+        }
+        return rval;
+    };
+    auto term = [](const std::string& colname, t_filter_op op, t_tscalar threshold,
+                    const std::vector<t_tscalar>& bag = {}) {
+        return t_fterm(colname, op, threshold, bag);
+    };
+
+    // Skipping blocks never changes the result of a full scan
+    std::vector<std::vector<t_fterm>> filters{{term("t", FILTER_OP_GTEQ, mktscalar(175))},
+        {term("t", FILTER_OP_LT, mktscalar<std::int32_t>(30))},
+        {term("t", FILTER_OP_IN, mknone(), {mktscalar(50), mktscalar(1000)})},
+        {term("px", FILTER_OP_IS_NULL, mknone())},
+        {term("px", FILTER_OP_EQ, mktscalar(3.0)), term("t", FILTER_OP_GT, mktscalar(0))}};
+    for (const auto& fterms : filters) {
+        t_mask mask;
+        ASSERT_TRUE(zone_maps.filter(tbl, fterms, mask));
+        EXPECT_EQ(rows(mask), rows(tbl.filter_cpp(FILTER_OP_AND, fterms)));
+    }
+
+    t_mask mask;
+    EXPECT_FALSE(zone_maps.filter(tbl, {term("t", FILTER_OP_GT, mktscalar(-1))}, mask));
+    EXPECT_FALSE(zone_maps.filter(tbl, {term("t", FILTER_OP_NE, mktscalar(10))}, mask));
+
+    // Written and appended rows are summarized again when marked
+    auto range = [](std::int64_t min, std::int64_t max) {
+        return std::make_pair(mktscalar(min), mktscalar(max));
+    };
+    auto t = tbl.get_column("t");
+    t->set_nth<std::int64_t>(2, -5);
+    tbl.extend(21);
+    tbl.get_column("psp_op")->set_nth<std::uint8_t>(20, OP_INSERT);
+    tbl.get_column("psp_pkey")->set_nth<std::int64_t>(20, 20);
+    tbl.get_column("px")->set_nth<double>(20, 0);
+    t->set_nth<std::int64_t>(20, 500);
+    zone_maps.mark({2, 20});
+    EXPECT_EQ(zone_maps.get_min_max(tbl, "t"), range(-5, 500));
+
+    // The t_gstate's maps follow its updates and deletes
+    t_gstate state(t_schema{{"t", "px"}, {DTYPE_INT64, DTYPE_FLOAT64}}, sch);
+    state.init();
+    state.update_history(&tbl);
+    EXPECT_EQ(state.get_min_max("t"), range(-5, 500));
+    t_data_table update(sch, {{dop, mktscalar<std::int64_t>(2), mknone(), mknone()}});
+    state.update_history(&update);
+    EXPECT_EQ(state.get_min_max("t"), range(0, 500));
+}
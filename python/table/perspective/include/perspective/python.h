@@ -14,7 +14,9 @@
 #include <perspective/binding.h>
 #include <perspective/data_table.h>
 #include <perspective/column.h>
+#include <perspective/csv.h>
 #include <perspective/gnode.h>
+#include <perspective/snapshot.h>
 #include <iostream>
 
 
@@ -28,6 +30,8 @@ void _fill_col(std::vector<T>& dcol, std::shared_ptr<perspective::t_column> col)
 template<typename T>
 void _fill_col_np(np::ndarray& dcol, std::shared_ptr<perspective::t_column> col);
 
+void _fill_col_str_np(np::ndarray& dcol, std::shared_ptr<perspective::t_column> col);
+
 
 void _fill_data_single_column(perspective::t_data_table& tbl,
                               const std::string& colname_i,
@@ -39,7 +43,31 @@ void _fill_data_single_column_np(perspective::t_data_table& tbl,
                                  np::ndarray& data_cols_i,
                                  perspective::t_dtype col_type);
 
+void _fill_data_single_column_categorical(perspective::t_data_table& tbl,
+                                          const std::string& colname_i,
+                                          np::ndarray& codes,
+                                          py::list& categories);
+
+void _fill_data_single_column_mask(perspective::t_data_table& tbl,
+                                   const std::string& colname_i,
+                                   np::ndarray& mask);
+
 np::ndarray _get_as_numpy(perspective::t_data_table& tbl, const std::string& colname_i);
+
+np::ndarray _get_status_as_numpy(perspective::t_data_table& tbl, const std::string& colname_i);
+
+py::list _get_vocab(perspective::t_data_table& tbl, const std::string& colname_i);
+
+perspective::t_uindex _get_column_version(perspective::t_data_table& tbl,
+                                          const std::string& colname_i);
+
+py::list _get_csv_schema(const perspective::t_csv_reader& reader);
+
+py::list _get_snapshot_schema(const perspective::t_snapshot& snapshot);
+
+void _save_snapshot(const perspective::t_data_table& tbl, const std::string& dirname);
+
+py::tuple _get_view_column(perspective::t_ctx0& ctx, const std::string& colname);
 }
 }
 
@@ -100,10 +128,39 @@ BOOST_PYTHON_MODULE(libbinding)
         // .def("load_column", _fill_data_single_column)
         .def("load_column", static_cast<void (*)(perspective::t_data_table& tbl, const std::string& colname_i, py::list& data_cols_i, perspective::t_dtype col_type)>(_fill_data_single_column))
         .def("load_column", static_cast<void (*)(perspective::t_data_table& tbl, const std::string& colname_i, np::ndarray& data_cols_i, perspective::t_dtype col_type)>(_fill_data_single_column_np))
+        .def("load_categorical", _fill_data_single_column_categorical)
+        .def("load_mask", _fill_data_single_column_mask)
         .def("get_column", _get_as_numpy)
+        .def("get_column_status", _get_status_as_numpy)
+        .def("get_column_vocab", _get_vocab)
+        .def("get_column_version", _get_column_version)
         .def("add_column", &perspective::t_data_table::add_column, py::return_value_policy<py::reference_existing_object>())
     ;
 
+    /******************************************************************************
+     *
+     * t_csv_reader
+     */
+    py::class_<perspective::t_csv_reader, boost::noncopyable>("t_csv_reader", py::init<std::string>())
+        .def("get_schema", &perspective::t_csv_reader::get_schema, py::return_value_policy<py::copy_const_reference>())
+        .def("get_columns", _get_csv_schema)
+        .def("num_rows", &perspective::t_csv_reader::num_rows)
+        .def("fill", &perspective::t_csv_reader::fill)
+    ;
+
+    /******************************************************************************
+     *
+     * t_snapshot
+     */
+    py::class_<perspective::t_snapshot>("t_snapshot", py::init<std::string>())
+        .def("get_schema", &perspective::t_snapshot::get_schema, py::return_value_policy<py::copy_const_reference>())
+        .def("get_columns", _get_snapshot_schema)
+        .def("num_rows", &perspective::t_snapshot::num_rows)
+        .def("load", static_cast<void (perspective::t_snapshot::*)(perspective::t_data_table&) const>(&perspective::t_snapshot::load))
+        .def("save", _save_snapshot)
+        .staticmethod("save")
+    ;
+
     /******************************************************************************
      *
      * t_schema
@@ -138,7 +195,7 @@ BOOST_PYTHON_MODULE(libbinding)
      *
      * t_gnode
      */
-    py::class_<perspective::t_gnode>("t_gnode", py::init<perspective::t_schema, perspective::t_schema>())
+    py::class_<perspective::t_gnode, boost::noncopyable>("t_gnode", py::init<perspective::t_schema, perspective::t_schema>())
         .def(py::init<
             perspective::t_gnode_processing_mode,
             const perspective::t_schema&,
@@ -165,6 +222,7 @@ BOOST_PYTHON_MODULE(libbinding)
         .def("get_step_delta", &perspective::t_ctx0::get_step_delta)
         .def("get_cell_delta", &perspective::t_ctx0::get_cell_delta)
         .def("get_column_names", &perspective::t_ctx0::get_column_names)
+        .def("get_column_numpy", _get_view_column)
         .def("unity_get_row_data", &perspective::t_ctx0::unity_get_row_data)
         .def("unity_get_column_data", &perspective::t_ctx0::unity_get_column_data)
         .def("unity_get_row_path", &perspective::t_ctx0::unity_get_row_path)
@@ -256,7 +314,7 @@ BOOST_PYTHON_MODULE(libbinding)
     py::class_<perspective::t_pool, boost::noncopyable>("t_pool", py::no_init)
         .def("register_gnode", &perspective::t_pool::register_gnode)
         .def("process", &perspective::t_pool::_process)
-        .def("send", &perspective::t_pool::send)
+        .def("send", static_cast<void (perspective::t_pool::*)(perspective::t_uindex, perspective::t_uindex, const perspective::t_data_table&)>(&perspective::t_pool::send))
         .def("epoch", &perspective::t_pool::epoch)
         .def("unregister_gnode", &perspective::t_pool::unregister_gnode)
         // .def("set_update_delegate", &perspective::t_pool::set_update_delegate)
@@ -82,14 +82,16 @@ get_numpy_typenum_from_dtype(t_dtype dtype)
         // {
         //     return np::dtype::get_builtin<t_str>();
         // }
-        // case DTYPE_TIME:
-        // {
-        //     return NPY_DATETIME;
-        // }
-        // case DTYPE_DATE:
-        // {
-        //     return NPY_UINT32;
-        // }
+        case DTYPE_TIME:
+        {
+            // t_time is stored as int64 milliseconds since epoch
+            return np::dtype(py::object("datetime64[ms]"));
+        }
+        case DTYPE_DATE:
+        {
+            // packed year/month/day, see t_date
+            return np::dtype::get_builtin<std::uint32_t>();
+        }
         case DTYPE_BOOL:
         {
             return np::dtype::get_builtin<bool>();
@@ -24,6 +24,10 @@
 #include <codecvt>
 #include <boost/optional.hpp>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
 
 namespace perspective {
 namespace binding {
@@ -57,17 +61,173 @@ void _fill_col(std::vector<T>& dcol, std::shared_ptr<perspective::t_column> col)
     }
 }
 
+/**
+ * Copies a numpy array into a column. Arrays that are contiguous and of the
+ * column's storage type are copied straight into the column's t_lstore;
+ * anything else is converted by numpy first. NaNs are marked invalid.
+ */
 template<typename T>
 void _fill_col_np(np::ndarray& dcol, std::shared_ptr<perspective::t_column>col)
 {
-    perspective::t_uindex nrows = col->size();
-    for (auto i = 0; i < nrows; ++i)
+    perspective::t_uindex nrows = std::min<perspective::t_uindex>(col->size(), dcol.shape(0));
+    np::dtype dtype = np::dtype::get_builtin<T>();
+
+    np::ndarray arr = dcol;
+    if (!(arr.get_dtype() == dtype)) {
+        arr = dcol.astype(dtype);
+    }
+
+    T* out = col->get_nth<T>(0);
+    if (arr.get_flags() & np::ndarray::C_CONTIGUOUS) {
+        std::memcpy(out, arr.get_data(), nrows * sizeof(T));
+    } else {
+        Py_intptr_t stride = arr.strides(0);
+        const char* base = arr.get_data();
+        for (perspective::t_uindex i = 0; i < nrows; ++i)
+        {
+            out[i] = *reinterpret_cast<const T*>(base + i * stride);
+        }
+    }
+
+    if (!col->is_status_enabled()) {
+        return;
+    }
+
+    col->valid_raw_fill();
+    if (std::is_floating_point<T>::value) {
+        for (perspective::t_uindex i = 0; i < nrows; ++i)
+        {
+            if (std::isnan(out[i])) {
+                col->set_valid(i, false);
+            }
+        }
+    }
+}
+
+/**
+ * Interns an object array of strings into a column in one pass. Repeated
+ * Python string objects are interned once; None and non-strings are
+ * marked invalid.
+ */
+void _fill_col_str_np(np::ndarray& dcol, std::shared_ptr<perspective::t_column> col)
+{
+    perspective::t_uindex nrows = std::min<perspective::t_uindex>(col->size(), dcol.shape(0));
+    np::ndarray arr = dcol;
+    if (!(arr.get_dtype() == np::dtype(py::object("O")))) {
+        arr = dcol.astype(np::dtype(py::object("O")));
+    }
+
+    Py_intptr_t stride = arr.strides(0);
+    const char* base = arr.get_data();
+    perspective::t_uindex* out = col->get_nth<perspective::t_uindex>(0);
+    bool has_status = col->is_status_enabled();
+    std::unordered_map<PyObject*, perspective::t_uindex> interned;
+
+    for (perspective::t_uindex i = 0; i < nrows; ++i)
     {
-        // auto elem = dcol[i];
-        auto elem = reinterpret_cast<T *>(dcol.get_data()+(i*sizeof(T)));
-        // T elem = py::extract<T>(dcol[i]);
-        // std::cout << *elem << std::endl;
-        col->set_nth(i, *elem);
+        PyObject* obj = *reinterpret_cast<PyObject* const*>(base + i * stride);
+        if (obj == Py_None || !PyUnicode_Check(obj)) {
+            if (has_status) {
+                col->clear(i);
+            } else {
+                out[i] = col->get_interned("");
+            }
+            continue;
+        }
+
+        auto iter = interned.find(obj);
+        if (iter == interned.end()) {
+            iter = interned.emplace(obj, col->get_interned(PyUnicode_AsUTF8(obj))).first;
+        }
+
+        out[i] = iter->second;
+        if (has_status) {
+            col->set_valid(i, true);
+        }
+    }
+}
+
+/**
+ * Loads a pandas categorical from its codes and categories. Each category
+ * is interned once and rows are mapped through their codes; code -1 is
+ * missing. Raises TypeError unless the column holds strings and IndexError
+ * for a code past the categories, before anything is written.
+ */
+void _fill_data_single_column_categorical(perspective::t_data_table& tbl,
+                                          const std::string& colname_i,
+                                          np::ndarray& codes,
+                                          py::list& categories)
+{
+    std::shared_ptr<perspective::t_column> col = tbl.get_column(colname_i);
+    if (col->get_dtype() != perspective::DTYPE_STR) {
+        PyErr_SetString(PyExc_TypeError,
+                        ("Cannot load a categorical into non-string column " + colname_i).c_str());
+        py::throw_error_already_set();
+    }
+
+    np::ndarray arr = codes.astype(np::dtype::get_builtin<std::int64_t>());
+    perspective::t_uindex nrows = std::min<perspective::t_uindex>(col->size(), arr.shape(0));
+    Py_intptr_t stride = arr.strides(0);
+    const char* base = arr.get_data();
+    std::int64_t ncategories = py::len(categories);
+
+    for (perspective::t_uindex i = 0; i < nrows; ++i)
+    {
+        std::int64_t code = *reinterpret_cast<const std::int64_t*>(base + i * stride);
+        if (code >= ncategories) {
+            PyErr_SetString(PyExc_IndexError,
+                            ("Categorical code out of range for column " + colname_i).c_str());
+            py::throw_error_already_set();
+        }
+    }
+
+    std::vector<perspective::t_uindex> vocab_idx;
+    for (ssize_t i = 0; i < ncategories; i++)
+    {
+        std::string category = py::extract<std::string>(py::str(categories[i]));
+        vocab_idx.push_back(col->get_interned(category));
+    }
+
+    perspective::t_uindex* out = col->get_nth<perspective::t_uindex>(0);
+
+    if (col->is_status_enabled()) {
+        col->valid_raw_fill();
+    }
+
+    for (perspective::t_uindex i = 0; i < nrows; ++i)
+    {
+        std::int64_t code = *reinterpret_cast<const std::int64_t*>(base + i * stride);
+        if (code < 0) {
+            col->clear(i);
+        } else {
+            out[i] = vocab_idx[code];
+        }
+    }
+}
+
+/**
+ * Marks the rows of a column where mask is true as invalid, as for the mask
+ * of a numpy masked array.
+ */
+void _fill_data_single_column_mask(perspective::t_data_table& tbl,
+                                   const std::string& colname_i,
+                                   np::ndarray& mask)
+{
+    std::shared_ptr<perspective::t_column> col = tbl.get_column(colname_i);
+    if (!col->is_status_enabled()) {
+        return;
+    }
+
+    np::ndarray arr = mask.astype(np::dtype::get_builtin<bool>());
+    perspective::t_uindex nrows = std::min<perspective::t_uindex>(col->size(), arr.shape(0));
+    Py_intptr_t stride = arr.strides(0);
+    const char* base = arr.get_data();
+
+    for (perspective::t_uindex i = 0; i < nrows; ++i)
+    {
+        if (*reinterpret_cast<const bool*>(base + i * stride)) {
+            col->set_valid(i, false);
+        }
     }
 }
 
@@ -153,16 +313,34 @@ _fill_data_single_column_np(perspective::t_data_table& tbl,
     std::shared_ptr<perspective::t_column> col = tbl.get_column(name);
 
     switch(col_type){
-        case perspective::DTYPE_INT64 : {
+        case perspective::DTYPE_INT64 :
+        case perspective::DTYPE_TIME : {
+            // datetime64 arrays arrive as int64 milliseconds since epoch
             _fill_col_np<std::int64_t>(dcol, col);
             break;
         }
+        case perspective::DTYPE_INT32 : {
+            _fill_col_np<std::int32_t>(dcol, col);
+            break;
+        }
+        case perspective::DTYPE_UINT64 : {
+            _fill_col_np<std::uint64_t>(dcol, col);
+            break;
+        }
         case perspective::DTYPE_FLOAT64 : {
             _fill_col_np<double>(dcol, col);
             break;
         }
+        case perspective::DTYPE_FLOAT32 : {
+            _fill_col_np<float>(dcol, col);
+            break;
+        }
+        case perspective::DTYPE_BOOL : {
+            _fill_col_np<bool>(dcol, col);
+            break;
+        }
         case perspective::DTYPE_STR : {
-            _fill_col_np<std::string>(dcol, col);
+            _fill_col_str_np(dcol, col);
             break;
         }
         default: {
@@ -179,6 +357,150 @@ np::ndarray _get_as_numpy(perspective::t_data_table& tbl, const std::string& col
     return col->_as_numpy();
 }
 
+/**
+ * Zero-copy status of a column, STATUS_VALID where a value is present.
+ */
+np::ndarray _get_status_as_numpy(perspective::t_data_table& tbl, const std::string& colname_i)
+{
+    return tbl.get_column(colname_i)->_status_as_numpy();
+}
+
+/**
+ * The vocabulary of a string column, indexed by the codes _get_as_numpy
+ * returns for it.
+ */
+py::list _get_vocab(perspective::t_data_table& tbl, const std::string& colname_i)
+{
+    return tbl.get_column(colname_i)->_vocab_as_list();
+}
+
+/**
+ * Changes whenever a column's values or status are written, reallocated or
+ * cleared. Arrays returned for an older version still hold the buffers they
+ * were taken from, with the values they had then.
+ */
+perspective::t_uindex _get_column_version(perspective::t_data_table& tbl,
+                                          const std::string& colname_i)
+{
+    std::shared_ptr<perspective::t_column> col = tbl.get_column(colname_i);
+    perspective::t_uindex version = col->data_lstore().get_version();
+    if (col->is_status_enabled()) {
+        version += col->status_lstore().get_version();
+    }
+    return version;
+}
+
+static py::list _get_schema_columns(const perspective::t_schema& schema)
+{
+    py::list out;
+    for (const std::string& name : schema.columns()) {
+        out.append(py::make_tuple(name, schema.get_dtype(name)));
+    }
+    return out;
+}
+
+py::list _get_csv_schema(const perspective::t_csv_reader& reader)
+{
+    return _get_schema_columns(reader.get_schema());
+}
+
+py::list _get_snapshot_schema(const perspective::t_snapshot& snapshot)
+{
+    return _get_schema_columns(snapshot.get_schema());
+}
+
+/**
+ * Every row of a plain table holds data, so none are recorded as free.
+ */
+void _save_snapshot(const perspective::t_data_table& tbl, const std::string& dirname)
+{
+    perspective::t_snapshot::save(tbl, std::vector<perspective::t_uindex>(), dirname);
+}
+
+template<typename T>
+np::ndarray _gather_np(const std::vector<t_tscalar>& cells, np::ndarray& valid)
+{
+    np::ndarray out = np::zeros(py::make_tuple(cells.size()), np::dtype::get_builtin<T>());
+    T* values = reinterpret_cast<T*>(out.get_data());
+    bool* is_valid = reinterpret_cast<bool*>(valid.get_data());
+
+    for (perspective::t_uindex i = 0; i < cells.size(); ++i)
+    {
+        is_valid[i] = cells[i].is_valid();
+        if (is_valid[i]) {
+            values[i] = *reinterpret_cast<const T*>(&cells[i].m_data);
+        }
+    }
+
+    return out;
+}
+
+/**
+ * Gathers a column of a flat view into new numpy arrays in one pass, without
+ * a Python object per cell. Returns (values, valid); string columns return
+ * (codes, valid, categories).
+ */
+py::tuple _get_view_column(perspective::t_ctx0& ctx, const std::string& colname)
+{
+    std::vector<std::string> names = ctx.get_column_names();
+    auto iter = std::find(names.begin(), names.end(), colname);
+    if (iter == names.end()) {
+        PSP_COMPLAIN_AND_ABORT("Unknown column " + colname);
+    }
+
+    t_index colidx = std::distance(names.begin(), iter);
+    std::vector<t_tscalar> cells = ctx.get_data(0, ctx.get_row_count(), colidx, colidx + 1);
+    np::ndarray valid = np::zeros(py::make_tuple(cells.size()), np::dtype::get_builtin<bool>());
+
+    t_dtype dtype = DTYPE_NONE;
+    for (const auto& cell : cells)
+    {
+        if (cell.is_valid()) {
+            dtype = cell.get_dtype();
+            break;
+        }
+    }
+
+    switch (dtype) {
+        case DTYPE_STR: {
+            np::ndarray codes = np::zeros(
+                py::make_tuple(cells.size()), np::dtype::get_builtin<std::int64_t>());
+            std::int64_t* out = reinterpret_cast<std::int64_t*>(codes.get_data());
+            bool* is_valid = reinterpret_cast<bool*>(valid.get_data());
+            std::unordered_map<std::string, std::int64_t> interned;
+            py::list categories;
+
+            for (perspective::t_uindex i = 0; i < cells.size(); ++i)
+            {
+                is_valid[i] = cells[i].is_valid();
+                if (!is_valid[i]) {
+                    out[i] = -1;
+                    continue;
+                }
+
+                auto it = interned.emplace(cells[i].get_char_ptr(), interned.size());
+                if (it.second) {
+                    categories.append(it.first->first);
+                }
+                out[i] = it.first->second;
+            }
+            return py::make_tuple(codes, valid, categories);
+        }
+        case DTYPE_INT64: return py::make_tuple(_gather_np<std::int64_t>(cells, valid), valid);
+        case DTYPE_INT32: return py::make_tuple(_gather_np<std::int32_t>(cells, valid), valid);
+        case DTYPE_UINT64: return py::make_tuple(_gather_np<std::uint64_t>(cells, valid), valid);
+        case DTYPE_UINT32:
+        case DTYPE_DATE: return py::make_tuple(_gather_np<std::uint32_t>(cells, valid), valid);
+        case DTYPE_FLOAT32: return py::make_tuple(_gather_np<float>(cells, valid), valid);
+        case DTYPE_BOOL: return py::make_tuple(_gather_np<bool>(cells, valid), valid);
+        case DTYPE_TIME: {
+            np::ndarray values = _gather_np<std::int64_t>(cells, valid);
+            return py::make_tuple(values.view(np::dtype(py::object("datetime64[ms]"))), valid);
+        }
+        default: return py::make_tuple(_gather_np<double>(cells, valid), valid);
+    }
+}
+
 
 
 
@@ -8,12 +8,13 @@
 
 import numpy as np
 import pandas as pd
-from .libbinding import t_schema, t_dtype, t_table, t_column, t_gnode  # noqa: F401
+from .libbinding import t_schema, t_dtype, t_table, t_column, t_gnode, t_csv_reader, t_snapshot  # noqa: F401
 
 
 class Perspective(object):
     def __init__(self, column_names, types):
         self._columns = {}
+        self._arrays = {}
 
         dtypes = []
         for name, _type in zip(column_names, types):
@@ -27,15 +28,42 @@ class Perspective(object):
         self._t_table = t_table(_schema)
         self._t_table.init()
 
+    @classmethod
+    def from_csv(cls, text):
+        # parsed and type-inferred natively, then written straight into the table
+        reader = t_csv_reader(text)
+        columns = reader.get_columns()
+        p = cls([name for name, _ in columns], [dtype for _, dtype in columns])
+        reader.fill(p._t_table)
+        return p
+
+    @classmethod
+    def open(cls, dirname):
+        # columns are mapped from the files written by `save`, not read
+        snapshot = t_snapshot(dirname)
+        columns = snapshot.get_columns()
+        p = cls([name for name, _ in columns], [dtype for _, dtype in columns])
+        snapshot.load(p._t_table)
+        return p
+
+    def save(self, dirname):
+        t_snapshot.save(self._t_table, dirname)
+
     @classmethod
     def _type_to_dtype(self, _type):
         if isinstance(_type, t_dtype):
             return _type
+        if isinstance(_type, pd.Categorical) or pd.api.types.is_categorical_dtype(_type):
+            return t_dtype.STR
+        if isinstance(_type, np.dtype) and np.issubdtype(_type, np.datetime64):
+            return t_dtype.TIME
         if isinstance(_type, np.ndarray):
             if _type.dtype == np.int64:
                 return t_dtype.INT64
             if _type.dtype == np.float64:
                 return t_dtype.FLOAT64
+            if np.issubdtype(_type.dtype, np.datetime64):
+                return t_dtype.TIME
             if _type.dtype == np.str:
                 return t_dtype.STR
             if _type.dtype == np.bool:
@@ -88,8 +116,27 @@ class Perspective(object):
         if not self._t_table.get_schema().has_column(col):
             raise Exception('schema change not implemented')
 
+        dtype = self._type_to_dtype(data)
+
+        if isinstance(data, pd.Categorical):
+            self._t_table.load_categorical(col, data.codes, list(data.categories))
+            return
+
+        if isinstance(data, np.ndarray):
+            # numpy arrays are loaded in bulk and are homogenous already
+            mask = np.ma.getmaskarray(data) if isinstance(data, np.ma.MaskedArray) else None
+            data = np.ma.getdata(data)
+            if np.issubdtype(data.dtype, np.datetime64):
+                nat = np.isnat(data)
+                data = data.astype('datetime64[ms]').astype(np.int64)
+                mask = nat if mask is None else (mask | nat)
+            self._t_table.load_column(col, data, self._t_table.get_schema().get_dtype(col))
+            if mask is not None and mask.any():
+                self._t_table.load_mask(col, mask)
+            return
+
         self._validate_col(data)
-        self._t_table.load_column(col, data, self._type_to_dtype(data))
+        self._t_table.load_column(col, data, dtype)
 
     def print(self):
         self._t_table.pprint()
@@ -102,7 +149,28 @@ class Perspective(object):
     def __getitem__(self, col):
         if not self._t_table.get_schema().has_column(col):
             raise Exception('col not in table - %s' % col)
-        return self._t_table.get_column(col)
+
+        # read-only array aliasing the column; string columns come back as
+        # a categorical over the column vocabulary. Writes move the column to
+        # a new buffer and bump its version, so arrays handed out earlier keep
+        # their values and are re-fetched here once stale.
+        key = (self.version(col), self._t_table.size())
+        cached = self._arrays.get(col)
+        if cached is not None and cached[0] == key:
+            return cached[1]
+
+        data = self._t_table.get_column(col)
+        if self._t_table.get_schema().get_dtype(col) == t_dtype.STR:
+            valid = self._t_table.get_column_status(col) == 1
+            codes = np.where(valid, data.view(np.int64), -1)
+            data = pd.Categorical.from_codes(codes, self._t_table.get_column_vocab(col))
+        self._arrays[col] = (key, data)
+        return data
+
+    # changes whenever `col` is written, after which arrays previously
+    # returned for it no longer alias it
+    def version(self, col):
+        return self._t_table.get_column_version(col)
 
     def to_df(self):
         df = pd.DataFrame()
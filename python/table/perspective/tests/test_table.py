@@ -8,8 +8,11 @@
 
 import os
 import os.path
+import shutil
+import tempfile
 import numpy as np
 import pandas as pd
+import pytest
 from perspective.table import Perspective
 
 
@@ -75,3 +78,55 @@ class TestTable(object):
         else:
             print('cannot fine ohlc file')
             assert False
+
+    def test_table_np_bulk(self):
+        print('\nfrom masked, datetime and categorical arrays test:\n')
+        t = Perspective(['a', 'b', 'c'], [np.float64, np.dtype('datetime64[ns]'), 'category'])
+        t.load('a', np.ma.masked_array([1.5, np.nan, 3.5], mask=[False, False, True]))
+        t.load('b', np.array(['2019-01-01', 'NaT', '2019-01-03'], dtype='datetime64[ns]'))
+        t.load('c', pd.Categorical(['x', 'y', None]))
+        t.print()
+
+        # codes are checked against the categories, and only strings load
+        with pytest.raises(IndexError):
+            t._t_table.load_categorical('c', np.array([0, 2, 0]), ['x', 'y'])
+        with pytest.raises(TypeError):
+            t._t_table.load_categorical('a', np.array([0, 1, 0]), ['x', 'y'])
+
+    def test_table_column_alias(self):
+        print('\nzero-copy column test:\n')
+        t = Perspective(['a', 'b'], [np.float64, str])
+        t.load('a', np.array([1.5, 2.5, 3.5]))
+        t.load('b', ['x', 'y', 'x'])
+        arr = t['a']
+        assert not arr.flags.writeable
+        assert t['a'] is arr
+        version = t.version('a')
+        print(arr, version)
+
+        # writing to the column leaves arrays already handed out untouched
+        t.load('a', np.array([4.5, 5.5, 6.5]))
+        assert t.version('a') != version
+        assert list(arr) == [1.5, 2.5, 3.5]
+        assert list(t['a']) == [4.5, 5.5, 6.5]
+        print(t['b'])
+
+    def test_table_from_csv(self):
+        print('\ncsv test:\n')
+        t = Perspective.from_csv('a,b,c\n1,x,1.5\n2,"y,z",\n')
+        assert t._t_table.size() == 2
+        t.print()
+
+    def test_table_snapshot(self):
+        print('\nsnapshot test:\n')
+        t = Perspective.from_csv('a,b,c\n1,x,1.5\n2,"y,z",\n')
+        dirname = tempfile.mkdtemp()
+        try:
+            t.save(dirname)
+            t2 = Perspective.open(dirname)
+            assert t2._t_table.size() == 2
+            assert (t2['a'] == t['a']).all()
+            assert t2._t_table.get_column_vocab('b') == t._t_table.get_column_vocab('b')
+            t2.print()
+        finally:
+            shutil.rmtree(dirname)